@@ -0,0 +1,404 @@
+#include "include/analysisservice.h"
+#include <algorithm>
+#include <cmath>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QMap>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include "include/csvprocessor.h"
+#include "include/datamanager.h"
+#include "include/filenameindex.h"
+#include "include/ingestpipeline.h"
+
+namespace {
+
+// A connection that sends this much without a newline is dropped
+constexpr qint64 MaxLineBytes = 16 * 1024 * 1024;
+
+} // namespace
+
+/**
+ * @brief Constructor
+ * @param config Configuration used as the default for every request
+ * @param parent The parent QObject
+ */
+AnalysisService::AnalysisService(const AppConfig &config, QObject *parent)
+    : QObject(parent), m_config(config)
+{
+    // Requests are CPU bound and get the compute pool's priority and CPUs
+    m_requestPool.configure(std::max(2, WorkerPools::computeThreads(config)),
+                            WorkerPool::priorityFromName(config.compute_priority, QThread::NormalPriority),
+                            WorkerPool::parseCpuList(config.worker_cpus));
+    // Keep request threads alive between bursts so a request never waits for a thread to start
+    m_requestPool.setExpiryTimeout(-1);
+    // Folder loads and structure fits share one set of pools across requests, as in the application
+    m_pools.configure(config);
+}
+
+/**
+ * @brief Destructor; waits for running requests
+ */
+AnalysisService::~AnalysisService()
+{
+    m_requestPool.waitForDone();
+}
+
+bool AnalysisService::listenTcp(quint16 port, QString *error)
+{
+    if (!m_tcpServer) {
+        m_tcpServer = new QTcpServer(this);
+        connect(m_tcpServer, &QTcpServer::newConnection, this, &AnalysisService::acceptTcp);
+    }
+    // Loopback only: the service has no authentication
+    if (!m_tcpServer->listen(QHostAddress::LocalHost, port)) {
+        if (error) *error = m_tcpServer->errorString();
+        return false;
+    }
+    return true;
+}
+
+bool AnalysisService::listenLocal(const QString &name, QString *error)
+{
+    if (!m_localServer) {
+        m_localServer = new QLocalServer(this);
+        m_localServer->setSocketOptions(QLocalServer::UserAccessOption);
+        connect(m_localServer, &QLocalServer::newConnection, this, &AnalysisService::acceptLocal);
+    }
+    // A stale socket file from a crashed instance would block listen()
+    QLocalServer::removeServer(name);
+    if (!m_localServer->listen(name)) {
+        if (error) *error = m_localServer->errorString();
+        return false;
+    }
+    return true;
+}
+
+quint16 AnalysisService::tcpPort() const
+{
+    return m_tcpServer && m_tcpServer->isListening() ? m_tcpServer->serverPort() : 0;
+}
+
+QString AnalysisService::localServerName() const
+{
+    return m_localServer && m_localServer->isListening() ? m_localServer->fullServerName() : QString();
+}
+
+void AnalysisService::setMaxConcurrentRequests(int count)
+{
+    m_requestPool.setMaxThreadCount(std::max(1, count));
+}
+
+void AnalysisService::acceptTcp()
+{
+    while (QTcpSocket *socket = m_tcpServer->nextPendingConnection()) {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        attach(socket);
+    }
+}
+
+void AnalysisService::acceptLocal()
+{
+    while (QLocalSocket *socket = m_localServer->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        attach(socket);
+    }
+}
+
+void AnalysisService::attach(QIODevice *connection)
+{
+    connect(connection, &QIODevice::readyRead, this, [this, connection]() {
+        readRequests(connection);
+    });
+    // Lines may already be buffered
+    readRequests(connection);
+}
+
+/**
+ * @brief Dispatch all complete lines buffered on a connection
+ *
+ * Every line becomes a job on the request pool. The watcher is owned by
+ * the connection, so a response for a client that has gone away is
+ * dropped together with the connection.
+ */
+void AnalysisService::readRequests(QIODevice *connection)
+{
+    while (connection->canReadLine()) {
+        const QByteArray line = connection->readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        auto *watcher = new QFutureWatcher<QByteArray>(connection);
+        connect(watcher, &QFutureWatcher<QByteArray>::finished, this, [this, watcher, connection, timer]() {
+            const QByteArray response = watcher->result();
+            if (!response.isEmpty()) {
+                connection->write(response + '\n');
+            }
+            watcher->deleteLater();
+            emit requestHandled(timer.nsecsElapsed() / 1.0e6);
+        });
+        watcher->setFuture(m_requestPool.run([this, line]() {
+            return handleLine(line);
+        }));
+    }
+
+    if (connection->bytesAvailable() > MaxLineBytes) {
+        qDebug() << "Dropping service connection: request line exceeds" << MaxLineBytes << "bytes";
+        QJsonObject response;
+        response["jsonrpc"] = QStringLiteral("2.0");
+        response["id"] = QJsonValue::Null;
+        response["error"] = errorObject(InvalidRequest, QStringLiteral("Request line too long"));
+        connection->write(QJsonDocument(response).toJson(QJsonDocument::Compact) + '\n');
+        connection->close();
+    }
+}
+
+QByteArray AnalysisService::handleLine(const QByteArray &line) const
+{
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        QJsonObject response;
+        response["jsonrpc"] = QStringLiteral("2.0");
+        response["id"] = QJsonValue::Null;
+        response["error"] = errorObject(ParseError, parseError.errorString());
+        return QJsonDocument(response).toJson(QJsonDocument::Compact);
+    }
+
+    // A batch is answered with an array of the non-notification responses
+    if (doc.isArray()) {
+        const QJsonArray batch = doc.array();
+        if (batch.isEmpty()) {
+            return QJsonDocument(handleRequest(QJsonValue())).toJson(QJsonDocument::Compact);
+        }
+        QJsonArray responses;
+        for (const QJsonValue &request : batch) {
+            const QJsonObject response = handleRequest(request);
+            if (!response.isEmpty()) {
+                responses.append(response);
+            }
+        }
+        return responses.isEmpty() ? QByteArray() : QJsonDocument(responses).toJson(QJsonDocument::Compact);
+    }
+
+    const QJsonObject response = handleRequest(doc.object());
+    return response.isEmpty() ? QByteArray() : QJsonDocument(response).toJson(QJsonDocument::Compact);
+}
+
+QJsonObject AnalysisService::handleRequest(const QJsonValue &request) const
+{
+    QJsonObject response;
+    response["jsonrpc"] = QStringLiteral("2.0");
+
+    const QJsonObject object = request.toObject();
+    if (!request.isObject() || object.value("jsonrpc").toString() != QLatin1String("2.0")
+        || !object.value("method").isString()) {
+        response["id"] = object.contains("id") ? object.value("id") : QJsonValue(QJsonValue::Null);
+        response["error"] = errorObject(InvalidRequest, QStringLiteral("Not a JSON-RPC 2.0 request"));
+        return response;
+    }
+
+    const bool notification = !object.contains("id");
+    response["id"] = object.value("id");
+
+    const QString method = object.value("method").toString();
+    const QJsonValue params = object.value("params");
+    if (!params.isUndefined() && !params.isObject()) {
+        response["error"] = errorObject(InvalidParams, QStringLiteral("params must be an object"));
+        return notification ? QJsonObject() : response;
+    }
+
+    if (method == QLatin1String("analyze")) {
+        QJsonObject error;
+        const QJsonObject result = analyze(params.toObject(), &error);
+        if (result.isEmpty()) {
+            response["error"] = error;
+        } else {
+            response["result"] = result;
+        }
+    } else if (method == QLatin1String("models")) {
+        response["result"] = QJsonArray::fromStringList(Calculator::fitModelNames());
+    } else if (method == QLatin1String("ping")) {
+        response["result"] = QStringLiteral("pong");
+    } else {
+        response["error"] = errorObject(MethodNotFound, QStringLiteral("Unknown method: %1").arg(method));
+    }
+
+    return notification ? QJsonObject() : response;
+}
+
+/**
+ * @brief Execute the "analyze" method
+ * @param params Request parameters
+ * @param error Receives the error object on failure
+ * @return Result object, empty on failure
+ *
+ * Files are parsed directly on the request thread, which is the fast path
+ * for the few files of a just-measured structure; folders go through the
+ * ingest pipeline.
+ */
+QJsonObject AnalysisService::analyze(const QJsonObject &params, QJsonObject *error) const
+{
+    // Request values override the service configuration for this request only
+    AppConfig config = m_config;
+    if (params.contains("voltage")) {
+        if (!params.value("voltage").isDouble()) {
+            *error = errorObject(InvalidParams, QStringLiteral("voltage must be a number"));
+            return {};
+        }
+        config.res_voltage = params.value("voltage").toDouble();
+    }
+
+    Calculator::FitModel model;
+    const QString modelName = params.value("model").toString(config.fit_model);
+    if (!Calculator::fitModelFromName(modelName, model)) {
+        *error = errorObject(InvalidParams, QStringLiteral("Unknown fit model: %1").arg(modelName));
+        return {};
+    }
+
+    const double channelWidth = params.value("channelWidth").toDouble(config.channel_length);
+    if (!(channelWidth > 0)) {
+        *error = errorObject(InvalidParams, QStringLiteral("channelWidth must be positive"));
+        return {};
+    }
+
+    QStringList files;
+    QStringList folders;
+    for (const QJsonValue &value : params.value("files").toArray()) {
+        files.append(value.toString());
+    }
+    for (const QJsonValue &value : params.value("folders").toArray()) {
+        folders.append(value.toString());
+    }
+    files.removeAll(QString());
+    folders.removeAll(QString());
+    if (files.isEmpty() && folders.isEmpty()) {
+        *error = errorObject(InvalidParams, QStringLiteral("Specify files or folders to analyse"));
+        return {};
+    }
+
+    QVector<DataPoint> points = loadFiles(files, config);
+    if (!folders.isEmpty()) {
+        IngestOptions options = IngestOptions::fromConfig(config);
+        options.stagePool = m_pools.ingest();
+        options.archivePool = m_pools.compute();
+        IngestPipeline pipeline(config, options);
+        points += pipeline.runMany(folders);
+        std::stable_sort(points.begin(), points.end(), [](const DataPoint &a, const DataPoint &b) {
+            if (a.structure != b.structure) {
+                return a.structure < b.structure;
+            }
+            return a.spacing < b.spacing;
+        });
+    }
+    if (points.isEmpty()) {
+        *error = errorObject(AnalysisFailed, QStringLiteral("No valid data points found"));
+        return {};
+    }
+
+    Calculator::FitGeometry geometry;
+    geometry.channelWidth = channelWidth;
+    geometry.ctlmInnerRadius = config.ctlm_inner_radius;
+    geometry.contactLength = config.contact_length;
+
+    // A fit pooled over different structures means nothing, so the overall
+    // result is only given for one structure. The points are sorted by
+    // structure, so there is one if the first and last agree.
+    const bool singleStructure = points.constFirst().structure == points.constLast().structure;
+    Calculator::TLMResult overall;
+    const bool overallOk = singleStructure && Calculator::fit(model, points, geometry, overall);
+    QMap<QString, Calculator::TLMResult> structureResults;
+    DataManager::calculateStructureResults(points, structureResults, model, geometry, m_pools.compute());
+    if (!overallOk && structureResults.isEmpty()) {
+        *error = errorObject(AnalysisFailed, QStringLiteral("Analysis failed: at least two distinct spacings are required"));
+        return {};
+    }
+
+    QJsonObject result;
+    result["points"] = points.size();
+    result["model"] = Calculator::fitModelName(model);
+    if (overallOk) {
+        result["result"] = resultToJson(overall);
+    }
+    QJsonArray structures;
+    for (auto it = structureResults.cbegin(); it != structureResults.cend(); ++it) {
+        QJsonObject entry = resultToJson(it.value());
+        entry["structure"] = it.key();
+        structures.append(entry);
+    }
+    result["structures"] = structures;
+    return result;
+}
+
+/**
+ * @brief Parse CSV files given by path, as a folder load would
+ * @param paths File paths
+ * @param config Configuration for this request
+ * @return Valid points sorted by structure and spacing
+ *
+ * Spacing comes from the file name and a file with several buffers or
+ * steps yields one structure per source, as in CSVProcessor::processFolder().
+ */
+QVector<DataPoint> AnalysisService::loadFiles(const QStringList &paths, const AppConfig &config)
+{
+    QVector<DataPoint> dataPoints;
+    const FilenameTemplates templates(config.filename_templates);
+    for (const QString &path : paths) {
+        const double spacing = templates.spacing(QFileInfo(path).fileName());
+        if (!(spacing > 0)) {
+            qDebug() << "Filename does not contain valid spacing, skipping:" << path;
+            continue;
+        }
+        const QVector<DataPoint> points = CSVProcessor::processFileAll(path, config);
+        for (DataPoint point : points) {
+            if (point.resistance > 0 && std::isfinite(point.resistance)) {
+                point.spacing = spacing;
+                point.structure = CSVProcessor::structureForSource(QString(), point.source);
+                dataPoints.append(point);
+            }
+        }
+    }
+
+    std::stable_sort(dataPoints.begin(), dataPoints.end(), [](const DataPoint &a, const DataPoint &b) {
+        if (a.structure != b.structure) {
+            return a.structure < b.structure;
+        }
+        return a.spacing < b.spacing;
+    });
+    return dataPoints;
+}
+
+QJsonObject AnalysisService::resultToJson(const Calculator::TLMResult &result)
+{
+    QJsonObject object;
+    object["slope"] = result.slope;
+    object["intercept"] = result.intercept;
+    object["rSquared"] = result.rSquared;
+    object["sheetResistance"] = result.sheetResistance;
+    object["contactResistance"] = result.contactResistance;
+    object["specificContactResistivity"] = result.specificContactResistivity;
+    object["channelWidth"] = result.channelWidth;
+    object["transferLength"] = result.transferLength;
+    object["endResistance"] = result.endResistance;
+    return object;
+}
+
+QJsonObject AnalysisService::errorObject(int code, const QString &message)
+{
+    QJsonObject error;
+    error["code"] = code;
+    error["message"] = message;
+    return error;
+}
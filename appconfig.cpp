@@ -1,6 +1,8 @@
 #include "include/appconfig.h"
 #include <QFile>
 #include <QJsonDocument>
+#include <QJsonArray>
+#include <QVariant>
 #include <QDir>
 #include <QDebug>
 #include <QStandardPaths>
@@ -12,8 +14,41 @@
  * @param configFile Path to the configuration file
  */
 AppConfig::AppConfig(const QString& configFile)
-    : res_voltage(1.0), channel_length(100.0), m_configFile(configFile)
+    : AppConfig(configFile, Loading::Immediate)
 {
+}
+
+/**
+ * @brief Constructor that can defer file I/O
+ * @param configFile Path to the configuration file
+ * @param loading Immediate to resolve now, Deferred to keep the defaults until resolve()
+ */
+AppConfig::AppConfig(const QString& configFile, Loading loading)
+    : res_voltage(1.0), channel_length(100.0),
+      ingest_read_threads(0), ingest_parse_threads(0), ingest_validate_threads(0), ingest_queue_capacity(0), ingest_read_batch(0),
+      scan_recursive(false), include_patterns({QStringLiteral("*.csv")}), group_by_folder(false),
+      ingest_archives(true), archive_member_limit_mb(256),
+      fit_model(QStringLiteral("linear")), ctlm_inner_radius(100.0), contact_length(100.0),
+      results_db(QStringLiteral("tlm_results.sqlite")), record_results(true),
+      results_path_levels({QStringLiteral("lot"), QStringLiteral("wafer"), QStringLiteral("die")}),
+      io_threads(0), io_priority(QStringLiteral("low")), compute_threads(0),
+      compute_priority(QStringLiteral("normal")), undo_limit(200),
+      prefetch_folders(0), prefetch_cache(4), prefetch_priority(QStringLiteral("lowest")),
+      m_configFile(configFile), m_resolved(false)
+{
+    if (loading == Loading::Immediate) {
+        resolve();
+    }
+}
+
+/**
+ * @brief Locate, migrate and load the configuration file
+ * @return True if a configuration file was loaded
+ */
+bool AppConfig::resolve()
+{
+    bool loaded = false;
+
     // Determine the platform-appropriate config directory
     QString standardConfigDir = QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation);
     if (standardConfigDir.isEmpty()) {
@@ -45,33 +80,50 @@ AppConfig::AppConfig(const QString& configFile)
                 // After copying, attempt to load from the new location; if successful, set m_configFile to target
                 QString original = m_configFile;
                 m_configFile = targetPath;
-                if (!loadConfig()) {
+                loaded = loadConfig();
+                if (!loaded) {
                     // Rollback: restore original path and try to restore backup if present
                     qDebug() << "Migration failed while loading new config; rolling back to original.";
                     m_configFile = original;
                     // Attempt to restore from backup if it exists (best-effort)
                     // (No hard failure; we keep using original if available)
+                    loaded = loadConfig();
                 }
             } else {
                 qDebug() << "Failed to migrate config file to" << targetPath << "; will continue using" << m_configFile;
+                loaded = loadConfig();
             }
         } else if (QFile::exists(targetPath)) {
             // Use the standard location config if it exists
             m_configFile = targetPath;
+            loaded = loadConfig();
         } else {
             // If neither exists, create default at the standard location
             m_configFile = targetPath;
             createDefaultConfig();
-            loadConfig();
+            loaded = loadConfig();
         }
     } else {
         // Could not determine a standard config location; fallback to provided path
         qDebug() << "Could not determine standard config dir; using provided config path:" << m_configFile;
-        if (!loadConfig()) {
+        loaded = loadConfig();
+        if (!loaded) {
             createDefaultConfig();
-            loadConfig();
+            loaded = loadConfig();
         }
     }
+
+    m_resolved = true;
+    return loaded;
+}
+
+/**
+ * @brief Whether resolve() has run
+ * @return True once the configuration file has been located
+ */
+bool AppConfig::isResolved() const
+{
+    return m_resolved;
 }
 
 /**
@@ -111,6 +163,118 @@ bool AppConfig::loadConfig()
     if (obj.contains("channel_length") && obj["channel_length"].isDouble()) {
         channel_length = obj["channel_length"].toDouble();
     }
+
+    if (obj.contains("ingest_read_threads") && obj["ingest_read_threads"].isDouble()) {
+        ingest_read_threads = obj["ingest_read_threads"].toInt();
+    }
+
+    if (obj.contains("ingest_parse_threads") && obj["ingest_parse_threads"].isDouble()) {
+        ingest_parse_threads = obj["ingest_parse_threads"].toInt();
+    }
+
+    if (obj.contains("ingest_validate_threads") && obj["ingest_validate_threads"].isDouble()) {
+        ingest_validate_threads = obj["ingest_validate_threads"].toInt();
+    }
+
+    if (obj.contains("ingest_queue_capacity") && obj["ingest_queue_capacity"].isDouble()) {
+        ingest_queue_capacity = obj["ingest_queue_capacity"].toInt();
+    }
+
+    if (obj.contains("ingest_read_batch") && obj["ingest_read_batch"].isDouble()) {
+        ingest_read_batch = obj["ingest_read_batch"].toInt();
+    }
+
+    if (obj.contains("scan_recursive") && obj["scan_recursive"].isBool()) {
+        scan_recursive = obj["scan_recursive"].toBool();
+    }
+
+    if (obj.contains("include_patterns") && obj["include_patterns"].isArray()) {
+        include_patterns = obj["include_patterns"].toVariant().toStringList();
+    }
+
+    if (obj.contains("exclude_patterns") && obj["exclude_patterns"].isArray()) {
+        exclude_patterns = obj["exclude_patterns"].toVariant().toStringList();
+    }
+
+    if (obj.contains("group_by_folder") && obj["group_by_folder"].isBool()) {
+        group_by_folder = obj["group_by_folder"].toBool();
+    }
+
+    if (obj.contains("ingest_archives") && obj["ingest_archives"].isBool()) {
+        ingest_archives = obj["ingest_archives"].toBool();
+    }
+
+    if (obj.contains("archive_member_limit_mb") && obj["archive_member_limit_mb"].isDouble()) {
+        archive_member_limit_mb = obj["archive_member_limit_mb"].toInt();
+    }
+
+    if (obj.contains("fit_model") && obj["fit_model"].isString()) {
+        fit_model = obj["fit_model"].toString();
+    }
+
+    if (obj.contains("ctlm_inner_radius") && obj["ctlm_inner_radius"].isDouble()) {
+        ctlm_inner_radius = obj["ctlm_inner_radius"].toDouble();
+    }
+
+    if (obj.contains("contact_length") && obj["contact_length"].isDouble()) {
+        contact_length = obj["contact_length"].toDouble();
+    }
+
+    if (obj.contains("filename_templates") && obj["filename_templates"].isArray()) {
+        filename_templates = obj["filename_templates"].toVariant().toStringList();
+    }
+
+    if (obj.contains("results_db") && obj["results_db"].isString()) {
+        results_db = obj["results_db"].toString();
+    }
+
+    if (obj.contains("record_results") && obj["record_results"].isBool()) {
+        record_results = obj["record_results"].toBool();
+    }
+
+    if (obj.contains("results_path_levels") && obj["results_path_levels"].isArray()) {
+        results_path_levels = obj["results_path_levels"].toVariant().toStringList();
+    }
+
+    if (obj.contains("io_threads") && obj["io_threads"].isDouble()) {
+        io_threads = obj["io_threads"].toInt();
+    }
+
+    if (obj.contains("io_priority") && obj["io_priority"].isString()) {
+        io_priority = obj["io_priority"].toString();
+    }
+
+    if (obj.contains("compute_threads") && obj["compute_threads"].isDouble()) {
+        compute_threads = obj["compute_threads"].toInt();
+    }
+
+    if (obj.contains("compute_priority") && obj["compute_priority"].isString()) {
+        compute_priority = obj["compute_priority"].toString();
+    }
+
+    if (obj.contains("worker_cpus") && obj["worker_cpus"].isString()) {
+        worker_cpus = obj["worker_cpus"].toString();
+    }
+
+    if (obj.contains("undo_limit") && obj["undo_limit"].isDouble()) {
+        undo_limit = obj["undo_limit"].toInt();
+    }
+
+    if (obj.contains("prefetch_folders") && obj["prefetch_folders"].isDouble()) {
+        prefetch_folders = obj["prefetch_folders"].toInt();
+    }
+
+    if (obj.contains("prefetch_cache") && obj["prefetch_cache"].isDouble()) {
+        prefetch_cache = obj["prefetch_cache"].toInt();
+    }
+
+    if (obj.contains("prefetch_order") && obj["prefetch_order"].isArray()) {
+        prefetch_order = obj["prefetch_order"].toVariant().toStringList();
+    }
+
+    if (obj.contains("prefetch_priority") && obj["prefetch_priority"].isString()) {
+        prefetch_priority = obj["prefetch_priority"].toString();
+    }
     
     return true;
 }
@@ -121,11 +285,45 @@ bool AppConfig::loadConfig()
  */
 bool AppConfig::saveConfig() const
 {
+    // A deferred configuration does not know its file location yet
+    if (!m_resolved) {
+        qDebug() << "Config not resolved yet; not saving" << m_configFile;
+        return false;
+    }
+
     QJsonObject obj;
     
     // Save configuration values
     obj["res_voltage"] = res_voltage;
     obj["channel_length"] = channel_length;
+    obj["ingest_read_threads"] = ingest_read_threads;
+    obj["ingest_parse_threads"] = ingest_parse_threads;
+    obj["ingest_validate_threads"] = ingest_validate_threads;
+    obj["ingest_queue_capacity"] = ingest_queue_capacity;
+    obj["ingest_read_batch"] = ingest_read_batch;
+    obj["scan_recursive"] = scan_recursive;
+    obj["include_patterns"] = QJsonArray::fromStringList(include_patterns);
+    obj["exclude_patterns"] = QJsonArray::fromStringList(exclude_patterns);
+    obj["group_by_folder"] = group_by_folder;
+    obj["ingest_archives"] = ingest_archives;
+    obj["archive_member_limit_mb"] = archive_member_limit_mb;
+    obj["fit_model"] = fit_model;
+    obj["ctlm_inner_radius"] = ctlm_inner_radius;
+    obj["contact_length"] = contact_length;
+    obj["filename_templates"] = QJsonArray::fromStringList(filename_templates);
+    obj["results_db"] = results_db;
+    obj["record_results"] = record_results;
+    obj["results_path_levels"] = QJsonArray::fromStringList(results_path_levels);
+    obj["io_threads"] = io_threads;
+    obj["io_priority"] = io_priority;
+    obj["compute_threads"] = compute_threads;
+    obj["compute_priority"] = compute_priority;
+    obj["worker_cpus"] = worker_cpus;
+    obj["undo_limit"] = undo_limit;
+    obj["prefetch_folders"] = prefetch_folders;
+    obj["prefetch_cache"] = prefetch_cache;
+    obj["prefetch_order"] = QJsonArray::fromStringList(prefetch_order);
+    obj["prefetch_priority"] = prefetch_priority;
     
     QJsonDocument doc(obj);
     
@@ -167,6 +365,17 @@ bool AppConfig::setChannelLength(double length)
     return saveConfig();
 }
 
+/**
+ * @brief Set fit model and save to config file
+ * @param model Fit model name ("linear", "circular" or "end_resistance")
+ * @return True if successful, false otherwise
+ */
+bool AppConfig::setFitModel(const QString& model)
+{
+    fit_model = model;
+    return saveConfig();
+}
+
 /**
  * @brief Get the configuration file path
  * @return Path to configuration file
@@ -187,6 +396,34 @@ bool AppConfig::createDefaultConfig() const
     // Save default values
     obj["res_voltage"] = res_voltage;
     obj["channel_length"] = channel_length;
+    obj["ingest_read_threads"] = ingest_read_threads;
+    obj["ingest_parse_threads"] = ingest_parse_threads;
+    obj["ingest_validate_threads"] = ingest_validate_threads;
+    obj["ingest_queue_capacity"] = ingest_queue_capacity;
+    obj["ingest_read_batch"] = ingest_read_batch;
+    obj["scan_recursive"] = scan_recursive;
+    obj["include_patterns"] = QJsonArray::fromStringList(include_patterns);
+    obj["exclude_patterns"] = QJsonArray::fromStringList(exclude_patterns);
+    obj["group_by_folder"] = group_by_folder;
+    obj["ingest_archives"] = ingest_archives;
+    obj["archive_member_limit_mb"] = archive_member_limit_mb;
+    obj["fit_model"] = fit_model;
+    obj["ctlm_inner_radius"] = ctlm_inner_radius;
+    obj["contact_length"] = contact_length;
+    obj["filename_templates"] = QJsonArray::fromStringList(filename_templates);
+    obj["results_db"] = results_db;
+    obj["record_results"] = record_results;
+    obj["results_path_levels"] = QJsonArray::fromStringList(results_path_levels);
+    obj["io_threads"] = io_threads;
+    obj["io_priority"] = io_priority;
+    obj["compute_threads"] = compute_threads;
+    obj["compute_priority"] = compute_priority;
+    obj["worker_cpus"] = worker_cpus;
+    obj["undo_limit"] = undo_limit;
+    obj["prefetch_folders"] = prefetch_folders;
+    obj["prefetch_cache"] = prefetch_cache;
+    obj["prefetch_order"] = QJsonArray::fromStringList(prefetch_order);
+    obj["prefetch_priority"] = prefetch_priority;
     
     QJsonDocument doc(obj);
     
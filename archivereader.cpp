@@ -0,0 +1,528 @@
+#include "include/archivereader.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QVector>
+#include <QThreadPool>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include "include/workerpools.h"
+
+#ifdef TLM_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+// Little-endian field readers for zip structures
+quint16 readLE16(const uchar *p) { return static_cast<quint16>(p[0] | (p[1] << 8)); }
+quint32 readLE32(const uchar *p) { return static_cast<quint32>(p[0]) | (static_cast<quint32>(p[1]) << 8)
+                                        | (static_cast<quint32>(p[2]) << 16) | (static_cast<quint32>(p[3]) << 24); }
+
+constexpr quint32 kZipLocalHeaderSignature = 0x04034b50;
+constexpr quint32 kZipCentralHeaderSignature = 0x02014b50;
+constexpr quint32 kZipEndOfCentralDirSignature = 0x06054b50;
+constexpr qint64 kTarBlockSize = 512;
+constexpr qint64 kInflateChunk = 256 * 1024;      // First output buffer of a zip member; doubled as needed
+constexpr qint64 kMaxCompressionRatio = 256;       // Sweep files compress far less; only checked above the floor
+constexpr qint64 kRatioCheckFloor = 1024 * 1024;
+
+struct ZipEntry {
+    QString name;
+    quint16 flags = 0;
+    quint16 method = 0;
+    quint32 crc = 0;
+    quint32 compressedSize = 0;
+    quint32 uncompressedSize = 0;
+    quint32 localHeaderOffset = 0;
+};
+
+struct ZipExtraction {
+    QByteArray content;
+    bool ok = false;
+};
+
+class MemberFilter {
+public:
+    explicit MemberFilter(const QStringList &patterns)
+    {
+        for (const QString &pattern : patterns) {
+            m_patterns.append(QRegularExpression(QRegularExpression::wildcardToRegularExpression(pattern),
+                                                 QRegularExpression::CaseInsensitiveOption));
+        }
+    }
+
+    bool accepts(const QString &memberName) const
+    {
+        if (m_patterns.isEmpty()) {
+            return true;
+        }
+        const QString baseName = memberName.section(QLatin1Char('/'), -1);
+        for (const QRegularExpression &re : m_patterns) {
+            if (re.match(baseName).hasMatch()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    QVector<QRegularExpression> m_patterns;
+};
+
+/**
+ * @brief Decompress one zip member from the mapped archive
+ *
+ * The sizes in the directory are not trusted: a member above the limit or
+ * claiming an implausible compression ratio is rejected before anything is
+ * allocated, and a deflated member is inflated into a buffer that grows with
+ * the output, so a header overstating the size costs no memory. Inflation
+ * stops one byte past the declared size, which catches understated sizes.
+ */
+ZipExtraction extractZipEntry(const uchar *archive, qint64 archiveSize, const ZipEntry &entry, qint64 maxMemberSize)
+{
+    ZipExtraction result;
+    const qint64 header = entry.localHeaderOffset;
+    if (header + 30 > archiveSize || readLE32(archive + header) != kZipLocalHeaderSignature) {
+        return result;
+    }
+    const qint64 dataStart = header + 30 + readLE16(archive + header + 26) + readLE16(archive + header + 28);
+    if (dataStart + entry.compressedSize > archiveSize) {
+        return result;
+    }
+    const qint64 declared = entry.uncompressedSize;
+    if (declared > maxMemberSize) {
+        qDebug() << "Skipping zip member larger than the limit:" << entry.name << declared << "bytes";
+        return result;
+    }
+    if (declared > kRatioCheckFloor && declared > qint64(entry.compressedSize) * kMaxCompressionRatio) {
+        qDebug() << "Skipping zip member with implausible compression ratio:" << entry.name;
+        return result;
+    }
+    const uchar *compressed = archive + dataStart;
+
+    if (entry.method == 0) {
+        if (entry.compressedSize != entry.uncompressedSize) {
+            return result;
+        }
+        result.content = QByteArray(reinterpret_cast<const char *>(compressed), entry.compressedSize);
+    } else if (entry.method == 8) {
+#ifdef TLM_HAVE_ZLIB
+        z_stream zs {};
+        if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) {
+            return result;
+        }
+        zs.next_in = const_cast<Bytef *>(compressed);
+        zs.avail_in = entry.compressedSize;
+        const qint64 limit = declared + 1;
+        result.content.resize(std::min(limit, kInflateChunk));
+        int ret = Z_OK;
+        while (ret == Z_OK) {
+            const qint64 produced = static_cast<qint64>(zs.total_out);
+            if (produced == result.content.size()) {
+                if (produced >= limit) {
+                    break;
+                }
+                result.content.resize(std::min(limit, produced * 2));
+            }
+            zs.next_out = reinterpret_cast<Bytef *>(result.content.data()) + produced;
+            zs.avail_out = static_cast<uInt>(result.content.size() - produced);
+            ret = inflate(&zs, Z_NO_FLUSH);
+        }
+        inflateEnd(&zs);
+        if (ret != Z_STREAM_END || static_cast<qint64>(zs.total_out) != declared) {
+            result.content.clear();
+            return result;
+        }
+        result.content.resize(declared);
+#else
+        return result;
+#endif
+    } else {
+        return result;
+    }
+
+#ifdef TLM_HAVE_ZLIB
+    const uLong crc = crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef *>(result.content.constData()),
+                            static_cast<uInt>(result.content.size()));
+    if (crc != entry.crc) {
+        result.content.clear();
+        return result;
+    }
+#endif
+    result.ok = true;
+    return result;
+}
+
+qint64 parseTarOctal(const char *field, int length)
+{
+    qint64 value = 0;
+    for (int i = 0; i < length && field[i] != '\0'; ++i) {
+        if (field[i] >= '0' && field[i] <= '7') {
+            value = value * 8 + (field[i] - '0');
+        }
+    }
+    return value;
+}
+
+QString tarHeaderName(const char *header)
+{
+    const QString name = QString::fromUtf8(header, static_cast<qsizetype>(qstrnlen(header, 100)));
+    if (std::memcmp(header + 257, "ustar", 5) == 0 && header[345] != '\0') {
+        return QString::fromUtf8(header + 345, static_cast<qsizetype>(qstrnlen(header + 345, 155)))
+               + QLatin1Char('/') + name;
+    }
+    return name;
+}
+
+/**
+ * @brief Extract the "path" record of a pax extended header, if any
+ */
+QString paxPath(const char *data, qint64 size)
+{
+    // Records look like "<length> <key>=<value>\n"
+    const QByteArray records(data, size);
+    for (const QByteArray &record : records.split('\n')) {
+        const qsizetype space = record.indexOf(' ');
+        if (space >= 0 && record.mid(space + 1).startsWith("path=")) {
+            return QString::fromUtf8(record.mid(space + 6));
+        }
+    }
+    return QString();
+}
+
+} // namespace
+
+/**
+ * @brief Member size limit in bytes
+ * @param megabytes archive_member_limit_mb; 0 or less selects DefaultMaxMemberSize
+ */
+qint64 ArchiveReader::memberLimit(int megabytes)
+{
+    return megabytes > 0 ? qint64(megabytes) * 1024 * 1024 : DefaultMaxMemberSize;
+}
+
+/**
+ * @brief File name wildcards recognised as archives
+ */
+QStringList ArchiveReader::archivePatterns()
+{
+    return {QStringLiteral("*.zip"), QStringLiteral("*.tar.gz"), QStringLiteral("*.tgz"), QStringLiteral("*.tar")};
+}
+
+/**
+ * @brief Check whether a file name denotes a supported archive
+ */
+bool ArchiveReader::isArchive(const QString &fileName)
+{
+    return fileName.endsWith(QLatin1String(".zip"), Qt::CaseInsensitive)
+        || fileName.endsWith(QLatin1String(".tar.gz"), Qt::CaseInsensitive)
+        || fileName.endsWith(QLatin1String(".tgz"), Qt::CaseInsensitive)
+        || fileName.endsWith(QLatin1String(".tar"), Qt::CaseInsensitive);
+}
+
+/**
+ * @brief File name of an archive without its archive suffix
+ */
+QString ArchiveReader::archiveBaseName(const QString &fileName)
+{
+    QString name = QFileInfo(fileName).fileName();
+    for (const QLatin1String suffix : {QLatin1String(".tar.gz"), QLatin1String(".tgz"),
+                                       QLatin1String(".tar"), QLatin1String(".zip")}) {
+        if (name.endsWith(suffix, Qt::CaseInsensitive)) {
+            name.chop(suffix.size());
+            break;
+        }
+    }
+    return name;
+}
+
+/**
+ * @brief Read the members of an archive
+ * @param archivePath Path of the archive
+ * @param memberPatterns File name wildcards a member must match (empty accepts all)
+ * @param visitor Called once per matching regular member, on the calling thread
+ * @param cancelFlag Optional flag; reading stops when it becomes non-zero
+ * @param pool Pool inflating zip members; nullptr for the global pool
+ * @param maxMemberSize Members larger than this, uncompressed, are skipped
+ * @return False if the archive could not be opened or is malformed
+ */
+bool ArchiveReader::readMembers(const QString &archivePath, const QStringList &memberPatterns,
+                                const MemberVisitor &visitor, const QAtomicInt *cancelFlag, QThreadPool *pool,
+                                qint64 maxMemberSize)
+{
+    if (archivePath.endsWith(QLatin1String(".zip"), Qt::CaseInsensitive)) {
+        return readZip(archivePath, memberPatterns, visitor, cancelFlag, pool, maxMemberSize);
+    }
+    const bool gzipped = !archivePath.endsWith(QLatin1String(".tar"), Qt::CaseInsensitive);
+    return readTar(archivePath, gzipped, memberPatterns, visitor, cancelFlag, maxMemberSize);
+}
+
+/**
+ * @brief Read a zip archive
+ *
+ * The archive is memory-mapped and its central directory parsed; matching
+ * members are then inflated in parallel on the given pool, a few per worker
+ * at a time, and passed to the visitor in directory order. Zip64 archives
+ * are not supported.
+ */
+bool ArchiveReader::readZip(const QString &archivePath, const QStringList &memberPatterns,
+                            const MemberVisitor &visitor, const QAtomicInt *cancelFlag, QThreadPool *pool,
+                            qint64 maxMemberSize)
+{
+    QFile file(archivePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Cannot open archive:" << archivePath;
+        return false;
+    }
+
+    const qint64 size = file.size();
+    QByteArray fallback;
+    const uchar *data = file.map(0, size);
+    if (!data) {
+        fallback = file.readAll();
+        data = reinterpret_cast<const uchar *>(fallback.constData());
+    }
+
+    // Locate the end of central directory record (followed by at most 64 KiB of comment)
+    qint64 eocd = -1;
+    for (qint64 pos = size - 22; pos >= 0 && pos >= size - 22 - 0xFFFF; --pos) {
+        if (readLE32(data + pos) == kZipEndOfCentralDirSignature) {
+            eocd = pos;
+            break;
+        }
+    }
+    if (eocd < 0) {
+        qDebug() << "Not a zip archive:" << archivePath;
+        return false;
+    }
+
+    const quint16 entryCount = readLE16(data + eocd + 10);
+    const quint32 directoryOffset = readLE32(data + eocd + 16);
+    if (entryCount == 0xFFFF || directoryOffset == 0xFFFFFFFF) {
+        qDebug() << "Zip64 archives are not supported:" << archivePath;
+        return false;
+    }
+
+    // Parse the central directory
+    const MemberFilter filter(memberPatterns);
+    QVector<ZipEntry> entries;
+    qint64 pos = directoryOffset;
+    for (quint16 i = 0; i < entryCount; ++i) {
+        if (pos + 46 > size || readLE32(data + pos) != kZipCentralHeaderSignature) {
+            qDebug() << "Corrupt zip central directory:" << archivePath;
+            return false;
+        }
+        ZipEntry entry;
+        entry.flags = readLE16(data + pos + 8);
+        entry.method = readLE16(data + pos + 10);
+        entry.crc = readLE32(data + pos + 16);
+        entry.compressedSize = readLE32(data + pos + 20);
+        entry.uncompressedSize = readLE32(data + pos + 24);
+        const quint16 nameLength = readLE16(data + pos + 28);
+        const quint16 extraLength = readLE16(data + pos + 30);
+        const quint16 commentLength = readLE16(data + pos + 32);
+        entry.localHeaderOffset = readLE32(data + pos + 42);
+        if (pos + 46 + nameLength > size) {
+            return false;
+        }
+        entry.name = QString::fromUtf8(reinterpret_cast<const char *>(data + pos + 46), nameLength);
+        pos += 46 + nameLength + extraLength + commentLength;
+
+        if (entry.name.endsWith(QLatin1Char('/')) || !filter.accepts(entry.name)) {
+            continue;
+        }
+        if (entry.flags & 0x1) {
+            qDebug() << "Skipping encrypted zip member:" << entry.name;
+            continue;
+        }
+        entries.append(entry);
+    }
+
+    // Inflate slices of members in parallel, then hand them over in order
+    const int workers = (pool ? pool : QThreadPool::globalInstance())->maxThreadCount() + 1;
+    const qsizetype sliceSize = std::max(1, workers) * 2;
+    QVector<ZipExtraction> extracted;
+    for (qsizetype first = 0; first < entries.size(); first += sliceSize) {
+        if (cancelFlag && cancelFlag->loadAcquire() != 0) {
+            return true;
+        }
+        const QVector<ZipEntry> slice = entries.mid(first, sliceSize);
+        extracted.fill(ZipExtraction(), slice.size());
+        ZipExtraction *out = extracted.data();
+        WorkerPool::parallelFor(pool, slice.size(), [&](qsizetype begin, qsizetype end) {
+            for (qsizetype i = begin; i < end; ++i) {
+                out[i] = extractZipEntry(data, size, slice.at(i), maxMemberSize);
+            }
+        }, 1);
+
+        for (qsizetype i = 0; i < slice.size(); ++i) {
+            if (!extracted[i].ok) {
+                qDebug() << "Cannot extract zip member:" << slice.at(i).name << "from" << archivePath;
+                continue;
+            }
+            if (!visitor(slice.at(i).name, std::move(extracted[i].content))) {
+                return true;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Read a tar archive, optionally gzip-compressed
+ *
+ * The file is read and inflated in chunks; complete members are cut out of
+ * the decompressed stream and passed on as soon as their last block has
+ * arrived, so only one member (plus one chunk) is held in memory. A member
+ * above the size limit is skipped as its bytes stream past, never buffered,
+ * so a header claiming a huge size cannot make the buffer grow with it.
+ * GNU long names and pax "path" records are honoured.
+ */
+bool ArchiveReader::readTar(const QString &archivePath, bool gzipped, const QStringList &memberPatterns,
+                            const MemberVisitor &visitor, const QAtomicInt *cancelFlag, qint64 maxMemberSize)
+{
+#ifndef TLM_HAVE_ZLIB
+    if (gzipped) {
+        qDebug() << "Built without zlib; cannot read compressed archive:" << archivePath;
+        return false;
+    }
+#endif
+
+    QFile file(archivePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Cannot open archive:" << archivePath;
+        return false;
+    }
+
+    const MemberFilter filter(memberPatterns);
+    QByteArray pending;        // Decompressed bytes not yet consumed
+    qsizetype consumed = 0;    // Offset of the next tar header in pending
+    QString overrideName;      // Name set by a preceding long-name or pax header
+    qint64 skipping = 0;       // Bytes of an oversized member still to be dropped
+    bool finished = false;
+
+    // Consume every complete member in pending; returns false once the walk must stop
+    auto consumeMembers = [&]() -> bool {
+        for (;;) {
+            if (skipping > 0) {
+                const qint64 dropped = std::min<qint64>(skipping, pending.size() - consumed);
+                consumed += dropped;
+                skipping -= dropped;
+                if (skipping > 0) {
+                    break;
+                }
+            }
+            if (pending.size() - consumed < kTarBlockSize) {
+                break;
+            }
+            const char *header = pending.constData() + consumed;
+            if (std::all_of(header, header + kTarBlockSize, [](char c) { return c == '\0'; })) {
+                finished = true; // End-of-archive marker
+                return false;
+            }
+            const qint64 size = parseTarOctal(header + 124, 12);
+            const qint64 padded = (size + kTarBlockSize - 1) / kTarBlockSize * kTarBlockSize;
+            if (size > maxMemberSize) {
+                qDebug() << "Skipping tar member larger than the limit:"
+                         << (overrideName.isEmpty() ? tarHeaderName(header) : overrideName) << size << "bytes";
+                overrideName.clear();
+                consumed += kTarBlockSize;
+                skipping = padded;
+                continue;
+            }
+            if (pending.size() - consumed < kTarBlockSize + padded) {
+                break; // Member not complete yet
+            }
+
+            const char *body = header + kTarBlockSize;
+            const char type = header[156];
+            if (type == 'L') {
+                overrideName = QString::fromUtf8(body, static_cast<qsizetype>(qstrnlen(body, static_cast<size_t>(size))));
+            } else if (type == 'x') {
+                overrideName = paxPath(body, size);
+            } else {
+                const QString name = overrideName.isEmpty() ? tarHeaderName(header) : overrideName;
+                overrideName.clear();
+                if ((type == '0' || type == '\0') && filter.accepts(name)) {
+                    if (!visitor(name, QByteArray(body, size))) {
+                        finished = true;
+                        return false;
+                    }
+                }
+            }
+
+            consumed += kTarBlockSize + padded;
+        }
+        // Drop consumed bytes once they dominate the buffer
+        if (consumed > 0 && consumed >= pending.size() / 2) {
+            pending.remove(0, consumed);
+            consumed = 0;
+        }
+        return true;
+    };
+
+    constexpr qint64 kChunkSize = 256 * 1024;
+    QByteArray input;
+
+#ifdef TLM_HAVE_ZLIB
+    z_stream zs {};
+    if (gzipped && inflateInit2(&zs, MAX_WBITS + 16) != Z_OK) {
+        return false;
+    }
+    QByteArray output(kChunkSize, Qt::Uninitialized);
+#endif
+
+    bool ok = true;
+    while (!finished && !file.atEnd()) {
+        if (cancelFlag && cancelFlag->loadAcquire() != 0) {
+            break;
+        }
+        input = file.read(kChunkSize);
+        if (input.isEmpty()) {
+            break;
+        }
+
+        if (!gzipped) {
+            pending.append(input);
+            if (!consumeMembers()) break;
+            continue;
+        }
+
+#ifdef TLM_HAVE_ZLIB
+        zs.next_in = reinterpret_cast<Bytef *>(input.data());
+        zs.avail_in = static_cast<uInt>(input.size());
+        while (!finished) {
+            zs.next_out = reinterpret_cast<Bytef *>(output.data());
+            zs.avail_out = static_cast<uInt>(output.size());
+            const int ret = inflate(&zs, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+                qDebug() << "Corrupt gzip stream in archive:" << archivePath;
+                ok = false;
+                finished = true;
+                break;
+            }
+            pending.append(output.constData(), output.size() - zs.avail_out);
+            if (!consumeMembers()) {
+                break;
+            }
+            if (ret == Z_STREAM_END) {
+                inflateReset(&zs); // Concatenated gzip members continue in the same file
+            } else if (ret == Z_BUF_ERROR || (zs.avail_in == 0 && zs.avail_out != 0)) {
+                break; // Input exhausted and no output held back by zlib
+            }
+            if (zs.avail_in == 0 && ret == Z_STREAM_END) {
+                break;
+            }
+        }
+#endif
+    }
+
+#ifdef TLM_HAVE_ZLIB
+    if (gzipped) {
+        inflateEnd(&zs);
+    }
+#endif
+    return ok;
+}
@@ -0,0 +1,254 @@
+#include "include/batchfilereader.h"
+#include <QFile>
+#include <QDebug>
+#include <algorithm>
+
+#ifdef TLM_HAVE_IO_URING
+#include <liburing.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdint>
+#include <vector>
+#endif
+
+/**
+ * @brief Constructor
+ * @param queueDepth Maximum number of files submitted at once
+ * @param preferredBackend Backend to try first; Portable forces the fallback
+ *
+ * Sets up the io_uring when available and requested. Any failure here is
+ * not an error: the reader silently uses the portable backend instead.
+ */
+BatchFileReader::BatchFileReader(int queueDepth, Backend preferredBackend)
+    : m_queueDepth(std::clamp(queueDepth, 1, 4096)), m_backend(Backend::Portable)
+{
+#ifdef TLM_HAVE_IO_URING
+    if (preferredBackend == Backend::IoUring) {
+        auto *ring = new io_uring;
+        const int ret = io_uring_queue_init(static_cast<unsigned>(m_queueDepth), ring, 0);
+        if (ret == 0) {
+            m_ring = ring;
+            m_backend = Backend::IoUring;
+        } else {
+            qDebug() << "io_uring unavailable (error" << -ret << "); using portable file reads";
+            delete ring;
+        }
+    }
+#else
+    Q_UNUSED(preferredBackend);
+#endif
+}
+
+BatchFileReader::~BatchFileReader()
+{
+#ifdef TLM_HAVE_IO_URING
+    if (m_ring) {
+        auto *ring = static_cast<io_uring *>(m_ring);
+        io_uring_queue_exit(ring);
+        delete ring;
+    }
+#endif
+}
+
+/**
+ * @brief Human-readable name of a backend
+ */
+const char *BatchFileReader::backendName(Backend backend)
+{
+    switch (backend) {
+        case Backend::IoUring: return "io_uring";
+        case Backend::Portable: return "portable";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Read a list of files
+ * @param paths Paths of the files to read
+ * @return One result per path, in the same order
+ */
+QVector<BatchFileReader::Result> BatchFileReader::readFiles(const QStringList &paths)
+{
+    QVector<Result> results(paths.size());
+    for (qsizetype first = 0; first < paths.size(); first += m_queueDepth) {
+        const qsizetype count = std::min<qsizetype>(m_queueDepth, paths.size() - first);
+#ifdef TLM_HAVE_IO_URING
+        if (m_backend == Backend::IoUring) {
+            if (readIoUring(paths, first, count, results)) {
+                continue;
+            }
+            // The ring is in an unknown state; stay on the portable path from now on
+            qDebug() << "io_uring batch failed; falling back to portable file reads";
+            auto *ring = static_cast<io_uring *>(m_ring);
+            io_uring_queue_exit(ring);
+            delete ring;
+            m_ring = nullptr;
+            m_backend = Backend::Portable;
+        }
+#endif
+        readPortable(paths, first, count, results);
+    }
+    return results;
+}
+
+/**
+ * @brief Read files one at a time with QFile
+ */
+void BatchFileReader::readPortable(const QStringList &paths, qsizetype first, qsizetype count,
+                                   QVector<Result> &results)
+{
+    for (qsizetype i = first; i < first + count; ++i) {
+        Result &result = results[i];
+        if (result.ok) {
+            continue; // Already completed by a partially successful io_uring batch
+        }
+        QFile file(paths.at(i));
+        if (file.open(QIODevice::ReadOnly)) {
+            result.content = file.readAll();
+            result.ok = true;
+        } else {
+            qDebug() << "Cannot open file:" << paths.at(i);
+        }
+    }
+}
+
+#ifdef TLM_HAVE_IO_URING
+/**
+ * @brief Read a batch of files through io_uring
+ * @return False if the ring itself failed; per-file errors are reported in
+ *         the results instead
+ *
+ * Three phases, each a single submit-and-wait: open every file, read every
+ * opened file into a buffer large enough for a typical sweep, close every
+ * descriptor. The rare file that fills its buffer is finished with plain
+ * read() calls before it is closed.
+ */
+bool BatchFileReader::readIoUring(const QStringList &paths, qsizetype first, qsizetype count,
+                                  QVector<Result> &results)
+{
+    constexpr unsigned kInitialBufferSize = 64 * 1024;
+    auto *ring = static_cast<io_uring *>(m_ring);
+
+    // Submit the queued entries and collect exactly `expected` completions
+    auto submitAndReap = [ring](unsigned expected, auto &&onCompletion) -> bool {
+        if (expected == 0) {
+            return true;
+        }
+        if (io_uring_submit_and_wait(ring, expected) < 0) {
+            return false;
+        }
+        for (unsigned reaped = 0; reaped < expected; ++reaped) {
+            io_uring_cqe *cqe = nullptr;
+            if (io_uring_wait_cqe(ring, &cqe) < 0) {
+                return false;
+            }
+            onCompletion(static_cast<qsizetype>(reinterpret_cast<std::uintptr_t>(io_uring_cqe_get_data(cqe))), cqe->res);
+            io_uring_cqe_seen(ring, cqe);
+        }
+        return true;
+    };
+
+    std::vector<QByteArray> encodedPaths(static_cast<size_t>(count));
+    std::vector<int> fds(static_cast<size_t>(count), -1);
+    std::vector<int> bytesRead(static_cast<size_t>(count), -1);
+
+    auto closeAll = [&]() {
+        unsigned queued = 0;
+        for (qsizetype i = 0; i < count; ++i) {
+            if (fds[i] < 0) {
+                continue;
+            }
+            io_uring_sqe *sqe = io_uring_get_sqe(ring);
+            if (!sqe) {
+                ::close(fds[i]);
+            } else {
+                io_uring_prep_close(sqe, fds[i]);
+                io_uring_sqe_set_data(sqe, reinterpret_cast<void *>(static_cast<std::uintptr_t>(i)));
+                ++queued;
+            }
+            fds[i] = -1;
+        }
+        return submitAndReap(queued, [](qsizetype, int) {});
+    };
+
+    // Phase 1: open
+    unsigned queued = 0;
+    for (qsizetype i = 0; i < count; ++i) {
+        encodedPaths[i] = QFile::encodeName(paths.at(first + i));
+        io_uring_sqe *sqe = io_uring_get_sqe(ring);
+        if (!sqe) {
+            break; // Remaining files are picked up by the portable path
+        }
+        io_uring_prep_openat(sqe, AT_FDCWD, encodedPaths[i].constData(), O_RDONLY | O_CLOEXEC, 0);
+        io_uring_sqe_set_data(sqe, reinterpret_cast<void *>(static_cast<std::uintptr_t>(i)));
+        ++queued;
+    }
+    if (!submitAndReap(queued, [&](qsizetype i, int res) { fds[i] = res; })) {
+        for (int fd : fds) {
+            if (fd >= 0) ::close(fd);
+        }
+        return false;
+    }
+
+    // Phase 2: read
+    queued = 0;
+    for (qsizetype i = 0; i < count; ++i) {
+        if (fds[i] < 0) {
+            continue;
+        }
+        QByteArray &buffer = results[first + i].content;
+        buffer.resize(kInitialBufferSize);
+        io_uring_sqe *sqe = io_uring_get_sqe(ring);
+        if (!sqe) {
+            break;
+        }
+        io_uring_prep_read(sqe, fds[i], buffer.data(), kInitialBufferSize, 0);
+        io_uring_sqe_set_data(sqe, reinterpret_cast<void *>(static_cast<std::uintptr_t>(i)));
+        ++queued;
+    }
+    if (!submitAndReap(queued, [&](qsizetype i, int res) { bytesRead[i] = res; })) {
+        for (int fd : fds) {
+            if (fd >= 0) ::close(fd);
+        }
+        return false;
+    }
+
+    for (qsizetype i = 0; i < count; ++i) {
+        Result &result = results[first + i];
+        if (fds[i] < 0 || bytesRead[i] < 0) {
+            result.content.clear();
+            continue; // Left for the portable path, which also reports the error
+        }
+        qsizetype size = bytesRead[i];
+        bool failed = false;
+        // Buffer filled completely: the file is larger than a typical sweep
+        while (size == result.content.size()) {
+            result.content.resize(size * 2);
+            const ssize_t n = ::pread(fds[i], result.content.data() + size,
+                                      static_cast<size_t>(result.content.size() - size), size);
+            if (n < 0 && errno == EINTR) {
+                result.content.resize(size);   // Retry the same range
+                continue;
+            }
+            if (n < 0) {
+                failed = true;
+                break;
+            }
+            if (n == 0) {
+                break;
+            }
+            size += n;
+        }
+        if (failed) {
+            result.content.clear();
+            continue; // Left for the portable path, which also reports the error
+        }
+        result.content.resize(size);
+        result.ok = true;
+    }
+
+    // Phase 3: close
+    return closeAll();
+}
+#endif
@@ -0,0 +1,314 @@
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QQmlApplicationEngine>
+#include <QQuickStyle>
+#include <QQuickWindow>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <QtQml/qqmlextensionplugin.h>
+#include <algorithm>
+#include "appconfig.h"
+#include "batchfilereader.h"
+#include "calculator.h"
+#include "csvprocessor.h"
+#include "datamanager.h"
+#include "ingestpipeline.h"
+#include "plotrenderer.h"
+#include "qmltypes.h"
+#include "resultexporter.h"
+
+Q_IMPORT_QML_PLUGIN(TLMAnalyzerPlugin)
+
+/**
+ * @brief Throughput benchmarks for the ingest path
+ *
+ * Generates (or reuses) a folder of small Keithley-style sweep files and
+ * times each way of getting them into DataPoints, from one-file-at-a-time
+ * CSVProcessor::processFile up to the full staged pipeline. Run the
+ * io_uring and portable cases under `strace -c -f` to compare system call
+ * counts. A startup report times the steps between entering main() and the
+ * first frame of the main window, as the application performs them.
+ */
+
+namespace {
+
+struct CaseResult {
+    QString name;
+    qsizetype files = 0;
+    double milliseconds = 0.0;
+};
+
+/**
+ * @brief Build the contents of a synthetic linear sweep file
+ * @param resistance Device resistance in Ω
+ * @return CSV text in the Keithley export layout used by test_data/
+ */
+QByteArray makeSweepCsv(double resistance)
+{
+    QByteArray csv;
+    csv += "[ DATA ]\n";
+    csv += "Name,Bias_SMU,,,Sweep_SMU,,\n";
+    csv += ",Timestamp,Source Value,Reading,Timestamp,Source Value,Reading\n";
+    csv += ",(seconds),(Volts),(Amps),(seconds),(Volts),(Amps)\n";
+    for (int step = 0; step <= 20; ++step) {
+        const double volts = -1.0 + 0.1 * step;
+        const double amps = volts / resistance + 6.0e-5;
+        csv += QByteArray::number(step + 1) + ",,,," + QByteArray::number(0.01 * step) + ","
+             + QByteArray::number(volts, 'f', 1) + "," + QByteArray::number(amps, 'g', 10) + "\n";
+    }
+    return csv;
+}
+
+bool generateCorpus(const QString &folder, int fileCount)
+{
+    static const double spacings[] = {2, 4, 8, 14, 22, 32, 44};
+    for (int i = 0; i < fileCount; ++i) {
+        const double spacing = spacings[i % 7];
+        QFile file(QDir(folder).filePath(QString("%1_%2.csv").arg(spacing).arg(i)));
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        file.write(makeSweepCsv(20.0 + 0.8 * spacing));
+    }
+    return true;
+}
+
+QStringList listCsvFiles(const QString &folder)
+{
+    QStringList paths;
+    QDirIterator it(folder, {QStringLiteral("*.csv")}, QDir::Files);
+    while (it.hasNext()) {
+        paths.append(it.next());
+    }
+    return paths;
+}
+
+template <typename Body>
+CaseResult timeCase(const QString &name, int repeat, Body body)
+{
+    CaseResult result;
+    result.name = name;
+    double best = -1.0;
+    for (int r = 0; r < repeat; ++r) {
+        QElapsedTimer timer;
+        timer.start();
+        result.files = body();
+        const double elapsed = timer.nsecsElapsed() / 1.0e6;
+        if (best < 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    result.milliseconds = best;
+    return result;
+}
+
+/**
+ * @brief One step of the startup sequence
+ */
+struct StartupPhase {
+    QString name;
+    double milliseconds = -1.0; ///< Negative if the step did not complete
+};
+
+/**
+ * @brief Time the application's startup sequence on the offscreen platform
+ * @return Phases in the order they complete; times are cumulative from the start
+ *
+ * Mirrors main(): the DataManager is created (starting its background
+ * configuration load) and the compiled MainUI module is loaded. The first
+ * swapped frame marks the end of startup. The configuration load is timed
+ * separately since it no longer blocks the first frame.
+ */
+QVector<StartupPhase> measureStartup()
+{
+    QVector<StartupPhase> phases;
+    QElapsedTimer timer;
+    timer.start();
+
+    QQuickStyle::setStyle(QStringLiteral("Material"));
+    QQmlApplicationEngine engine;
+    phases.append({QStringLiteral("engine created"), timer.nsecsElapsed() / 1.0e6});
+
+    auto *dm = new DataManager(&engine);
+    DataManagerForeign::s_instance = dm;
+    phases.append({QStringLiteral("DataManager created"), timer.nsecsElapsed() / 1.0e6});
+
+    StartupPhase configPhase{QStringLiteral("config loaded (background)")};
+    QObject::connect(dm, &DataManager::configLoaded, [&]() {
+        configPhase.milliseconds = timer.nsecsElapsed() / 1.0e6;
+    });
+
+    engine.loadFromModule("TLMAnalyzer", "MainUI");
+    phases.append({QStringLiteral("MainUI created"), timer.nsecsElapsed() / 1.0e6});
+
+    StartupPhase framePhase{QStringLiteral("first frame")};
+    auto *window = engine.rootObjects().isEmpty() ? nullptr : qobject_cast<QQuickWindow *>(engine.rootObjects().first());
+    if (window) {
+        QEventLoop loop;
+        QObject::connect(window, &QQuickWindow::frameSwapped, &loop, [&]() {
+            if (framePhase.milliseconds < 0) {
+                framePhase.milliseconds = timer.nsecsElapsed() / 1.0e6;
+            }
+            loop.quit();
+        });
+        QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+    phases.append(framePhase);
+
+    // Let a slow configuration load finish so its time is reported
+    for (int waited = 0; configPhase.milliseconds < 0 && waited < 100; ++waited) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
+    }
+    phases.append(configPhase);
+
+    DataManagerForeign::s_instance = nullptr;
+    return phases;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // Plot rendering needs fonts but no window system
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("TLM_Benchmark"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("TLM Analyzer ingest benchmarks"));
+    parser.addHelpOption();
+    QCommandLineOption filesOption(QStringLiteral("files"), QStringLiteral("Number of files to generate."),
+                                   QStringLiteral("count"), QStringLiteral("5000"));
+    QCommandLineOption dirOption(QStringLiteral("dir"), QStringLiteral("Use an existing folder instead of a generated corpus."),
+                                 QStringLiteral("path"));
+    QCommandLineOption repeatOption(QStringLiteral("repeat"), QStringLiteral("Repetitions per case (best time is reported)."),
+                                    QStringLiteral("n"), QStringLiteral("3"));
+    parser.addOption(filesOption);
+    parser.addOption(dirOption);
+    parser.addOption(repeatOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    const int repeat = std::max(1, parser.value(repeatOption).toInt());
+
+    // First, while caches are as cold as they get inside one process
+    const QVector<StartupPhase> startup = measureStartup();
+
+    QTemporaryDir tempDir;
+    QString folder = parser.value(dirOption);
+    if (folder.isEmpty()) {
+        if (!tempDir.isValid() || !generateCorpus(tempDir.path(), parser.value(filesOption).toInt())) {
+            out << "Failed to generate benchmark corpus\n";
+            return 1;
+        }
+        folder = tempDir.path();
+    }
+
+    // Lives in the TLM_Benchmark config location, separate from the application's
+    AppConfig config(QStringLiteral("bench_config.json"));
+    const QStringList paths = listCsvFiles(folder);
+
+    QVector<CaseResult> results;
+
+    results.append(timeCase(QStringLiteral("processFile (sequential)"), repeat, [&]() {
+        qsizetype valid = 0;
+        for (const QString &path : paths) {
+            if (CSVProcessor::processFile(path, config).resistance > 0) ++valid;
+        }
+        return valid;
+    }));
+
+    results.append(timeCase(QStringLiteral("BatchFileReader portable"), repeat, [&]() {
+        BatchFileReader reader(256, BatchFileReader::Backend::Portable);
+        return reader.readFiles(paths).size();
+    }));
+
+    BatchFileReader probe(256, BatchFileReader::Backend::IoUring);
+    if (probe.backend() == BatchFileReader::Backend::IoUring) {
+        results.append(timeCase(QStringLiteral("BatchFileReader io_uring"), repeat, [&]() {
+            BatchFileReader reader(256, BatchFileReader::Backend::IoUring);
+            return reader.readFiles(paths).size();
+        }));
+    } else {
+        out << "io_uring backend not available in this build or kernel; skipping\n";
+    }
+
+    results.append(timeCase(QStringLiteral("IngestPipeline"), repeat, [&]() {
+        IngestPipeline pipeline(config, IngestOptions::fromConfig(config));
+        return pipeline.run(folder).size();
+    }));
+
+    // Per-structure fits of the loaded points with each specialised model
+    IngestPipeline loader(config, IngestOptions::fromConfig(config));
+    const QVector<DataPoint> points = loader.run(folder);
+    Calculator::FitGeometry geometry;
+    for (Calculator::FitModel model : {Calculator::FitModel::LinearTLM, Calculator::FitModel::CircularTLM,
+                                       Calculator::FitModel::EndResistance}) {
+        results.append(timeCase(QStringLiteral("fit ") + Calculator::fitModelName(model), repeat, [&]() {
+            qsizetype fitted = 0;
+            for (int pass = 0; pass < 100; ++pass) {
+                QMap<QString, Calculator::TLMResult> fits;
+                DataManager::calculateStructureResults(points, fits, model, geometry);
+                fitted += points.size();
+            }
+            return fitted;
+        }));
+    }
+
+    // Export of a lot-sized point table (the loaded points repeated to 1M rows)
+    QVector<DataPoint> lot;
+    lot.reserve(1000000);
+    while (!points.isEmpty() && lot.size() < 1000000) {
+        lot += points;
+    }
+    QTemporaryDir exportDir;
+    for (ResultExporter::Format format : {ResultExporter::Format::Csv, ResultExporter::Format::Columnar}) {
+        ResultExporter::Options options;
+        options.format = format;
+        const QString base = QDir(exportDir.path()).filePath(QStringLiteral("lot"));
+        results.append(timeCase(QStringLiteral("export ") + ResultExporter::suffix(format), repeat, [&]() {
+            return ResultExporter::writePoints(lot, base + ResultExporter::suffix(format), options) ? lot.size() : 0;
+        }));
+    }
+
+    // One plot per structure for 1000 seven-point structures
+    QVector<DataPoint> wafer;
+    for (int structure = 0; structure < 1000 && !points.isEmpty(); ++structure) {
+        for (int i = 0; i < 7; ++i) {
+            DataPoint point = points.at((structure * 7 + i) % points.size());
+            point.structure = QStringLiteral("die%1").arg(structure, 4, 10, QLatin1Char('0'));
+            wafer.append(point);
+        }
+    }
+    QTemporaryDir plotDir;
+    for (PlotRenderer::Format format : {PlotRenderer::Format::Png, PlotRenderer::Format::Svg}) {
+        results.append(timeCase(QStringLiteral("plots ") + PlotRenderer::suffix(format), repeat, [&]() {
+            return PlotRenderer::renderStructures(wafer, Calculator::FitModel::LinearTLM, Calculator::FitGeometry(),
+                                                  plotDir.path(), QString(), format);
+        }));
+    }
+
+    out << QString("%1 %2 %3 %4\n").arg(QStringLiteral("case"), -28).arg(QStringLiteral("files"), 8)
+               .arg(QStringLiteral("ms"), 10).arg(QStringLiteral("files/s"), 12);
+    for (const CaseResult &r : results) {
+        const double rate = r.milliseconds > 0 ? r.files / (r.milliseconds / 1000.0) : 0.0;
+        out << QString("%1 %2 %3 %4\n").arg(r.name, -28).arg(r.files, 8)
+                   .arg(r.milliseconds, 10, 'f', 2).arg(rate, 12, 'f', 0);
+    }
+
+    out << "\n" << QString("%1 %2\n").arg(QStringLiteral("startup"), -28).arg(QStringLiteral("ms"), 10);
+    for (const StartupPhase &phase : startup) {
+        out << QString("%1 %2\n").arg(phase.name, -28)
+                   .arg(phase.milliseconds < 0 ? QStringLiteral("n/a") : QString::number(phase.milliseconds, 'f', 2), 10);
+    }
+    return 0;
+}
@@ -0,0 +1,509 @@
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QMetaMethod>
+#include <QMetaProperty>
+#include <QPointer>
+#include <QQmlApplicationEngine>
+#include <QQuickItem>
+#include <QQuickStyle>
+#include <QQuickWindow>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <QtQml/qqmlextensionplugin.h>
+#include <algorithm>
+#include <cmath>
+#include "datamanager.h"
+#include "qmltypes.h"
+#include "testcorpus.h"
+
+Q_IMPORT_QML_PLUGIN(TLMAnalyzerPlugin)
+
+/**
+ * @brief Frame-time benchmarks for MainUI at growing point counts
+ *
+ * Loads the compiled MainUI offscreen, once per point count, and drives it
+ * through scripted scenarios the way an engineer would: load a folder,
+ * toggle points, scroll the point list and re-run the analysis. Every
+ * scenario reports the intervals between swapped frames, the time the
+ * scene graph spent synchronising and rendering each frame, how late a 1 ms
+ * probe timer fired on the GUI thread (a stall percentile), the number of
+ * property notifications (each re-evaluates the bindings that depend on the
+ * property) and the number of plot repaints.
+ */
+
+namespace {
+
+/**
+ * @brief Measurements of one scenario
+ */
+struct ScenarioResult {
+    QString name;
+    int points = 0;
+    int steps = 0;
+    double wallMs = 0.0;
+    QVector<double> frameIntervals;    ///< ms between consecutive swapped frames
+    QVector<double> frameTimes;        ///< ms from synchronising to swapping a frame
+    QVector<double> stalls;            ///< ms the probe timer fired late
+    qint64 notifications = 0;
+    QHash<QByteArray, qint64> notificationsBySignal;
+    int canvasPaints = 0;
+};
+
+/**
+ * @brief Nearest-rank percentile
+ * @return 0 for no values
+ */
+double percentile(QVector<double> values, double p)
+{
+    if (values.isEmpty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const qsizetype rank = static_cast<qsizetype>(std::ceil(p / 100.0 * values.size()));
+    return values.at(std::clamp<qsizetype>(rank - 1, 0, values.size() - 1));
+}
+
+/**
+ * @brief Collects frame times, GUI-thread stalls and notifications of one window
+ *
+ * Notifications are counted through the notify signal of every property of
+ * every object in the scene when a scenario starts, plus DataManager and
+ * its model. Qt offers no public count of binding evaluations; every
+ * notification re-evaluates the bindings that read the property, so the
+ * count (and which signals dominate it) tracks binding work closely.
+ * Delegates created during a scenario are only watched from the next one.
+ */
+class Probe : public QObject {
+    Q_OBJECT
+
+public:
+    explicit Probe(QQuickWindow *window, QObject *parent = nullptr)
+        : QObject(parent), m_window(window)
+    {
+        // The basic render loop renders on the GUI thread, so these fire there too
+        connect(window, &QQuickWindow::beforeSynchronizing, this, [this]() {
+            m_frameTimer.start();
+        }, Qt::DirectConnection);
+        connect(window, &QQuickWindow::frameSwapped, this, [this]() {
+            const qint64 now = m_clock.nsecsElapsed();
+            if (m_active) {
+                if (m_lastFrame >= 0) {
+                    m_result.frameIntervals.append((now - m_lastFrame) / 1.0e6);
+                }
+                if (m_frameTimer.isValid()) {
+                    m_result.frameTimes.append(m_frameTimer.nsecsElapsed() / 1.0e6);
+                }
+            }
+            m_lastFrame = now;
+            m_frameTimer.invalidate();
+        }, Qt::DirectConnection);
+
+        m_stallTimer.setTimerType(Qt::PreciseTimer);
+        m_stallTimer.setInterval(1);
+        connect(&m_stallTimer, &QTimer::timeout, this, [this]() {
+            const qint64 now = m_clock.nsecsElapsed();
+            if (m_lastTick >= 0) {
+                m_result.stalls.append(std::max(0.0, (now - m_lastTick) / 1.0e6 - 1.0));
+            }
+            m_lastTick = now;
+        });
+        m_clock.start();
+    }
+
+    /**
+     * @brief Also count the notifications of an object outside the scene
+     */
+    void watchObject(QObject *object)
+    {
+        m_extraObjects.append(object);
+    }
+
+    /**
+     * @brief Start measuring a scenario
+     */
+    void begin(const QString &name, int points)
+    {
+        m_result = ScenarioResult();
+        m_result.name = name;
+        m_result.points = points;
+
+        QSet<QObject *> visited;
+        watchTree(m_window, visited);
+        watchTree(m_window->contentItem(), visited);
+        for (const QPointer<QObject> &object : std::as_const(m_extraObjects)) {
+            if (object) watchTree(object, visited);
+        }
+
+        m_lastFrame = -1;
+        m_lastTick = -1;
+        m_active = true;
+        m_wall.start();
+        m_stallTimer.start();
+    }
+
+    /**
+     * @brief Stop measuring and return the scenario's results
+     */
+    ScenarioResult end(int steps)
+    {
+        m_stallTimer.stop();
+        m_active = false;
+        m_result.steps = steps;
+        m_result.wallMs = m_wall.nsecsElapsed() / 1.0e6;
+        return m_result;
+    }
+
+public slots:
+    void countNotification()
+    {
+        if (!m_active) {
+            return;
+        }
+        const QObject *object = sender();
+        const QMetaMethod signal = object->metaObject()->method(senderSignalIndex());
+        ++m_result.notifications;
+        ++m_result.notificationsBySignal[QByteArray(object->metaObject()->className()) + "::" + signal.name()];
+    }
+
+    void countPaint()
+    {
+        if (m_active) ++m_result.canvasPaints;
+    }
+
+private:
+    void watchTree(QObject *object, QSet<QObject *> &visited)
+    {
+        if (!object || visited.contains(object)) {
+            return;
+        }
+        visited.insert(object);
+        watch(object);
+        for (QObject *child : object->children()) {
+            watchTree(child, visited);
+        }
+        if (auto *item = qobject_cast<QQuickItem *>(object)) {
+            for (QQuickItem *child : item->childItems()) {
+                watchTree(child, visited);
+            }
+        }
+    }
+
+    void watch(QObject *object)
+    {
+        static const QMetaMethod countSlot = staticMetaObject.method(staticMetaObject.indexOfSlot("countNotification()"));
+        static const QMetaMethod paintSlot = staticMetaObject.method(staticMetaObject.indexOfSlot("countPaint()"));
+        const QMetaObject *meta = object->metaObject();
+        for (int i = 0; i < meta->propertyCount(); ++i) {
+            const QMetaProperty property = meta->property(i);
+            if (property.hasNotifySignal()) {
+                connect(object, property.notifySignal(), this, countSlot, Qt::UniqueConnection);
+            }
+        }
+        if (object->inherits("QQuickCanvasItem")) {
+            const int paint = meta->indexOfSignal("paint(QRect)");
+            if (paint >= 0) {
+                connect(object, meta->method(paint), this, paintSlot, Qt::UniqueConnection);
+            }
+        }
+    }
+
+    QQuickWindow *m_window;
+    QVector<QPointer<QObject>> m_extraObjects;
+    QElapsedTimer m_clock;
+    QElapsedTimer m_wall;
+    QElapsedTimer m_frameTimer;
+    QTimer m_stallTimer;
+    qint64 m_lastFrame = -1;
+    qint64 m_lastTick = -1;
+    bool m_active = false;
+    ScenarioResult m_result;
+};
+
+/**
+ * @brief Process events until the window swaps a frame
+ * @return False if no frame came within the timeout
+ */
+bool waitForFrame(QQuickWindow *window, int timeoutMs)
+{
+    QEventLoop loop;
+    bool swapped = false;
+    QObject::connect(window, &QQuickWindow::frameSwapped, &loop, [&]() {
+        swapped = true;
+        loop.quit();
+    });
+    QTimer::singleShot(timeoutMs, &loop, &QEventLoop::quit);
+    loop.exec();
+    return swapped;
+}
+
+/**
+ * @brief Process events until no frame has been swapped for a while
+ *
+ * Lets the plot animations that follow every data change run to the end.
+ */
+void settle(QQuickWindow *window, int quietMs = 250, int capMs = 10000)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < capMs && waitForFrame(window, quietMs)) {
+    }
+}
+
+/**
+ * @brief Process events until a signal arrives
+ * @return False on timeout
+ */
+template <typename Sender, typename Signal>
+bool waitForSignal(const Sender *sender, Signal signal, int timeoutMs)
+{
+    QEventLoop loop;
+    bool arrived = false;
+    QObject::connect(sender, signal, &loop, [&]() {
+        arrived = true;
+        loop.quit();
+    });
+    QTimer::singleShot(timeoutMs, &loop, &QEventLoop::quit);
+    loop.exec();
+    return arrived;
+}
+
+/**
+ * @brief First item in a tree that inherits a class
+ */
+QQuickItem *findItem(QQuickItem *root, const char *className)
+{
+    if (!root) {
+        return nullptr;
+    }
+    if (root->inherits(className)) {
+        return root;
+    }
+    for (QQuickItem *child : root->childItems()) {
+        if (QQuickItem *found = findItem(child, className)) {
+            return found;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Run every scenario against a fresh MainUI loaded with one corpus
+ * @param folder Folder of generated sweep files
+ * @param points Number of files in the folder
+ * @param toggles Points toggled in the toggle scenario
+ * @param scrolls Scroll steps in the scroll scenario
+ * @param analyses Runs in the re-analysis scenario
+ */
+QVector<ScenarioResult> runScenarios(const QString &folder, int points, int toggles, int scrolls, int analyses)
+{
+    QVector<ScenarioResult> results;
+    QQmlApplicationEngine engine;
+    auto *dm = new DataManager(&engine);
+    DataManagerForeign::s_instance = dm;
+    engine.loadFromModule("TLMAnalyzer", "MainUI");
+    auto *window = engine.rootObjects().isEmpty() ? nullptr : qobject_cast<QQuickWindow *>(engine.rootObjects().first());
+    if (!window) {
+        DataManagerForeign::s_instance = nullptr;
+        return results;
+    }
+    waitForFrame(window, 10000);
+    if (!dm->isConfigLoaded()) {
+        waitForSignal(dm, &DataManager::configLoaded, 5000);
+    }
+    settle(window);
+
+    Probe probe(window);
+    probe.watchObject(dm);
+    probe.watchObject(dm->model());
+
+    // Load; the UI starts the analysis itself once the load completes
+    probe.begin(QStringLiteral("load"), points);
+    dm->c_loadDataFromFolder(folder, 1.0);
+    waitForSignal(dm, &DataManager::analysisComplete, 600000);
+    settle(window);
+    results.append(probe.end(1));
+    const int loaded = static_cast<int>(dm->getDataPoints().size());
+
+    // Toggle points spread over the collection, one edit per frame
+    probe.begin(QStringLiteral("toggle"), loaded);
+    int toggled = 0;
+    for (int i = 0; i < toggles && loaded > 0; ++i, ++toggled) {
+        const int index = static_cast<int>((static_cast<qint64>(i) * 7919) % loaded);
+        dm->c_setDataPointEnabled(index, !dm->getDataPoints().at(index).enabled);
+        waitForFrame(window, 1000);
+    }
+    settle(window);
+    results.append(probe.end(toggled));
+
+    // Scroll the point list half a page per frame
+    QQuickItem *list = findItem(window->contentItem(), "QQuickListView");
+    probe.begin(QStringLiteral("scroll"), loaded);
+    int scrolled = 0;
+    if (list) {
+        const double page = std::max(1.0, list->height() / 2.0);
+        for (; scrolled < scrolls; ++scrolled) {
+            const double limit = std::max(0.0, list->property("contentHeight").toDouble() - list->height());
+            const double next = list->property("contentY").toDouble() + page;
+            list->setProperty("contentY", next > limit ? 0.0 : next);
+            waitForFrame(window, 1000);
+        }
+    }
+    settle(window);
+    results.append(probe.end(scrolled));
+
+    // Re-run the analysis and wait for the refreshed result
+    probe.begin(QStringLiteral("re-analyze"), loaded);
+    for (int i = 0; i < analyses; ++i) {
+        dm->c_performAnalysis(dm->getChannelWidth());
+        waitForSignal(dm, &DataManager::analysisComplete, 600000);
+        waitForFrame(window, 1000);
+    }
+    settle(window);
+    results.append(probe.end(analyses));
+
+    DataManagerForeign::s_instance = nullptr;
+    return results;
+}
+
+QJsonObject resultToJson(const ScenarioResult &r)
+{
+    auto stats = [](const QVector<double> &values) {
+        QJsonObject object;
+        object[QStringLiteral("count")] = values.size();
+        object[QStringLiteral("p50")] = percentile(values, 50);
+        object[QStringLiteral("p95")] = percentile(values, 95);
+        object[QStringLiteral("p99")] = percentile(values, 99);
+        object[QStringLiteral("max")] = values.isEmpty() ? 0.0 : *std::max_element(values.cbegin(), values.cend());
+        return object;
+    };
+
+    // The ten signals that caused the most notifications
+    QVector<QPair<QByteArray, qint64>> signalCounts;
+    for (auto it = r.notificationsBySignal.cbegin(); it != r.notificationsBySignal.cend(); ++it) {
+        signalCounts.append({it.key(), it.value()});
+    }
+    std::sort(signalCounts.begin(), signalCounts.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+    QJsonArray topSignals;
+    for (qsizetype i = 0; i < std::min<qsizetype>(10, signalCounts.size()); ++i) {
+        topSignals.append(QJsonObject {{QStringLiteral("signal"), QString::fromLatin1(signalCounts.at(i).first)},
+                                       {QStringLiteral("count"), signalCounts.at(i).second}});
+    }
+
+    QJsonObject object;
+    object[QStringLiteral("scenario")] = r.name;
+    object[QStringLiteral("points")] = r.points;
+    object[QStringLiteral("steps")] = r.steps;
+    object[QStringLiteral("wallMs")] = r.wallMs;
+    object[QStringLiteral("frameIntervalMs")] = stats(r.frameIntervals);
+    object[QStringLiteral("frameTimeMs")] = stats(r.frameTimes);
+    object[QStringLiteral("stallMs")] = stats(r.stalls);
+    object[QStringLiteral("notifications")] = r.notifications;
+    object[QStringLiteral("topNotifications")] = topSignals;
+    object[QStringLiteral("canvasPaints")] = r.canvasPaints;
+    return object;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // Render offscreen, on the GUI thread, so frame times include every stall
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    if (!qEnvironmentVariableIsSet("QSG_RENDER_LOOP")) {
+        qputenv("QSG_RENDER_LOOP", "basic");
+    }
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("TLM_UiBenchmark"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("TLM Analyzer UI frame-time benchmarks"));
+    parser.addHelpOption();
+    QCommandLineOption pointsOption(QStringLiteral("points"), QStringLiteral("Comma-separated point counts to load."),
+                                    QStringLiteral("list"), QStringLiteral("1000,10000"));
+    QCommandLineOption togglesOption(QStringLiteral("toggles"), QStringLiteral("Points toggled per run."),
+                                     QStringLiteral("n"), QStringLiteral("50"));
+    QCommandLineOption scrollsOption(QStringLiteral("scrolls"), QStringLiteral("Half-page scroll steps per run."),
+                                     QStringLiteral("n"), QStringLiteral("100"));
+    QCommandLineOption analysesOption(QStringLiteral("analyses"), QStringLiteral("Analyses per run."),
+                                      QStringLiteral("n"), QStringLiteral("10"));
+    QCommandLineOption jsonOption(QStringLiteral("json"), QStringLiteral("Also write the full report to a JSON file."),
+                                  QStringLiteral("path"));
+    QCommandLineOption logOption(QStringLiteral("log"), QStringLiteral("Keep debug and QML console output."));
+    parser.addOption(pointsOption);
+    parser.addOption(togglesOption);
+    parser.addOption(scrollsOption);
+    parser.addOption(analysesOption);
+    parser.addOption(jsonOption);
+    parser.addOption(logOption);
+    parser.process(app);
+
+    // Logging on every data change would dominate the GUI thread
+    if (!parser.isSet(logOption)) {
+        QLoggingCategory::setFilterRules(QStringLiteral("*.debug=false\nqml.info=false\njs.info=false"));
+    }
+
+    QQuickStyle::setStyle(QStringLiteral("Material"));
+    QTextStream out(stdout);
+    const int toggles = std::max(0, parser.value(togglesOption).toInt());
+    const int scrolls = std::max(0, parser.value(scrollsOption).toInt());
+    const int analyses = std::max(0, parser.value(analysesOption).toInt());
+
+    QVector<ScenarioResult> results;
+    const QStringList counts = parser.value(pointsOption).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString &count : counts) {
+        const int points = count.trimmed().toInt();
+        QTemporaryDir corpus;
+        if (points <= 0 || !corpus.isValid() || !TestCorpus::writeFlat(corpus.path(), points)) {
+            out << "Failed to generate a corpus of " << count << " points\n";
+            return 1;
+        }
+        const QVector<ScenarioResult> run = runScenarios(corpus.path(), points, toggles, scrolls, analyses);
+        if (run.isEmpty()) {
+            out << "Failed to load MainUI\n";
+            return 1;
+        }
+        results += run;
+    }
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10\n").arg(QStringLiteral("scenario"), -12)
+               .arg(QStringLiteral("points"), 8).arg(QStringLiteral("frames"), 7)
+               .arg(QStringLiteral("frame p50"), 10).arg(QStringLiteral("frame p99"), 10)
+               .arg(QStringLiteral("render p99"), 11).arg(QStringLiteral("stall p99"), 10)
+               .arg(QStringLiteral("stall max"), 10).arg(QStringLiteral("notifies"), 10)
+               .arg(QStringLiteral("paints"), 7);
+    QJsonArray report;
+    for (const ScenarioResult &r : results) {
+        out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10\n").arg(r.name, -12).arg(r.points, 8)
+                   .arg(r.frameTimes.size(), 7)
+                   .arg(percentile(r.frameIntervals, 50), 10, 'f', 2).arg(percentile(r.frameIntervals, 99), 10, 'f', 2)
+                   .arg(percentile(r.frameTimes, 99), 11, 'f', 2).arg(percentile(r.stalls, 99), 10, 'f', 2)
+                   .arg(percentile(r.stalls, 100), 10, 'f', 2).arg(r.notifications, 10).arg(r.canvasPaints, 7);
+        report.append(resultToJson(r));
+    }
+    out << "Times in ms; frame = interval between swapped frames, render = synchronise to swap,\n"
+           "stall = lateness of a 1 ms GUI-thread timer\n";
+
+    if (parser.isSet(jsonOption)) {
+        QFile file(parser.value(jsonOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            out << "Cannot write " << file.fileName() << "\n";
+            return 1;
+        }
+        file.write(QJsonDocument(report).toJson(QJsonDocument::Indented));
+    }
+    return 0;
+}
+
+#include "uibenchmark.moc"
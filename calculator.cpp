@@ -1,4 +1,6 @@
 #include "include/calculator.h"
+#include "include/fitmodels.h"
+#include "include/numerics.h"
 #include <cmath>
 
 /**
@@ -32,46 +34,92 @@ bool Calculator::linearRegression(const QVector<DataPoint> &dataPoints, Calculat
  */
 bool Calculator::linearRegression(const QVector<DataPoint> &dataPoints, Calculator::TLMResult &result, double channelWidth)
 {
-    if (dataPoints.size() < 2) {
-        return false;
-    }
-    
-    // Filter enabled data points
-    QVector<double> x, y;
-    for (const DataPoint &point : dataPoints) {
-        if (point.enabled) {
-            x.append(point.spacing);
-            y.append(point.resistance);
-        }
-    }
-    
-    if (x.size() < 2) {
-        return false;
-    }
-    
-    // Perform linear regression
-    double slope, intercept;
-    if (!linearRegression(x, y, slope, intercept)) {
-        return false;
+    FitGeometry geometry;
+    geometry.channelWidth = channelWidth;
+    return FitModels::FitEngine<FitModels::LinearTLM>::fit(dataPoints, geometry, result);
+}
+
+/**
+ * @brief Fit a structure with the given model
+ * @param model Structure model
+ * @param dataPoints Points of one structure; only enabled points are fitted
+ * @param geometry Structure geometry
+ * @param result Reference to TLMResult object to store calculated values
+ * @return True if the fit was successful, false otherwise
+ */
+bool Calculator::fit(FitModel model, const QVector<DataPoint> &dataPoints, const FitGeometry &geometry,
+                     TLMResult &result)
+{
+    switch (model) {
+    case FitModel::CircularTLM:
+        return FitModels::FitEngine<FitModels::CircularTLM>::fit(dataPoints, geometry, result);
+    case FitModel::EndResistance:
+        return FitModels::FitEngine<FitModels::EndResistanceTLM>::fit(dataPoints, geometry, result);
+    case FitModel::LinearTLM:
+        break;
     }
-    
+    return FitModels::FitEngine<FitModels::LinearTLM>::fit(dataPoints, geometry, result);
+}
+
+/**
+ * @brief Fill a result from a line that has already been fitted
+ * @param model Structure model the line was fitted in
+ * @param slope Slope in the model's coordinates
+ * @param intercept Intercept in the model's coordinates
+ * @param rSquared Coefficient of determination of the fit
+ * @param geometry Structure geometry
+ * @param result Receives the line and the extracted parameters
+ */
+void Calculator::fromLine(FitModel model, double slope, double intercept, double rSquared,
+                          const FitGeometry &geometry, TLMResult &result)
+{
     result.slope = slope;
     result.intercept = intercept;
-    result.channelWidth = channelWidth;
-    result.sheetResistance = slope * channelWidth;  // Convert to Ω/sq
-    result.contactResistance = intercept; // Contact resistance in Ω
-    // Specific contact resistivity (legacy formula used by the app).
-    // Keep same units as before but guard against division by zero.
-    if (std::abs(result.sheetResistance) < 1e-15) {
-        result.specificContactResistivity = 0.0;
-    } else {
-        result.specificContactResistivity = (result.contactResistance * result.contactResistance / result.sheetResistance) * 1e-2; // ρc in Ω·cm²
+    result.rSquared = rSquared;
+    result.channelWidth = geometry.channelWidth;
+    result.transferLength = 0.0;
+    result.endResistance = 0.0;
+    switch (model) {
+    case FitModel::CircularTLM:
+        FitModels::CircularTLM::extract(slope, intercept, geometry, result);
+        return;
+    case FitModel::EndResistance:
+        FitModels::EndResistanceTLM::extract(slope, intercept, geometry, result);
+        return;
+    case FitModel::LinearTLM:
+        break;
+    }
+    FitModels::LinearTLM::extract(slope, intercept, geometry, result);
+}
+
+QString Calculator::fitModelName(FitModel model)
+{
+    switch (model) {
+    case FitModel::CircularTLM:
+        return QStringLiteral("circular");
+    case FitModel::EndResistance:
+        return QStringLiteral("end_resistance");
+    case FitModel::LinearTLM:
+        break;
     }
+    return QStringLiteral("linear");
+}
 
-    // Calculate and store R-squared for the fit
-    result.rSquared = calculateRSquared(x, y, slope, intercept);
+bool Calculator::fitModelFromName(const QString &name, FitModel &model)
+{
+    for (FitModel candidate : {FitModel::LinearTLM, FitModel::CircularTLM, FitModel::EndResistance}) {
+        if (name.compare(fitModelName(candidate), Qt::CaseInsensitive) == 0) {
+            model = candidate;
+            return true;
+        }
+    }
+    return false;
+}
 
-    return true;
+QStringList Calculator::fitModelNames()
+{
+    return {fitModelName(FitModel::LinearTLM), fitModelName(FitModel::CircularTLM),
+            fitModelName(FitModel::EndResistance)};
 }
 
 /**
@@ -83,7 +131,9 @@ bool Calculator::linearRegression(const QVector<DataPoint> &dataPoints, Calculat
  * @return True if regression was successful, false otherwise
  * 
  * This method performs a standard linear regression using the least squares method.
- * It uses numerically stable centering techniques to improve accuracy.
+ * It uses numerically stable centering techniques to improve accuracy, and
+ * every sum goes through Numerics::sumOf so results do not depend on how
+ * many threads computed them.
  */
 bool Calculator::linearRegression(const QVector<double> &x, const QVector<double> &y,
                                  double &slope, double &intercept)
@@ -92,26 +142,17 @@ bool Calculator::linearRegression(const QVector<double> &x, const QVector<double
         return false;
     }
 
-    qsizetype n = x.size();
-    
+    const qsizetype n = x.size();
+    const double *px = x.constData();
+    const double *py = y.constData();
+
     // Calculate means
-    double meanX = 0.0, meanY = 0.0;
-    for (qsizetype i = 0; i < n; ++i) {
-        meanX += x[i];
-        meanY += y[i];
-    }
-    // Avoid narrowing conversion by casting n to double
-    meanX /= static_cast<double>(n);
-    meanY /= static_cast<double>(n);
+    const double meanX = Numerics::sumOf(n, [px](qsizetype i) { return px[i]; }) / static_cast<double>(n);
+    const double meanY = Numerics::sumOf(n, [py](qsizetype i) { return py[i]; }) / static_cast<double>(n);
 
     // Calculate centered sums for better numerical stability
-    double sumXY_centered = 0.0, sumX2_centered = 0.0;
-    for (qsizetype i = 0; i < n; ++i) {
-        double x_centered = x[i] - meanX;
-        double y_centered = y[i] - meanY;
-        sumXY_centered += x_centered * y_centered;
-        sumX2_centered += x_centered * x_centered;
-    }
+    const double sumXY_centered = Numerics::sumOf(n, [=](qsizetype i) { return (px[i] - meanX) * (py[i] - meanY); });
+    const double sumX2_centered = Numerics::sumOf(n, [=](qsizetype i) { return (px[i] - meanX) * (px[i] - meanX); });
 
     // Check for zero denominator
     if (std::abs(sumX2_centered) < 1e-15) {
@@ -143,24 +184,19 @@ double Calculator::calculateRSquared(const QVector<double> &x, const QVector<dou
         return 0.0;
     }
     
-    qsizetype n = x.size();
-    
+    const qsizetype n = x.size();
+    const double *px = x.constData();
+    const double *py = y.constData();
+
     // Calculate mean of y values
-    double meanY = 0.0;
-    for (qsizetype i = 0; i < n; ++i) {
-        meanY += y[i];
-    }
-    meanY /= static_cast<double>(n);
+    const double meanY = Numerics::sumOf(n, [py](qsizetype i) { return py[i]; }) / static_cast<double>(n);
 
     // Calculate total sum of squares and residual sum of squares
-    double totalSumSquares = 0.0;
-    double residualSumSquares = 0.0;
-    
-    for (qsizetype i = 0; i < n; ++i) {
-        double predictedY = slope * x[i] + intercept;
-        totalSumSquares += (y[i] - meanY) * (y[i] - meanY);
-        residualSumSquares += (y[i] - predictedY) * (y[i] - predictedY);
-    }
+    const double totalSumSquares = Numerics::sumOf(n, [=](qsizetype i) { return (py[i] - meanY) * (py[i] - meanY); });
+    const double residualSumSquares = Numerics::sumOf(n, [=](qsizetype i) {
+        const double residual = py[i] - (slope * px[i] + intercept);
+        return residual * residual;
+    });
     
     // Calculate R-squared
     if (std::abs(totalSumSquares) < 1e-15) {
@@ -172,4 +208,133 @@ double Calculator::calculateRSquared(const QVector<double> &x, const QVector<dou
     if (r2 < 0.0) r2 = 0.0;
     if (r2 > 1.0) r2 = 1.0;
     return r2;
-}
\ No newline at end of file
+}
+
+namespace {
+
+/**
+ * @brief Leave-one-out influence diagnostics in the coordinates of one model
+ *
+ * With x̄, Sxx and the residuals e of the full fit, each enabled point i has
+ *   leverage               h = 1/n + (xi - x̄)²/Sxx
+ *   deleted variance       s(i)² = (SSE - e²/(1 - h)) / (n - 3)
+ *   studentized residual   t = e / (s(i)·√(1 - h))
+ *   Cook's distance        D = e²·h / (2·s²·(1 - h)²)
+ *   slope change           Δb1 = (xi - x̄)·e / (Sxx·(1 - h))
+ *   intercept change       Δb0 = e/(1 - h) · (1/n - x̄·(xi - x̄)/Sxx)
+ * and the leave-one-out fit is (b0 - Δb0, b1 - Δb1).
+ */
+template <typename Model>
+QVector<Calculator::InfluenceDiagnostics> diagnose(const QVector<DataPoint> &dataPoints,
+                                                   const Calculator::FitGeometry &geometry)
+{
+    QVector<Calculator::InfluenceDiagnostics> diagnostics(dataPoints.size());
+
+    // Means of the enabled points; disabled points contribute zero terms
+    qsizetype n = 0;
+    for (const DataPoint &point : dataPoints) {
+        n += point.enabled ? 1 : 0;
+    }
+    if (n < 2) {
+        return diagnostics;
+    }
+    const qsizetype count = dataPoints.size();
+    QVector<double> x(count), y(count);
+    QVector<char> enabled(count);
+    for (qsizetype i = 0; i < count; ++i) {
+        x[i] = Model::x(dataPoints.at(i), geometry);
+        y[i] = Model::y(dataPoints.at(i), geometry);
+        enabled[i] = dataPoints.at(i).enabled;
+    }
+    const double *px = x.constData();
+    const double *py = y.constData();
+    const char *pe = enabled.constData();
+    const double meanX = Numerics::sumOf(count, [=](qsizetype i) { return pe[i] ? px[i] : 0.0; })
+                         / static_cast<double>(n);
+    const double meanY = Numerics::sumOf(count, [=](qsizetype i) { return pe[i] ? py[i] : 0.0; })
+                         / static_cast<double>(n);
+
+    // Centered sums
+    const double sxx = Numerics::sumOf(count, [=](qsizetype i) {
+        const double dx = px[i] - meanX;
+        return pe[i] ? dx * dx : 0.0;
+    });
+    const double sxy = Numerics::sumOf(count, [=](qsizetype i) {
+        return pe[i] ? (px[i] - meanX) * (py[i] - meanY) : 0.0;
+    });
+    if (std::abs(sxx) < 1e-15) {
+        return diagnostics;
+    }
+    const double slope = sxy / sxx;
+    const double intercept = meanY - slope * meanX;
+
+    const double sse = Numerics::sumOf(count, [=](qsizetype i) {
+        const double e = py[i] - (slope * px[i] + intercept);
+        return pe[i] ? e * e : 0.0;
+    });
+    const double nd = static_cast<double>(n);
+    const double s2 = n > 2 ? sse / (nd - 2.0) : 0.0;
+    const double cooksThreshold = 4.0 / nd;
+
+    for (qsizetype i = 0; i < count; ++i) {
+        Calculator::InfluenceDiagnostics &d = diagnostics[i];
+        const double dx = px[i] - meanX;
+        d.valid = true;
+        d.leverage = 1.0 / nd + dx * dx / sxx;
+        d.residual = py[i] - (slope * px[i] + intercept);
+        d.looSlope = slope;
+        d.looIntercept = intercept;
+
+        const double oneMinusH = 1.0 - d.leverage;
+        if (pe[i] && oneMinusH > 1e-12) {
+            const double e = d.residual;
+            d.looSlope = slope - dx * e / (sxx * oneMinusH);
+            d.looIntercept = intercept - e / oneMinusH * (1.0 / nd - meanX * dx / sxx);
+
+            if (n > 2 && s2 > 0.0) {
+                d.cooksDistance = e * e * d.leverage / (2.0 * s2 * oneMinusH * oneMinusH);
+                d.influential = d.cooksDistance > cooksThreshold;
+            }
+            if (n > 3) {
+                const double deletedVariance = (sse - e * e / oneMinusH) / (nd - 3.0);
+                if (deletedVariance > 0.0) {
+                    d.studentizedResidual = e / std::sqrt(deletedVariance * oneMinusH);
+                }
+            }
+        }
+
+        Calculator::TLMResult loo;
+        Model::extract(d.looSlope, d.looIntercept, geometry, loo);
+        d.looSheetResistance = loo.sheetResistance;
+        d.looContactResistance = loo.contactResistance;
+    }
+
+    return diagnostics;
+}
+
+} // namespace
+
+/**
+ * @brief Compute leave-one-out influence diagnostics for all points
+ * @param model Structure model the points are fitted with
+ * @param dataPoints Points of one structure; only enabled points are fitted
+ * @param geometry Structure geometry
+ * @return One entry per input point, in input order
+ *
+ * Dispatches once on the model, like fit(), so the transforms are inlined
+ * into the single pass over the points.
+ */
+QVector<Calculator::InfluenceDiagnostics> Calculator::influenceDiagnostics(FitModel model,
+                                                                           const QVector<DataPoint> &dataPoints,
+                                                                           const FitGeometry &geometry)
+{
+    switch (model) {
+    case FitModel::CircularTLM:
+        return diagnose<FitModels::CircularTLM>(dataPoints, geometry);
+    case FitModel::EndResistance:
+        return diagnose<FitModels::EndResistanceTLM>(dataPoints, geometry);
+    case FitModel::LinearTLM:
+        break;
+    }
+    return diagnose<FitModels::LinearTLM>(dataPoints, geometry);
+}
@@ -0,0 +1,391 @@
+#include "include/cli.h"
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QMap>
+#include <cstring>
+#include <memory>
+#include "include/analysisservice.h"
+#include "include/appconfig.h"
+#include "include/calculator.h"
+#include "include/datamanager.h"
+#include "include/filenameindex.h"
+#include "include/numerics.h"
+#include "include/ingestpipeline.h"
+#include "include/resultexporter.h"
+#include "include/resultstore.h"
+#include "include/plotrenderer.h"
+#include "include/streamreducer.h"
+#include "include/workerpools.h"
+#include <QDir>
+#include <QFileInfo>
+
+/**
+ * @brief Whether the arguments request a headless run
+ * @param argc Argument count from main()
+ * @param argv Argument vector from main()
+ * @return True if a command-line action was given
+ */
+bool Cli::wantsCli(int argc, char *argv[])
+{
+    static const char *const actions[] = {"--analyze", "--serve", "--history", "--trend", "--help", "-h"};
+    for (int i = 1; i < argc; ++i) {
+        for (const char *action : actions) {
+            if (std::strcmp(argv[i], action) == 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Run the command-line front end
+ * @param argc Argument count from main()
+ * @param argv Argument vector from main()
+ * @return 0 on success, 1 on invalid arguments, 2 if no folder could be analysed
+ *
+ * Each folder passed with --analyze is loaded through the ingest pipeline
+ * and every structure in it is fitted with the selected model, or with all
+ * models for --model all. Results are printed as a tab-separated table.
+ * With --stream the points are folded into a StreamReducer as they are
+ * parsed instead of being collected, for lots too large to hold in memory.
+ * With --where only the files whose names satisfy the query are read.
+ * --record appends the results to the results store; --history and
+ * --trend query the store instead of reading any file.
+ * With --serve the process instead stays up as an AnalysisService.
+ */
+int Cli::run(int argc, char *argv[])
+{
+    // Plots are painted into images; no window system is needed
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("TLM_Analyzer"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("TLM Analyzer command-line analysis"));
+    parser.addHelpOption();
+    QCommandLineOption analyzeOption(QStringLiteral("analyze"), QStringLiteral("Analyse a folder of CSV files (repeatable)."),
+                                     QStringLiteral("folder"));
+    QCommandLineOption modelOption(QStringLiteral("model"),
+                                   QStringLiteral("Fit model: %1 or all.").arg(Calculator::fitModelNames().join(QStringLiteral(", "))),
+                                   QStringLiteral("model"));
+    QCommandLineOption widthOption(QStringLiteral("channel-width"), QStringLiteral("Channel width in μm."),
+                                   QStringLiteral("um"));
+    QCommandLineOption voltageOption(QStringLiteral("voltage"), QStringLiteral("Voltage at which resistance is read."),
+                                     QStringLiteral("volts"));
+    QCommandLineOption configOption(QStringLiteral("config"), QStringLiteral("Configuration file."),
+                                    QStringLiteral("file"), QStringLiteral("config.json"));
+    QCommandLineOption exportOption(QStringLiteral("export"),
+                                    QStringLiteral("Also write points and results to <base>_points / <base>_results."),
+                                    QStringLiteral("base"));
+    QCommandLineOption exportFormatOption(QStringLiteral("export-format"), QStringLiteral("Export format: csv or columnar."),
+                                          QStringLiteral("format"), QStringLiteral("csv"));
+    QCommandLineOption plotsOption(QStringLiteral("plots"), QStringLiteral("Render one plot per structure into a folder."),
+                                   QStringLiteral("folder"));
+    QCommandLineOption plotFormatOption(QStringLiteral("plot-format"), QStringLiteral("Plot format: png or svg."),
+                                        QStringLiteral("format"), QStringLiteral("png"));
+    QCommandLineOption serveOption(QStringLiteral("serve"),
+                                   QStringLiteral("Run as a JSON-RPC analysis service until terminated."));
+    QCommandLineOption portOption(QStringLiteral("port"), QStringLiteral("Loopback TCP port for --serve (0 picks a free port)."),
+                                  QStringLiteral("port"), QStringLiteral("47800"));
+    QCommandLineOption socketOption(QStringLiteral("socket"), QStringLiteral("Local socket name or path for --serve."),
+                                    QStringLiteral("name"));
+    QCommandLineOption streamOption(QStringLiteral("stream"),
+                                    QStringLiteral("Fold points into per-structure statistics instead of keeping them; "
+                                                   "memory stays constant for lots of any size. Exports results only."));
+    QCommandLineOption whereOption(QStringLiteral("where"),
+                                   QStringLiteral("Read only files whose name fields match, e.g. \"spacing=20 and die_y=7\" "
+                                                  "(fields come from filename_templates)."),
+                                   QStringLiteral("query"));
+    QCommandLineOption recordOption(QStringLiteral("record"),
+                                    QStringLiteral("Append the results to the results store (results_db)."));
+    QCommandLineOption historyOption(QStringLiteral("history"),
+                                     QStringLiteral("List stored results matching a query, e.g. \"lot=L42 and date>=2026-09-01\" "
+                                                    "(\"\" for all)."),
+                                     QStringLiteral("query"));
+    QCommandLineOption trendOption(QStringLiteral("trend"),
+                                   QStringLiteral("Summarise stored results per group, e.g. lot:rsh or day:rc; "
+                                                  "filtered by --history."),
+                                   QStringLiteral("group:quantity"));
+    parser.addOption(analyzeOption);
+    parser.addOption(whereOption);
+    parser.addOption(recordOption);
+    parser.addOption(historyOption);
+    parser.addOption(trendOption);
+    parser.addOption(streamOption);
+    parser.addOption(serveOption);
+    parser.addOption(portOption);
+    parser.addOption(socketOption);
+    parser.addOption(modelOption);
+    parser.addOption(widthOption);
+    parser.addOption(voltageOption);
+    parser.addOption(configOption);
+    parser.addOption(exportOption);
+    parser.addOption(exportFormatOption);
+    parser.addOption(plotsOption);
+    parser.addOption(plotFormatOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    // Command-line values override the configuration for this run only
+    AppConfig config(parser.value(configOption));
+    if (parser.isSet(voltageOption)) {
+        config.res_voltage = parser.value(voltageOption).toDouble();
+    }
+    double channelWidth = config.channel_length;
+    if (parser.isSet(widthOption)) {
+        channelWidth = parser.value(widthOption).toDouble();
+    }
+    if (!(channelWidth > 0)) {
+        err << "Invalid channel width specified.\n";
+        return 1;
+    }
+
+    QVector<Calculator::FitModel> models;
+    const QString modelName = parser.isSet(modelOption) ? parser.value(modelOption) : config.fit_model;
+    if (modelName.compare(QStringLiteral("all"), Qt::CaseInsensitive) == 0) {
+        models = {Calculator::FitModel::LinearTLM, Calculator::FitModel::CircularTLM, Calculator::FitModel::EndResistance};
+    } else {
+        Calculator::FitModel model;
+        if (!Calculator::fitModelFromName(modelName, model)) {
+            err << "Unknown fit model: " << modelName << "\n";
+            return 1;
+        }
+        models = {model};
+    }
+
+    ResultExporter::Options exportOptions;
+    if (!ResultExporter::formatFromName(parser.value(exportFormatOption), exportOptions.format)) {
+        err << "Unknown export format: " << parser.value(exportFormatOption) << "\n";
+        return 1;
+    }
+
+    PlotRenderer::Format plotFormat;
+    if (!PlotRenderer::formatFromName(parser.value(plotFormatOption), plotFormat)) {
+        err << "Unknown plot format: " << parser.value(plotFormatOption) << "\n";
+        return 1;
+    }
+
+    if (parser.isSet(serveOption)) {
+        // Command-line values become the defaults of every request
+        config.channel_length = channelWidth;
+        if (models.size() == 1) {
+            config.fit_model = Calculator::fitModelName(models.first());
+        }
+        AnalysisService service(config);
+        QString error;
+        // TCP unless only a local socket was asked for
+        if (parser.isSet(portOption) || !parser.isSet(socketOption)) {
+            if (!service.listenTcp(static_cast<quint16>(parser.value(portOption).toUInt()), &error)) {
+                err << "Cannot listen on port " << parser.value(portOption) << ": " << error << "\n";
+                return 2;
+            }
+            out << "Listening on 127.0.0.1:" << service.tcpPort() << "\n";
+        }
+        if (parser.isSet(socketOption)) {
+            if (!service.listenLocal(parser.value(socketOption), &error)) {
+                err << "Cannot listen on " << parser.value(socketOption) << ": " << error << "\n";
+                return 2;
+            }
+            out << "Listening on " << service.localServerName() << "\n";
+        }
+        out.flush();
+        return QCoreApplication::exec();
+    }
+
+    if (parser.isSet(historyOption) || parser.isSet(trendOption)) {
+        ResultStore store(ResultStore::pathFor(config));
+        QString error;
+        if (!store.open(&error)) {
+            err << error << "\n";
+            return 2;
+        }
+        const QString query = parser.value(historyOption);
+        if (parser.isSet(trendOption)) {
+            const QString spec = parser.value(trendOption);
+            const QString groupBy = spec.section(QLatin1Char(':'), 0, 0);
+            const QString quantity = spec.contains(QLatin1Char(':')) ? spec.section(QLatin1Char(':'), 1) : QStringLiteral("rsh");
+            const QVector<ResultStore::TrendRow> rows = store.trend(query, groupBy, quantity, &error);
+            if (!error.isEmpty()) {
+                err << error << "\n";
+                return 1;
+            }
+            out << groupBy << "\tcount\tmean(" << quantity << ")\tmin\tmax\n";
+            for (const ResultStore::TrendRow &row : rows) {
+                out << row.key << '\t' << row.count << '\t' << row.mean << '\t' << row.minimum << '\t' << row.maximum << '\n';
+            }
+            return 0;
+        }
+        const QVector<ResultStore::Record> records = store.query(query, 0, &error);
+        if (!error.isEmpty()) {
+            err << error << "\n";
+            return 1;
+        }
+        out << "recorded\tlot\twafer\tdie\tstructure\tmodel\tRsh(ohm/sq)\tRc(ohm)\trho_c(ohm*cm2)\tLT(um)\tRe(ohm)\tR2\n";
+        for (const ResultStore::Record &r : records) {
+            out << r.recordedAt.toString(Qt::ISODate) << '\t' << r.lot << '\t' << r.wafer << '\t' << r.die << '\t'
+                << (r.structure.isEmpty() ? QStringLiteral("(root)") : r.structure) << '\t' << r.model << '\t'
+                << r.result.sheetResistance << '\t' << r.result.contactResistance << '\t'
+                << r.result.specificContactResistivity << '\t' << r.result.transferLength << '\t'
+                << r.result.endResistance << '\t' << r.result.rSquared << '\n';
+        }
+        return 0;
+    }
+
+    const QStringList folders = parser.values(analyzeOption);
+    if (folders.isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    std::unique_ptr<ResultStore> store;
+    if (parser.isSet(recordOption)) {
+        store = std::make_unique<ResultStore>(ResultStore::pathFor(config));
+        QString error;
+        if (!store->open(&error)) {
+            err << error << "\n";
+            return 2;
+        }
+    }
+    const QDateTime recordedAt = QDateTime::currentDateTime();
+
+    Calculator::FitGeometry geometry;
+    geometry.channelWidth = channelWidth;
+    geometry.ctlmInnerRadius = config.ctlm_inner_radius;
+    geometry.contactLength = config.contact_length;
+
+    const bool stream = parser.isSet(streamOption);
+    if (stream && parser.isSet(plotsOption)) {
+        err << "--plots needs the individual points and is ignored with --stream\n";
+    }
+
+    QVector<FilenameIndex::Condition> conditions;
+    if (parser.isSet(whereOption)) {
+        QString error;
+        if (!FilenameIndex::parseQuery(parser.value(whereOption), conditions, &error)) {
+            err << error << "\n";
+            return 1;
+        }
+    }
+
+    out << "folder\tstructure\tmodel\tRsh(ohm/sq)\tRc(ohm)\trho_c(ohm*cm2)\tLT(um)\tRe(ohm)\tR2\n";
+    int analysed = 0;
+    // Fits, plots and archive inflation run on the configured compute pool
+    WorkerPools pools;
+    pools.configure(config);
+    IngestOptions ingestOptions = IngestOptions::fromConfig(config);
+    ingestOptions.archivePool = pools.compute();
+    ingestOptions.stagePool = pools.ingest();
+    Numerics::setThreadPool(pools.compute());
+    for (const QString &folder : folders) {
+        IngestPipeline pipeline(config, ingestOptions);
+        QVector<DataPoint> points;
+        StreamReducer reducer(geometry);
+        const IngestPipeline::FileSink reduce = [&reducer](int, const QString &, QVector<DataPoint> &&filePoints) {
+            reducer.add(filePoints);
+        };
+        if (parser.isSet(whereOption)) {
+            // Select by file name first, so unmatched files are never opened
+            FilenameIndex index(config.filename_templates);
+            index.addFolders(QStringList {folder}, DiscoveryOptions::fromConfig(config));
+            QString error;
+            const FilenameIndex::Bitmap selection = index.select(conditions, &error);
+            if (!error.isEmpty()) {
+                err << error << "\n";
+                return 1;
+            }
+            const auto files = index.files(selection);
+            if (stream) {
+                pipeline.streamFiles(index.roots(), files, reduce);
+            } else {
+                points = pipeline.runFiles(index.roots(), files);
+            }
+        } else if (stream) {
+            pipeline.streamMany(QStringList {folder}, reduce);
+        } else {
+            points = pipeline.run(folder);
+        }
+        if (stream ? reducer.pointCount() == 0 : points.isEmpty()) {
+            err << "No valid data points in " << folder << "\n";
+            continue;
+        }
+        QVector<ResultExporter::ResultRow> exportRows;
+        QVector<ResultStore::Record> records;
+        for (Calculator::FitModel model : models) {
+            QMap<QString, Calculator::TLMResult> results;
+            const bool fitted = stream ? reducer.fitAll(model, results)
+                                       : DataManager::calculateStructureResults(points, results, model, geometry,
+                                                                                pools.compute());
+            if (!fitted) {
+                err << "Analysis failed for " << folder << " (" << Calculator::fitModelName(model) << ")\n";
+                continue;
+            }
+            for (auto it = results.cbegin(); it != results.cend(); ++it) {
+                const Calculator::TLMResult &r = it.value();
+                out << folder << '\t' << (it.key().isEmpty() ? QStringLiteral("(root)") : it.key()) << '\t'
+                    << Calculator::fitModelName(model) << '\t' << r.sheetResistance << '\t' << r.contactResistance << '\t'
+                    << r.specificContactResistivity << '\t' << r.transferLength << '\t' << r.endResistance << '\t'
+                    << r.rSquared << '\n';
+                exportRows.append({it.key(), Calculator::fitModelName(model), r});
+            }
+            if (store && !stream) {
+                records += ResultStore::recordsFor(points, results, Calculator::fitModelName(model), config.res_voltage,
+                                                   config.results_path_levels, recordedAt);
+            } else if (store) {
+                for (auto it = results.cbegin(); it != results.cend(); ++it) {
+                    ResultStore::Record record;
+                    record.recordedAt = recordedAt;
+                    record.structure = it.key();
+                    record.folder = QDir(folder).absolutePath();
+                    record.model = Calculator::fitModelName(model);
+                    record.points = static_cast<int>(reducer.structure(it.key())->points);
+                    record.resVoltage = config.res_voltage;
+                    record.result = it.value();
+                    ResultStore::provenance(record, QString(), config.results_path_levels);
+                    records.append(record);
+                }
+            }
+            ++analysed;
+        }
+
+        if (store) {
+            QString error;
+            if (!store->insert(records, &error)) {
+                err << error << "\n";
+                return 2;
+            }
+        }
+
+        if (parser.isSet(exportOption)) {
+            // One file pair per folder when several folders are analysed
+            QString base = parser.value(exportOption);
+            if (folders.size() > 1) {
+                base += QLatin1Char('_') + QFileInfo(folder).fileName();
+            }
+            QString error;
+            const bool written = stream
+                ? ResultExporter::writeResults(exportRows, base + QStringLiteral("_results")
+                                               + ResultExporter::suffix(exportOptions.format), exportOptions, &error)
+                : ResultExporter::exportAll(points, exportRows, base, exportOptions, &error);
+            if (!written) {
+                err << error << "\n";
+                return 2;
+            }
+        }
+
+        if (parser.isSet(plotsOption) && !stream) {
+            // Structures of different folders may share names, so prefix them
+            const QString prefix = folders.size() > 1 ? QFileInfo(folder).fileName() + QLatin1Char('_') : QString();
+            PlotRenderer::renderStructures(points, models.constFirst(), geometry, parser.value(plotsOption), prefix,
+                                           plotFormat, PlotRenderer::Style(), nullptr, PlotRenderer::ProgressCallback(),
+                                           pools.compute());
+        }
+    }
+    out.flush();
+
+    return analysed > 0 ? 0 : 2;
+}
@@ -1,12 +1,17 @@
 #include "include/csvprocessor.h"
 #include "include/datapoint.h"
+#include "include/filediscovery.h"
+#include "include/filenameindex.h"
+#include "include/archivereader.h"
+#include "include/sweepparser.h"
 #include <QDir>
 #include <QFile>
-#include <QTextStream>
+#include <QByteArrayView>
 #include <QFileInfo>
 #include <QDebug>
 #include <QRegularExpression>
 #include <algorithm>
+#include <cmath>
 
 /**
  * @brief Process all CSV files in a folder to extract TLM data points
@@ -14,38 +19,73 @@
  * @param config Application configuration
  * @return QVector of DataPoint objects extracted from the CSV files
  * 
- * This method scans a folder for CSV files, extracts spacing information from filenames,
+ * This method walks a folder (recursively if configured) for CSV files, extracts spacing information from filenames
+ * (using the configured filename templates, if any),
  * processes each file to extract current/voltage measurements, and calculates resistance
- * values. The resulting data points are sorted by spacing before being returned.
+ * values. Files holding several instrument buffers or steps contribute one point per
+ * buffer/step, each assigned to its own structure. The resulting data points are sorted by spacing before being returned.
  */
 QVector<DataPoint> CSVProcessor::processFolder(const QString &folderPath, const AppConfig& config)
 {
-    QDir dir(folderPath);
-    QStringList csvFiles = dir.entryList({"*.csv"}, QDir::Files);
-    
     QVector<DataPoint> dataPoints;
 
-    // Process each CSV file
-    for (const QString &filename : csvFiles) {
-        double spacing = extractSpacingFromFilename(filename);
+    // Process each CSV file as it is discovered
+    const FileDiscovery discovery(DiscoveryOptions::fromConfig(config));
+    const FilenameTemplates templates(config.filename_templates);
+    discovery.discover(folderPath, [&](DiscoveredFile &&file) {
+        if (ArchiveReader::isArchive(file.fileName)) {
+            // Parse bundle members straight from memory
+            const QString structure = config.group_by_folder
+                ? (file.group.isEmpty() ? QString() : file.group + QLatin1Char('/')) + ArchiveReader::archiveBaseName(file.fileName)
+                : QString();
+            const QStringList memberPatterns = config.include_patterns.isEmpty()
+                ? QStringList {QStringLiteral("*.csv")} : config.include_patterns;
+            ArchiveReader::readMembers(file.path, memberPatterns, [&](const QString &memberName, QByteArray &&content) {
+                double spacing = templates.spacing(memberName.section(QLatin1Char('/'), -1));
+                if (spacing > 0) {
+                    const QVector<DataPoint> points = parseContentAll(content, config, memberName);
+                    for (DataPoint point : points) {
+                        if (point.resistance > 0 && std::isfinite(point.resistance)) {
+                            point.spacing = spacing;
+                            point.structure = structureForSource(structure, point.source);
+                            dataPoints.append(point);
+                        }
+                    }
+                }
+                return true;
+            }, nullptr, nullptr, ArchiveReader::memberLimit(config.archive_member_limit_mb));
+            return true;
+        }
+
+        const QString &filename = file.fileName;
+        double spacing = templates.spacing(filename);
         if (spacing > 0) {
-            QString filePath = dir.filePath(filename);
-            DataPoint point = processFile(filePath, config);
-            
-            if (point.resistance > 0 && std::isfinite(point.resistance)) {
-                point.spacing = spacing;
-                dataPoints.append(point);
-                qDebug() << "File:" << filename << "Spacing:" << spacing << "μm, Resistance:" << point.resistance << "Ω, Current:" << point.current << "A";
-            } else {
-                qDebug() << "Skipping file due to invalid resistance:" << filename << point.resistance;
+            const QVector<DataPoint> points = processFileAll(file.path, config);
+            if (points.isEmpty()) {
+                qDebug() << "Skipping file without a complete measurement:" << filename;
+            }
+
+            // Every buffer and step is its own structure, however many a file holds
+            for (DataPoint point : points) {
+                if (point.resistance > 0 && std::isfinite(point.resistance)) {
+                    point.spacing = spacing;
+                    point.structure = structureForSource(file.group, point.source);
+                    dataPoints.append(point);
+                } else {
+                    qDebug() << "Skipping file due to invalid resistance:" << filename << point.resistance;
+                }
             }
         } else {
             qDebug() << "Filename does not contain valid spacing, skipping:" << filename;
         }
-    }
+        return true;
+    });
     
-    // Sort data points by spacing in ascending order
-    std::sort(dataPoints.begin(), dataPoints.end(), [](const DataPoint& a, const DataPoint& b) {
+    // Sort data points by structure, then spacing in ascending order
+    std::stable_sort(dataPoints.begin(), dataPoints.end(), [](const DataPoint& a, const DataPoint& b) {
+        if (a.structure != b.structure) {
+            return a.structure < b.structure;
+        }
         return a.spacing < b.spacing;
     });
     
@@ -65,68 +105,117 @@ QVector<DataPoint> CSVProcessor::processFolder(const QString &folderPath, const
  */
 DataPoint CSVProcessor::processFile(const QString &filePath, const AppConfig& config)
 {
-    DataPoint point;
-    
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly)) {
         qDebug() << "Cannot open file:" << filePath;
+        DataPoint point;
         point.resistance = -1;
         return point;
     }
 
-    QTextStream in(&file);
-    bool foundVoltage = false;
-    bool foundZero = false;
-    double I_voltage = 0.0;
-    double I_zero = 0.0;
-
-    // Skip header (if present) and find data
-    while (!in.atEnd()) {
-        QString line = in.readLine();
-        QStringList fields = line.split(',');
-
-        if (fields.size() >= 7) {
-            bool ok1, ok2;
-            double v = fields[5].toDouble(&ok1);  // Column 6 voltage
-            double i = fields[6].toDouble(&ok2);  // Column 7 current
-
-            if (ok1 && ok2) {
-                if (std::abs(v - config.res_voltage) < 1e-3 && !foundVoltage) {
-                    I_voltage = i;
-                    foundVoltage = true;
-                }
-                if (std::abs(v) < 1e-3 && !foundZero) {
-                    I_zero = i;
-                    foundZero = true;
-                }
-            }
-        }
+    const QByteArray content = file.readAll();
+    file.close();
+
+    return parseContent(content, config, filePath);
+}
+
+/**
+ * @brief Parse CSV contents to extract electrical measurements
+ * @param content Raw file contents
+ * @param config Application configuration
+ * @param sourceName File name used in diagnostic messages
+ * @return DataPoint object containing the extracted measurements
+ *
+ * Returns the first point found by parseContentAll(), or a point with a
+ * negative resistance when the file holds no complete measurement.
+ */
+DataPoint CSVProcessor::parseContent(const QByteArray &content, const AppConfig& config,
+                                     const QString &sourceName)
+{
+    const QVector<DataPoint> points = parseContentAll(content, config, sourceName);
+    if (points.isEmpty()) {
+        DataPoint point;
+        point.resistance = -1;
+        return point;
+    }
+    return points.first();
+}
 
-        if (foundVoltage && foundZero) {
-            break;
+/**
+ * @brief Parse every buffer and step of a CSV file in a single pass
+ * @param content Raw file contents
+ * @param config Application configuration
+ * @param sourceName File name used in diagnostic messages
+ * @return One DataPoint per instrument buffer and step, in file order
+ *
+ * Lines are split in place without allocating a string per row and fed to
+ * a SweepParser, which follows all buffers of the `[ DATA ]` section at
+ * once. Files without a data section fall back to voltage in column 6 and
+ * current in column 7.
+ */
+QVector<DataPoint> CSVProcessor::parseContentAll(const QByteArray &content, const AppConfig& config,
+                                                 const QString &sourceName)
+{
+    SweepParser parser(config.res_voltage);
+
+    const QByteArrayView data(content);
+    qsizetype lineStart = 0;
+    while (lineStart < data.size()) {
+        qsizetype lineEnd = data.indexOf('\n', lineStart);
+        if (lineEnd < 0) {
+            lineEnd = data.size();
         }
+        parser.feedLine(data.sliced(lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
+    }
+
+    const QVector<DataPoint> points = parser.finish();
+    // Only failures are logged; this runs once per file on every ingest path
+    if (points.isEmpty()) {
+        qDebug() << "Incomplete data in file:" << sourceName;
     }
+    return points;
+}
 
+/**
+ * @brief Process a single CSV file, keeping every buffer and step
+ * @param filePath Path to the CSV file to process
+ * @param config Application configuration
+ * @return One DataPoint per instrument buffer and step
+ */
+QVector<DataPoint> CSVProcessor::processFileAll(const QString &filePath, const AppConfig& config)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Cannot open file:" << filePath;
+        return {};
+    }
+
+    const QByteArray content = file.readAll();
     file.close();
 
-    if (foundVoltage && foundZero) {
-        double deltaI = (I_voltage - I_zero);
-        if (std::abs(deltaI) < 1e-15 || !std::isfinite(deltaI)) {
-            point.resistance = -1;
-            qDebug() << "Invalid current difference (zero or non-finite) in file:" << filePath << "deltaI=" << deltaI;
-        } else {
-            point.resistance = config.res_voltage / deltaI;
-            point.current = deltaI;  // Store the current value
-            qDebug() << "File:" << QFileInfo(filePath).fileName()
-                     << "V:" << config.res_voltage << "I_voltage:" << I_voltage
-                     << "I_zero:" << I_zero << "R:" << point.resistance;
-        }
-    } else {
-        point.resistance = -1;
-        qDebug() << "Incomplete data in file:" << filePath;
+    return parseContentAll(content, config, filePath);
+}
+
+/**
+ * @brief Structure name for a point extracted from a file
+ * @param group Structure the file belongs to (may be empty)
+ * @param source Buffer / step the point was extracted from; empty for the
+ *               legacy column layout
+ * @return "group/source", just the source for an empty group, or the group
+ *         for a point without a source
+ *
+ * The name depends on the point's source only, never on how many points
+ * its file happened to yield, so a buffer that is missing its 0 V reading
+ * in one file does not move the other files' points of the same buffer
+ * into a separate structure.
+ */
+QString CSVProcessor::structureForSource(const QString &group, const QString &source)
+{
+    if (source.isEmpty()) {
+        return group;
     }
-    
-    return point;
+    return group.isEmpty() ? source : group + QLatin1Char('/') + source;
 }
 
 /**
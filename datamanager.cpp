@@ -1,37 +1,226 @@
 #include "include/datamanager.h"
 #include <algorithm>
+#include <cmath>
 #include <QVariant>
 #include <QtConcurrent/QtConcurrent>
 #include <QFuture>
 #include <QMetaObject>
+#include <QDebug>
 #include <QDir>
+#include <QFileInfo>
+#include <QSet>
+#include <QUrl>
+#include <QElapsedTimer>
+#include <QMutex>
 #include "include/csvprocessor.h"
+#include "include/ingestpipeline.h"
+#include "include/resultexporter.h"
+#include "include/plotrenderer.h"
+#include "include/streamreducer.h"
+#include "include/filenameindex.h"
+#include "include/tailparser.h"
+#include "include/archivereader.h"
+#include "include/folderprefetcher.h"
+#include "include/numerics.h"
+#include <QFileSystemWatcher>
 
 
 /**
  * @brief Constructor for DataManager
  * @param parent The parent QObject
  * 
- * Initializes the DataManager with an empty data points collection.
+ * Initializes the DataManager with an empty data points collection and
+ * starts loading the configuration on a worker thread, so locating,
+ * migrating and parsing the config file never delays the first frame.
  */
 DataManager::DataManager(QObject *parent)
-    : QObject(parent), m_channelWidth(100.0), m_resistanceVoltage(1.0), m_appConfig("config.json")
+    : QObject(parent), m_channelWidth(100.0), m_resistanceVoltage(1.0),
+      m_appConfig(QStringLiteral("config.json"), AppConfig::Loading::Deferred)
 {
     m_model = new DataPointModel(this);
+    m_history.record(dataPoints);   // The empty collection is the first state to return to
+
+    m_configWatcher = new QFutureWatcher<AppConfig>(this);
+    connect(m_configWatcher, &QFutureWatcher<AppConfig>::finished, this, [this]() {
+        applyConfig(m_configWatcher->result());
+    });
+    const QString configFile = m_appConfig.getConfigFile();
+    m_configWatcher->setFuture(m_pools.io()->run([configFile]() {
+        AppConfig config(configFile, AppConfig::Loading::Deferred);
+        config.resolve();
+        return config;
+    }));
+
+    m_prefetcher = new FolderPrefetcher(this);
+    m_prefetcher->setStagePool(m_pools.ingest());
+    Numerics::setThreadPool(m_pools.compute());
 
     m_loadWatcher = new QFutureWatcher<QVector<DataPoint>>(this);
     connect(m_loadWatcher, &QFutureWatcher<QVector<DataPoint>>::finished, this, [this]() {
-        // Move results into the dataPoints and notify
-        QVector<DataPoint> results = m_loadWatcher->result();
-        dataPoints = results;
-        sortDataPoints();
-        if (m_model) m_model->setDataPoints(dataPoints);
-        emit dataChanged();
-        emit progressUpdated(100);
-        m_cancelRequested.storeRelease(0);
+        finishLoad(m_loadWatcher->result());
+    });
+
+    m_reduceWatcher = new QFutureWatcher<std::shared_ptr<StreamReducer>>(this);
+    connect(m_reduceWatcher, &QFutureWatcher<std::shared_ptr<StreamReducer>>::finished, this, [this]() {
+        m_reduction = m_reduceWatcher->result();
+        const bool cancelled = m_reduceCancel.loadAcquire() != 0;
+        emit progressUpdated(cancelled ? 0 : 100);
+        emit reducingChanged();
+        emit reductionFinished(static_cast<int>(m_reduction->structures().size()), m_reduction->pointCount(), cancelled);
+    });
+
+    m_indexWatcher = new QFutureWatcher<std::shared_ptr<FilenameIndex>>(this);
+    connect(m_indexWatcher, &QFutureWatcher<std::shared_ptr<FilenameIndex>>::finished, this, [this]() {
+        m_filenameIndex = m_indexWatcher->result();
+        emit indexReady(static_cast<int>(m_filenameIndex->size()), m_filenameIndex->templateErrors());
+    });
+
+    m_exportWatcher = new QFutureWatcher<QString>(this);
+    connect(m_exportWatcher, &QFutureWatcher<QString>::finished, this, [this]() {
+        const QString error = m_exportWatcher->result();
+        emit exportFinished(error.isEmpty(), error.isEmpty() ? m_exportSuccessMessage : error);
+    });
+
+    m_followPollWatcher = new QFutureWatcher<FollowBatch>(this);
+    connect(m_followPollWatcher, &QFutureWatcher<FollowBatch>::finished, this, [this]() {
+        const FollowBatch batch = m_followPollWatcher->result();
+        // A batch of a folder that was followed again since is dropped; the new session reads it anew
+        if (m_followSessions.value(batch.folder) == batch.generation) {
+            applyFollowBatch(batch);
+            if (batch.final) forgetFollowHandles(batch.folder);
+        }
+        if (!m_followFinals.isEmpty()) {
+            m_followPollWatcher->setFuture(m_pools.io()->run(m_followFinals.dequeue()));
+            return;
+        }
+        pollFollowed();
+    });
+
+    m_analysisWatcher = new QFutureWatcher<AnalysisOutcome>(this);
+    connect(m_analysisWatcher, &QFutureWatcher<AnalysisOutcome>::finished, this, [this]() {
+        const AnalysisOutcome outcome = m_analysisWatcher->result();
+        // Drop outcomes a newer request has superseded
+        if (outcome.superseded || outcome.generation != m_analysisGeneration.loadAcquire()) {
+            return;
+        }
+        if (outcome.ok) {
+            // Store last results for QML access
+            m_lastResult = outcome.result;
+            m_structureResults = outcome.structureResults;
+            if (outcome.historyVersion != 0) {
+                m_history.cacheFit(outcome.historyVersion, {outcome.model, outcome.geometry, outcome.result,
+                                                            outcome.structureResults, outcome.message});
+            }
+        }
+        if (!outcome.records.isEmpty()) {
+            recordResults(outcome.records);
+        }
+        emit analysisComplete(outcome.message);
     });
 }
 
+/**
+ * @brief Destructor; cancels background work and waits for the worker pools
+ *
+ * Tasks still running refer to this object, so they are finished here,
+ * before any member goes away; raising every cancel flag keeps that wait
+ * short. The prefetcher is a child object and would only be deleted after
+ * the pools, although its parses use them, so it goes first. I/O tasks
+ * start ingest runs and use the compute pool, so the pools are drained in
+ * the order I/O, ingest, compute.
+ */
+DataManager::~DataManager()
+{
+    m_cancelRequested.storeRelease(1);
+    m_reduceCancel.storeRelease(1);
+    m_exportCancel.storeRelease(1);
+    m_analysisGeneration.fetchAndAddOrdered(1);
+
+    m_prefetcher->cancel();
+    delete m_prefetcher;
+    m_prefetcher = nullptr;
+
+    m_pools.io()->waitForDone();
+    m_pools.ingest()->waitForDone();
+    m_pools.compute()->waitForDone();
+    if (Numerics::threadPool() == m_pools.compute()) {
+        Numerics::setThreadPool(nullptr);
+    }
+}
+
+/**
+ * @brief Adopt the configuration loaded in the background
+ * @param config Resolved configuration
+ *
+ * Settings changed before the file was read win over the file and only
+ * those are saved into it; every other setting comes from the file.
+ */
+void DataManager::applyConfig(const AppConfig &config)
+{
+    if (m_configLoaded) {
+        return;
+    }
+    m_configLoaded = true;
+
+    AppConfig loaded = config;
+    if (m_editedSettings.contains(QStringLiteral("res_voltage"))) loaded.res_voltage = m_appConfig.res_voltage;
+    if (m_editedSettings.contains(QStringLiteral("channel_length"))) loaded.channel_length = m_appConfig.channel_length;
+    if (m_editedSettings.contains(QStringLiteral("fit_model"))) loaded.fit_model = m_appConfig.fit_model;
+    m_appConfig = loaded;
+    if (!m_editedSettings.isEmpty()) {
+        m_appConfig.saveConfig();
+        m_editedSettings.clear();
+    }
+
+    // Edited settings already hold these values, so only the saved ones change anything
+    if (m_appConfig.channel_length > 0 && m_channelWidth != m_appConfig.channel_length) {
+        m_channelWidth = m_appConfig.channel_length;
+        if (m_model) m_model->setDiagnostics(computeDiagnostics());
+        emit channelWidthChanged();
+    }
+    if (m_resistanceVoltage != m_appConfig.res_voltage) {
+        m_resistanceVoltage = m_appConfig.res_voltage;
+        emit resistanceVoltageChanged();
+    }
+    Calculator::FitModel model = m_fitModel;
+    if (Calculator::fitModelFromName(m_appConfig.fit_model, model) && model != m_fitModel) {
+        m_fitModel = model;
+        if (m_model) m_model->setDiagnostics(computeDiagnostics());
+        emit fitModelChanged();
+    }
+
+    m_pools.configure(m_appConfig);
+    m_prefetcher->configure(m_appConfig);
+    if (m_history.limit() != m_appConfig.undo_limit) {
+        m_history.setLimit(m_appConfig.undo_limit);
+        if (m_appConfig.undo_limit > 0 && m_history.currentVersion() == 0) {
+            m_history.record(dataPoints);
+        }
+        emit historyChanged();
+    }
+    emit configLoaded();
+}
+
+/**
+ * @brief Block until the background configuration load has been applied
+ *
+ * Only waits if a request needs the configuration within the first moments
+ * after startup; afterwards it returns immediately.
+ */
+void DataManager::ensureConfigLoaded()
+{
+    if (m_configLoaded) {
+        return;
+    }
+    m_configWatcher->waitForFinished();
+    applyConfig(m_configWatcher->result());
+}
+
+bool DataManager::isConfigLoaded() const
+{
+    return m_configLoaded;
+}
+
 // Property accessors
 
 QAbstractListModel* DataManager::model() const
@@ -49,8 +238,16 @@ void DataManager::setChannelWidth(double width)
     if (m_channelWidth != width) {
         m_channelWidth = width;
         
-        // Save to configuration
-        m_appConfig.setChannelLength(width);
+        // Save to configuration; before the deferred load finishes, remember it for applyConfig()
+        if (m_configLoaded) {
+            m_appConfig.setChannelLength(width);
+        } else {
+            m_appConfig.channel_length = width;
+            m_editedSettings.insert(QStringLiteral("channel_length"));
+        }
+
+        // Leave-one-out sheet resistances scale with the channel width
+        if (m_model) m_model->setDiagnostics(computeDiagnostics());
         
         emit channelWidthChanged();
     }
@@ -66,26 +263,94 @@ void DataManager::setResistanceVoltage(double voltage)
     if (m_resistanceVoltage != voltage) {
         m_resistanceVoltage = voltage;
         
-        // Save to configuration
-        m_appConfig.setResistanceVoltage(voltage);
+        // Save to configuration; before the deferred load finishes, remember it for applyConfig()
+        if (m_configLoaded) {
+            m_appConfig.setResistanceVoltage(voltage);
+        } else {
+            m_appConfig.res_voltage = voltage;
+            m_editedSettings.insert(QStringLiteral("res_voltage"));
+        }
         
         emit resistanceVoltageChanged();
     }
 }
 
+QString DataManager::getFitModel() const
+{
+    return Calculator::fitModelName(m_fitModel);
+}
+
+void DataManager::setFitModel(const QString &model)
+{
+    Calculator::FitModel parsed;
+    if (!Calculator::fitModelFromName(model, parsed)) {
+        qDebug() << "Unknown fit model:" << model;
+        return;
+    }
+    if (m_fitModel != parsed) {
+        m_fitModel = parsed;
+
+        // Save to configuration; before the deferred load finishes, remember it for applyConfig()
+        if (m_configLoaded) {
+            m_appConfig.setFitModel(Calculator::fitModelName(parsed));
+        } else {
+            m_appConfig.fit_model = Calculator::fitModelName(parsed);
+            m_editedSettings.insert(QStringLiteral("fit_model"));
+        }
+
+        // Leave-one-out diagnostics follow the model's coordinates
+        if (m_model) m_model->setDiagnostics(computeDiagnostics());
+
+        emit fitModelChanged();
+    }
+}
+
+QStringList DataManager::c_fitModels() const
+{
+    return Calculator::fitModelNames();
+}
+
+Calculator::FitGeometry DataManager::fitGeometry(double channelWidth) const
+{
+    Calculator::FitGeometry geometry;
+    geometry.channelWidth = channelWidth;
+    geometry.ctlmInnerRadius = m_appConfig.ctlm_inner_radius;
+    geometry.contactLength = m_appConfig.contact_length;
+    return geometry;
+}
+
 /**
  * @brief Add a data point to the collection
  * @param point The DataPoint to add
  * 
- * Appends a new data point to the internal collection, sorts the data points
- * by spacing, and emits the dataChanged signal to notify any observers.
+ * Inserts the data point at its sorted position, updates the spacing index
+ * and emits the dataChanged signal to notify any observers.
  */
 void DataManager::c_addDataPoint(const DataPoint &point)
 {
-    dataPoints.append(point);
-    sortDataPoints();
-    if (m_model) m_model->setDataPoints(dataPoints);
-    emit dataChanged();
+    const qsizetype row = insertSorted(point);
+    publish(false, {RowEdit {RowEdit::Inserted, row, dataPoints.at(row)}});
+}
+
+/**
+ * @brief Insert a point at its sorted position
+ * @param point The DataPoint to insert
+ * @return Index of the inserted point
+ *
+ * Binary-searches the position after all points with the same structure and
+ * spacing, so replicates keep their insertion order, and assigns a handle if
+ * the point has none. No full re-sort is needed.
+ */
+qsizetype DataManager::insertSorted(DataPoint point)
+{
+    if (point.handle == 0) {
+        point.handle = m_spacingIndex.nextHandle();
+    }
+    m_spacingIndex.insert(point);
+    const auto it = std::upper_bound(dataPoints.cbegin(), dataPoints.cend(), point, &SpacingIndex::lessThan);
+    const qsizetype index = it - dataPoints.cbegin();
+    dataPoints.insert(index, std::move(point));
+    return index;
 }
 
 /**
@@ -98,9 +363,9 @@ void DataManager::c_addDataPoint(const DataPoint &point)
 void DataManager::c_removeDataPoint(int index)
 {
     if (index >= 0 && index < dataPoints.size()) {
-        dataPoints.remove(index);
-        if (m_model) m_model->setDataPoints(dataPoints);
-        emit dataChanged();
+        const DataPoint removed = dataPoints.takeAt(index);
+        m_spacingIndex.remove(removed);
+        publish(false, {RowEdit {RowEdit::Removed, index, removed}});
     }
 }
 
@@ -115,9 +380,9 @@ void DataManager::c_removeDataPoint(int index)
 void DataManager::c_setDataPointEnabled(int index, bool enabled)
 {
     if (index >= 0 && index < dataPoints.size()) {
+        m_spacingIndex.setEnabled(dataPoints.at(index), enabled);
         dataPoints[index].enabled = enabled;
-        if (m_model) m_model->setDataPoints(dataPoints);
-        emit dataChanged();
+        publish(false, {RowEdit {RowEdit::Changed, index, dataPoints.at(index)}});
     }
 }
 
@@ -130,270 +395,2005 @@ void DataManager::c_setDataPointEnabled(int index, bool enabled)
 void DataManager::c_clearDataPoints()
 {
     dataPoints.clear();
-    if (m_model) m_model->setDataPoints(dataPoints);
-    emit dataChanged();
+    m_spacingIndex.clear();
+    publish(false);
 }
 
 /**
  * @brief Remove all disabled data points from the collection
  * 
- * Creates a new collection containing only enabled data points, replaces
- * the internal collection with this filtered collection, sorts the data
- * points by spacing, and emits the dataChanged signal.
+ * Removes the disabled points in place, keeping the order of the rest,
+ * and emits the dataChanged signal. The removal is recorded in the history
+ * like any other edit, so it can be undone.
  */
 void DataManager::c_clearDisabledDataPoints()
 {
-    // Create a new vector with only enabled data points
-    QVector<DataPoint> enabledPoints;
-    for (const DataPoint &point : dataPoints) {
-        if (point.enabled) {
-            enabledPoints.append(point);
-        }
-    }
-
-    // Replace the old data with only enabled points
-    dataPoints = enabledPoints;
-    sortDataPoints();
-    if (m_model) m_model->setDataPoints(dataPoints);
-    emit dataChanged();
+    removeWhere([](const DataPoint &point) { return !point.enabled; });
 }
 
 /**
- * @brief Get a reference to the internal collection of data points
- * @return A const reference to the internal QVector of DataPoint objects
+ * @brief Restore the collection as it was before the last change
+ * @return False if there is nothing to undo or a batch is open
  */
-const QVector<DataPoint>& DataManager::getDataPoints() const
+bool DataManager::c_undo()
 {
-    return dataPoints;
+    QVector<RowEdit> edits;
+    if (m_updateDepth > 0 || !m_history.undo(&edits)) {
+        return false;
+    }
+    restoreHistory(edits);
+    return true;
 }
 
 /**
- * @brief Sort data points by spacing in ascending order
- * 
- * Sorts the internal collection of data points by their spacing values
- * in ascending order using std::sort with a lambda comparison function.
+ * @brief Reapply the last undone change
+ * @return False if there is nothing to redo or a batch is open
  */
-void DataManager::sortDataPoints()
+bool DataManager::c_redo()
 {
-    // Sort data points by spacing in ascending order
-    std::sort(dataPoints.begin(), dataPoints.end(), [](const DataPoint& a, const DataPoint& b) {
-        return a.spacing < b.spacing;
-    });
+    QVector<RowEdit> edits;
+    if (m_updateDepth > 0 || !m_history.redo(&edits)) {
+        return false;
+    }
+    restoreHistory(edits);
+    return true;
 }
 
 /**
- * @brief Get a collection of only the enabled data points
- * @return A QVector containing only the enabled data points
+ * @brief Replace the collection with the current history entry and its cached fit
+ * @param edits Edits from the collection to the entry, as reported by the history; empty if unknown
+ *
+ * The history hands over the edits between the two entries, so a step
+ * that toggled or removed k points is replayed row by row: the spacing
+ * index and the model see only those rows, and only the touched
+ * structures get fresh diagnostics. A changed point that moved to another
+ * structure is replayed as a removal and an insertion so both structures
+ * are refreshed. Entries that were rebuilt, and steps past a quarter of
+ * the rows as in publish(), reset from the entry instead. Any analysis
+ * still running for the state that was left is dropped; a cached fit is
+ * only reused if the model and geometry still match.
  */
-QVector<DataPoint> DataManager::getEnabledDataPoints() const
+void DataManager::restoreHistory(const QVector<RowEdit> &edits)
 {
-    QVector<DataPoint> enabledPoints;
-    for (const DataPoint &point : dataPoints) {
-        if (point.enabled) {
-            enabledPoints.append(point);
+    m_analysisGeneration.fetchAndAddOrdered(1);
+    m_handleRows.clear();
+    if (edits.isEmpty() || edits.size() * 4 > m_history.currentPoints().size()) {
+        dataPoints = m_history.currentPoints().toVector();
+        m_spacingIndex.rebuild(dataPoints);
+        refreshModel({});
+    } else {
+        QVector<RowEdit> rows;
+        rows.reserve(edits.size());
+        for (const RowEdit &edit : edits) {
+            switch (edit.kind) {
+                case RowEdit::Changed:
+                    m_spacingIndex.remove(dataPoints.at(edit.row));
+                    m_spacingIndex.insert(edit.point);
+                    if (dataPoints.at(edit.row).structure != edit.point.structure) {
+                        rows.append(RowEdit {RowEdit::Removed, edit.row, dataPoints.at(edit.row)});
+                        rows.append(RowEdit {RowEdit::Inserted, edit.row, edit.point});
+                    } else {
+                        rows.append(edit);
+                    }
+                    dataPoints[edit.row] = edit.point;
+                    break;
+                case RowEdit::Inserted:
+                    m_spacingIndex.insert(edit.point);
+                    dataPoints.insert(edit.row, edit.point);
+                    rows.append(edit);
+                    break;
+                case RowEdit::Removed:
+                    m_spacingIndex.remove(dataPoints.at(edit.row));
+                    rows.append(RowEdit {RowEdit::Removed, edit.row, dataPoints.takeAt(edit.row)});
+                    break;
+            }
         }
+        refreshModel(rows);
+    }
+    emit dataChanged();
+    emit historyChanged();
+
+    const PointHistory::Fit *fit = m_history.currentFit();
+    const Calculator::FitGeometry geometry = fitGeometry(m_channelWidth);
+    if (fit && fit->model == m_fitModel && fit->geometry.channelWidth == geometry.channelWidth
+        && fit->geometry.ctlmInnerRadius == geometry.ctlmInnerRadius
+        && fit->geometry.contactLength == geometry.contactLength) {
+        m_lastResult = fit->result;
+        m_structureResults = fit->structureResults;
+        emit analysisComplete(fit->message);
     }
-    return enabledPoints;
 }
 
 /**
- * @brief Add a manually entered data point
- * @param spacing The spacing value for the new data point (in μm)
- * @param current The current value for the new data point (in A)
- * @param voltage The voltage value for calculating resistance (in V)
- * 
- * Calculates resistance from the provided voltage and current values,
- * creates a new DataPoint with the provided values, appends it to the
- * internal collection, sorts the data points by spacing, and emits the
- * dataChanged signal.
+ * @brief Start a batch of edits
+ *
+ * Edits made until the matching c_commitUpdate() are published together.
  */
-void DataManager::c_addManualDataPoint(double spacing, double current, double voltage)
+void DataManager::c_beginUpdate()
 {
-    // Calculate resistance from voltage and current
-    double resistance = 0.0;
-    double deltaI = current;
-    if (std::abs(deltaI) < 1e-15 || !std::isfinite(deltaI)) {
-        resistance = -1;
-    } else {
-        resistance = voltage / deltaI;
-    }
-
-    DataPoint point(spacing, resistance, current, true);
-    dataPoints.append(point);
-    sortDataPoints();
-    if (m_model) m_model->setDataPoints(dataPoints);
-    emit dataChanged();
+    ++m_updateDepth;
 }
 
 /**
- * @brief Load data from a folder of CSV files
- * @param folderPath Path to the folder containing CSV files
- * @param voltage Reference voltage for resistance calculations
+ * @brief Finish a batch of edits
+ *
+ * The outermost commit sorts at most once, refreshes the model once and
+ * emits a single dataChanged, regardless of how many edits were made.
  */
-void DataManager::c_loadDataFromFolder(const QString &folderPath, double voltage)
+void DataManager::c_commitUpdate()
 {
-    // If a load is already in progress, refuse to start another
-    if (m_loadWatcher && m_loadWatcher->isRunning()) {
-        emit analysisComplete("Loading already in progress.");
+    if (m_updateDepth == 0) {
+        qDebug() << "c_commitUpdate called without c_beginUpdate";
+        return;
+    }
+    if (--m_updateDepth > 0 || !m_publishPending) {
         return;
     }
 
-    m_cancelRequested.storeRelease(0);
-
-    setCurrentFolder(folderPath);
-    setResistanceVoltage(voltage);  // Update the resistance voltage in persistent config
+    const bool resort = m_resortPending;
+    m_publishPending = false;
+    m_resortPending = false;
+    publish(resort);
+}
 
-    // Prepare local copies for the background task
-    AppConfig configCopy = m_appConfig; // copy configuration for thread safety
-
-    QDir dir(folderPath);
-    QStringList csvFiles = dir.entryList({"*.csv"}, QDir::Files);
-
-    // Launch background task that processes files one-by-one and reports progress
-    QFuture<QVector<DataPoint>> future = QtConcurrent::run([folderPath, csvFiles, configCopy, this]() -> QVector<DataPoint> {
-        QVector<DataPoint> points;
-        qsizetype total = csvFiles.size();
-        for (qsizetype i = 0; i < total; ++i) {
-            if (m_cancelRequested.loadAcquire() != 0) {
-                // Cancel requested; stop processing
-                QMetaObject::invokeMethod(this, "emitProgress", Qt::QueuedConnection, Q_ARG(int, 0));
-                return points;
-            }
+/**
+ * @brief Set the enabled state of several data points at once
+ * @param indices Indices of the points to modify
+ * @param enabled The new enabled state
+ * @return Number of points whose state changed
+ */
+int DataManager::c_setDataPointsEnabled(const QList<int> &indices, bool enabled)
+{
+    int changed = 0;
+    for (int index : indices) {
+        if (index >= 0 && index < dataPoints.size() && dataPoints.at(index).enabled != enabled) {
+            m_spacingIndex.setEnabled(dataPoints.at(index), enabled);
+            dataPoints[index].enabled = enabled;
+            ++changed;
+        }
+    }
+    if (changed > 0) {
+        publish(false);
+    }
+    return changed;
+}
 
-            const QString &filename = csvFiles.at(static_cast<int>(i));
-            QString path = QDir(folderPath).filePath(filename);
+/**
+ * @brief Remove several data points at once
+ * @param indices Indices of the points to remove
+ * @return Number of points removed
+ *
+ * Marks the indices first and then compacts the collection in one pass, so
+ * removing k points costs O(n + k) instead of k shifts of the tail.
+ */
+int DataManager::c_removeDataPoints(const QList<int> &indices)
+{
+    QVector<bool> doomed(dataPoints.size(), false);
+    for (int index : indices) {
+        if (index >= 0 && index < dataPoints.size()) {
+            doomed[index] = true;
+        }
+    }
 
-            DataPoint p = CSVProcessor::processFile(path, configCopy);
-            if (p.resistance > 0 && std::isfinite(p.resistance)) {
-                double spacing = CSVProcessor::extractSpacingFromFilename(filename);
-                if (spacing > 0) {
-                    p.spacing = spacing;
-                    points.append(p);
-                }
+    qsizetype kept = 0;
+    for (qsizetype i = 0; i < dataPoints.size(); ++i) {
+        if (doomed.at(i)) {
+            m_spacingIndex.remove(dataPoints.at(i));
+        } else {
+            if (kept != i) {
+                dataPoints[kept] = std::move(dataPoints[i]);
             }
-
-            int percent = total > 0 ? static_cast<int>(((i + 1) * 100) / total) : 100;
-            // Safely invoke progress emission in the GUI thread
-            QMetaObject::invokeMethod(this, "emitProgress", Qt::QueuedConnection, Q_ARG(int, percent));
+            ++kept;
         }
+    }
+    const qsizetype removed = dataPoints.size() - kept;
+    dataPoints.resize(kept);
+    if (removed > 0) {
+        publish(false);
+    }
+    return static_cast<int>(removed);
+}
 
-        // Sort here to keep behavior consistent
-        std::sort(points.begin(), points.end(), [](const DataPoint& a, const DataPoint& b) {
-            return a.spacing < b.spacing;
-        });
-
-        return points;
-    });
-
-    // Set future to watcher so finished() handler will pick up results
-    m_loadWatcher->setFuture(future);
+namespace {
 
-    Q_UNUSED(csvFiles);
+/**
+ * @brief Local file path of a path or file URL coming from a QML dialog
+ */
+QString localPath(const QString &pathOrUrl)
+{
+    return pathOrUrl.startsWith(QStringLiteral("file:")) ? QUrl(pathOrUrl).toLocalFile() : pathOrUrl;
 }
 
-void DataManager::c_cancelLoad()
+/**
+ * @brief Shortest trailing part of each folder path that tells it apart from the others
+ * @param origins Absolute folder paths
+ * @return Label per origin: "die_3" if no other folder has that name, otherwise
+ *         "w1/die_3", "lotA/w1/die_3", ... and the full path as a last resort
+ */
+QHash<QString, QString> originLabels(const QSet<QString> &origins)
 {
-    if (m_loadWatcher && m_loadWatcher->isRunning()) {
-        m_cancelRequested.storeRelease(1);
+    QHash<QString, QStringList> parts;
+    for (const QString &origin : origins) {
+        parts.insert(origin, QDir::fromNativeSeparators(origin).split(QLatin1Char('/'), Qt::SkipEmptyParts));
+    }
+
+    QHash<QString, QString> labels;
+    for (auto it = parts.cbegin(); it != parts.cend(); ++it) {
+        const QStringList &own = it.value();
+        QString label = it.key();
+        for (qsizetype k = 1; k <= own.size(); ++k) {
+            const QStringList tail = own.mid(own.size() - k);
+            bool unique = true;
+            for (auto other = parts.cbegin(); other != parts.cend() && unique; ++other) {
+                unique = other.key() == it.key() || other.value().size() < k
+                    || other.value().mid(other.value().size() - k) != tail;
+            }
+            if (unique) {
+                label = tail.join(QLatin1Char('/'));
+                break;
+            }
+        }
+        labels.insert(it.key(), label);
     }
+    return labels;
 }
 
 /**
- * @brief Perform TLM analysis on the current data points
- * @param channelWidth Width of the channel in μm
+ * @brief Structure of a point without the origin label it may carry
+ *
+ * A label is a trailing part of the origin path, so the longest such part
+ * the structure starts with is removed; relabelling then works no matter
+ * which folders were loaded when the point was qualified.
  */
-void DataManager::c_performAnalysis(double channelWidth)
+QString unlabelledStructure(const DataPoint &point)
 {
-    if (channelWidth <= 0 || !std::isfinite(channelWidth)) {
-        emit analysisComplete("Invalid channel width specified.");
-        return;
+    const QStringList own = QDir::fromNativeSeparators(point.origin).split(QLatin1Char('/'), Qt::SkipEmptyParts);
+    for (qsizetype k = own.size(); k >= 1; --k) {
+        const QString tail = own.mid(own.size() - k).join(QLatin1Char('/'));
+        if (point.structure == tail) {
+            return QString();
+        }
+        if (point.structure.startsWith(tail + QLatin1Char('/'))) {
+            return point.structure.mid(tail.size() + 1);
+        }
     }
+    return point.structure;
+}
 
-    setChannelWidth(channelWidth);
-    
-    Calculator::TLMResult result;
-    if (calculateTLMResults(result, channelWidth)) {
-        // Store last result for QML access
-        m_lastResult = result;
-
-        // Format the result message
-        QString resultMessage = QString(
-            "TLM Analysis Results:\n"
-            "====================\n"
-            "Sheet Resistance: %1 Ω/sq\n"
-            "Contact Resistance: %2 Ω\n"
-            "Specific Contact Resistivity: %3 Ω·cm²\n"
-            "Linear Fit Slope: %4 Ω/μm\n"
-            "Linear Fit Intercept: %5 Ω\n"
-            "R² (Goodness of Fit): %6\n"
-            "Channel Width: %7 μm")
-            .arg(result.sheetResistance)
-            .arg(result.contactResistance)
-            .arg(result.specificContactResistivity)
-            .arg(result.slope)
-            .arg(result.intercept)
-            .arg(result.rSquared)
-            .arg(result.channelWidth);
-        
-        emit analysisComplete(resultMessage);
-    } else {
-        emit analysisComplete("Analysis failed. Please check your data.");
-    }
+/**
+ * @brief Structure qualified by an origin label
+ */
+QString labelledStructure(const QString &label, const QString &structure)
+{
+    return structure.isEmpty() ? label : label + QLatin1Char('/') + structure;
 }
 
-QVariantMap DataManager::c_lastAnalysisResult() const
+/**
+ * @brief True if a file lies inside a folder (an absolute path)
+ */
+bool isUnder(const QString &file, const QString &folder)
 {
-    QVariantMap map;
-    map["slope"] = m_lastResult.slope;
-    map["intercept"] = m_lastResult.intercept;
-    map["rSquared"] = m_lastResult.rSquared;
-    map["sheetResistance"] = m_lastResult.sheetResistance;
-    map["contactResistance"] = m_lastResult.contactResistance;
-    map["specificContactResistivity"] = m_lastResult.specificContactResistivity;
-    map["channelWidth"] = m_lastResult.channelWidth;
-    return map;
+    return file.startsWith(folder) && file.size() > folder.size() && file.at(folder.size()) == QLatin1Char('/');
 }
 
 /**
- * @brief Get the number of data points in the collection
- * @return The size of the internal data points collection
+ * @brief Build a predicate comparing one field of a point against a value
+ * @return Empty function for an unknown field or operator
  */
-qsizetype DataManager::size() const
+std::function<bool(const DataPoint &)> makeComparison(const QString &field, const QString &op, double value)
 {
-    return dataPoints.size();
+    double DataPoint::*member = nullptr;
+    if (field == QLatin1String("spacing")) member = &DataPoint::spacing;
+    else if (field == QLatin1String("resistance")) member = &DataPoint::resistance;
+    else if (field == QLatin1String("current")) member = &DataPoint::current;
+    else return {};
+
+    if (op == QLatin1String("<")) return [=](const DataPoint &p) { return p.*member < value; };
+    if (op == QLatin1String("<=")) return [=](const DataPoint &p) { return p.*member <= value; };
+    if (op == QLatin1String(">")) return [=](const DataPoint &p) { return p.*member > value; };
+    if (op == QLatin1String(">=")) return [=](const DataPoint &p) { return p.*member >= value; };
+    if (op == QLatin1String("==")) return [=](const DataPoint &p) { return p.*member == value; };
+    if (op == QLatin1String("!=")) return [=](const DataPoint &p) { return p.*member != value; };
+    return {};
 }
 
+} // namespace
+
 /**
- * @brief Access a data point at the specified index
- * @param index The index of the data point to access
- * @return A const reference to the data point at the specified index
+ * @brief Set the enabled state of every point matching a comparison
+ * @param field "spacing", "resistance" or "current"
+ * @param op Comparison operator
+ * @param value Value to compare against
+ * @param enabled The new enabled state
+ * @return Number of points whose state changed, or -1 for an invalid field or operator
  */
-const DataPoint& DataManager::at(qsizetype index) const
+int DataManager::c_setEnabledWhere(const QString &field, const QString &op, double value, bool enabled)
 {
-    return dataPoints.at(index);
+    const auto predicate = makeComparison(field, op, value);
+    if (!predicate) {
+        qDebug() << "Invalid point filter:" << field << op;
+        return -1;
+    }
+    return setEnabledWhere(predicate, enabled);
 }
 
 /**
- * @brief Calculate TLM results using linear regression with specified channel width
- * @param result Reference to a TLMResult object to store the calculation results
- * @param channelWidth Width of the channel in μm
- * @return True if the calculation was successful, false otherwise
- * 
- * Performs linear regression analysis on the data points and stores the
- * results in the provided TLMResult object.
+ * @brief Remove every point matching a comparison
+ * @param field "spacing", "resistance" or "current"
+ * @param op Comparison operator
+ * @param value Value to compare against
+ * @return Number of points removed, or -1 for an invalid field or operator
  */
-bool DataManager::calculateTLMResults(Calculator::TLMResult &result, double channelWidth) const
+int DataManager::c_removeWhere(const QString &field, const QString &op, double value)
 {
-    return Calculator::linearRegression(dataPoints, result, channelWidth);
+    const auto predicate = makeComparison(field, op, value);
+    if (!predicate) {
+        qDebug() << "Invalid point filter:" << field << op;
+        return -1;
+    }
+    return removeWhere(predicate);
 }
 
 /**
- * @brief Emit progress update for loading data
- * @param progress The progress percentage (0-100)
- *
- * Emits the progressUpdated signal with the specified progress value.
+ * @brief Set the enabled state of every point matching a predicate
+ * @param predicate Selects the points to modify
+ * @param enabled The new enabled state
+ * @return Number of points whose state changed
  */
-void DataManager::emitProgress(int progress)
+int DataManager::setEnabledWhere(const std::function<bool(const DataPoint &)> &predicate, bool enabled)
 {
-    emit progressUpdated(progress);
+    int changed = 0;
+    for (DataPoint &point : dataPoints) {
+        if (point.enabled != enabled && predicate(point)) {
+            m_spacingIndex.setEnabled(point, enabled);
+            point.enabled = enabled;
+            ++changed;
+        }
+    }
+    if (changed > 0) {
+        publish(false);
+    }
+    return changed;
+}
+
+/**
+ * @brief Remove every point matching a predicate
+ * @param predicate Selects the points to remove
+ * @return Number of points removed
+ */
+int DataManager::removeWhere(const std::function<bool(const DataPoint &)> &predicate)
+{
+    const qsizetype removed = dataPoints.removeIf([this, &predicate](const DataPoint &point) {
+        if (!predicate(point)) {
+            return false;
+        }
+        m_spacingIndex.remove(point);
+        return true;
+    });
+    if (removed > 0) {
+        publish(false);
+    }
+    return static_cast<int>(removed);
+}
+
+/**
+ * @brief Get a reference to the internal collection of data points
+ * @return A const reference to the internal QVector of DataPoint objects
+ */
+const QVector<DataPoint>& DataManager::getDataPoints() const
+{
+    return dataPoints;
+}
+
+/**
+ * @brief Sort data points by spacing in ascending order
+ * 
+ * Sorts the internal collection of data points by structure and then by
+ * spacing in ascending order; points with equal keys keep their order.
+ */
+void DataManager::sortDataPoints()
+{
+    // Sort data points by structure, then spacing in ascending order
+    std::stable_sort(dataPoints.begin(), dataPoints.end(), [](const DataPoint& a, const DataPoint& b) {
+        if (a.structure != b.structure) {
+            return a.structure < b.structure;
+        }
+        return a.spacing < b.spacing;
+    });
+}
+
+/**
+ * @brief Publish a change of the collection
+ * @param resort True if the change may have broken the sort order
+ * @param edits The rows that changed, in the order they were edited; empty if unknown
+ *
+ * Edits inside a batch are not tracked row by row; the commit resets the
+ * model once. Known edits also go to the history, so recording a toggle
+ * costs O(log n) instead of a pass over the collection.
+ */
+void DataManager::publish(bool resort, const QVector<RowEdit> &edits)
+{
+    m_handleRows.clear();
+    if (m_updateDepth > 0) {
+        m_publishPending = true;
+        m_resortPending = m_resortPending || resort;
+        return;
+    }
+
+    if (resort) {
+        sortDataPoints();
+    }
+    // A re-sort moves rows the edits do not describe
+    const QVector<RowEdit> rows = resort ? QVector<RowEdit>() : edits;
+    refreshModel(rows);
+    emit dataChanged();
+
+    const bool couldUndo = m_history.canUndo();
+    const quint64 version = m_history.currentVersion();
+    if (m_history.record(dataPoints, rows) != version || couldUndo != m_history.canUndo()) {
+        emit historyChanged();
+    }
+}
+
+/**
+ * @brief Bring the model up to date with the collection
+ * @param edits The rows that changed since the model was last updated; empty if unknown
+ *
+ * Past a quarter of the rows edited, as in PersistentPoints, one reset is
+ * cheaper than replaying the edits.
+ */
+void DataManager::refreshModel(const QVector<RowEdit> &edits)
+{
+    if (!m_model) {
+        return;
+    }
+    if (edits.isEmpty() || edits.size() * 4 > dataPoints.size()) {
+        m_model->setDataPoints(dataPoints, computeDiagnostics());
+        return;
+    }
+    QSet<QString> structures;
+    for (const RowEdit &edit : edits) {
+        const int row = static_cast<int>(edit.row);
+        switch (edit.kind) {
+            case RowEdit::Changed: m_model->setPoint(row, edit.point); break;
+            case RowEdit::Inserted: m_model->insertPoint(row, edit.point); break;
+            case RowEdit::Removed: m_model->removePoint(row); break;
+        }
+        structures.insert(edit.point.structure);
+    }
+    // Only the edited structures' fits, and so their diagnostics, changed
+    for (const QString &structure : structures) {
+        const auto [begin, end] = structureRun(structure);
+        m_model->setDiagnostics(static_cast<int>(begin), computeDiagnostics(begin, end));
+    }
+}
+
+/**
+ * @brief Get a collection of only the enabled data points
+ * @return A QVector containing only the enabled data points
+ */
+QVector<DataPoint> DataManager::getEnabledDataPoints() const
+{
+    QVector<DataPoint> enabledPoints;
+    for (const DataPoint &point : dataPoints) {
+        if (point.enabled) {
+            enabledPoints.append(point);
+        }
+    }
+    return enabledPoints;
+}
+
+/**
+ * @brief Add a manually entered data point
+ * @param spacing The spacing value for the new data point (in μm)
+ * @param current The current value for the new data point (in A)
+ * @param voltage The voltage value for calculating resistance (in V)
+ * 
+ * Calculates resistance from the provided voltage and current values,
+ * creates a new DataPoint with the provided values, inserts it at its
+ * sorted position, and emits the dataChanged signal.
+ */
+void DataManager::c_addManualDataPoint(double spacing, double current, double voltage)
+{
+    // Calculate resistance from voltage and current
+    double resistance = 0.0;
+    double deltaI = current;
+    if (std::abs(deltaI) < 1e-15 || !std::isfinite(deltaI)) {
+        resistance = -1;
+    } else {
+        resistance = voltage / deltaI;
+    }
+
+    DataPoint point(spacing, resistance, current, true);
+    const qsizetype row = insertSorted(point);
+    publish(false, {RowEdit {RowEdit::Inserted, row, dataPoints.at(row)}});
+}
+
+/**
+ * @brief Load data from a folder of CSV files
+ * @param folderPath Path to the folder containing CSV files
+ * @param voltage Reference voltage for resistance calculations
+ *
+ * Replaces the current collection; queued behind a running load if needed.
+ */
+void DataManager::c_loadDataFromFolder(const QString &folderPath, double voltage)
+{
+    setResistanceVoltage(voltage);  // Update the resistance voltage in persistent config
+    c_loadDataFromFolders(QStringList {folderPath}, false);
+}
+
+/**
+ * @brief Load several folders in one action
+ * @param folderPaths Folders to load
+ * @param merge True to merge into the current collection, false to replace it
+ */
+void DataManager::c_loadDataFromFolders(const QStringList &folderPaths, bool merge)
+{
+    if (folderPaths.isEmpty()) {
+        return;
+    }
+
+    ensureConfigLoaded();
+
+    // Points are tagged with these paths, and merges match on them
+    QStringList folders;
+    for (const QString &folder : folderPaths) {
+        folders.append(QDir(localPath(folder)).absolutePath());
+    }
+
+    // Speculative parsing of other folders must not compete with this load
+    m_prefetcher->retarget(folders);
+
+    LoadRequest request;
+    request.folders = folders;
+    request.merge = merge;
+    request.config = m_appConfig; // copy configuration for thread safety
+
+    // Queue behind the running load instead of refusing the request
+    if (m_loadWatcher && m_loadWatcher->isRunning()) {
+        m_pendingLoads.enqueue(request);
+        return;
+    }
+
+    startLoad(request);
+}
+
+/**
+ * @brief Set the order in which folders are stepped through, for prefetching
+ * @param folders Folder names or paths in wafer-map order; empty for natural name order
+ */
+void DataManager::c_setPrefetchOrder(const QStringList &folders)
+{
+    m_prefetcher->setOrder(folders);
+}
+
+int DataManager::c_pendingLoadCount() const
+{
+    return static_cast<int>(m_pendingLoads.size());
+}
+
+/**
+ * @brief Start a load request on a worker thread
+ * @param request Folders, merge mode and configuration of the load
+ *
+ * Runs the staged ingest pipeline over all folders of the request, or over
+ * its file selection if it carries one. Progress
+ * is reported per folder from the pipeline's reduce stage; the overall
+ * percentage is the mean over the folders. A single folder that was parsed
+ * ahead by the prefetcher is taken from it instead; the prefetcher checks
+ * the cached set on the I/O pool and runs the load there if it is stale.
+ */
+void DataManager::startLoad(const LoadRequest &request)
+{
+    m_activeLoad = request;
+    m_cancelRequested.storeRelease(0);
+
+    setCurrentFolder(request.folders.constFirst());
+
+    const QStringList folders = request.folders;
+    const AppConfig configCopy = request.config;
+    const auto files = request.files;
+
+    // The staged ingest pipeline; it reports progress from the background task that runs it
+    const std::function<QVector<DataPoint>()> load = [folders, configCopy, files, this]() -> QVector<DataPoint> {
+        IngestOptions options = IngestOptions::fromConfig(configCopy);
+        options.archivePool = m_pools.compute();
+        options.stagePool = m_pools.ingest();
+        IngestPipeline pipeline(configCopy, options);
+        QVector<int> folderPercent(folders.size(), -1);
+        int lastPercent = -1;
+        const IngestPipeline::FolderProgressCallback progress =
+            [&](int rootIndex, qsizetype processed, qsizetype discovered, bool discoveryDone) {
+                // 100 is reserved for the finished handler; the total is only
+                // known once enumeration is complete
+                int percent = discovered > 0 ? static_cast<int>((processed * 100) / discovered) : 0;
+                percent = std::min(percent, discoveryDone ? 99 : 90);
+                if (percent == folderPercent.at(rootIndex)) {
+                    return;
+                }
+                folderPercent[rootIndex] = percent;
+
+                int total = 0;
+                for (int folder : folderPercent) {
+                    total += std::max(folder, 0);
+                }
+                const int overall = total / static_cast<int>(folderPercent.size());
+
+                // Safely invoke progress emission in the GUI thread
+                QMetaObject::invokeMethod(this, "emitFolderProgress", Qt::QueuedConnection,
+                                          Q_ARG(QString, folders.at(rootIndex)), Q_ARG(int, percent));
+                if (overall != lastPercent) {
+                    lastPercent = overall;
+                    QMetaObject::invokeMethod(this, "emitProgress", Qt::QueuedConnection, Q_ARG(int, overall));
+                }
+            };
+        // A query selection replaces discovery; otherwise the folders are walked
+        QVector<DataPoint> points = files ? pipeline.runFiles(folders, *files, &m_cancelRequested, progress)
+                                          : pipeline.runMany(folders, &m_cancelRequested, progress);
+
+        if (m_cancelRequested.loadAcquire() != 0) {
+            QMetaObject::invokeMethod(this, "emitProgress", Qt::QueuedConnection, Q_ARG(int, 0));
+        }
+        return points;
+    };
+
+    // Set future to watcher so finished() handler will pick up results
+    if (!files && folders.size() == 1) {
+        QFuture<QVector<DataPoint>> prefetched = m_prefetcher->take(folders.constFirst(), configCopy, m_pools.io(), load);
+        if (prefetched.isValid()) {
+            m_loadWatcher->setFuture(prefetched);
+            return;
+        }
+    }
+    m_loadWatcher->setFuture(m_pools.io()->run(load));
+}
+
+/**
+ * @brief Apply the result of the finished load and start the next queued one
+ * @param points Points returned by the ingest pipeline
+ *
+ * In merge mode points previously loaded from the same folders are replaced
+ * and all other points are kept.
+ */
+void DataManager::finishLoad(QVector<DataPoint> points)
+{
+    if (m_activeLoad.merge) {
+        QSet<QString> origins;
+        for (const QString &folder : m_activeLoad.folders) {
+            origins.insert(QDir(folder).absolutePath());
+        }
+        dataPoints.removeIf([&origins](const DataPoint &point) {
+            return origins.contains(point.origin);
+        });
+        dataPoints += points;
+    } else {
+        dataPoints = std::move(points);
+    }
+    for (DataPoint &point : dataPoints) {
+        if (point.handle == 0) {
+            point.handle = m_spacingIndex.nextHandle();
+        }
+    }
+    qualifyStructuresByOrigin();
+    m_spacingIndex.rebuild(dataPoints);
+    publish(true);
+
+    for (const QString &folder : m_activeLoad.folders) {
+        emit folderProgressUpdated(folder, 100);
+    }
+    emit progressUpdated(100);
+
+    // Stepping through dies: parse the next ones while this one is analysed
+    if (m_pendingLoads.isEmpty() && m_cancelRequested.loadAcquire() == 0 && !m_activeLoad.merge
+        && !m_activeLoad.files && m_activeLoad.folders.size() == 1) {
+        m_prefetcher->prefetchAfter(m_activeLoad.folders.constFirst(), m_activeLoad.config);
+    }
+    m_cancelRequested.storeRelease(0);
+
+    if (!m_pendingLoads.isEmpty()) {
+        startLoad(m_pendingLoads.dequeue());
+    }
+}
+
+/**
+ * @brief Prefix structures with their folder label once several folders are loaded
+ *
+ * With points from a single folder the structure is the sub-folder group
+ * (or empty). As soon as the collection spans several folders, every point
+ * is assigned to "label" or "label/group" so each folder is fitted on its
+ * own. The label is the shortest trailing part of the folder path that no
+ * other loaded folder shares, so lotA/w1/die_3 and lotB/w1/die_3 stay two
+ * structures. A label a point already carries is replaced, since another
+ * folder with the same name may have been added since.
+ */
+void DataManager::qualifyStructuresByOrigin()
+{
+    QSet<QString> origins;
+    for (const DataPoint &point : dataPoints) {
+        if (!point.origin.isEmpty()) {
+            origins.insert(point.origin);
+        }
+    }
+    if (origins.size() < 2) {
+        return;
+    }
+
+    const QHash<QString, QString> labels = originLabels(origins);
+    for (DataPoint &point : dataPoints) {
+        if (!point.origin.isEmpty()) {
+            point.structure = labelledStructure(labels.value(point.origin), unlabelledStructure(point));
+        }
+    }
+}
+
+void DataManager::c_cancelLoad()
+{
+    m_pendingLoads.clear();
+    m_prefetcher->cancel();
+    if (m_loadWatcher && m_loadWatcher->isRunning()) {
+        m_cancelRequested.storeRelease(1);
+    }
+    if (m_reduceWatcher && m_reduceWatcher->isRunning()) {
+        m_reduceCancel.storeRelease(1);
+    }
+}
+
+/**
+ * @brief Summarise a lot without keeping its points
+ * @param folderPaths Folders to read
+ *
+ * The pipeline's reduce stage folds each file's points into the reducer as
+ * the file arrives, so no point outlives its file. Refused while another
+ * reduction is running.
+ */
+void DataManager::c_reduceFolders(const QStringList &folderPaths)
+{
+    if (folderPaths.isEmpty() || isReducing()) {
+        return;
+    }
+
+    ensureConfigLoaded();
+
+    QStringList folders;
+    for (const QString &folder : folderPaths) {
+        folders.append(localPath(folder));
+    }
+    AppConfig config = m_appConfig;
+    config.res_voltage = m_resistanceVoltage;
+    const Calculator::FitGeometry geometry = fitGeometry(m_channelWidth);
+    m_reduceCancel.storeRelease(0);
+
+    m_reduceWatcher->setFuture(m_pools.io()->run([folders, config, geometry, this]() {
+        auto reducer = std::make_shared<StreamReducer>(geometry);
+        IngestOptions options = IngestOptions::fromConfig(config);
+        options.archivePool = m_pools.compute();
+        options.stagePool = m_pools.ingest();
+        IngestPipeline pipeline(config, options);
+        QVector<int> folderPercent(folders.size(), 0);
+        int lastPercent = -1;
+        pipeline.streamMany(folders, [&reducer](int, const QString &, QVector<DataPoint> &&points) {
+            reducer->add(points);
+        }, &m_reduceCancel, [&](int rootIndex, qsizetype processed, qsizetype discovered, bool discoveryDone) {
+            int percent = discovered > 0 ? static_cast<int>((processed * 100) / discovered) : 0;
+            folderPercent[rootIndex] = std::min(percent, discoveryDone ? 99 : 90);
+            int total = 0;
+            for (int folder : folderPercent) {
+                total += folder;
+            }
+            const int overall = total / static_cast<int>(folderPercent.size());
+            if (overall != lastPercent) {
+                lastPercent = overall;
+                QMetaObject::invokeMethod(this, "emitProgress", Qt::QueuedConnection, Q_ARG(int, overall));
+            }
+        });
+        return reducer;
+    }));
+    emit reducingChanged();
+}
+
+bool DataManager::isReducing() const
+{
+    return m_reduceWatcher && m_reduceWatcher->isRunning();
+}
+
+QVariantList DataManager::c_reductionResults() const
+{
+    QVariantList list;
+    if (!m_reduction) {
+        return list;
+    }
+    QMap<QString, Calculator::TLMResult> results;
+    m_reduction->fitAll(m_fitModel, results);
+    for (const QString &name : m_reduction->structures()) {
+        const StreamReducer::StructureStats *stats = m_reduction->structure(name);
+        QVariantMap map;
+        map["structure"] = name;
+        map["points"] = static_cast<qlonglong>(stats->points);
+        map["median"] = stats->resistance.quantile(0.5);
+        map["p05"] = stats->resistance.quantile(0.05);
+        map["p95"] = stats->resistance.quantile(0.95);
+        map["ok"] = results.contains(name);
+        const Calculator::TLMResult result = results.value(name);
+        map["slope"] = result.slope;
+        map["intercept"] = result.intercept;
+        map["rSquared"] = result.rSquared;
+        map["sheetResistance"] = result.sheetResistance;
+        map["contactResistance"] = result.contactResistance;
+        map["specificContactResistivity"] = result.specificContactResistivity;
+        map["channelWidth"] = result.channelWidth;
+        map["transferLength"] = result.transferLength;
+        map["endResistance"] = result.endResistance;
+        list.append(map);
+    }
+    return list;
+}
+
+QVariantList DataManager::c_reductionSpacings() const
+{
+    QVariantList list;
+    if (!m_reduction) {
+        return list;
+    }
+    for (const QString &name : m_reduction->structures()) {
+        for (const auto &[spacing, group] : m_reduction->structure(name)->spacings) {
+            QVariantMap map;
+            map["structure"] = name;
+            map["spacing"] = spacing;
+            map["count"] = static_cast<qlonglong>(group.count);
+            map["mean"] = group.mean;
+            map["stdDev"] = std::sqrt(group.variance());
+            map["min"] = group.minimum;
+            map["max"] = group.maximum;
+            list.append(map);
+        }
+    }
+    return list;
+}
+
+QVariantList DataManager::c_reductionHistogram(const QString &structure) const
+{
+    QVariantList list;
+    const StreamReducer::StructureStats *stats = m_reduction ? m_reduction->structure(structure) : nullptr;
+    if (!stats) {
+        return list;
+    }
+    using Histogram = StreamReducer::Histogram;
+    for (int bin = 0; bin < Histogram::BinCount; ++bin) {
+        if (stats->resistance.bins.at(bin) == 0) {
+            continue;
+        }
+        QVariantMap map;
+        map["lower"] = Histogram::lowerEdge(bin);
+        map["upper"] = Histogram::lowerEdge(bin + 1);
+        map["count"] = static_cast<qlonglong>(stats->resistance.bins.at(bin));
+        list.append(map);
+    }
+    return list;
+}
+
+void DataManager::c_clearReduction()
+{
+    m_reduction.reset();
+}
+
+/**
+ * @brief Index the file names of folders without reading the files
+ * @param folderPaths Folders to walk
+ *
+ * Only directory listings are read; the index is built on a worker thread
+ * and swapped in when it is complete, so queries keep answering from the
+ * previous index meanwhile.
+ */
+void DataManager::c_indexFolders(const QStringList &folderPaths)
+{
+    if (folderPaths.isEmpty() || m_indexWatcher->isRunning()) {
+        return;
+    }
+
+    ensureConfigLoaded();
+
+    QStringList folders;
+    for (const QString &folder : folderPaths) {
+        folders.append(QDir(localPath(folder)).absolutePath());
+    }
+    const QStringList templates = m_appConfig.filename_templates;
+    const DiscoveryOptions options = DiscoveryOptions::fromConfig(m_appConfig);
+
+    m_indexWatcher->setFuture(m_pools.io()->run([folders, templates, options, this]() {
+        auto index = std::make_shared<FilenameIndex>(templates);
+        index->addFolders(folders, options);
+        return index;
+    }));
+}
+
+QVariantMap DataManager::c_queryIndex(const QString &query) const
+{
+    QVariantMap map;
+    if (!m_filenameIndex) {
+        map["ok"] = false;
+        map["count"] = 0;
+        map["error"] = QStringLiteral("No folders have been indexed");
+        return map;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    const FilenameIndex::Bitmap selection = m_filenameIndex->query(query, &error);
+    const qsizetype count = selection.count();
+    map["micros"] = timer.nsecsElapsed() / 1000.0;
+    map["ok"] = error.isEmpty();
+    map["count"] = static_cast<qlonglong>(count);
+    map["error"] = error;
+    return map;
+}
+
+QStringList DataManager::c_indexFields() const
+{
+    return m_filenameIndex ? m_filenameIndex->fields() : QStringList();
+}
+
+QStringList DataManager::c_indexValues(const QString &field) const
+{
+    return m_filenameIndex ? m_filenameIndex->values(field) : QStringList();
+}
+
+/**
+ * @brief Load only the indexed files matching a query
+ * @param query Query text
+ * @param merge True to merge into the current collection
+ * @return False if there is no index or the query is invalid
+ *
+ * Queued behind a running load like any other load request.
+ */
+bool DataManager::c_loadQuery(const QString &query, bool merge)
+{
+    if (!m_filenameIndex) {
+        qDebug() << "No folders have been indexed";
+        return false;
+    }
+    QString error;
+    const FilenameIndex::Bitmap selection = m_filenameIndex->query(query, &error);
+    if (!error.isEmpty()) {
+        qDebug() << "Invalid query:" << query << error;
+        return false;
+    }
+
+    ensureConfigLoaded();
+
+    LoadRequest request;
+    request.folders = m_filenameIndex->roots();
+    request.merge = merge;
+    request.config = m_appConfig;
+    request.files = m_filenameIndex->files(selection);
+    if (request.folders.isEmpty()) {
+        return true;
+    }
+
+    if (m_loadWatcher && m_loadWatcher->isRunning()) {
+        m_pendingLoads.enqueue(request);
+        return true;
+    }
+
+    startLoad(request);
+    return true;
+}
+
+/**
+ * @brief Follow a folder whose files are still being written
+ * @param folderPath Folder to follow
+ * @return False if the folder does not exist
+ *
+ * File system notifications only mark files as changed; the reading and
+ * parsing happen in one background poll at a time, and notifications that
+ * arrive meanwhile are coalesced into the next poll.
+ */
+bool DataManager::c_followFolder(const QString &folderPath)
+{
+    const QString folder = QDir(localPath(folderPath)).absolutePath();
+    if (folderPath.isEmpty() || !QFileInfo(folder).isDir()) {
+        qDebug() << "Cannot follow folder:" << folderPath;
+        return false;
+    }
+    ensureConfigLoaded();
+    c_stopFollowing();
+
+    // The followed files are read again from the start
+    const qsizetype before = dataPoints.size();
+    dataPoints.removeIf([&folder](const DataPoint &point) {
+        return point.origin == folder;
+    });
+    if (dataPoints.size() != before) {
+        m_spacingIndex.rebuild(dataPoints);
+        publish(false);
+    }
+    forgetFollowHandles(folder);
+
+    m_followedFolder = folder;
+    m_followSessions.insert(folder, ++m_followGeneration);
+    m_tailParser = std::make_shared<TailParser>(m_appConfig);
+    m_followWatcher = new QFileSystemWatcher(this);
+    m_followWatcher->addPath(folder);
+    connect(m_followWatcher, &QFileSystemWatcher::directoryChanged, this, [this]() {
+        m_followRescan = true;
+        pollFollowed();
+    });
+    connect(m_followWatcher, &QFileSystemWatcher::fileChanged, this, [this](const QString &path) {
+        m_followChanged.insert(path, m_followGroups.value(path));
+        // Files replaced by a rename drop out of the watch list
+        if (QFileInfo::exists(path) && !m_followWatcher->files().contains(path)) {
+            m_followWatcher->addPath(path);
+        }
+        pollFollowed();
+    });
+
+    setCurrentFolder(folder);
+    emit followingChanged();
+
+    m_followRescan = true;
+    pollFollowed();
+    return true;
+}
+
+/**
+ * @brief Stop following the folder
+ *
+ * The last poll of whatever changed and the finish of every file run as
+ * one task on the I/O pool, queued behind a poll that is still running so
+ * the parser is never shared and no batch is lost; the GUI thread does not
+ * wait for either. The batch is applied by the poll watcher like any other,
+ * including the points only reported at the end of a file.
+ */
+void DataManager::c_stopFollowing()
+{
+    if (m_followedFolder.isEmpty()) {
+        return;
+    }
+
+    const std::shared_ptr<TailParser> parser = m_tailParser;
+    const QString folder = m_followedFolder;
+    const DiscoveryOptions options = DiscoveryOptions::fromConfig(m_appConfig);
+    const bool rescan = m_followRescan;
+    const QHash<QString, QString> changed = m_followChanged;
+    const quint64 generation = m_followGeneration;
+    ++m_followGeneration;   // The session's polls no longer register new files
+    m_followFinals.enqueue([parser, folder, options, rescan, changed, generation]() {
+        FollowBatch batch = runFollowPoll(parser, folder, options, rescan, changed, generation);
+        for (const QString &file : parser->files()) {
+            const QVector<DataPoint> points = parser->finish(file);
+            if (!points.isEmpty()) {
+                batch.pointsByFile[file] += points;
+            }
+        }
+        batch.final = true;
+        return batch;
+    });
+    if (!m_followPollWatcher->isRunning()) {
+        m_followPollWatcher->setFuture(m_pools.io()->run(m_followFinals.dequeue()));
+    }
+
+    m_followWatcher->deleteLater();
+    m_followWatcher = nullptr;
+    m_tailParser.reset();
+    m_followGroups.clear();
+    m_followChanged.clear();
+    m_followRescan = false;
+    m_followedFolder.clear();
+    emit followingChanged();
+}
+
+/**
+ * @brief Forget which points were read from the files of a folder
+ *
+ * Called once a session's last batch is in, or when the folder is followed
+ * again and its points are read anew.
+ */
+void DataManager::forgetFollowHandles(const QString &folder)
+{
+    m_followHandles.removeIf([&folder](const QHash<QString, QVector<quint64>>::iterator &it) {
+        return isUnder(it.key(), folder);
+    });
+}
+
+void DataManager::pollFollowed()
+{
+    if (!m_tailParser || m_followPollWatcher->isRunning() || (!m_followRescan && m_followChanged.isEmpty())) {
+        return;
+    }
+
+    const std::shared_ptr<TailParser> parser = m_tailParser;
+    const QString folder = m_followedFolder;
+    const DiscoveryOptions options = DiscoveryOptions::fromConfig(m_appConfig);
+    const bool rescan = m_followRescan;
+    const QHash<QString, QString> changed = m_followChanged;
+    const quint64 generation = m_followGeneration;
+    m_followRescan = false;
+    m_followChanged.clear();
+
+    m_followPollWatcher->setFuture(m_pools.io()->run([parser, folder, options, rescan, changed, generation]() {
+        return runFollowPoll(parser, folder, options, rescan, changed, generation);
+    }));
+}
+
+/**
+ * @brief Poll files of a followed folder; executed on a worker thread
+ * @return New points per file, restarted files and newly discovered files
+ *
+ * A rescan walks the folder for files the parser does not follow yet and
+ * reads them in full; changed files are read from their last offset.
+ * Archives are not followed since they are written in one go.
+ */
+DataManager::FollowBatch DataManager::runFollowPoll(const std::shared_ptr<TailParser> &parser, const QString &folder,
+                                                    const DiscoveryOptions &options, bool rescan,
+                                                    const QHash<QString, QString> &changedFiles, quint64 generation)
+{
+    FollowBatch batch;
+    batch.generation = generation;
+    batch.folder = folder;
+
+    QHash<QString, QString> files = changedFiles;
+    if (rescan) {
+        const QStringList followed = parser->files();
+        const QSet<QString> known(followed.cbegin(), followed.cend());
+        FileDiscovery(options).discover(folder, [&](DiscoveredFile &&file) {
+            if (!ArchiveReader::isArchive(file.fileName) && !known.contains(file.path)) {
+                batch.newFiles.insert(file.path, file.group);
+                files.insert(file.path, file.group);
+            }
+            return true;
+        });
+    }
+
+    for (auto it = files.cbegin(); it != files.cend(); ++it) {
+        bool restarted = false;
+        const QVector<DataPoint> points = parser->poll(it.key(), it.value(), &restarted);
+        if (restarted) {
+            batch.restartedFiles.append(it.key());
+        }
+        if (!points.isEmpty()) {
+            batch.pointsByFile.insert(it.key(), points);
+        }
+    }
+    return batch;
+}
+
+/**
+ * @brief Add the points of a poll to the collection
+ * @param batch Result of runFollowPoll()
+ *
+ * Newly discovered files are added to the file watcher. New points are
+ * inserted at their sorted position and added to the spacing index one by
+ * one, so a poll costs O(k log n) plus the model rows it touches rather
+ * than a re-sort and index rebuild of the whole collection. Only the first
+ * poll that brings a second folder into the collection takes the full path,
+ * because every existing structure is renamed then. All changes are published
+ * as one update, followed by followUpdated if points were added.
+ */
+void DataManager::applyFollowBatch(const FollowBatch &batch)
+{
+    // Files found by the polls of a stopped session are not watched any more
+    const bool active = batch.generation == m_followGeneration;
+    for (auto it = batch.newFiles.cbegin(); active && it != batch.newFiles.cend(); ++it) {
+        if (!m_followGroups.contains(it.key())) {
+            m_followGroups.insert(it.key(), it.value());
+            if (m_followWatcher) {
+                m_followWatcher->addPath(it.key());
+            }
+        }
+    }
+
+    bool hadFollowed = false;
+    for (auto it = m_followHandles.cbegin(); it != m_followHandles.cend() && !hadFollowed; ++it) {
+        hadFollowed = !it.value().isEmpty() && isUnder(it.key(), batch.folder);
+    }
+    QSet<quint64> stale;
+    for (const QString &file : batch.restartedFiles) {
+        for (quint64 handle : m_followHandles.take(file)) {
+            stale.insert(handle);
+        }
+    }
+    const bool removed = !stale.isEmpty() && dataPoints.removeIf([this, &stale](const DataPoint &point) {
+        if (!stale.contains(point.handle)) {
+            return false;
+        }
+        m_spacingIndex.remove(point);
+        return true;
+    }) > 0;
+    if (batch.pointsByFile.isEmpty()) {
+        if (removed) publish(false);
+        return;
+    }
+
+    // Structures are qualified by folder once the collection spans several
+    QSet<QString> origins {batch.folder};
+    for (const DataPoint &point : std::as_const(dataPoints)) {
+        if (!point.origin.isEmpty()) {
+            origins.insert(point.origin);
+        }
+    }
+    const bool otherOrigins = origins.size() > 1;
+    // The first followed points add a folder, which may change the labels of the others
+    const bool renameAll = otherOrigins && !hadFollowed;
+    const QString label = otherOrigins && !renameAll ? originLabels(origins).value(batch.folder) : QString();
+
+    QVector<RowEdit> edits;
+    int added = 0;
+    for (auto it = batch.pointsByFile.cbegin(); it != batch.pointsByFile.cend(); ++it) {
+        QVector<quint64> &handles = m_followHandles[it.key()];
+        for (DataPoint point : it.value()) {
+            point.origin = batch.folder;
+            point.handle = m_spacingIndex.nextHandle();
+            handles.append(point.handle);
+            ++added;
+            if (renameAll) {
+                dataPoints.append(std::move(point));
+                continue;
+            }
+            if (otherOrigins) {
+                point.structure = labelledStructure(label, point.structure);
+            }
+            const qsizetype row = insertSorted(std::move(point));
+            edits.append(RowEdit {RowEdit::Inserted, row, dataPoints.at(row)});
+        }
+    }
+
+    if (renameAll) {
+        qualifyStructuresByOrigin();
+        m_spacingIndex.rebuild(dataPoints);
+        publish(true);
+    } else {
+        // Removed rows are not tracked individually, so they reset the model
+        publish(false, removed ? QVector<RowEdit>() : edits);
+    }
+    emit followUpdated(added);
+}
+
+/**
+ * @brief Export the current points and per-structure fits on a worker thread
+ * @param basePath Output path without suffix (a local path or file URL)
+ * @param format "csv" or "columnar"
+ *
+ * The worker owns copy-on-write snapshots of the points and settings, so
+ * edits and analyses can continue while the files are written.
+ */
+void DataManager::c_exportResults(const QString &basePath, const QString &format)
+{
+    ResultExporter::Options options;
+    if (!ResultExporter::formatFromName(format, options.format)) {
+        emit exportFinished(false, QStringLiteral("Unknown export format: %1").arg(format));
+        return;
+    }
+
+    // Accept file URLs from QML dialogs and drop a typed extension
+    QString base = localPath(basePath);
+    const QString typedSuffix = QFileInfo(base).suffix();
+    if (typedSuffix.compare(QStringLiteral("csv"), Qt::CaseInsensitive) == 0
+        || typedSuffix.compare(QStringLiteral("tlmc"), Qt::CaseInsensitive) == 0) {
+        base.chop(typedSuffix.size() + 1);
+    }
+    if (base.isEmpty()) {
+        emit exportFinished(false, QStringLiteral("No export path specified."));
+        return;
+    }
+    ensureConfigLoaded();
+    const QVector<DataPoint> snapshot = dataPoints;
+    const Calculator::FitModel model = m_fitModel;
+    const Calculator::FitGeometry geometry = fitGeometry(m_channelWidth);
+
+    startExport(QStringLiteral("Results exported to %1_points and %1_results").arg(base),
+                [this, snapshot, model, geometry, base, options]() {
+        QMap<QString, Calculator::TLMResult> fits;
+        calculateStructureResults(snapshot, fits, model, geometry, m_pools.compute());
+        QVector<ResultExporter::ResultRow> rows;
+        rows.reserve(fits.size());
+        for (auto it = fits.cbegin(); it != fits.cend(); ++it) {
+            rows.append({it.key(), Calculator::fitModelName(model), it.value()});
+        }
+
+        int lastPercent = -1;
+        QString error;
+        ResultExporter::exportAll(snapshot, rows, base, options, &error, &m_exportCancel,
+            [this, &lastPercent](qsizetype written, qsizetype total) {
+                const int percent = total > 0 ? static_cast<int>(written * 100 / total) : 100;
+                if (percent != lastPercent) {
+                    lastPercent = percent;
+                    QMetaObject::invokeMethod(this, "emitExportProgress", Qt::QueuedConnection, Q_ARG(int, percent));
+                }
+            });
+        return error;
+    });
+}
+
+/**
+ * @brief Render the plot of the current points to an image on a worker thread
+ * @param path Output file (a local path or file URL); ".svg" selects SVG, anything else PNG
+ */
+void DataManager::c_exportPlot(const QString &path)
+{
+    QString file = localPath(path);
+    if (file.isEmpty()) {
+        emit exportFinished(false, QStringLiteral("No export path specified."));
+        return;
+    }
+    PlotRenderer::Format format = PlotRenderer::Format::Png;
+    if (!PlotRenderer::formatFromName(QFileInfo(file).suffix(), format)) {
+        file += PlotRenderer::suffix(format);
+    }
+
+    const QVector<DataPoint> snapshot = dataPoints;
+    const Calculator::FitModel model = m_fitModel;
+    const Calculator::FitGeometry geometry = fitGeometry(m_channelWidth);
+    startExport(QStringLiteral("Plot exported to %1").arg(file), [snapshot, model, geometry, file, format]() {
+        QString error;
+        PlotRenderer::renderToFile(PlotRenderer::chartData(snapshot, model, geometry), file, format,
+                                   PlotRenderer::Style(), &error);
+        return error;
+    });
+}
+
+/**
+ * @brief Render one plot per structure into a folder, in parallel
+ * @param directory Output folder (a local path or file URL)
+ * @param format "png" or "svg"
+ */
+void DataManager::c_exportPlots(const QString &directory, const QString &format)
+{
+    PlotRenderer::Format plotFormat;
+    if (!PlotRenderer::formatFromName(format, plotFormat)) {
+        emit exportFinished(false, QStringLiteral("Unknown plot format: %1").arg(format));
+        return;
+    }
+    const QString folder = localPath(directory);
+    const QVector<DataPoint> snapshot = dataPoints;
+    const int structures = static_cast<int>(structuresOf(snapshot).size());
+    const Calculator::FitModel model = m_fitModel;
+    const Calculator::FitGeometry geometry = fitGeometry(m_channelWidth);
+
+    startExport(QStringLiteral("%1 plots exported to %2").arg(structures).arg(folder),
+                [this, snapshot, model, geometry, folder, plotFormat, structures]() {
+        int lastPercent = -1;
+        QMutex progressMutex;
+        const int written = PlotRenderer::renderStructures(snapshot, model, geometry, folder, QString(), plotFormat,
+            PlotRenderer::Style(), &m_exportCancel, [this, &lastPercent, &progressMutex](int rendered, int total) {
+                const int percent = total > 0 ? rendered * 100 / total : 100;
+                QMutexLocker locker(&progressMutex);
+                if (percent > lastPercent) {
+                    lastPercent = percent;
+                    QMetaObject::invokeMethod(this, "emitExportProgress", Qt::QueuedConnection, Q_ARG(int, percent));
+                }
+            }, m_pools.compute());
+        if (m_exportCancel.loadAcquire() != 0) {
+            return QStringLiteral("Export cancelled");
+        }
+        return written == structures ? QString()
+                                     : QStringLiteral("Only %1 of %2 plots could be written to %3")
+                                           .arg(written).arg(structures).arg(folder);
+    });
+}
+
+/**
+ * @brief Start an export job on a worker thread
+ * @param successMessage Message reported when the job returns no error
+ * @param job Returns an error message, empty on success
+ * @return False if another export is still running
+ */
+bool DataManager::startExport(const QString &successMessage, const std::function<QString()> &job)
+{
+    if (m_exportWatcher->isRunning()) {
+        emit exportFinished(false, QStringLiteral("An export is already running."));
+        return false;
+    }
+    m_exportSuccessMessage = successMessage;
+    m_exportCancel.storeRelease(0);
+    m_exportWatcher->setFuture(m_pools.io()->run(job));
+    return true;
+}
+
+void DataManager::c_cancelExport()
+{
+    m_exportCancel.storeRelease(1);
+}
+
+/**
+ * @brief Perform TLM analysis on the current data points
+ * @param channelWidth Width of the channel in μm
+ *
+ * Returns immediately; the result message is delivered through
+ * analysisComplete once the background fit finishes.
+ */
+void DataManager::c_performAnalysis(double channelWidth)
+{
+    if (channelWidth <= 0 || !std::isfinite(channelWidth)) {
+        emit analysisComplete("Invalid channel width specified.");
+        return;
+    }
+
+    performAnalysisAsync(channelWidth);
+}
+
+/**
+ * @brief Start TLM analysis on a worker thread
+ * @param channelWidth Width of the channel in μm
+ * @return Future for the outcome
+ *
+ * Copying the point vector only bumps a reference count; edits made on the
+ * GUI thread while the fit runs detach the live collection and leave the
+ * snapshot untouched.
+ */
+QFuture<DataManager::AnalysisOutcome> DataManager::performAnalysisAsync(double channelWidth)
+{
+    ensureConfigLoaded();
+    setChannelWidth(channelWidth);
+
+    // Newer generations supersede anything still running
+    const quint64 generation = m_analysisGeneration.fetchAndAddOrdered(1) + 1;
+    const QVector<DataPoint> snapshot = dataPoints;
+    const Calculator::FitModel model = m_fitModel;
+    const Calculator::FitGeometry geometry = fitGeometry(channelWidth);
+    const QAtomicInteger<quint64> *currentGeneration = &m_analysisGeneration;
+    const bool record = m_appConfig.record_results && !m_appConfig.results_db.isEmpty();
+    const double resVoltage = m_resistanceVoltage;
+    const QStringList pathLevels = m_appConfig.results_path_levels;
+    WorkerPool *pool = m_pools.compute();
+    // Edits of an open batch are not in the history yet, so their fit cannot be cached
+    const quint64 historyVersion = m_updateDepth == 0 ? m_history.currentVersion() : 0;
+
+    QFuture<AnalysisOutcome> future = pool->run([snapshot, model, geometry, generation, currentGeneration,
+                                                 record, resVoltage, pathLevels, pool, historyVersion]() {
+        AnalysisOutcome outcome = runAnalysis(snapshot, model, geometry, generation, currentGeneration, pool);
+        outcome.historyVersion = historyVersion;
+        outcome.model = model;
+        outcome.geometry = geometry;
+        if (record && outcome.ok && !outcome.superseded) {
+            // A single structure is stored under its own name
+            QMap<QString, Calculator::TLMResult> results = outcome.structureResults;
+            if (results.isEmpty()) {
+                results.insert(snapshot.constFirst().structure, outcome.result);
+            }
+            outcome.records = ResultStore::recordsFor(snapshot, results, Calculator::fitModelName(model), resVoltage,
+                                                      pathLevels, QDateTime::currentDateTime());
+        }
+        return outcome;
+    });
+    m_analysisWatcher->setFuture(future);
+    return future;
+}
+
+/**
+ * @brief Run one analysis against a snapshot
+ * @param snapshot Points to fit, sorted by structure
+ * @param model Structure model
+ * @param geometry Structure geometry
+ * @param generation Generation of the request
+ * @param currentGeneration Generation of the newest request; checked between fits
+ * @param pool Pool fitting the structures of a grouped snapshot
+ * @return Outcome including the formatted result message
+ */
+DataManager::AnalysisOutcome DataManager::runAnalysis(const QVector<DataPoint> &snapshot, Calculator::FitModel model,
+                                                      const Calculator::FitGeometry &geometry, quint64 generation, const QAtomicInteger<quint64> *currentGeneration,
+                                                      QThreadPool *pool)
+{
+    AnalysisOutcome outcome;
+    outcome.generation = generation;
+    auto isStale = [&]() {
+        return currentGeneration && currentGeneration->loadAcquire() != generation;
+    };
+
+    if (!Calculator::fit(model, snapshot, geometry, outcome.result)) {
+        outcome.message = QStringLiteral("Analysis failed. Please check your data.");
+        return outcome;
+    }
+    outcome.ok = true;
+    if (isStale()) {
+        outcome.superseded = true;
+        return outcome;
+    }
+
+    const Calculator::TLMResult &result = outcome.result;
+
+    // Format the result message
+    outcome.message = QString(
+        "TLM Analysis Results:\n"
+        "====================\n"
+        "Fit Model: %1\n"
+        "Sheet Resistance: %2 Ω/sq\n"
+        "Contact Resistance: %3 Ω\n"
+        "Specific Contact Resistivity: %4 Ω·cm²\n"
+        "Transfer Length: %5 μm\n"
+        "Linear Fit Slope: %6 Ω/μm\n"
+        "Linear Fit Intercept: %7 Ω\n"
+        "R² (Goodness of Fit): %8\n"
+        "Channel Width: %9 μm")
+        .arg(Calculator::fitModelName(model))
+        .arg(result.sheetResistance)
+        .arg(result.contactResistance)
+        .arg(result.specificContactResistivity)
+        .arg(result.transferLength)
+        .arg(result.slope)
+        .arg(result.intercept)
+        .arg(result.rSquared)
+        .arg(result.channelWidth);
+    if (model == Calculator::FitModel::EndResistance) {
+        outcome.message += QString("\nEnd Resistance: %1 Ω").arg(result.endResistance);
+    }
+
+    // Report each structure separately when folders were grouped
+    if (structuresOf(snapshot).size() > 1
+        && calculateStructureResults(snapshot, outcome.structureResults, model, geometry, pool)) {
+        if (isStale()) {
+            outcome.superseded = true;
+            return outcome;
+        }
+        outcome.message += QStringLiteral("\n\nPer-Structure Results:\n======================");
+        for (auto it = outcome.structureResults.cbegin(); it != outcome.structureResults.cend(); ++it) {
+            outcome.message += QString("\n%1: Rsh=%2 Ω/sq, Rc=%3 Ω, ρc=%4 Ω·cm², LT=%5 μm, R²=%6")
+                .arg(it.key().isEmpty() ? QStringLiteral("(root)") : it.key())
+                .arg(it.value().sheetResistance)
+                .arg(it.value().contactResistance)
+                .arg(it.value().specificContactResistivity)
+                .arg(it.value().transferLength)
+                .arg(it.value().rSquared);
+        }
+    }
+
+    return outcome;
+}
+
+QVariantMap DataManager::c_linearFit() const
+{
+    QVector<double> x, y;
+    for (const DataPoint &point : dataPoints) {
+        if (point.enabled) {
+            x.append(point.spacing);
+            y.append(point.resistance);
+        }
+    }
+    double slope = 0.0, intercept = 0.0;
+    QVariantMap map;
+    map["ok"] = Calculator::linearRegression(x, y, slope, intercept);
+    map["slope"] = slope;
+    map["intercept"] = intercept;
+    return map;
+}
+
+/**
+ * @brief The results store, opened on first use
+ * @return nullptr if recording is disabled or the database cannot be opened
+ *
+ * Opened again after a failure, e.g. once a locked file is released.
+ */
+ResultStore *DataManager::resultStore()
+{
+    ensureConfigLoaded();
+    const QString path = ResultStore::pathFor(m_appConfig);
+    if (path.isEmpty()) {
+        return nullptr;
+    }
+    if (!m_resultStore || m_resultStore->path() != path) {
+        m_resultStore = std::make_unique<ResultStore>(path);
+    }
+    if (!m_resultStore->isOpen() && !m_resultStore->open()) {
+        return nullptr;
+    }
+    return m_resultStore.get();
+}
+
+/**
+ * @brief Store the records of an analysis on the I/O pool
+ * @param records Records to store
+ *
+ * The commit syncs the database file, which must not stall the GUI thread.
+ * A SQLite connection belongs to the thread that opened it, so the task
+ * opens its own; recordings are serialised so two of them never wait on
+ * each other's write lock.
+ */
+void DataManager::recordResults(const QVector<ResultStore::Record> &records)
+{
+    ensureConfigLoaded();
+    const QString path = ResultStore::pathFor(m_appConfig);
+    if (path.isEmpty()) {
+        return;
+    }
+    m_pools.io()->run([this, path, records]() {
+        QMutexLocker locker(&m_recordMutex);
+        ResultStore store(path);
+        QVector<ResultStore::Record> stored = records;
+        if (store.open() && store.insert(stored)) {
+            QMetaObject::invokeMethod(this, "emitResultsRecorded", Qt::QueuedConnection,
+                                      Q_ARG(int, static_cast<int>(stored.size())));
+        }
+    });
+}
+
+/**
+ * @brief Emit resultsRecorded on the GUI thread
+ */
+void DataManager::emitResultsRecorded(int count)
+{
+    emit resultsRecorded(count);
+}
+
+QVariantMap DataManager::c_queryResults(const QString &query, int limit)
+{
+    QVariantMap map;
+    ResultStore *store = resultStore();
+    if (!store) {
+        map["ok"] = false;
+        map["error"] = QStringLiteral("The results store is not available");
+        return map;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    const QVector<ResultStore::Record> records = store->query(query, limit, &error);
+    QVariantList rows;
+    for (const ResultStore::Record &record : records) {
+        QVariantMap row;
+        row["id"] = record.id;
+        row["recordedAt"] = record.recordedAt;
+        row["lot"] = record.lot;
+        row["wafer"] = record.wafer;
+        row["die"] = record.die;
+        row["structure"] = record.structure;
+        row["folder"] = record.folder;
+        row["model"] = record.model;
+        row["points"] = record.points;
+        row["slope"] = record.result.slope;
+        row["intercept"] = record.result.intercept;
+        row["rSquared"] = record.result.rSquared;
+        row["sheetResistance"] = record.result.sheetResistance;
+        row["contactResistance"] = record.result.contactResistance;
+        row["specificContactResistivity"] = record.result.specificContactResistivity;
+        row["channelWidth"] = record.result.channelWidth;
+        row["transferLength"] = record.result.transferLength;
+        row["endResistance"] = record.result.endResistance;
+        rows.append(row);
+    }
+    map["micros"] = timer.nsecsElapsed() / 1000.0;
+    map["ok"] = error.isEmpty();
+    map["error"] = error;
+    map["rows"] = rows;
+    return map;
+}
+
+QVariantMap DataManager::c_resultTrend(const QString &query, const QString &groupBy, const QString &quantity)
+{
+    QVariantMap map;
+    ResultStore *store = resultStore();
+    if (!store) {
+        map["ok"] = false;
+        map["error"] = QStringLiteral("The results store is not available");
+        return map;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    const QVector<ResultStore::TrendRow> trend = store->trend(query, groupBy, quantity, &error);
+    QVariantList rows;
+    for (const ResultStore::TrendRow &entry : trend) {
+        QVariantMap row;
+        row["key"] = entry.key;
+        row["count"] = entry.count;
+        row["mean"] = entry.mean;
+        row["min"] = entry.minimum;
+        row["max"] = entry.maximum;
+        rows.append(row);
+    }
+    map["micros"] = timer.nsecsElapsed() / 1000.0;
+    map["ok"] = error.isEmpty();
+    map["error"] = error;
+    map["rows"] = rows;
+    return map;
+}
+
+QString DataManager::c_resultStorePath() const
+{
+    return ResultStore::pathFor(m_appConfig);
+}
+
+QVariantMap DataManager::c_lastAnalysisResult() const
+{
+    QVariantMap map;
+    map["slope"] = m_lastResult.slope;
+    map["intercept"] = m_lastResult.intercept;
+    map["rSquared"] = m_lastResult.rSquared;
+    map["sheetResistance"] = m_lastResult.sheetResistance;
+    map["contactResistance"] = m_lastResult.contactResistance;
+    map["specificContactResistivity"] = m_lastResult.specificContactResistivity;
+    map["channelWidth"] = m_lastResult.channelWidth;
+    map["transferLength"] = m_lastResult.transferLength;
+    map["endResistance"] = m_lastResult.endResistance;
+    return map;
+}
+
+QStringList DataManager::c_structures() const
+{
+    return structuresOf(dataPoints);
+}
+
+/**
+ * @brief Distinct structure names of points sorted by structure
+ * @param points Points sorted by structure
+ * @return Structure names in order
+ */
+QStringList DataManager::structuresOf(const QVector<DataPoint> &points)
+{
+    QStringList structures;
+    for (const DataPoint &point : points) {
+        // Points are kept sorted by structure, so duplicates are adjacent
+        if (structures.isEmpty() || structures.constLast() != point.structure) {
+            structures.append(point.structure);
+        }
+    }
+    return structures;
+}
+
+QVariantList DataManager::c_structureResults() const
+{
+    QVariantList list;
+    for (auto it = m_structureResults.cbegin(); it != m_structureResults.cend(); ++it) {
+        QVariantMap map;
+        map["structure"] = it.key();
+        map["slope"] = it.value().slope;
+        map["intercept"] = it.value().intercept;
+        map["rSquared"] = it.value().rSquared;
+        map["sheetResistance"] = it.value().sheetResistance;
+        map["contactResistance"] = it.value().contactResistance;
+        map["specificContactResistivity"] = it.value().specificContactResistivity;
+        map["channelWidth"] = it.value().channelWidth;
+        map["transferLength"] = it.value().transferLength;
+        map["endResistance"] = it.value().endResistance;
+        list.append(map);
+    }
+    return list;
+}
+
+QVariantList DataManager::c_spacingGroups() const
+{
+    QVariantList list;
+    for (const auto &[key, group] : m_spacingIndex.groups()) {
+        QVariantMap map;
+        map["structure"] = key.structure;
+        map["spacing"] = key.spacing;
+        map["count"] = group.count;
+        map["enabledCount"] = group.enabledCount;
+        map["mean"] = group.mean;
+        map["variance"] = group.variance();
+        map["stdDev"] = std::sqrt(group.variance());
+        list.append(map);
+    }
+    return list;
+}
+
+/**
+ * @brief Indices of enabled points that deviate from their replicates
+ * @param threshold Deviation limit in standard deviations of the other replicates
+ * @return Indices in collection order
+ *
+ * Each point is compared with the mean and standard deviation of the other
+ * enabled points at its spacing. Both follow from the group aggregates in
+ * O(1), so no group is re-scanned. Groups need at least three enabled points.
+ */
+QList<int> DataManager::c_replicateOutliers(double threshold) const
+{
+    QList<int> outliers;
+    for (qsizetype i = 0; i < dataPoints.size(); ++i) {
+        const DataPoint &point = dataPoints.at(i);
+        if (!point.enabled) {
+            continue;
+        }
+        const SpacingIndex::Group *group = m_spacingIndex.group(point.structure, point.spacing);
+        if (!group || group->enabledCount < 3) {
+            continue;
+        }
+
+        // Leave the point out of its own group's statistics
+        const int others = group->enabledCount - 1;
+        const double otherMean = (group->mean * group->enabledCount - point.resistance) / others;
+        const double otherM2 = group->m2 - (point.resistance - group->mean) * (point.resistance - otherMean);
+        const double otherStdDev = std::sqrt(std::max(otherM2, 0.0) / (others - 1));
+        if (otherStdDev > 0.0 && std::abs(point.resistance - otherMean) > threshold * otherStdDev) {
+            outliers.append(static_cast<int>(i));
+        }
+    }
+    return outliers;
+}
+
+/**
+ * @brief Current index of the point with a given handle
+ * @param handle Stable handle of the point
+ * @return Index, or -1 if no point has that handle
+ *
+ * The handle-to-row map is built on the first lookup after a change and
+ * dropped by the next publish, so the lookups a view makes between two
+ * edits cost O(1) each.
+ */
+int DataManager::c_indexOfHandle(qulonglong handle) const
+{
+    if (m_handleRows.isEmpty()) {
+        m_handleRows.reserve(dataPoints.size());
+        for (qsizetype i = 0; i < dataPoints.size(); ++i) {
+            m_handleRows.insert(dataPoints.at(i).handle, static_cast<int>(i));
+        }
+    }
+    return m_handleRows.value(handle, -1);
+}
+
+/**
+ * @brief Get the number of data points in the collection
+ * @return The size of the internal data points collection
+ */
+qsizetype DataManager::size() const
+{
+    return dataPoints.size();
+}
+
+/**
+ * @brief Access a data point at the specified index
+ * @param index The index of the data point to access
+ * @return A const reference to the data point at the specified index
+ */
+const DataPoint& DataManager::at(qsizetype index) const
+{
+    return dataPoints.at(index);
+}
+
+/**
+ * @brief Calculate TLM results using linear regression with specified channel width
+ * @param result Reference to a TLMResult object to store the calculation results
+ * @param channelWidth Width of the channel in μm
+ * @return True if the calculation was successful, false otherwise
+ * 
+ * Performs linear regression analysis on the data points and stores the
+ * results in the provided TLMResult object.
+ */
+bool DataManager::calculateTLMResults(Calculator::TLMResult &result, double channelWidth) const
+{
+    return Calculator::fit(m_fitModel, dataPoints, fitGeometry(channelWidth), result);
+}
+
+/**
+ * @brief Calculate TLM results separately for every structure
+ * @param results Map receiving one result per structure that could be fitted
+ * @param channelWidth Width of the channel in μm
+ * @return True if at least one structure could be fitted
+ *
+ * Relies on the collection being sorted by structure, so each structure is
+ * a contiguous run of points.
+ */
+bool DataManager::calculateStructureResults(QMap<QString, Calculator::TLMResult> &results, double channelWidth) const
+{
+    return calculateStructureResults(dataPoints, results, m_fitModel, fitGeometry(channelWidth));
+}
+
+/**
+ * @brief Calculate TLM results separately for every structure of a point set
+ * @param dataPoints Points sorted by structure
+ * @param results Map receiving one result per structure that could be fitted
+ * @param model Structure model used for every structure
+ * @param geometry Structure geometry
+ * @param pool Pool fitting the structures in parallel; nullptr fits them on the calling thread
+ * @return True if at least one structure could be fitted
+ *
+ * Each structure is a contiguous run of points. Structures are fitted
+ * independently and collected in order, so the result does not depend on
+ * the pool. Safe to call from any thread.
+ */
+bool DataManager::calculateStructureResults(const QVector<DataPoint> &dataPoints,
+                                            QMap<QString, Calculator::TLMResult> &results,
+                                            Calculator::FitModel model, const Calculator::FitGeometry &geometry,
+                                            QThreadPool *pool)
+{
+    QVector<qsizetype> starts;
+    for (qsizetype begin = 0; begin < dataPoints.size();) {
+        starts.append(begin);
+        qsizetype end = begin + 1;
+        while (end < dataPoints.size() && dataPoints.at(end).structure == dataPoints.at(begin).structure) {
+            ++end;
+        }
+        begin = end;
+    }
+    const qsizetype structures = starts.size();
+    starts.append(dataPoints.size());
+
+    QVector<Calculator::TLMResult> fits(structures);
+    QVector<char> fitted(structures, 0);
+    Calculator::TLMResult *fitOut = fits.data();
+    char *fittedOut = fitted.data();
+    auto fitRange = [&](qsizetype first, qsizetype last) {
+        for (qsizetype i = first; i < last; ++i) {
+            const qsizetype begin = starts.at(i);
+            fittedOut[i] = Calculator::fit(model, dataPoints.mid(begin, starts.at(i + 1) - begin), geometry, fitOut[i]);
+        }
+    };
+    if (pool) {
+        WorkerPool::parallelFor(pool, structures, fitRange);
+    } else {
+        fitRange(0, structures);
+    }
+
+    for (qsizetype i = 0; i < structures; ++i) {
+        if (fitted.at(i)) {
+            results.insert(dataPoints.at(starts.at(i)).structure, fits.at(i));
+        }
+    }
+    return !results.isEmpty();
+}
+
+/**
+ * @brief Leave-one-out influence diagnostics of the current collection
+ * @return One entry per point, parallel to the collection
+ *
+ * Each structure (a contiguous run of the sorted collection) is diagnosed
+ * against its own fit. Costs O(n), so it is recomputed on every publish.
+ */
+QVector<Calculator::InfluenceDiagnostics> DataManager::computeDiagnostics() const
+{
+    QVector<Calculator::InfluenceDiagnostics> diagnostics;
+    diagnostics.reserve(dataPoints.size());
+    qsizetype begin = 0;
+    while (begin < dataPoints.size()) {
+        qsizetype end = begin + 1;
+        while (end < dataPoints.size() && dataPoints.at(end).structure == dataPoints.at(begin).structure) {
+            ++end;
+        }
+        diagnostics += computeDiagnostics(begin, end);
+        begin = end;
+    }
+    return diagnostics;
+}
+
+/**
+ * @brief Leave-one-out influence diagnostics of one structure
+ * @param begin First row of the structure
+ * @param end Row after the structure's last point
+ */
+QVector<Calculator::InfluenceDiagnostics> DataManager::computeDiagnostics(qsizetype begin, qsizetype end) const
+{
+    return Calculator::influenceDiagnostics(m_fitModel, dataPoints.mid(begin, end - begin), fitGeometry(m_channelWidth));
+}
+
+/**
+ * @brief Rows [first, second) of a structure, found by binary search
+ *
+ * Relies on the collection being sorted by structure; an unknown structure
+ * yields an empty run at its sorted position.
+ */
+std::pair<qsizetype, qsizetype> DataManager::structureRun(const QString &structure) const
+{
+    struct StructureLess {
+        bool operator()(const DataPoint &point, const QString &name) const { return point.structure < name; }
+        bool operator()(const QString &name, const DataPoint &point) const { return name < point.structure; }
+    };
+    const auto [first, last] = std::equal_range(dataPoints.cbegin(), dataPoints.cend(), structure, StructureLess());
+    return {first - dataPoints.cbegin(), last - dataPoints.cbegin()};
+}
+
+/**
+ * @brief Emit progress update for loading data
+ * @param progress The progress percentage (0-100)
+ *
+ * Emits the progressUpdated signal with the specified progress value.
+ */
+void DataManager::emitProgress(int progress)
+{
+    emit progressUpdated(progress);
+}
+
+/**
+ * @brief Emit export progress
+ * @param progress The progress percentage (0-100)
+ */
+void DataManager::emitExportProgress(int progress)
+{
+    emit exportProgressUpdated(progress);
+}
+
+/**
+ * @brief Emit progress update for one folder of a load
+ * @param folderPath Folder as passed to c_loadDataFromFolders()
+ * @param progress The progress percentage (0-100)
+ */
+void DataManager::emitFolderProgress(const QString &folderPath, int progress)
+{
+    emit folderProgressUpdated(folderPath, progress);
 }
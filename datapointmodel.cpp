@@ -1,5 +1,6 @@
 #include "include/datapointmodel.h"
 #include <QVariantMap>
+#include <algorithm>
 
 DataPointModel::DataPointModel(QObject *parent)
     : QAbstractListModel(parent)
@@ -21,6 +22,24 @@ QVariant DataPointModel::data(const QModelIndex &index, int role) const
         case ResistanceRole: return p.resistance;
         case CurrentRole: return p.current;
         case EnabledRole: return p.enabled;
+        case StructureRole: return p.structure;
+        case SourceRole: return p.source;
+        case OriginRole: return p.origin;
+        case HandleRole: return p.handle;
+        default: break;
+    }
+
+    // Influence diagnostics; neutral values until they have been computed
+    const Calculator::InfluenceDiagnostics d = index.row() < m_diagnostics.size()
+        ? m_diagnostics.at(index.row()) : Calculator::InfluenceDiagnostics();
+    switch (role) {
+        case LeverageRole: return d.leverage;
+        case ResidualRole: return d.residual;
+        case StudentizedResidualRole: return d.studentizedResidual;
+        case CooksDistanceRole: return d.cooksDistance;
+        case LooSheetResistanceRole: return d.looSheetResistance;
+        case LooContactResistanceRole: return d.looContactResistance;
+        case InfluentialRole: return d.influential;
         default: return {};
     }
 }
@@ -32,16 +51,78 @@ QHash<int, QByteArray> DataPointModel::roleNames() const
     roles[ResistanceRole] = "resistance";
     roles[CurrentRole] = "current";
     roles[EnabledRole] = "enabled";
+    roles[StructureRole] = "structure";
+    roles[SourceRole] = "source";
+    roles[OriginRole] = "origin";
+    roles[HandleRole] = "handle";
+    roles[LeverageRole] = "leverage";
+    roles[ResidualRole] = "residual";
+    roles[StudentizedResidualRole] = "studentizedResidual";
+    roles[CooksDistanceRole] = "cooksDistance";
+    roles[LooSheetResistanceRole] = "looSheetResistance";
+    roles[LooContactResistanceRole] = "looContactResistance";
+    roles[InfluentialRole] = "influential";
     return roles;
 }
 
-void DataPointModel::setDataPoints(const QVector<DataPoint> &points)
+void DataPointModel::setDataPoints(const QVector<DataPoint> &points,
+                                   const QVector<Calculator::InfluenceDiagnostics> &diagnostics)
 {
     beginResetModel();
     m_points = points;
+    m_diagnostics = diagnostics;
     endResetModel();
 }
 
+void DataPointModel::setDiagnostics(const QVector<Calculator::InfluenceDiagnostics> &diagnostics)
+{
+    m_diagnostics = diagnostics;
+    if (!m_points.isEmpty()) {
+        emit dataChanged(index(0), index(static_cast<int>(m_points.size()) - 1),
+                         {LeverageRole, ResidualRole, StudentizedResidualRole, CooksDistanceRole,
+                          LooSheetResistanceRole, LooContactResistanceRole, InfluentialRole});
+    }
+}
+
+void DataPointModel::setDiagnostics(int first, const QVector<Calculator::InfluenceDiagnostics> &diagnostics)
+{
+    if (diagnostics.isEmpty() || first < 0 || first + diagnostics.size() > m_points.size()) return;
+    m_diagnostics.resize(m_points.size());
+    std::copy(diagnostics.cbegin(), diagnostics.cend(), m_diagnostics.begin() + first);
+    emit dataChanged(index(first), index(first + static_cast<int>(diagnostics.size()) - 1),
+                     {LeverageRole, ResidualRole, StudentizedResidualRole, CooksDistanceRole,
+                      LooSheetResistanceRole, LooContactResistanceRole, InfluentialRole});
+}
+
+void DataPointModel::setPoint(int row, const DataPoint &point)
+{
+    if (row < 0 || row >= m_points.size()) return;
+    m_points[row] = point;
+    emit dataChanged(index(row), index(row));
+}
+
+void DataPointModel::insertPoint(int row, const DataPoint &point)
+{
+    if (row < 0 || row > m_points.size()) return;
+    beginInsertRows(QModelIndex(), row, row);
+    m_points.insert(row, point);
+    if (m_diagnostics.size() + 1 == m_points.size()) {
+        m_diagnostics.insert(row, Calculator::InfluenceDiagnostics());
+    }
+    endInsertRows();
+}
+
+void DataPointModel::removePoint(int row)
+{
+    if (row < 0 || row >= m_points.size()) return;
+    beginRemoveRows(QModelIndex(), row, row);
+    m_points.remove(row);
+    if (row < m_diagnostics.size()) {
+        m_diagnostics.remove(row);
+    }
+    endRemoveRows();
+}
+
 QVariantMap DataPointModel::get(int index) const
 {
     QVariantMap map;
@@ -51,5 +132,19 @@ QVariantMap DataPointModel::get(int index) const
     map["resistance"] = p.resistance;
     map["current"] = p.current;
     map["enabled"] = p.enabled;
+    map["structure"] = p.structure;
+    map["source"] = p.source;
+    map["origin"] = p.origin;
+    map["handle"] = p.handle;
+    if (index < m_diagnostics.size()) {
+        const Calculator::InfluenceDiagnostics &d = m_diagnostics.at(index);
+        map["leverage"] = d.leverage;
+        map["residual"] = d.residual;
+        map["studentizedResidual"] = d.studentizedResidual;
+        map["cooksDistance"] = d.cooksDistance;
+        map["looSheetResistance"] = d.looSheetResistance;
+        map["looContactResistance"] = d.looContactResistance;
+        map["influential"] = d.influential;
+    }
     return map;
 }
@@ -0,0 +1,160 @@
+#include "include/filediscovery.h"
+#include "include/archivereader.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+
+namespace {
+
+QVector<QRegularExpression> compilePatterns(const QStringList &patterns)
+{
+    QVector<QRegularExpression> compiled;
+    compiled.reserve(patterns.size());
+    for (const QString &pattern : patterns) {
+        if (pattern.isEmpty()) {
+            continue;
+        }
+        QRegularExpression re(QRegularExpression::wildcardToRegularExpression(
+                                  pattern, QRegularExpression::NonPathWildcardConversion),
+                              QRegularExpression::CaseInsensitiveOption);
+        re.optimize();
+        compiled.append(re);
+    }
+    return compiled;
+}
+
+bool matchesAny(const QVector<QRegularExpression> &patterns, const QString &text)
+{
+    for (const QRegularExpression &re : patterns) {
+        if (re.match(text).hasMatch()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+/**
+ * @brief Build options from the persisted application configuration
+ * @param config Application configuration
+ * @return Discovery options
+ */
+DiscoveryOptions DiscoveryOptions::fromConfig(const AppConfig &config)
+{
+    DiscoveryOptions options;
+    options.recursive = config.scan_recursive;
+    if (!config.include_patterns.isEmpty()) {
+        options.includePatterns = config.include_patterns;
+    }
+    if (config.ingest_archives) {
+        options.includePatterns += ArchiveReader::archivePatterns();
+    }
+    options.excludePatterns = config.exclude_patterns;
+    options.groupByFolder = config.group_by_folder;
+    return options;
+}
+
+/**
+ * @brief Constructor
+ * @param options Discovery options; patterns are compiled once here
+ */
+FileDiscovery::FileDiscovery(const DiscoveryOptions &options)
+    : m_options(options),
+      m_include(compilePatterns(options.includePatterns)),
+      m_exclude(compilePatterns(options.excludePatterns))
+{
+}
+
+/**
+ * @brief Walk a root folder and report matching files
+ * @param rootPath Folder to walk
+ * @param visitor Called for every matching file, in walk order
+ * @param cancelFlag Optional flag; the walk stops when it becomes non-zero
+ * @return Number of files passed to the visitor
+ *
+ * Uses an explicit stack of pending folders. Each folder is listed with a
+ * non-recursive QDirIterator, which streams entries from the file system
+ * instead of materialising the listing. Files of a folder are reported
+ * before its sub-folders are entered.
+ */
+qsizetype FileDiscovery::discover(const QString &rootPath, const Visitor &visitor,
+                                  const QAtomicInt *cancelFlag) const
+{
+    const QDir root(rootPath);
+    QStringList pending {root.absolutePath()};
+    qsizetype reported = 0;
+
+    while (!pending.isEmpty()) {
+        const QString dirPath = pending.takeLast();
+        const QString group = m_options.groupByFolder ? root.relativeFilePath(dirPath) : QString();
+        QStringList subDirs;
+
+        QDir::Filters filters = QDir::Files | QDir::Readable;
+        if (m_options.recursive) {
+            filters |= QDir::Dirs | QDir::NoDotAndDotDot;
+        }
+
+        QDirIterator it(dirPath, filters);
+        while (it.hasNext()) {
+            if (cancelFlag && cancelFlag->loadAcquire() != 0) {
+                return reported;
+            }
+            it.next();
+            const QFileInfo info = it.fileInfo();
+            const QString relativePath = root.relativeFilePath(info.absoluteFilePath());
+
+            if (info.isDir()) {
+                if (!info.isSymLink() && acceptsDirectory(info.fileName(), relativePath)) {
+                    subDirs.append(info.absoluteFilePath());
+                }
+                continue;
+            }
+
+            if (!acceptsFile(info.fileName(), relativePath)) {
+                continue;
+            }
+
+            DiscoveredFile file;
+            file.path = info.absoluteFilePath();
+            file.fileName = info.fileName();
+            file.group = (group == QLatin1String(".")) ? QString() : group;
+            ++reported;
+            if (!visitor(std::move(file))) {
+                return reported;
+            }
+        }
+
+        // Push in reverse so sub-folders are visited in listing order
+        for (qsizetype i = subDirs.size() - 1; i >= 0; --i) {
+            pending.append(subDirs.at(i));
+        }
+    }
+
+    return reported;
+}
+
+/**
+ * @brief Check a file against the include and exclude patterns
+ * @param fileName File name without directory
+ * @param relativePath Path relative to the walked root
+ * @return True if the file should be processed
+ */
+bool FileDiscovery::acceptsFile(const QString &fileName, const QString &relativePath) const
+{
+    if (!m_include.isEmpty() && !matchesAny(m_include, fileName)) {
+        return false;
+    }
+    return !matchesAny(m_exclude, fileName) && !matchesAny(m_exclude, relativePath);
+}
+
+/**
+ * @brief Check whether a folder should be descended into
+ * @param dirName Folder name without parent
+ * @param relativePath Path relative to the walked root
+ * @return True unless the folder matches an exclude pattern
+ */
+bool FileDiscovery::acceptsDirectory(const QString &dirName, const QString &relativePath) const
+{
+    return !matchesAny(m_exclude, dirName) && !matchesAny(m_exclude, relativePath);
+}
@@ -0,0 +1,610 @@
+#include "include/filenameindex.h"
+#include "include/csvprocessor.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QDebug>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief Constructor
+ * @param templates Templates in priority order
+ *
+ * Each template becomes one anchored, case-insensitive regular expression
+ * that is optimized up front, so matching a file costs one regex run per
+ * template tried.
+ */
+FilenameTemplates::FilenameTemplates(const QStringList &templates)
+{
+    for (const QString &text : templates) {
+        if (text.trimmed().isEmpty()) {
+            continue;
+        }
+        Compiled compiled;
+        QString error;
+        const QString pattern = toPattern(text.trimmed(), compiled.fields, &error);
+        if (pattern.isEmpty()) {
+            m_errors.append(QStringLiteral("%1: %2").arg(text, error));
+            qDebug() << "Invalid filename template" << text << error;
+            continue;
+        }
+        compiled.regex = QRegularExpression(pattern, QRegularExpression::CaseInsensitiveOption);
+        if (!compiled.regex.isValid()) {
+            m_errors.append(QStringLiteral("%1: %2").arg(text, compiled.regex.errorString()));
+            qDebug() << "Invalid filename template" << text << compiled.regex.errorString();
+            continue;
+        }
+        compiled.regex.optimize();
+        compiled.spacingField = static_cast<int>(compiled.fields.indexOf(QStringLiteral("spacing")));
+        m_templates.append(compiled);
+    }
+}
+
+QStringList FilenameTemplates::fieldNames() const
+{
+    QStringList names;
+    for (const Compiled &compiled : m_templates) {
+        for (const QString &field : compiled.fields) {
+            if (!names.contains(field)) {
+                names.append(field);
+            }
+        }
+    }
+    return names;
+}
+
+/**
+ * @brief Match a file name
+ * @param fileName File name without directory
+ * @param names Receives the field names of the matching template
+ * @param values Receives the field values, parallel to names
+ * @return Index of the matching template, or -1
+ */
+int FilenameTemplates::match(const QString &fileName, QStringList &names, QStringList &values) const
+{
+    const QString baseName = QFileInfo(fileName).completeBaseName();
+    for (int i = 0; i < m_templates.size(); ++i) {
+        const Compiled &compiled = m_templates.at(i);
+        const QRegularExpressionMatch match = compiled.regex.match(baseName);
+        if (!match.hasMatch()) {
+            continue;
+        }
+        names = compiled.fields;
+        values.clear();
+        for (int f = 0; f < compiled.fields.size(); ++f) {
+            values.append(match.captured(f + 1));
+        }
+        return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Pad spacing encoded in a file name
+ * @param fileName File name without directory
+ * @return Spacing in μm, or -1
+ */
+double FilenameTemplates::spacing(const QString &fileName) const
+{
+    if (!m_templates.isEmpty()) {
+        const QString baseName = QFileInfo(fileName).completeBaseName();
+        for (const Compiled &compiled : m_templates) {
+            if (compiled.spacingField < 0) {
+                continue;
+            }
+            const QRegularExpressionMatch match = compiled.regex.match(baseName);
+            if (match.hasMatch()) {
+                bool ok = false;
+                const double value = match.captured(compiled.spacingField + 1).toDouble(&ok);
+                return ok && value > 0 ? value : -1;
+            }
+        }
+    }
+    return CSVProcessor::extractSpacingFromFilename(fileName);
+}
+
+/**
+ * @brief Translate a template into a regular expression
+ * @param text Template
+ * @param fields Receives the placeholder names in order
+ * @param error Receives a description of the problem, if any
+ * @return Anchored pattern with one capture group per placeholder, empty on error
+ *
+ * Placeholders become numbered groups in field order, so field names are
+ * not restricted to what PCRE accepts as group names.
+ */
+QString FilenameTemplates::toPattern(const QString &text, QStringList &fields, QString *error)
+{
+    static const QRegularExpression nameRegex(QStringLiteral("^[A-Za-z_][A-Za-z0-9_]*$"));
+    auto fail = [error](const QString &message) {
+        if (error) {
+            *error = message;
+        }
+        return QString();
+    };
+
+    fields.clear();
+    QString pattern = QStringLiteral("^");
+    QString literal;
+    auto flushLiteral = [&]() {
+        pattern += QRegularExpression::escape(literal);
+        literal.clear();
+    };
+
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const QChar c = text.at(i);
+        if (c == QLatin1Char('*')) {
+            flushLiteral();
+            pattern += QStringLiteral(".*?");
+            continue;
+        }
+        if (c != QLatin1Char('{')) {
+            literal += c;
+            continue;
+        }
+
+        // Placeholder: find the matching brace, allowing braces inside a custom pattern
+        qsizetype depth = 1;
+        qsizetype end = i + 1;
+        for (; end < text.size() && depth > 0; ++end) {
+            if (text.at(end) == QLatin1Char('{')) ++depth;
+            else if (text.at(end) == QLatin1Char('}')) --depth;
+        }
+        if (depth != 0) {
+            return fail(QStringLiteral("unterminated placeholder at position %1").arg(i));
+        }
+        const QString body = text.mid(i + 1, end - i - 2);
+        const qsizetype colon = body.indexOf(QLatin1Char(':'));
+        const QString name = (colon < 0 ? body : body.left(colon)).trimmed().toLower();
+        if (!nameRegex.match(name).hasMatch()) {
+            return fail(QStringLiteral("invalid field name \"%1\"").arg(name));
+        }
+        if (fields.contains(name)) {
+            return fail(QStringLiteral("field \"%1\" appears twice").arg(name));
+        }
+        QString fieldPattern;
+        if (colon >= 0) {
+            fieldPattern = body.mid(colon + 1);
+        } else if (name == QLatin1String("spacing")) {
+            fieldPattern = QStringLiteral("\\d+(?:\\.\\d+)?");
+        } else {
+            fieldPattern = QStringLiteral(".+?");
+        }
+        flushLiteral();
+        // Inner groups of custom patterns must not shift the field numbering
+        if (QRegularExpression(fieldPattern).captureCount() > 0) {
+            return fail(QStringLiteral("pattern of \"%1\" must use (?:...) instead of capturing groups").arg(name));
+        }
+        pattern += QLatin1Char('(') + fieldPattern + QLatin1Char(')');
+        fields.append(name);
+        i = end - 1;
+    }
+    flushLiteral();
+    pattern += QLatin1Char('$');
+    return pattern;
+}
+
+/**
+ * @brief Add an id; cheapest when ids arrive in ascending order
+ */
+void FilenameIndex::Bitmap::set(FileId id)
+{
+    const qsizetype word = id / 64;
+    if (m_words.isEmpty()) {
+        m_firstWord = word;
+        m_words.append(0);
+    } else if (word < m_firstWord) {
+        m_words.insert(qsizetype(0), m_firstWord - word, quint64(0));
+        m_firstWord = word;
+    } else if (word >= m_firstWord + m_words.size()) {
+        m_words.resize(word - m_firstWord + 1, quint64(0));
+    }
+    m_words[word - m_firstWord] |= quint64(1) << (id % 64);
+}
+
+bool FilenameIndex::Bitmap::contains(FileId id) const
+{
+    const qsizetype word = id / 64 - m_firstWord;
+    return word >= 0 && word < m_words.size() && (m_words.at(word) >> (id % 64)) & 1;
+}
+
+qsizetype FilenameIndex::Bitmap::count() const
+{
+    qsizetype total = 0;
+    for (quint64 word : m_words) {
+        total += qPopulationCount(word);
+    }
+    return total;
+}
+
+QVector<FilenameIndex::FileId> FilenameIndex::Bitmap::ids() const
+{
+    QVector<FileId> result;
+    result.reserve(count());
+    for (qsizetype w = 0; w < m_words.size(); ++w) {
+        quint64 word = m_words.at(w);
+        while (word) {
+            const int bit = qCountTrailingZeroBits(word);
+            result.append(static_cast<FileId>((m_firstWord + w) * 64 + bit));
+            word &= word - 1;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Intersection
+ *
+ * Only the overlap of the two word ranges is visited.
+ */
+FilenameIndex::Bitmap FilenameIndex::Bitmap::operator&(const Bitmap &other) const
+{
+    Bitmap result;
+    const qsizetype first = std::max(m_firstWord, other.m_firstWord);
+    const qsizetype end = std::min(m_firstWord + m_words.size(), other.m_firstWord + other.m_words.size());
+    if (first >= end) {
+        return result;
+    }
+    result.m_firstWord = first;
+    result.m_words.resize(end - first);
+    for (qsizetype w = first; w < end; ++w) {
+        result.m_words[w - first] = m_words.at(w - m_firstWord) & other.m_words.at(w - other.m_firstWord);
+    }
+    result.trim();
+    return result;
+}
+
+/**
+ * @brief Union, in place
+ */
+FilenameIndex::Bitmap &FilenameIndex::Bitmap::operator|=(const Bitmap &other)
+{
+    if (other.m_words.isEmpty()) {
+        return *this;
+    }
+    if (m_words.isEmpty()) {
+        *this = other;
+        return *this;
+    }
+    const qsizetype first = std::min(m_firstWord, other.m_firstWord);
+    const qsizetype end = std::max(m_firstWord + m_words.size(), other.m_firstWord + other.m_words.size());
+    if (first < m_firstWord) {
+        m_words.insert(qsizetype(0), m_firstWord - first, quint64(0));
+        m_firstWord = first;
+    }
+    m_words.resize(end - first, quint64(0));
+    for (qsizetype w = 0; w < other.m_words.size(); ++w) {
+        m_words[other.m_firstWord - first + w] |= other.m_words.at(w);
+    }
+    return *this;
+}
+
+FilenameIndex::Bitmap FilenameIndex::Bitmap::range(qsizetype count)
+{
+    Bitmap result;
+    if (count <= 0) {
+        return result;
+    }
+    result.m_words.fill(~quint64(0), (count + 63) / 64);
+    if (count % 64) {
+        result.m_words.last() = (quint64(1) << (count % 64)) - 1;
+    }
+    return result;
+}
+
+/**
+ * @brief Drop zero words at both ends so the stored range stays tight
+ */
+void FilenameIndex::Bitmap::trim()
+{
+    qsizetype begin = 0;
+    while (begin < m_words.size() && m_words.at(begin) == 0) {
+        ++begin;
+    }
+    qsizetype end = m_words.size();
+    while (end > begin && m_words.at(end - 1) == 0) {
+        --end;
+    }
+    if (begin == end) {
+        m_words.clear();
+        m_firstWord = 0;
+        return;
+    }
+    m_words = m_words.mid(begin, end - begin);
+    m_firstWord += begin;
+}
+
+/**
+ * @brief Constructor
+ * @param templates Filename templates
+ */
+FilenameIndex::FilenameIndex(const QStringList &templates)
+    : m_templates(templates)
+{
+    for (const QString &name : m_templates.fieldNames()) {
+        fieldIndex(name);
+    }
+    fieldIndex(QStringLiteral("spacing"));
+    fieldIndex(QStringLiteral("group"));
+}
+
+/**
+ * @brief Walk folders and index every discovered file
+ */
+qsizetype FilenameIndex::addFolders(const QStringList &folderPaths, const DiscoveryOptions &options,
+                                    const QAtomicInt *cancelFlag)
+{
+    const FileDiscovery discovery(options);
+    qsizetype added = 0;
+    for (const QString &folder : folderPaths) {
+        const QString root = QDir(folder).absolutePath();
+        added += discovery.discover(root, [this, &root](DiscoveredFile &&file) {
+            add(root, file);
+            return true;
+        }, cancelFlag);
+        if (cancelFlag && cancelFlag->loadAcquire() != 0) {
+            break;
+        }
+    }
+    return added;
+}
+
+/**
+ * @brief Index one file
+ * @param root Folder the file was found in
+ * @param file The file
+ * @return Id of the file
+ */
+FilenameIndex::FileId FilenameIndex::add(const QString &root, const DiscoveredFile &file)
+{
+    const FileId id = static_cast<FileId>(m_paths.size());
+    qsizetype rootId = m_roots.indexOf(root);
+    if (rootId < 0) {
+        rootId = m_roots.size();
+        m_roots.append(root);
+    }
+    m_paths.append(file.path);
+    m_groups.append(file.group);
+    m_rootIds.append(static_cast<quint32>(rootId));
+
+    QStringList names, values;
+    double spacing = -1;
+    if (m_templates.match(file.fileName, names, values) >= 0) {
+        for (int f = 0; f < names.size(); ++f) {
+            post(fieldIndex(names.at(f)), values.at(f), id);
+        }
+        const qsizetype spacingField = names.indexOf(QStringLiteral("spacing"));
+        if (spacingField >= 0) {
+            spacing = values.at(spacingField).toDouble();
+        }
+    } else {
+        spacing = CSVProcessor::extractSpacingFromFilename(file.fileName);
+        if (spacing > 0) {
+            post(fieldIndex(QStringLiteral("spacing")), QString::number(spacing), id);
+        }
+    }
+    m_spacings.append(spacing > 0 ? spacing : -1);
+    if (!file.group.isEmpty()) {
+        post(fieldIndex(QStringLiteral("group")), file.group, id);
+    }
+    return id;
+}
+
+void FilenameIndex::clear()
+{
+    for (Field &field : m_fields) {
+        field.ids.clear();
+        field.values.clear();
+        field.numbers.clear();
+        field.postings.clear();
+    }
+    m_paths.clear();
+    m_spacings.clear();
+    m_groups.clear();
+    m_rootIds.clear();
+    m_roots.clear();
+}
+
+QStringList FilenameIndex::fields() const
+{
+    QStringList names;
+    for (const Field &field : m_fields) {
+        names.append(field.name);
+    }
+    return names;
+}
+
+QStringList FilenameIndex::values(const QString &field) const
+{
+    const int index = m_fieldIndex.value(field.toLower(), -1);
+    return index < 0 ? QStringList() : m_fields.at(index).values;
+}
+
+/**
+ * @brief Position of a field, created on first use
+ */
+int FilenameIndex::fieldIndex(const QString &name)
+{
+    const QString key = name.toLower();
+    auto it = m_fieldIndex.constFind(key);
+    if (it != m_fieldIndex.constEnd()) {
+        return it.value();
+    }
+    Field field;
+    field.name = key;
+    m_fields.append(field);
+    m_fieldIndex.insert(key, static_cast<int>(m_fields.size() - 1));
+    return static_cast<int>(m_fields.size() - 1);
+}
+
+/**
+ * @brief Add a file to the posting of one field value
+ */
+void FilenameIndex::post(int fieldIndex, const QString &value, FileId id)
+{
+    Field &field = m_fields[fieldIndex];
+    auto it = field.ids.constFind(value);
+    quint32 valueId;
+    if (it == field.ids.constEnd()) {
+        valueId = static_cast<quint32>(field.values.size());
+        field.ids.insert(value, valueId);
+        field.values.append(value);
+        bool ok = false;
+        const double number = value.toDouble(&ok);
+        field.numbers.append(ok ? number : std::numeric_limits<double>::quiet_NaN());
+        field.postings.append(Bitmap());
+    } else {
+        valueId = it.value();
+    }
+    field.postings[valueId].set(id);
+}
+
+/**
+ * @brief Parse a query
+ * @param text Query text; empty selects every file
+ * @param conditions Receives the conditions
+ * @param error Receives a description of the problem, if any
+ * @return False if the text is not a valid query
+ */
+bool FilenameIndex::parseQuery(const QString &text, QVector<Condition> &conditions, QString *error)
+{
+    static const QRegularExpression conditionRegex(
+        QStringLiteral("\\G[\\s,]*(?:(?i:and)\\s+)?([A-Za-z_][A-Za-z0-9_]*)\\s*(==|=|!=|<=|>=|<|>)\\s*([^\\s,]+)"));
+    static const QRegularExpression trailingRegex(QStringLiteral("^[\\s,]*$"));
+
+    conditions.clear();
+    qsizetype position = 0;
+    QRegularExpressionMatch match;
+    while ((match = conditionRegex.match(text, position)).hasMatch()) {
+        Condition condition;
+        condition.field = match.captured(1).toLower();
+        const QString op = match.captured(2);
+        if (op == QLatin1String("!=")) condition.op = Op::NotEqual;
+        else if (op == QLatin1String("<")) condition.op = Op::Less;
+        else if (op == QLatin1String("<=")) condition.op = Op::LessEqual;
+        else if (op == QLatin1String(">")) condition.op = Op::Greater;
+        else if (op == QLatin1String(">=")) condition.op = Op::GreaterEqual;
+        else condition.op = Op::Equal;
+        condition.values = condition.op == Op::Equal ? match.captured(3).split(QLatin1Char('|'), Qt::SkipEmptyParts)
+                                                     : QStringList {match.captured(3)};
+        if (condition.values.isEmpty()) {
+            if (error) {
+                *error = QStringLiteral("Missing value for \"%1\"").arg(condition.field);
+            }
+            return false;
+        }
+        conditions.append(condition);
+        position = match.capturedEnd(0);
+    }
+    if (!trailingRegex.match(text.mid(position)).hasMatch()) {
+        if (error) {
+            *error = QStringLiteral("Cannot parse query at \"%1\"").arg(text.mid(position).trimmed());
+        }
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Files satisfying every condition
+ * @param conditions Conditions to AND
+ * @param error Receives a description of the problem, if any
+ * @return Matching file ids
+ */
+FilenameIndex::Bitmap FilenameIndex::select(const QVector<Condition> &conditions, QString *error) const
+{
+    Bitmap result = Bitmap::range(m_paths.size());
+    for (const Condition &condition : conditions) {
+        const int index = m_fieldIndex.value(condition.field.toLower(), -1);
+        if (index < 0) {
+            if (error) {
+                *error = QStringLiteral("Unknown field \"%1\"; available: %2").arg(condition.field, fields().join(QStringLiteral(", ")));
+            }
+            return Bitmap();
+        }
+        const Field &field = m_fields.at(index);
+
+        // Alternatives as numbers when all of them are numeric
+        QVector<double> numbers;
+        for (const QString &value : condition.values) {
+            bool ok = false;
+            const double number = value.toDouble(&ok);
+            if (!ok) {
+                numbers.clear();
+                break;
+            }
+            numbers.append(number);
+        }
+        const bool numeric = numbers.size() == condition.values.size();
+
+        Bitmap matching;
+        for (qsizetype v = 0; v < field.values.size(); ++v) {
+            const double number = field.numbers.at(v);
+            bool accepted = false;
+            if (numeric && !std::isnan(number)) {
+                const double target = numbers.constFirst();
+                switch (condition.op) {
+                case Op::Equal:        accepted = numbers.contains(number); break;
+                case Op::NotEqual:     accepted = number != target; break;
+                case Op::Less:         accepted = number < target; break;
+                case Op::LessEqual:    accepted = number <= target; break;
+                case Op::Greater:      accepted = number > target; break;
+                case Op::GreaterEqual: accepted = number >= target; break;
+                }
+            } else {
+                const int order = field.values.at(v).compare(condition.values.constFirst(), Qt::CaseInsensitive);
+                switch (condition.op) {
+                case Op::Equal:
+                    accepted = condition.values.contains(field.values.at(v), Qt::CaseInsensitive);
+                    break;
+                case Op::NotEqual:     accepted = order != 0; break;
+                case Op::Less:         accepted = order < 0; break;
+                case Op::LessEqual:    accepted = order <= 0; break;
+                case Op::Greater:      accepted = order > 0; break;
+                case Op::GreaterEqual: accepted = order >= 0; break;
+                }
+            }
+            if (accepted) {
+                matching |= field.postings.at(v);
+            }
+        }
+        result = result & matching;
+        if (result.isEmpty()) {
+            break;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Parse and run a query
+ */
+FilenameIndex::Bitmap FilenameIndex::query(const QString &text, QString *error) const
+{
+    QVector<Condition> conditions;
+    if (!parseQuery(text, conditions, error)) {
+        return Bitmap();
+    }
+    return select(conditions, error);
+}
+
+/**
+ * @brief Selected files grouped by folder
+ * @param selection File ids
+ * @return One list per entry of roots(), in id order
+ */
+QVector<QVector<DiscoveredFile>> FilenameIndex::files(const Bitmap &selection) const
+{
+    QVector<QVector<DiscoveredFile>> result(m_roots.size());
+    for (FileId id : selection.ids()) {
+        DiscoveredFile file;
+        file.path = m_paths.at(id);
+        file.fileName = QFileInfo(file.path).fileName();
+        file.group = m_groups.at(id);
+        file.spacing = m_spacings.at(id);
+        result[m_rootIds.at(id)].append(file);
+    }
+    return result;
+}
@@ -0,0 +1,386 @@
+#include "include/folderprefetcher.h"
+#include "include/filediscovery.h"
+#include "include/ingestpipeline.h"
+#include <QCollator>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QPromise>
+#include <algorithm>
+
+/**
+ * @brief Constructor; prefetching is off until configure() sets a depth
+ * @param parent The parent QObject
+ */
+FolderPrefetcher::FolderPrefetcher(QObject *parent)
+    : QObject(parent), m_queueConfig(QString(), AppConfig::Loading::Deferred)
+{
+    m_pool.configure(1, QThread::LowestPriority, QVector<int>());
+    m_watcher = new QFutureWatcher<QVector<DataPoint>>(this);
+    connect(m_watcher, &QFutureWatcher<QVector<DataPoint>>::finished, this, &FolderPrefetcher::finishRunning);
+}
+
+/**
+ * @brief Destructor; cancels the running parse and waits for it
+ */
+FolderPrefetcher::~FolderPrefetcher()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+/**
+ * @brief Apply prefetch_folders, prefetch_cache, prefetch_order, prefetch_priority and worker_cpus
+ *
+ * A depth of 0 turns prefetching off and drops the cache.
+ */
+void FolderPrefetcher::configure(const AppConfig &config)
+{
+    m_depth = std::max(0, config.prefetch_folders);
+    m_capacity = std::max(1, config.prefetch_cache);
+    m_order = config.prefetch_order;
+    m_pool.configure(1, WorkerPool::priorityFromName(config.prefetch_priority, QThread::LowestPriority),
+                     WorkerPool::parseCpuList(config.worker_cpus));
+
+    if (m_depth == 0) {
+        retarget(QStringList());
+        m_cache.clear();
+    }
+    while (m_cache.size() > m_capacity) {
+        m_cache.removeLast();
+    }
+}
+
+/**
+ * @brief Run the stage workers of prefetch parses on a shared pool
+ * @param pool Stage pool; nullptr for a pool private to each parse
+ *
+ * The stage workers still run at the prefetch priority, and a parse takes
+ * at most one thread per stage of the shared pool.
+ */
+void FolderPrefetcher::setStagePool(WorkerPool *pool)
+{
+    m_stagePool = pool;
+}
+
+/**
+ * @brief Replace the wafer-map order used to predict the next folders
+ * @param order Folder names or paths in stepping order; empty for natural name order
+ */
+void FolderPrefetcher::setOrder(const QStringList &order)
+{
+    m_order = order;
+}
+
+/**
+ * @brief Points of a folder parsed ahead
+ * @param folder Folder the user loads
+ * @param config Configuration of the load
+ * @param pool Pool that checks a cached set
+ * @param load Normal load of the folder, run on `pool` if the cached set is stale
+ * @return Future of a cached set or its replacement, the running parse
+ *         of the folder, or an invalid future if the folder must be loaded
+ *
+ * A cached set stays cached (the load shares it), so stepping back to the
+ * previous die is a hit as well. Before it is handed out, the folder's
+ * files are listed and stat'ed again: a file edited in place leaves the
+ * folder's own modification time alone, so only the files tell whether the
+ * set is still current. The walk runs on `pool` as the first step of the
+ * returned future, which then either yields the cached points or runs
+ * `load` itself and marks the entry stale; the calling thread only
+ * compares the ingest settings. A running parse that is handed out is no
+ * longer cancelled by retarget().
+ */
+QFuture<QVector<DataPoint>> FolderPrefetcher::take(const QString &folder, const AppConfig &config, WorkerPool *pool,
+                                                   const std::function<QVector<DataPoint>()> &load)
+{
+    if (m_depth == 0) {
+        return QFuture<QVector<DataPoint>>();
+    }
+
+    dropStale();
+    const QString path = QDir(folder).absolutePath();
+    const QString key = ingestKey(config);
+    for (qsizetype i = 0; i < m_cache.size(); ++i) {
+        if (m_cache.at(i).folder != path) {
+            continue;
+        }
+        const Entry entry = m_cache.takeAt(i);
+        if (entry.key != key) {
+            qDebug() << "Dropping stale prefetched folder" << path;
+            break;
+        }
+        m_cache.prepend(entry);
+
+        const QByteArray stamp = entry.stamp;
+        const QVector<DataPoint> points = entry.points;
+        const std::shared_ptr<QAtomicInt> stale = entry.stale;
+        return pool->run([path, config, stamp, points, stale, load]() -> QVector<DataPoint> {
+            if (folderStamp(path, config) == stamp) {
+                return points;
+            }
+            qDebug() << "Dropping stale prefetched folder" << path;
+            stale->storeRelease(1);
+            return load();
+        });
+    }
+
+    if (m_watcher->isRunning() && m_running.folder == path && m_running.key == key
+        && m_runningCancel->loadAcquire() == 0) {
+        m_runningAdopted = true;
+        return m_watcher->future();
+    }
+    return QFuture<QVector<DataPoint>>();
+}
+
+/**
+ * @brief Cancel speculative work that does not serve a request
+ * @param folders Folders the user requested
+ *
+ * Drops the queue and cancels the running parse unless it is for one of
+ * the requested folders. The pipeline checks the flag between files, so
+ * the thread is free again after at most one file.
+ */
+void FolderPrefetcher::retarget(const QStringList &folders)
+{
+    m_queue.clear();
+    if (!m_watcher->isRunning() || m_runningAdopted) {
+        return;
+    }
+    for (const QString &folder : folders) {
+        if (QDir(folder).absolutePath() == m_running.folder) {
+            return;
+        }
+    }
+    m_runningCancel->storeRelease(1);
+}
+
+/**
+ * @brief Cancel all work, including a parse handed out by take()
+ */
+void FolderPrefetcher::cancel()
+{
+    m_queue.clear();
+    if (m_watcher->isRunning()) {
+        m_runningCancel->storeRelease(1);
+    }
+}
+
+/**
+ * @brief Start parsing the folders predicted to follow one
+ * @param folder Folder that was just loaded
+ * @param config Configuration of that load
+ *
+ * Folders that are cached already are skipped; a running parse that is not
+ * part of the new prediction is cancelled.
+ */
+void FolderPrefetcher::prefetchAfter(const QString &folder, const AppConfig &config)
+{
+    if (m_depth == 0) {
+        return;
+    }
+
+    dropStale();
+    const QString key = ingestKey(config);
+    const QStringList predicted = siblingsAfter(folder, m_order, m_depth);
+    m_queue.clear();
+    m_queueConfig = config;
+    for (const QString &sibling : predicted) {
+        const bool cached = std::any_of(m_cache.cbegin(), m_cache.cend(), [&](const Entry &entry) {
+            return entry.folder == sibling && entry.key == key;
+        });
+        const bool running = m_watcher->isRunning() && m_running.folder == sibling && m_running.key == key;
+        if (!cached && !running) {
+            m_queue.append(sibling);
+        }
+    }
+
+    if (m_watcher->isRunning()) {
+        if (!m_runningAdopted && (!predicted.contains(m_running.folder) || m_running.key != key)) {
+            m_runningCancel->storeRelease(1);
+        }
+        return;   // The next parse starts when the running one finishes
+    }
+    startNext();
+}
+
+/**
+ * @brief True if a ready point set of a folder is cached
+ */
+bool FolderPrefetcher::isCached(const QString &folder) const
+{
+    const QString path = QDir(folder).absolutePath();
+    return std::any_of(m_cache.cbegin(), m_cache.cend(), [&](const Entry &entry) {
+        return entry.folder == path && !isStale(entry);
+    });
+}
+
+bool FolderPrefetcher::isStale(const Entry &entry)
+{
+    return entry.stale && entry.stale->loadAcquire() != 0;
+}
+
+/**
+ * @brief Drop entries found stale
+ *
+ * The check that finds an entry stale runs on a worker thread, which only
+ * sets the entry's flag; the entry itself leaves the cache here, on the
+ * GUI thread.
+ */
+void FolderPrefetcher::dropStale()
+{
+    m_cache.removeIf([](const Entry &entry) { return isStale(entry); });
+}
+
+/**
+ * @brief Folders that follow one
+ * @param folder Current folder
+ * @param order Folder names or paths in stepping order; empty for natural name order
+ * @param count Maximum number of folders returned
+ * @return Existing sibling folders, as absolute paths, in stepping order
+ *
+ * Entries of a supplied order that are not absolute are taken relative to
+ * the parent of `folder`; entries that do not exist are skipped.
+ */
+QStringList FolderPrefetcher::siblingsAfter(const QString &folder, const QStringList &order, int count)
+{
+    QStringList result;
+    if (count <= 0) {
+        return result;
+    }
+    const QString path = QDir(folder).absolutePath();
+    const QDir parent = QFileInfo(path).dir();
+
+    if (!order.isEmpty()) {
+        QStringList resolved;
+        for (const QString &entry : order) {
+            resolved.append(QDir::isAbsolutePath(entry) ? QDir(entry).absolutePath()
+                                                        : QDir(parent.absoluteFilePath(entry)).absolutePath());
+        }
+        const qsizetype index = resolved.indexOf(path);
+        if (index >= 0) {
+            for (qsizetype i = index + 1; i < resolved.size() && result.size() < count; ++i) {
+                if (resolved.at(i) != path && QFileInfo(resolved.at(i)).isDir() && !result.contains(resolved.at(i))) {
+                    result.append(resolved.at(i));
+                }
+            }
+            return result;
+        }
+    }
+
+    QStringList names = parent.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    QCollator collator;
+    collator.setNumericMode(true);
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+    std::sort(names.begin(), names.end(), collator);
+    const qsizetype index = names.indexOf(QFileInfo(path).fileName());
+    if (index < 0) {
+        return result;
+    }
+    for (qsizetype i = index + 1; i < names.size() && result.size() < count; ++i) {
+        result.append(parent.absoluteFilePath(names.at(i)));
+    }
+    return result;
+}
+
+/**
+ * @brief Settings that change what a folder parses to
+ */
+QString FolderPrefetcher::ingestKey(const AppConfig &config)
+{
+    return QStringList {QString::number(config.res_voltage, 'g', 17),
+                        config.scan_recursive ? QStringLiteral("recursive") : QString(),
+                        config.include_patterns.join(QLatin1Char('|')),
+                        config.exclude_patterns.join(QLatin1Char('|')),
+                        config.group_by_folder ? QStringLiteral("grouped") : QString(),
+                        config.ingest_archives ? QStringLiteral("archives") : QString(),
+                        config.filename_templates.join(QLatin1Char('|'))}
+        .join(QLatin1Char('\n'));
+}
+
+/**
+ * @brief Fingerprint of the files a load of a folder would read
+ * @param folder Folder to list
+ * @param config Configuration selecting the files
+ * @return Hash over the paths, sizes and modification times of the files
+ *
+ * Uses the same discovery options as the ingest pipeline, so adding,
+ * removing, replacing or editing any file that a load would read changes
+ * the stamp. Entries are sorted, so the walk order does not matter.
+ */
+QByteArray FolderPrefetcher::folderStamp(const QString &folder, const AppConfig &config)
+{
+    QStringList entries;
+    FileDiscovery(DiscoveryOptions::fromConfig(config)).discover(folder, [&entries](DiscoveredFile &&file) {
+        const QFileInfo info(file.path);
+        entries.append(file.path + QLatin1Char('\t') + QString::number(info.size()) + QLatin1Char('\t')
+                       + QString::number(info.lastModified().toMSecsSinceEpoch()));
+        return true;
+    });
+    entries.sort();
+    return QCryptographicHash::hash(entries.join(QLatin1Char('\n')).toUtf8(), QCryptographicHash::Sha1);
+}
+
+/**
+ * @brief Start parsing the next queued folder
+ *
+ * The folder is stamped before it is read, so a file that changes during
+ * the parse makes the cached set stale. The stages run with a single worker
+ * each, at the priority of the prefetch thread, so a prefetch keeps at most
+ * four stage workers of low priority busy besides the prefetch thread.
+ */
+void FolderPrefetcher::startNext()
+{
+    if (m_queue.isEmpty()) {
+        return;
+    }
+
+    const QString folder = m_queue.takeFirst();
+    const AppConfig config = m_queueConfig;
+    m_running = Entry {folder, ingestKey(config), QByteArray(), QVector<DataPoint>()};
+    m_runningCancel = std::make_shared<QAtomicInt>(0);
+    m_runningStamp = std::make_shared<QByteArray>();
+    m_runningAdopted = false;
+
+    const std::shared_ptr<QAtomicInt> cancelFlag = m_runningCancel;
+    const std::shared_ptr<QByteArray> stamp = m_runningStamp;
+    WorkerPool *stagePool = m_stagePool;
+    m_watcher->setFuture(m_pool.run([folder, config, cancelFlag, stamp, stagePool]() {
+        *stamp = folderStamp(folder, config);
+        IngestOptions options = IngestOptions::fromConfig(config);
+        options.readThreads = 1;
+        options.parseThreads = 1;
+        options.validateThreads = 1;
+        options.threadPriority = QThread::currentThread()->priority();
+        options.stagePool = stagePool;
+        IngestPipeline pipeline(config, options);
+        return pipeline.runMany(QStringList {folder}, cancelFlag.get());
+    }));
+}
+
+/**
+ * @brief Cache the finished parse, unless it was cancelled, and start the next one
+ */
+void FolderPrefetcher::finishRunning()
+{
+    const bool cancelled = !m_runningCancel || m_runningCancel->loadAcquire() != 0;
+    if (!cancelled && m_depth > 0) {
+        Entry entry = m_running;
+        entry.stamp = *m_runningStamp;
+        entry.points = m_watcher->result();
+        entry.stale = std::make_shared<QAtomicInt>(0);
+        m_cache.removeIf([&entry](const Entry &cached) { return cached.folder == entry.folder; });
+        m_cache.prepend(entry);
+        while (m_cache.size() > m_capacity) {
+            m_cache.removeLast();
+        }
+        emit prefetched(entry.folder, static_cast<int>(entry.points.size()));
+    }
+    m_running = Entry();
+    m_runningCancel.reset();
+    m_runningStamp.reset();
+    m_runningAdopted = false;
+    startNext();
+}
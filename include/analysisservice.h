@@ -0,0 +1,168 @@
+#ifndef TLMANALYZER_ANALYSISSERVICE_H
+#define TLMANALYZER_ANALYSISSERVICE_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QVector>
+#include "appconfig.h"
+#include "calculator.h"
+#include "datapoint.h"
+#include "workerpools.h"
+
+class QIODevice;
+class QLocalServer;
+class QTcpServer;
+
+/**
+ * @brief Long-lived analysis endpoint speaking JSON-RPC 2.0
+ *
+ * Listens on a localhost TCP port and/or a local socket (a Unix domain
+ * socket or a named pipe on Windows). Each connection carries one JSON-RPC
+ * request (or batch) per line and receives one response per line. Requests
+ * run concurrently on a dedicated thread pool; responses are written as
+ * they finish, so they may arrive out of order and are matched by "id".
+ *
+ * The configuration is read once when the service starts, so a request
+ * only pays for reading its files and fitting them.
+ *
+ * Methods:
+ * - `analyze`: params `files` (array of CSV paths) and/or `folders` (array
+ *   of folders), optional `model`, `channelWidth` and `voltage`; returns
+ *   the number of points, the model, the fit over all points as `result`
+ *   and one fit per structure in `structures`
+ * - `models`: names of the available fit models
+ * - `ping`: returns "pong"
+ */
+class AnalysisService : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief JSON-RPC 2.0 error codes used by the service
+     */
+    enum ErrorCode {
+        ParseError = -32700,     ///< The line is not valid JSON
+        InvalidRequest = -32600, ///< The JSON is not a request object
+        MethodNotFound = -32601, ///< Unknown method
+        InvalidParams = -32602,  ///< Missing or malformed parameters
+        AnalysisFailed = -32000  ///< No data or the fit failed
+    };
+
+    /**
+     * @brief Constructor
+     * @param config Configuration used as the default for every request
+     * @param parent The parent QObject
+     */
+    explicit AnalysisService(const AppConfig &config, QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor; waits for running requests
+     */
+    ~AnalysisService() override;
+
+    /**
+     * @brief Listen on a TCP port of the loopback interface
+     * @param port Port number; 0 picks a free port (see tcpPort())
+     * @param error Receives a description of the failure, if any
+     * @return True if the server is listening
+     */
+    bool listenTcp(quint16 port, QString *error = nullptr);
+
+    /**
+     * @brief Listen on a local socket
+     * @param name Socket name or path
+     * @param error Receives a description of the failure, if any
+     * @return True if the server is listening
+     */
+    bool listenLocal(const QString &name, QString *error = nullptr);
+
+    /**
+     * @brief Port the TCP server listens on, or 0
+     */
+    [[nodiscard]] quint16 tcpPort() const;
+
+    /**
+     * @brief Full name of the local socket, or an empty string
+     */
+    [[nodiscard]] QString localServerName() const;
+
+    /**
+     * @brief Maximum number of requests processed at the same time
+     */
+    void setMaxConcurrentRequests(int count);
+
+    /**
+     * @brief Handle one request line
+     * @param line A JSON-RPC request object or batch array
+     * @return Response line without the trailing newline; empty for notifications
+     *
+     * Thread-safe; this is what every connection runs on the request pool.
+     */
+    [[nodiscard]] QByteArray handleLine(const QByteArray &line) const;
+
+    /**
+     * @brief Handle one parsed request
+     * @param request JSON-RPC request object
+     * @return Response object; empty for notifications (requests without "id")
+     */
+    [[nodiscard]] QJsonObject handleRequest(const QJsonValue &request) const;
+
+    /**
+     * @brief Serialise a fit result
+     * @return Object with the same keys as DataManager::c_lastAnalysisResult()
+     */
+    static QJsonObject resultToJson(const Calculator::TLMResult &result);
+
+signals:
+    /**
+     * @brief Signal emitted when a response has been written
+     * @param milliseconds Time from receiving the line to writing the response
+     */
+    void requestHandled(double milliseconds);
+
+private slots:
+    void acceptTcp();
+    void acceptLocal();
+
+private:
+    /**
+     * @brief Start reading request lines from a new connection
+     */
+    void attach(QIODevice *connection);
+
+    /**
+     * @brief Dispatch all complete lines buffered on a connection
+     */
+    void readRequests(QIODevice *connection);
+
+    /**
+     * @brief Execute the "analyze" method
+     * @param params Request parameters
+     * @param error Receives the error object on failure
+     * @return Result object, empty on failure
+     */
+    QJsonObject analyze(const QJsonObject &params, QJsonObject *error) const;
+
+    /**
+     * @brief Parse CSV files given by path, as a folder load would
+     * @param paths File paths
+     * @param config Configuration for this request
+     * @return Valid points sorted by structure and spacing
+     */
+    static QVector<DataPoint> loadFiles(const QStringList &paths, const AppConfig &config);
+
+    /**
+     * @brief Build a JSON-RPC error object
+     */
+    static QJsonObject errorObject(int code, const QString &message);
+
+    AppConfig m_config;                      ///< Defaults for every request
+    QTcpServer *m_tcpServer = nullptr;       ///< Loopback TCP listener
+    QLocalServer *m_localServer = nullptr;   ///< Local socket listener
+    mutable WorkerPools m_pools;             ///< Ingest stages, zip inflation and structure fits of all requests
+    mutable WorkerPool m_requestPool;        ///< Runs requests concurrently, like the compute pool
+};
+
+#endif // TLMANALYZER_ANALYSISSERVICE_H
@@ -2,6 +2,7 @@
 #define TLMANALYZER_APPCONFIG_H
 
 #include <QString>
+#include <QStringList>
 #include <QJsonObject>
 #include <QMetaType>
 #include <QVector>
@@ -18,12 +19,91 @@ public:
     // Configuration parameters
     double res_voltage;      ///< Resistance voltage parameter
     double channel_length;   ///< Channel length parameter
+
+    // Ingest pipeline stage sizes (0 selects an automatic value)
+    int ingest_read_threads;      ///< Concurrent file readers
+    int ingest_parse_threads;     ///< Concurrent CSV parsers
+    int ingest_validate_threads;  ///< Concurrent validators
+    int ingest_queue_capacity;    ///< Capacity of each inter-stage queue
+    int ingest_read_batch;        ///< Files read per batched I/O submission
+
+    // File discovery
+    bool scan_recursive;          ///< Walk sub-folders when loading a folder
+    QStringList include_patterns; ///< File name wildcards to load (empty means "*.csv")
+    QStringList exclude_patterns; ///< File or folder wildcards to skip
+    bool group_by_folder;         ///< Treat each sub-folder as a separate TLM structure
+    bool ingest_archives;         ///< Also load CSV members of .zip/.tar.gz/.tgz/.tar bundles
+    int archive_member_limit_mb;  ///< Largest archive member read, uncompressed (MiB; 0 for the default)
+
+    // Fit model
+    QString fit_model;        ///< Fit model: "linear", "circular" or "end_resistance"
+    double ctlm_inner_radius; ///< Inner contact radius of circular TLM structures (μm)
+    double contact_length;    ///< Contact length for the end-resistance model (μm)
+
+    // Filename metadata
+    QStringList filename_templates; ///< Templates such as {lot}_W{wafer}_X{die_x}Y{die_y}_{spacing}um; the first match wins
+
+    // Results store
+    QString results_db;              ///< SQLite file receiving every analysis; relative paths are next to the config file
+    bool record_results;             ///< Store per-structure results after each analysis
+    QStringList results_path_levels; ///< Names of the innermost folders of a structure path, outermost first
+
+    // Worker pools (0 threads selects an automatic value)
+    int io_threads;           ///< Threads of the I/O pool (loading, reduction, indexing, export)
+    QString io_priority;      ///< Priority of I/O threads: idle, lowest, low, normal, high, highest
+    int compute_threads;      ///< Threads of the compute pool (fits, plots, archive inflation)
+    QString compute_priority; ///< Priority of compute threads
+    QString worker_cpus;      ///< CPUs worker threads may run on, e.g. "2-7" (empty for all)
+
+    // Point curation
+    int undo_limit; ///< Undo steps kept for point edits (0 disables undo)
+
+    // Predictive prefetch of sibling folders
+    int prefetch_folders;       ///< Sibling folders parsed ahead after each load (0 disables prefetching)
+    int prefetch_cache;         ///< Prefetched folders kept ready, least recently used dropped first
+    QStringList prefetch_order; ///< Folder names in stepping (wafer-map) order; empty for natural name order
+    QString prefetch_priority;  ///< Priority of the prefetch thread
     
+    /**
+     * @brief When the configuration file is located and read
+     */
+    enum class Loading {
+        Immediate, ///< In the constructor
+        Deferred   ///< On the first call to resolve(); until then only defaults are set
+    };
+
     /**
      * @brief Constructor
      * @param configFile Path to the configuration file
      */
     explicit AppConfig(const QString& configFile = "config.json");
+
+    /**
+     * @brief Constructor that can defer file I/O
+     * @param configFile Path to the configuration file
+     * @param loading Immediate to resolve now, Deferred to keep the defaults until resolve()
+     *
+     * A deferred configuration touches no files, so it is cheap enough to
+     * build on the GUI thread during startup.
+     */
+    AppConfig(const QString& configFile, Loading loading);
+
+    /**
+     * @brief Locate, migrate and load the configuration file
+     * @return True if a configuration file was loaded
+     *
+     * Moves a configuration file found at the given path to the standard
+     * location (backing up any file already there) or creates a default
+     * one, then reads it. Safe to call from a worker thread on an object
+     * no other thread is using.
+     */
+    bool resolve();
+
+    /**
+     * @brief Whether resolve() has run
+     * @return True once the configuration file has been located
+     */
+    bool isResolved() const;
     
     /**
      * @brief Load configuration from file
@@ -33,7 +113,7 @@ public:
     
     /**
      * @brief Save current configuration to file
-     * @return True if successful, false otherwise
+     * @return True if successful, false otherwise (always false before resolve())
      */
     bool saveConfig() const;
     
@@ -50,6 +130,13 @@ public:
      * @return True if successful, false otherwise
      */
     bool setChannelLength(double length);
+
+    /**
+     * @brief Set fit model and save to config file
+     * @param model Fit model name ("linear", "circular" or "end_resistance")
+     * @return True if successful, false otherwise
+     */
+    bool setFitModel(const QString& model);
     
     /**
      * @brief Get the configuration file path
@@ -59,6 +146,7 @@ public:
 
 private:
     QString m_configFile;  ///< Path to the configuration file
+    bool m_resolved;       ///< True once resolve() has run
     
     /**
      * @brief Create a default configuration file
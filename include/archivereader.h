@@ -0,0 +1,96 @@
+#ifndef TLMANALYZER_ARCHIVEREADER_H
+#define TLMANALYZER_ARCHIVEREADER_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+class QThreadPool;
+
+/**
+ * @brief Streams the members of sweep-file archives straight into memory
+ *
+ * Test cells ship results as one `.zip`, `.tar.gz`/`.tgz` or `.tar` bundle
+ * per die. ArchiveReader hands each regular member to a visitor as a byte
+ * buffer, so the ingest pipeline can parse bundles without extracting them
+ * to scratch disk.
+ *
+ * Zip members are independent and are inflated in parallel, a slice at a
+ * time so memory stays bounded. Gzip-compressed tar streams are inherently
+ * sequential and are inflated and split into members on the fly.
+ *
+ * Deflate and gzip support require zlib (TLM_HAVE_ZLIB); without it only
+ * stored zip members and plain tar files can be read.
+ *
+ * The class is designed as a utility with only static methods and no instance data.
+ */
+class ArchiveReader {
+public:
+    /**
+     * @brief Visitor receiving one archive member
+     * @param memberName Path of the member inside the archive
+     * @param content Uncompressed member contents
+     * @return False to stop reading the archive
+     */
+    using MemberVisitor = std::function<bool(const QString &memberName, QByteArray &&content)>;
+
+    /**
+     * @brief Default limit on the uncompressed size of one member (256 MiB)
+     */
+    static constexpr qint64 DefaultMaxMemberSize = qint64(256) * 1024 * 1024;
+
+    /**
+     * @brief Member size limit in bytes
+     * @param megabytes archive_member_limit_mb; 0 or less selects DefaultMaxMemberSize
+     */
+    static qint64 memberLimit(int megabytes);
+
+    /**
+     * @brief File name wildcards recognised as archives
+     */
+    static QStringList archivePatterns();
+
+    /**
+     * @brief Check whether a file name denotes a supported archive
+     * @param fileName File name or path
+     * @return True for .zip, .tar.gz, .tgz and .tar files
+     */
+    static bool isArchive(const QString &fileName);
+
+    /**
+     * @brief File name of an archive without its archive suffix
+     * @param fileName File name or path, e.g. "die_07.tar.gz"
+     * @return Name without directory and suffix, e.g. "die_07"
+     */
+    static QString archiveBaseName(const QString &fileName);
+
+    /**
+     * @brief Read the members of an archive
+     * @param archivePath Path of the archive
+     * @param memberPatterns File name wildcards a member must match (empty accepts all)
+     * @param visitor Called once per matching regular member, on the calling thread
+     * @param cancelFlag Optional flag; reading stops when it becomes non-zero
+     * @param pool Pool inflating zip members; nullptr for the global pool
+     * @param maxMemberSize Members larger than this, uncompressed, are skipped
+     * @return False if the archive could not be opened or is malformed
+     */
+    static bool readMembers(const QString &archivePath, const QStringList &memberPatterns,
+                            const MemberVisitor &visitor, const QAtomicInt *cancelFlag = nullptr,
+                            QThreadPool *pool = nullptr, qint64 maxMemberSize = DefaultMaxMemberSize);
+
+private:
+    static bool readZip(const QString &archivePath, const QStringList &memberPatterns,
+                        const MemberVisitor &visitor, const QAtomicInt *cancelFlag, QThreadPool *pool,
+                        qint64 maxMemberSize);
+    static bool readTar(const QString &archivePath, bool gzipped, const QStringList &memberPatterns,
+                        const MemberVisitor &visitor, const QAtomicInt *cancelFlag, qint64 maxMemberSize);
+
+    /**
+     * @brief Private constructor to prevent instantiation
+     */
+    ArchiveReader() = default; // Static class
+};
+
+#endif // TLMANALYZER_ARCHIVEREADER_H
@@ -0,0 +1,187 @@
+#ifndef TLMANALYZER_BOUNDEDQUEUE_H
+#define TLMANALYZER_BOUNDEDQUEUE_H
+
+#include <QAtomicInt>
+#include <QThread>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief Bounded lock-free multi-producer/multi-consumer queue
+ *
+ * Fixed-capacity ring buffer in which every cell carries a sequence number
+ * (Vyukov's bounded MPMC design). Producers and consumers only contend on a
+ * single atomic position each, so stages of the ingest pipeline can hand
+ * work to each other without taking a lock.
+ *
+ * The non-blocking tryPush()/tryPop() never wait. push()/pop() back off
+ * (spin, then yield, then sleep) while the queue is full or empty, which is
+ * what gives the pipeline its backpressure. A queue is closed by its last
+ * producer; pop() then drains the remaining items and returns false.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    /**
+     * @brief Constructor
+     * @param capacity Requested capacity, rounded up to a power of two (minimum 2)
+     */
+    explicit BoundedQueue(qsizetype capacity)
+    {
+        std::size_t size = 2;
+        while (size < static_cast<std::size_t>(capacity)) {
+            size <<= 1;
+        }
+        m_mask = size - 1;
+        m_cells.reset(new Cell[size]);
+        for (std::size_t i = 0; i < size; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    /**
+     * @brief Try to enqueue a value without waiting
+     * @param value Value to move into the queue
+     * @return True if the value was enqueued, false if the queue is full
+     */
+    bool tryPush(T &&value)
+    {
+        Cell *cell = nullptr;
+        std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Try to dequeue a value without waiting
+     * @param value Receives the dequeued value
+     * @return True if a value was dequeued, false if the queue is empty
+     */
+    bool tryPop(T &value)
+    {
+        Cell *cell = nullptr;
+        std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->data);
+        cell->data = T();
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Enqueue a value, waiting while the queue is full
+     * @param value Value to move into the queue
+     * @param cancelFlag Optional flag; waiting stops when it becomes non-zero
+     * @return True if the value was enqueued, false if cancelled
+     */
+    bool push(T &&value, const QAtomicInt *cancelFlag = nullptr)
+    {
+        for (int attempt = 0;; ++attempt) {
+            if (tryPush(std::move(value))) {
+                return true;
+            }
+            if (cancelFlag && cancelFlag->loadAcquire() != 0) {
+                return false;
+            }
+            backoff(attempt);
+        }
+    }
+
+    /**
+     * @brief Dequeue a value, waiting while the queue is empty and still open
+     * @param value Receives the dequeued value
+     * @param cancelFlag Optional flag; waiting stops when it becomes non-zero
+     * @return True if a value was dequeued, false if the queue is closed and
+     *         drained, or if cancelled
+     */
+    bool pop(T &value, const QAtomicInt *cancelFlag = nullptr)
+    {
+        for (int attempt = 0;; ++attempt) {
+            if (tryPop(value)) {
+                return true;
+            }
+            if (m_closed.load(std::memory_order_acquire)) {
+                // Items pushed before close() are visible now; take one last look
+                return tryPop(value);
+            }
+            if (cancelFlag && cancelFlag->loadAcquire() != 0) {
+                return false;
+            }
+            backoff(attempt);
+        }
+    }
+
+    /**
+     * @brief Mark the queue as closed; no further pushes may follow
+     */
+    void close() { m_closed.store(true, std::memory_order_release); }
+
+    /**
+     * @brief Check whether the queue has been closed
+     */
+    [[nodiscard]] bool isClosed() const { return m_closed.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Capacity of the ring buffer
+     */
+    [[nodiscard]] qsizetype capacity() const { return static_cast<qsizetype>(m_mask + 1); }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence {0};
+        T data {};
+    };
+
+    static void backoff(int attempt)
+    {
+        if (attempt < 16) {
+            return; // Busy retry; the other side is usually mid-operation
+        }
+        if (attempt < 64) {
+            QThread::yieldCurrentThread();
+        } else {
+            QThread::usleep(attempt < 256 ? 50 : 500);
+        }
+    }
+
+    std::unique_ptr<Cell[]> m_cells;
+    std::size_t m_mask = 0;
+    alignas(64) std::atomic<std::size_t> m_enqueuePos {0};
+    alignas(64) std::atomic<std::size_t> m_dequeuePos {0};
+    alignas(64) std::atomic<bool> m_closed {false};
+};
+
+#endif // TLMANALYZER_BOUNDEDQUEUE_H
@@ -2,6 +2,8 @@
 #define TLMANALYZER_CALCULATOR_H
 
 #include <QVector>
+#include <QString>
+#include <QStringList>
 #include "datapoint.h"
 
 /**
@@ -23,15 +25,116 @@ public:
         double contactResistance;          ///< Contact resistance in Ω
         double specificContactResistivity; ///< Specific contact resistivity in Ω·cm²
         double channelWidth;               ///< Channel width in μm
+        double transferLength;             ///< Transfer length LT in μm
+        double endResistance;              ///< End resistance in Ω (end-resistance model only)
         
         /**
          * @brief Default constructor
          * Initializes all values to zero
          */
         TLMResult() : slope(0.0), intercept(0.0), rSquared(0.0), sheetResistance(0.0), 
-                     contactResistance(0.0), specificContactResistivity(0.0), channelWidth(100.0) {}
+                     contactResistance(0.0), specificContactResistivity(0.0), channelWidth(100.0),
+                     transferLength(0.0), endResistance(0.0) {}
     };
+
+    /**
+     * @brief Test structure model used to interpret a fit
+     */
+    enum class FitModel {
+        LinearTLM,     ///< Rectangular TLM, R = (Rsh/W)·d + 2Rc
+        CircularTLM,   ///< Circular TLM with curvature correction
+        EndResistance  ///< Rectangular TLM with finite contact length
+    };
+
+    /**
+     * @brief Geometry of a test structure in μm
+     */
+    struct FitGeometry {
+        double channelWidth = 100.0;    ///< Channel width W (linear and end-resistance models)
+        double ctlmInnerRadius = 100.0; ///< Inner contact radius r0 (circular model)
+        double contactLength = 100.0;   ///< Contact length L (end-resistance model)
+    };
+
+    /**
+     * @brief Fit a structure with the given model
+     * @param model Structure model
+     * @param dataPoints Points of one structure; only enabled points are fitted
+     * @param geometry Structure geometry
+     * @param result Reference to TLMResult structure to store results
+     * @return True if successful, false otherwise
+     *
+     * Dispatches once to the fitting engine specialised for the model.
+     */
+    static bool fit(FitModel model, const QVector<DataPoint> &dataPoints, const FitGeometry &geometry,
+                    TLMResult &result);
+
+    /**
+     * @brief Fill a result from a line that has already been fitted
+     * @param model Structure model the line was fitted in
+     * @param slope Slope in the model's coordinates
+     * @param intercept Intercept in the model's coordinates
+     * @param rSquared Coefficient of determination of the fit
+     * @param geometry Structure geometry
+     * @param result Receives the line and the extracted parameters
+     *
+     * For fits computed from accumulated statistics instead of points.
+     */
+    static void fromLine(FitModel model, double slope, double intercept, double rSquared,
+                         const FitGeometry &geometry, TLMResult &result);
+
+    /**
+     * @brief Configuration name of a model ("linear", "circular", "end_resistance")
+     */
+    static QString fitModelName(FitModel model);
+
+    /**
+     * @brief Parse a model name as returned by fitModelName()
+     * @param name Model name, case-insensitive
+     * @param model Receives the model
+     * @return False if the name is unknown
+     */
+    static bool fitModelFromName(const QString &name, FitModel &model);
+
+    /**
+     * @brief Names of all models
+     */
+    static QStringList fitModelNames();
     
+    /**
+     * @brief Leave-one-out influence diagnostics of one point
+     *
+     * For points excluded from the fit (disabled), leverage and residual
+     * describe the point relative to the fit of the others and the
+     * leave-one-out values equal the full fit.
+     */
+    struct InfluenceDiagnostics {
+        bool valid = false;                ///< False if the structure could not be fitted
+        double leverage = 0.0;             ///< Hat-matrix diagonal h = 1/n + (x - x̄)²/Sxx
+        double residual = 0.0;             ///< Raw residual y - ŷ in the model's coordinates (Ω)
+        double studentizedResidual = 0.0;  ///< Externally studentized residual (needs n > 3)
+        double cooksDistance = 0.0;        ///< Cook's distance (needs n > 2)
+        double looSlope = 0.0;             ///< Slope of the fit without this point, in the model's coordinates
+        double looIntercept = 0.0;         ///< Intercept of the fit without this point, in the model's coordinates
+        double looSheetResistance = 0.0;   ///< Sheet resistance without this point (Ω/sq)
+        double looContactResistance = 0.0; ///< Contact resistance without this point (Ω)
+        bool influential = false;          ///< Cook's distance above 4/n
+    };
+
+    /**
+     * @brief Influence diagnostics of every point in a single pass
+     * @param model Structure model the points are fitted with
+     * @param dataPoints Points of one structure; only enabled points are fitted
+     * @param geometry Structure geometry
+     * @return One entry per input point, in input order
+     *
+     * Uses the closed-form hat-matrix identities of simple linear regression,
+     * so all n leave-one-out fits cost O(n) in total instead of n refits.
+     * The regression runs on the same (x, y) as fit() for the model, and the
+     * leave-one-out parameters are extracted as fit() extracts them.
+     */
+    static QVector<InfluenceDiagnostics> influenceDiagnostics(FitModel model, const QVector<DataPoint> &dataPoints,
+                                                             const FitGeometry &geometry);
+
     /**
      * @brief Perform linear regression on DataPoint vector
      * @param dataPoints Vector of data points to analyze
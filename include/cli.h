@@ -0,0 +1,38 @@
+#ifndef TLMANALYZER_CLI_H
+#define TLMANALYZER_CLI_H
+
+/**
+ * @brief Headless command-line front end
+ *
+ * Runs the ingest pipeline and the analysis without creating the QML UI,
+ * so batches of folders can be analysed from scripts. Example:
+ *
+ *     TLM_Analyzer --analyze wafer01/die07 --model all --channel-width 100
+ */
+class Cli {
+public:
+    /**
+     * @brief Whether the arguments request a headless run
+     * @param argc Argument count from main()
+     * @param argv Argument vector from main()
+     * @return True if a command-line action was given
+     */
+    static bool wantsCli(int argc, char *argv[]);
+
+    /**
+     * @brief Run the command-line front end
+     * @param argc Argument count from main()
+     * @param argv Argument vector from main()
+     * @return Process exit code
+     */
+    static int run(int argc, char *argv[]);
+
+private:
+    /**
+     * @brief Private constructor to prevent instantiation
+     * This is a static utility class that should not be instantiated
+     */
+    Cli() = default;
+};
+
+#endif // TLMANALYZER_CLI_H
@@ -31,6 +31,48 @@ public:
      * @return DataPoint object containing the extracted measurements
      */
     static DataPoint processFile(const QString &filePath, const AppConfig& config);
+
+    /**
+     * @brief Parse the contents of a CSV file that has already been read
+     * @param content Raw file contents
+     * @param config Application configuration
+     * @param sourceName File name used in diagnostic messages
+     * @return DataPoint object containing the extracted measurements
+     *
+     * Performs no I/O, so callers can read files on one thread and parse
+     * them on another.
+     */
+    static DataPoint parseContent(const QByteArray &content, const AppConfig& config,
+                                  const QString &sourceName);
+
+    /**
+     * @brief Parse every buffer and step of a CSV file that has already been read
+     * @param content Raw file contents
+     * @param config Application configuration
+     * @param sourceName File name used in diagnostic messages
+     * @return One DataPoint per instrument buffer and step, in file order;
+     *         empty if the file holds no complete measurement
+     */
+    static QVector<DataPoint> parseContentAll(const QByteArray &content, const AppConfig& config,
+                                              const QString &sourceName);
+
+    /**
+     * @brief Process a single CSV file, keeping every buffer and step
+     * @param filePath Path to the CSV file to process
+     * @param config Application configuration
+     * @return One DataPoint per instrument buffer and step
+     */
+    static QVector<DataPoint> processFileAll(const QString &filePath, const AppConfig& config);
+
+    /**
+     * @brief Structure name for a point extracted from a file
+     * @param group Structure the file belongs to (may be empty)
+     * @param source Buffer / step the point was extracted from; empty for the
+     *               legacy column layout
+     * @return "group/source", just the source for an empty group, or the group
+     *         for a point without a source
+     */
+    static QString structureForSource(const QString &group, const QString &source);
     
     /**
      * @brief Extract spacing value from a filename
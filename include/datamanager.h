@@ -4,11 +4,34 @@
 #include <QObject>
 #include <QVector>
 #include <QVariant>
+#include <QMap>
+#include <QQueue>
+#include <functional>
+#include <QStringList>
+#include <QFuture>
 #include <QFutureWatcher>
+#include <QAtomicInteger>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <memory>
+#include <optional>
+#include <utility>
 #include "datapoint.h"
 #include "calculator.h"
 #include "appconfig.h"
 #include "datapointmodel.h"
+#include "spacingindex.h"
+#include "filediscovery.h"
+#include "resultstore.h"
+#include "workerpools.h"
+#include "pointhistory.h"
+
+class QFileSystemWatcher;
+class FolderPrefetcher;
+class FilenameIndex;
+class StreamReducer;
+class TailParser;
 
 /**
  * @brief Manages TLM data points and provides an interface between C++ and QML
@@ -30,19 +53,46 @@ class DataManager : public QObject
     Q_PROPERTY(QVector<DataPoint> dataPoints READ getDataPoints NOTIFY dataChanged)
     Q_PROPERTY(double resistanceVoltage READ getResistanceVoltage WRITE setResistanceVoltage NOTIFY resistanceVoltageChanged)
     Q_PROPERTY(double channelWidth READ getChannelWidth WRITE setChannelWidth NOTIFY channelWidthChanged)
+    Q_PROPERTY(QString fitModel READ getFitModel WRITE setFitModel NOTIFY fitModelChanged)
+    Q_PROPERTY(bool configReady READ isConfigLoaded NOTIFY configLoaded)
+    Q_PROPERTY(bool following READ isFollowing NOTIFY followingChanged)
+    Q_PROPERTY(bool reducing READ isReducing NOTIFY reducingChanged)
+    Q_PROPERTY(bool canUndo READ canUndo NOTIFY historyChanged)
+    Q_PROPERTY(bool canRedo READ canRedo NOTIFY historyChanged)
 public:
+    /**
+     * @brief Result of one background analysis run
+     */
+    struct AnalysisOutcome {
+        quint64 generation = 0;                               ///< Request that produced this outcome
+        bool ok = false;                                      ///< True if the overall fit succeeded
+        bool superseded = false;                              ///< True if a newer request made this one stale
+        Calculator::TLMResult result;                         ///< Fit over all points
+        QMap<QString, Calculator::TLMResult> structureResults; ///< Fits per structure (multi-structure data only)
+        QString message;                                      ///< Formatted result message
+        QVector<ResultStore::Record> records;                 ///< Rows for the results store (if recording)
+        quint64 historyVersion = 0;                           ///< History entry of the snapshot; 0 if unknown
+        Calculator::FitModel model = Calculator::FitModel::LinearTLM; ///< Model of the request
+        Calculator::FitGeometry geometry;                     ///< Geometry of the request
+    };
+
     /**
      * @brief Constructor for DataManager
      * @param parent The parent QObject
      */
     explicit DataManager(QObject *parent = nullptr);
 
+    /**
+     * @brief Destructor; cancels background work and waits for the worker pools
+     */
+    ~DataManager() override;
+
     /**
      * @brief Add a data point to the collection
      * @param point The DataPoint to add
      * 
-     * Appends a new data point to the internal collection, sorts the data points
-     * by spacing, and emits the dataChanged signal to notify any observers.
+     * Inserts the data point at its sorted position found by binary search,
+     * and emits the dataChanged signal to notify any observers.
      */
     Q_INVOKABLE void c_addDataPoint(const DataPoint &point);
 
@@ -53,9 +103,8 @@ public:
      * @param voltage The voltage value for calculating resistance (in V)
      *
      * Calculates resistance from the provided voltage and current values,
-     * creates a new DataPoint with the provided values, appends it to the
-     * internal collection, sorts the data points by spacing, and emits the
-     * dataChanged signal.
+     * creates a new DataPoint with the provided values, inserts it at its
+     * sorted position, and emits the dataChanged signal.
      */
     Q_INVOKABLE void c_addManualDataPoint(double spacing, double current, double voltage);
     
@@ -89,11 +138,108 @@ public:
     /**
      * @brief Remove all disabled data points from the collection
      * 
-     * Creates a new collection containing only enabled data points, replaces
-     * the internal collection with this filtered collection, sorts the data
-     * points by spacing, and emits the dataChanged signal.
+     * Removes the disabled points in place, keeping the order of the rest,
+     * and emits the dataChanged signal.
      */
     Q_INVOKABLE void c_clearDisabledDataPoints();
+
+    /**
+     * @brief Restore the collection as it was before the last change
+     * @return False if there is nothing to undo or a batch is open
+     *
+     * The fit of the restored state is published again without refitting if
+     * it was computed with the current model and geometry. An analysis still
+     * running is dropped.
+     */
+    Q_INVOKABLE bool c_undo();
+
+    /**
+     * @brief Reapply the last undone change
+     * @return False if there is nothing to redo or a batch is open
+     */
+    Q_INVOKABLE bool c_redo();
+
+    /**
+     * @brief True if c_undo() would restore an earlier state
+     */
+    [[nodiscard]] bool canUndo() const { return m_history.canUndo(); }
+
+    /**
+     * @brief True if c_redo() would restore a later state
+     */
+    [[nodiscard]] bool canRedo() const { return m_history.canRedo(); }
+
+    /**
+     * @brief Start a batch of edits
+     *
+     * Until the matching c_commitUpdate(), edits change the collection but
+     * neither re-sort it, refresh the model nor emit dataChanged. Calls may
+     * be nested; only the outermost commit publishes.
+     */
+    Q_INVOKABLE void c_beginUpdate();
+
+    /**
+     * @brief Finish a batch of edits
+     *
+     * When the outermost batch ends, the collection is sorted once if any
+     * edit required it, the model is refreshed once and a single dataChanged
+     * is emitted.
+     */
+    Q_INVOKABLE void c_commitUpdate();
+
+    /**
+     * @brief Set the enabled state of several data points at once
+     * @param indices Indices of the points to modify; invalid indices are ignored
+     * @param enabled The new enabled state
+     * @return Number of points whose state changed
+     */
+    Q_INVOKABLE int c_setDataPointsEnabled(const QList<int> &indices, bool enabled);
+
+    /**
+     * @brief Remove several data points at once
+     * @param indices Indices of the points to remove; invalid and duplicate indices are ignored
+     * @return Number of points removed
+     *
+     * Removes all points in a single pass over the collection.
+     */
+    Q_INVOKABLE int c_removeDataPoints(const QList<int> &indices);
+
+    /**
+     * @brief Set the enabled state of every point matching a comparison
+     * @param field "spacing", "resistance" or "current"
+     * @param op One of "<", "<=", ">", ">=", "==", "!="
+     * @param value Value to compare against
+     * @param enabled The new enabled state
+     * @return Number of points whose state changed, or -1 for an invalid field or operator
+     *
+     * Example: c_setEnabledWhere("spacing", "<", 5, false) disables all points
+     * below 5 μm.
+     */
+    Q_INVOKABLE int c_setEnabledWhere(const QString &field, const QString &op, double value, bool enabled);
+
+    /**
+     * @brief Remove every point matching a comparison
+     * @param field "spacing", "resistance" or "current"
+     * @param op One of "<", "<=", ">", ">=", "==", "!="
+     * @param value Value to compare against
+     * @return Number of points removed, or -1 for an invalid field or operator
+     */
+    Q_INVOKABLE int c_removeWhere(const QString &field, const QString &op, double value);
+
+    /**
+     * @brief Set the enabled state of every point matching a predicate
+     * @param predicate Selects the points to modify
+     * @param enabled The new enabled state
+     * @return Number of points whose state changed
+     */
+    int setEnabledWhere(const std::function<bool(const DataPoint &)> &predicate, bool enabled);
+
+    /**
+     * @brief Remove every point matching a predicate
+     * @param predicate Selects the points to remove
+     * @return Number of points removed
+     */
+    int removeWhere(const std::function<bool(const DataPoint &)> &predicate);
     
     /**
      * @brief Load data from a folder of CSV files
@@ -101,16 +247,102 @@ public:
      * @param voltage Reference voltage for resistance calculations
      */
     Q_INVOKABLE void c_loadDataFromFolder(const QString &folderPath, double voltage);
+
+    /**
+     * @brief Load several folders in one action
+     * @param folderPaths Folders to load, e.g. all die folders of a wafer
+     * @param merge True to add the points to the current collection (replacing
+     *              points previously loaded from the same folders), false to
+     *              replace the collection
+     *
+     * All folders share one ingest pipeline, so they are read and parsed
+     * concurrently. A request made while another load is running is queued
+     * and started when the running load finishes. Progress is reported per
+     * folder through folderProgressUpdated and overall through progressUpdated.
+     */
+    Q_INVOKABLE void c_loadDataFromFolders(const QStringList &folderPaths, bool merge);
+
+    /**
+     * @brief Set the order in which folders are stepped through, for prefetching
+     * @param folders Folder names or paths in wafer-map order; empty for natural name order
+     *
+     * Only has an effect when prefetch_folders is set.
+     */
+    Q_INVOKABLE void c_setPrefetchOrder(const QStringList &folders);
+
+    /**
+     * @brief Number of load requests waiting behind the running one
+     */
+    Q_INVOKABLE int c_pendingLoadCount() const;
     
     /**
      * @brief Perform TLM analysis on the current data points
      * @param channelWidth Width of the channel in μm
+     *
+     * Starts performAnalysisAsync(); the result arrives through analysisComplete.
      */
     Q_INVOKABLE void c_performAnalysis(double channelWidth);
+
+    /**
+     * @brief Start TLM analysis on a worker thread
+     * @param channelWidth Width of the channel in μm
+     * @return Future for the outcome
+     *
+     * The worker fits a copy-on-write snapshot of the current points, so
+     * later edits never race with the fit. Starting a new analysis supersedes
+     * any running one: the stale run stops at its next checkpoint and its
+     * outcome is neither stored nor announced.
+     */
+    QFuture<AnalysisOutcome> performAnalysisAsync(double channelWidth);
     
+    /**
+     * @brief Straight-line fit of all enabled points, for drawing the fit line
+     * @return Map with "ok", "slope" and "intercept"
+     */
+    Q_INVOKABLE QVariantMap c_linearFit() const;
+
     // Return last analysis results (slope/intercept/rSquared/sheetResistance/contactResistance)
     Q_INVOKABLE QVariantMap c_lastAnalysisResult() const;
 
+    /**
+     * @brief Names of the TLM structures present in the current data
+     * @return Sorted structure names ("" for points loaded without folder grouping)
+     */
+    Q_INVOKABLE QStringList c_structures() const;
+
+    /**
+     * @brief Per-structure results of the last analysis
+     * @return One map per structure with the same keys as c_lastAnalysisResult()
+     *         plus "structure"
+     */
+    Q_INVOKABLE QVariantList c_structureResults() const;
+
+    /**
+     * @brief Replicate groups of the current data
+     * @return One map per (structure, spacing) with "structure", "spacing",
+     *         "count", "enabledCount", "mean", "variance" and "stdDev"
+     */
+    Q_INVOKABLE QVariantList c_spacingGroups() const;
+
+    /**
+     * @brief Indices of enabled points that deviate from their replicates
+     * @param threshold Deviation limit in standard deviations of the other replicates
+     * @return Indices in collection order
+     */
+    Q_INVOKABLE QList<int> c_replicateOutliers(double threshold = 3.0) const;
+
+    /**
+     * @brief Current index of the point with a given handle
+     * @param handle Stable handle of the point
+     * @return Index, or -1 if no point has that handle
+     */
+    Q_INVOKABLE int c_indexOfHandle(qulonglong handle) const;
+
+    /**
+     * @brief Replicate groups with incrementally maintained aggregates
+     */
+    [[nodiscard]] const SpacingIndex &spacingIndex() const { return m_spacingIndex; }
+
     [[nodiscard]] QAbstractListModel* model() const;
 
     [[nodiscard]] const QVector<DataPoint>& getDataPoints() const;
@@ -137,6 +369,36 @@ public:
      */
     void setChannelWidth(double width);
 
+    /**
+     * @brief Get the fit model used by the analysis
+     * @return Model name ("linear", "circular" or "end_resistance")
+     */
+    Q_INVOKABLE QString getFitModel() const;
+
+    /**
+     * @brief Select the fit model used by the analysis
+     * @param model Model name; unknown names are ignored
+     */
+    void setFitModel(const QString &model);
+
+    /**
+     * @brief Whether the saved configuration has been read
+     * @return False during the first moments after startup, while the
+     *         configuration is still loading on a worker thread
+     */
+    Q_INVOKABLE bool isConfigLoaded() const;
+
+    /**
+     * @brief Names of the available fit models
+     */
+    Q_INVOKABLE QStringList c_fitModels() const;
+
+    /**
+     * @brief Structure geometry for a channel width, taken from the configuration
+     * @param channelWidth Width of the channel in μm
+     */
+    [[nodiscard]] Calculator::FitGeometry fitGeometry(double channelWidth) const;
+
     /**
      * @brief Get resistance voltage
      * @return Resistance voltage value
@@ -160,9 +422,210 @@ public:
      */
     bool calculateTLMResults(Calculator::TLMResult &result, double channelWidth) const;
 
-    // Cancel loading in progress
+    /**
+     * @brief Calculate TLM results separately for every structure
+     * @param results Map receiving one result per structure that could be fitted
+     * @param channelWidth Width of the channel in μm
+     * @return True if at least one structure could be fitted
+     */
+    bool calculateStructureResults(QMap<QString, Calculator::TLMResult> &results, double channelWidth) const;
+
+    /**
+     * @brief Calculate TLM results separately for every structure of a point set
+     * @param points Points sorted by structure
+     * @param results Map receiving one result per structure that could be fitted
+     * @param model Structure model used for every structure
+     * @param geometry Structure geometry
+     * @param pool Pool fitting the structures in parallel; nullptr fits them on the calling thread
+     * @return True if at least one structure could be fitted
+     */
+    static bool calculateStructureResults(const QVector<DataPoint> &points,
+                                          QMap<QString, Calculator::TLMResult> &results,
+                                          Calculator::FitModel model, const Calculator::FitGeometry &geometry,
+                                          QThreadPool *pool = nullptr);
+
+    // Cancel loading (or a reduction) in progress and drop queued load requests
     Q_INVOKABLE void c_cancelLoad();
 
+    /**
+     * @brief Summarise a lot without keeping its points
+     * @param folderPaths Folders to read (local paths or file URLs)
+     *
+     * Streams every file through the ingest pipeline into a StreamReducer on
+     * a worker thread: points are folded into per-structure regression
+     * statistics, replicate statistics and resistance histograms and then
+     * dropped, so memory stays proportional to the number of structures
+     * however many files the lot holds. The collection is left untouched.
+     * The channel width, model geometry and resistance voltage are taken
+     * when the reduction starts. Progress is reported through
+     * progressUpdated; reductionFinished announces the summary.
+     */
+    Q_INVOKABLE void c_reduceFolders(const QStringList &folderPaths);
+
+    /**
+     * @brief Per-structure fits of the last reduction with the current model
+     * @return One map per structure with the keys of c_lastAnalysisResult()
+     *         plus "structure", "points", "median", "p05" and "p95"
+     *         (resistance quantiles from the histogram, Ω)
+     */
+    Q_INVOKABLE QVariantList c_reductionResults() const;
+
+    /**
+     * @brief Replicate statistics of the last reduction
+     * @return One map per (structure, spacing) with "structure", "spacing",
+     *         "count", "mean", "stdDev", "min" and "max"
+     */
+    Q_INVOKABLE QVariantList c_reductionSpacings() const;
+
+    /**
+     * @brief Resistance histogram of one structure of the last reduction
+     * @return One map per non-empty bin with "lower", "upper" (Ω) and "count"
+     */
+    Q_INVOKABLE QVariantList c_reductionHistogram(const QString &structure) const;
+
+    /**
+     * @brief Drop the summary of the last reduction
+     */
+    Q_INVOKABLE void c_clearReduction();
+
+    [[nodiscard]] bool isReducing() const;
+
+    /**
+     * @brief Summary of the last reduction, or nullptr
+     */
+    [[nodiscard]] std::shared_ptr<const StreamReducer> reduction() const { return m_reduction; }
+
+    /**
+     * @brief Index the file names of folders without reading the files
+     * @param folderPaths Folders to walk (local paths or file URLs)
+     *
+     * Walks the folders on a worker thread with the configured discovery
+     * options and extracts the filename_templates fields of every file into
+     * a FilenameIndex, which replaces the previous one. indexReady announces
+     * the result. Refused while another indexing run is in progress.
+     */
+    Q_INVOKABLE void c_indexFolders(const QStringList &folderPaths);
+
+    /**
+     * @brief Run a query against the filename index
+     * @param query Conditions such as "spacing=20 and die_y=7"
+     * @return Map with "ok", "count" (matching files), "error" and "micros"
+     *         (time taken by the query)
+     */
+    Q_INVOKABLE QVariantMap c_queryIndex(const QString &query) const;
+
+    /**
+     * @brief Fields of the filename index
+     */
+    Q_INVOKABLE QStringList c_indexFields() const;
+
+    /**
+     * @brief Distinct values of one field of the filename index
+     */
+    Q_INVOKABLE QStringList c_indexValues(const QString &field) const;
+
+    /**
+     * @brief Load only the indexed files matching a query
+     * @param query Conditions such as "spacing=20 and die_y=7"
+     * @param merge True to merge into the current collection, false to replace it
+     * @return False if there is no index or the query is invalid
+     *
+     * The selected files go through the ingest pipeline as a folder load
+     * would, without walking the folders again; files that do not match are
+     * never opened. In merge mode the points previously loaded from the
+     * indexed folders are replaced.
+     */
+    Q_INVOKABLE bool c_loadQuery(const QString &query, bool merge = false);
+
+    /**
+     * @brief The filename index, or nullptr before c_indexFolders() has finished
+     */
+    [[nodiscard]] std::shared_ptr<const FilenameIndex> filenameIndex() const { return m_filenameIndex; }
+
+    /**
+     * @brief Query the results store
+     * @param query Conditions such as "lot=L42 and date>=2026-09-01" (see ResultStore)
+     * @param limit Maximum number of rows, 0 for all
+     * @return Map with "ok", "error", "micros" and "rows": one map per stored
+     *         structure, newest first, with the keys of c_lastAnalysisResult()
+     *         plus "id", "recordedAt", "lot", "wafer", "die", "structure",
+     *         "folder", "model" and "points"
+     */
+    Q_INVOKABLE QVariantMap c_queryResults(const QString &query, int limit = 1000);
+
+    /**
+     * @brief Per-group statistics of one result quantity from the results store
+     * @param query Conditions selecting the stored structures
+     * @param groupBy lot, wafer, die, structure, model, folder, day or month
+     * @param quantity Result field, e.g. "rsh", "rc", "rho_c" or "lt"
+     * @return Map with "ok", "error", "micros" and "rows": one map per group
+     *         with "key", "count", "mean", "min" and "max"
+     */
+    Q_INVOKABLE QVariantMap c_resultTrend(const QString &query, const QString &groupBy, const QString &quantity);
+
+    /**
+     * @brief Database file of the results store
+     */
+    Q_INVOKABLE QString c_resultStorePath() const;
+
+    /**
+     * @brief Follow a folder whose files are still being written
+     * @param folderPath Folder to follow (a local path or file URL)
+     * @return False if the folder does not exist
+     *
+     * Replaces the points previously loaded from the folder with the points
+     * of its files, then watches the folder. Only bytes appended to a file
+     * since it was last read are parsed, and each point is added as soon
+     * as both of its readings are on disk. New files are picked up as they
+     * appear. Every batch of new points is announced through followUpdated.
+     */
+    Q_INVOKABLE bool c_followFolder(const QString &folderPath);
+
+    /**
+     * @brief Stop following the folder
+     *
+     * Returns at once; the last changes are read in the background. Points
+     * of files without a `[ DATA ]` section, which have no marker for a
+     * complete sweep, are added with them.
+     */
+    Q_INVOKABLE void c_stopFollowing();
+
+    /**
+     * @brief Whether a folder is being followed
+     */
+    [[nodiscard]] bool isFollowing() const { return !m_followedFolder.isEmpty(); }
+
+    /**
+     * @brief Export the current points and per-structure fits on a worker thread
+     * @param basePath Output path without suffix (a local path or file URL);
+     *                 "_points" and "_results" files are written next to it
+     * @param format "csv" or "columnar"
+     *
+     * Fits every structure with the current model against a snapshot of the
+     * points, then streams both tables to disk. Progress arrives through
+     * exportProgressUpdated and the outcome through exportFinished.
+     */
+    Q_INVOKABLE void c_exportResults(const QString &basePath, const QString &format);
+
+    /**
+     * @brief Render the plot of the current points to an image on a worker thread
+     * @param path Output file (a local path or file URL); ".svg" selects SVG, anything else PNG
+     *
+     * Draws the same plot as the interactive chart without needing it on
+     * screen. The outcome arrives through exportFinished.
+     */
+    Q_INVOKABLE void c_exportPlot(const QString &path);
+
+    /**
+     * @brief Render one plot per structure into a folder, in parallel
+     * @param directory Output folder (a local path or file URL)
+     * @param format "png" or "svg"
+     */
+    Q_INVOKABLE void c_exportPlots(const QString &directory, const QString &format);
+
+    // Cancel an export in progress
+    Q_INVOKABLE void c_cancelExport();
+
 signals:
     /**
      * @brief Signal emitted when data changes
@@ -171,6 +634,11 @@ signals:
      * notifying any connected components that they should update their displays.
      */
     void dataChanged();
+
+    /**
+     * @brief Signal emitted when canUndo or canRedo may have changed
+     */
+    void historyChanged();
     
     /**
      * @brief Signal emitted when current folder changes
@@ -186,6 +654,11 @@ signals:
      * @brief Signal emitted to update progress
      */
     void progressUpdated(int progress);
+
+    /**
+     * @brief Signal emitted to update the progress of one folder of a load
+     */
+    void folderProgressUpdated(const QString &folderPath, int progress);
     
     /**
      * @brief Signal emitted when channel width changes
@@ -197,33 +670,316 @@ signals:
      */
     void resistanceVoltageChanged();
 
+    /**
+     * @brief Signal emitted when the fit model changes
+     */
+    void fitModelChanged();
+
+    /**
+     * @brief Signal emitted when following starts or stops
+     */
+    void followingChanged();
+
+    /**
+     * @brief Signal emitted when points have been added from a followed folder
+     * @param newPoints Number of points added by this update
+     */
+    void followUpdated(int newPoints);
+
+    /**
+     * @brief Signal emitted once the saved configuration has been applied
+     */
+    void configLoaded();
+
+    /**
+     * @brief Signal emitted when a reduction starts or stops
+     */
+    void reducingChanged();
+
+    /**
+     * @brief Signal emitted when a reduction has finished
+     * @param structures Structures in the summary
+     * @param points Points folded into the summary
+     * @param cancelled True if the reduction was cancelled; the summary is partial
+     */
+    void reductionFinished(int structures, qlonglong points, bool cancelled);
+
+    /**
+     * @brief Signal emitted when c_indexFolders() has finished
+     * @param files Files in the index
+     * @param errors Templates that could not be compiled; empty if all are valid
+     */
+    void indexReady(int files, const QStringList &errors);
+
+    /**
+     * @brief Signal emitted when the results of an analysis have been stored
+     * @param count Structures stored
+     */
+    void resultsRecorded(int count);
+
+    /**
+     * @brief Signal emitted to update export progress
+     */
+    void exportProgressUpdated(int progress);
+
+    /**
+     * @brief Signal emitted when an export has finished or failed
+     */
+    void exportFinished(bool ok, const QString &message);
+
 private slots:
     // Invokable helper to emit progress from background thread via invokeMethod
     void emitProgress(int progress);
+    void emitFolderProgress(const QString &folderPath, int progress);
+    void emitExportProgress(int progress);
+    void emitResultsRecorded(int count);
 
 private:
     /**
      * @brief Sort data points by spacing in ascending order
      * 
-     * Sorts the internal collection of data points by their spacing values
-     * in ascending order using std::sort with a lambda comparison function.
+     * Sorts the internal collection of data points by structure and then by
+     * spacing in ascending order; points with equal keys keep their order.
      */
     void sortDataPoints();
+
+    /**
+     * @brief Insert a point at its sorted position and index it
+     * @param point Point to insert; a handle is assigned if it has none
+     * @return Index of the inserted point
+     */
+    qsizetype insertSorted(DataPoint point);
+
+    /**
+     * @brief Leave-one-out influence diagnostics of the current collection, per structure
+     */
+    QVector<Calculator::InfluenceDiagnostics> computeDiagnostics() const;
+
+    /**
+     * @brief Leave-one-out influence diagnostics of one structure
+     * @param begin First row of the structure
+     * @param end Row after the structure's last point
+     */
+    QVector<Calculator::InfluenceDiagnostics> computeDiagnostics(qsizetype begin, qsizetype end) const;
+
+    /**
+     * @brief Rows [first, second) of a structure, found by binary search
+     */
+    std::pair<qsizetype, qsizetype> structureRun(const QString &structure) const;
+
+    /**
+     * @brief Adopt the configuration loaded in the background
+     * @param config Resolved configuration
+     */
+    void applyConfig(const AppConfig &config);
+
+    /**
+     * @brief Block until the background configuration load has been applied
+     */
+    void ensureConfigLoaded();
+
+    /**
+     * @brief A change of one row that the model and the history can apply without a reset
+     */
+    using RowEdit = PointEdit;
+
+    /**
+     * @brief Publish a change of the collection
+     * @param resort True if the change may have broken the sort order
+     * @param edits The rows that changed, in the order they were edited; empty if unknown
+     *
+     * Sorts if needed, refreshes the model and emits dataChanged, or defers
+     * all of that to c_commitUpdate() while a batch is open. Known edits are
+     * replayed on the model row by row and only the diagnostics of the
+     * edited structures are recomputed; anything else resets the model.
+     * The same edits are handed to the history.
+     */
+    void publish(bool resort, const QVector<RowEdit> &edits = {});
+
+    /**
+     * @brief Bring the model up to date with the collection
+     * @param edits The rows that changed since the model was last updated; empty if unknown
+     */
+    void refreshModel(const QVector<RowEdit> &edits);
+
+    /**
+     * @brief Replace the collection with the current history entry and its cached fit
+     * @param edits Edits from the collection to the entry, as reported by the history; empty if unknown
+     *
+     * Replays known edits on the collection, the spacing index and the
+     * model; drops any analysis still running.
+     */
+    void restoreHistory(const QVector<RowEdit> &edits);
+
+    /**
+     * @brief Start an export job on a worker thread
+     * @param successMessage Message reported when the job returns no error
+     * @param job Returns an error message, empty on success
+     * @return False if another export is still running
+     */
+    bool startExport(const QString &successMessage, const std::function<QString()> &job);
+
+    /**
+     * @brief Run one analysis against a snapshot; executed on a worker thread
+     */
+    static AnalysisOutcome runAnalysis(const QVector<DataPoint> &snapshot, Calculator::FitModel model,
+                                       const Calculator::FitGeometry &geometry, quint64 generation, const QAtomicInteger<quint64> *currentGeneration,
+                                       QThreadPool *pool);
+
+    /**
+     * @brief Distinct structure names of points sorted by structure
+     */
+    static QStringList structuresOf(const QVector<DataPoint> &points);
+
+    /**
+     * @brief A folder load waiting for (or occupying) the ingest pipeline
+     */
+    struct LoadRequest {
+        QStringList folders;   ///< Folders to load
+        bool merge = false;    ///< Merge into the collection instead of replacing it
+        AppConfig config;      ///< Configuration captured when the request was made
+        std::optional<QVector<QVector<DiscoveredFile>>> files; ///< Files per folder; set to skip discovery
+    };
+
+    /**
+     * @brief Start a load request on a worker thread
+     */
+    void startLoad(const LoadRequest &request);
+
+    /**
+     * @brief Apply the result of the finished load and start the next queued one
+     */
+    void finishLoad(QVector<DataPoint> points);
+
+    /**
+     * @brief Prefix structures with their folder label once several folders are loaded
+     *
+     * The label is the shortest trailing part of the folder path that is
+     * unique among the loaded folders.
+     */
+    void qualifyStructuresByOrigin();
+
+    /**
+     * @brief Points read from a followed folder by one background poll
+     */
+    struct FollowBatch {
+        quint64 generation = 0;                          ///< Follow session that produced the batch
+        QString folder;                                  ///< Followed folder of that session
+        bool final = false;                              ///< Last batch of the session, files finished
+        QHash<QString, QVector<DataPoint>> pointsByFile; ///< New points per file
+        QStringList restartedFiles;                      ///< Files parsed again from the start
+        QHash<QString, QString> newFiles;                ///< Files seen for the first time, with their group
+    };
+
+    /**
+     * @brief Start a background poll of the followed folder if one is due and none is running
+     */
+    void pollFollowed();
+
+    /**
+     * @brief Forget which points were read from the files of a folder
+     */
+    void forgetFollowHandles(const QString &folder);
+
+    /**
+     * @brief Add the points of a poll to the collection
+     *
+     * Points read earlier from files that were parsed again are replaced.
+     */
+    void applyFollowBatch(const FollowBatch &batch);
+
+    /**
+     * @brief Poll files of a followed folder; executed on a worker thread
+     * @param parser Tail parser of the folder
+     * @param folder Followed folder
+     * @param options Discovery options for finding new files
+     * @param rescan True to look for new files
+     * @param changedFiles Files reported as changed, with their group
+     * @param generation Follow session the poll belongs to
+     */
+    static FollowBatch runFollowPoll(const std::shared_ptr<TailParser> &parser, const QString &folder,
+                                     const DiscoveryOptions &options, bool rescan,
+                                     const QHash<QString, QString> &changedFiles, quint64 generation);
     
     QVector<DataPoint> dataPoints;  ///< Internal collection of data points
+    SpacingIndex m_spacingIndex;    ///< Replicate groups of dataPoints
+    mutable QHash<quint64, int> m_handleRows; ///< Row of every handle; built on demand, dropped on publish
+    int m_updateDepth = 0;          ///< Nesting depth of c_beginUpdate()
+    bool m_publishPending = false;  ///< A change was made inside the open batch
+    bool m_resortPending = false;   ///< A change inside the open batch needs a re-sort
+    PointHistory m_history;         ///< Published states of the collection, for undo and redo
     QString m_currentFolder;        ///< Current folder path for CSV files
     double m_channelWidth;          ///< Channel width for calculations
     double m_resistanceVoltage;     ///< Resistance voltage for calculations
+    Calculator::FitModel m_fitModel = Calculator::FitModel::LinearTLM; ///< Model used by the analysis
     AppConfig m_appConfig;          ///< Application configuration
+    bool m_configLoaded = false;    ///< The saved configuration has been applied
+    QSet<QString> m_editedSettings; ///< Config keys changed before the configuration was applied
+
+    // Background configuration load started by the constructor
+    QFutureWatcher<AppConfig> *m_configWatcher = nullptr;
 
     // Background loading watcher for asynchronous folder processing
     QFutureWatcher<QVector<DataPoint>> *m_loadWatcher = nullptr;
+    FolderPrefetcher *m_prefetcher = nullptr;   ///< Parses the next sibling folders ahead of time
+    LoadRequest m_activeLoad;               ///< Load currently running
+    QQueue<LoadRequest> m_pendingLoads;     ///< Loads waiting for the running one
+
+    // Background analysis; only the outcome of the newest generation is published
+    QFutureWatcher<AnalysisOutcome> *m_analysisWatcher = nullptr;
+    QAtomicInteger<quint64> m_analysisGeneration {0};
 
     Calculator::TLMResult m_lastResult;
+    QMap<QString, Calculator::TLMResult> m_structureResults; ///< Last results per structure
 
     QAtomicInt m_cancelRequested {0};
 
+    // Following a folder that is still being written
+    QString m_followedFolder;                           ///< Absolute path, empty when not following
+    std::shared_ptr<TailParser> m_tailParser;           ///< Per-file parse state; used by one poll at a time
+    QFileSystemWatcher *m_followWatcher = nullptr;      ///< Watches the folder and its files
+    QFutureWatcher<FollowBatch> *m_followPollWatcher = nullptr;
+    QHash<QString, QString> m_followGroups;             ///< Group of every followed file
+    QHash<QString, QString> m_followChanged;            ///< Changed files waiting for the next poll
+    bool m_followRescan = false;                        ///< The folder changed since the last poll
+    quint64 m_followGeneration = 0;                     ///< Incremented by every c_followFolder() and c_stopFollowing()
+    QHash<QString, quint64> m_followSessions;           ///< Generation of the latest session of each followed folder
+    QQueue<std::function<FollowBatch()>> m_followFinals; ///< Final polls of stopped sessions waiting for the poll watcher
+    QHash<QString, QVector<quint64>> m_followHandles;   ///< Handles of the points read from each file, until its session ends
+
+    // Streaming reduction of a lot; only the summary is kept
+    QFutureWatcher<std::shared_ptr<StreamReducer>> *m_reduceWatcher = nullptr;
+    std::shared_ptr<const StreamReducer> m_reduction;   ///< Summary of the last reduction
+    QAtomicInt m_reduceCancel {0};
+
+    /**
+     * @brief The results store, opened on first use; nullptr if it cannot be opened
+     */
+    ResultStore *resultStore();
+
+    /**
+     * @brief Store the records of an analysis on the I/O pool
+     */
+    void recordResults(const QVector<ResultStore::Record> &records);
+
+    // Results store for queries, used from the GUI thread only
+    std::unique_ptr<ResultStore> m_resultStore;
+    QMutex m_recordMutex;   ///< Serialises the background recordings
+
+    // Filename metadata of indexed folders
+    QFutureWatcher<std::shared_ptr<FilenameIndex>> *m_indexWatcher = nullptr;
+    std::shared_ptr<const FilenameIndex> m_filenameIndex;   ///< Result of the last c_indexFolders()
+
+    // Background export; the future carries an error message, empty on success
+    QFutureWatcher<QString> *m_exportWatcher = nullptr;
+    QString m_exportSuccessMessage;   ///< Reported by exportFinished when the running export succeeds
+    QAtomicInt m_exportCancel {0};
+
     DataPointModel *m_model = nullptr;
+
+    // I/O, ingest and compute pools; declared last so they are destroyed after nothing else needs them.
+    // The destructor drains them before any other member goes away.
+    WorkerPools m_pools;
 };
 
 #endif // TLMANALYZER_DATAMANAGER_H
@@ -2,6 +2,7 @@
 #define TLMANALYZER_DATAPOINT_H
 
 #include <QMetaType>
+#include <QString>
 #include <QVector>
 
 
@@ -9,13 +10,17 @@
  * @brief Represents a single data point in TLM analysis
  * 
  * Contains the spacing, resistance, current measurements and enabled status
- * for a single TLM data point.
+ * for a single TLM data point, plus the structure it was measured on.
  */
 struct DataPoint {
     double spacing;      ///< Pad spacing in micrometers (μm)
     double resistance;   ///< Total resistance in ohms (Ω)
     double current;      ///< Current in amperes (A)
     bool enabled;        ///< Whether this data point is enabled for analysis
+    QString structure;   ///< TLM structure the point belongs to (empty for a single structure)
+    QString source;      ///< Instrument buffer / step the point was extracted from
+    QString origin;      ///< Folder the point was loaded from (empty for manual points)
+    quint64 handle = 0;  ///< Stable handle assigned by DataManager (0 = unassigned)
     
     /**
      * @brief Default constructor
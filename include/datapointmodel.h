@@ -4,6 +4,7 @@
 #include <QAbstractListModel>
 #include <QModelIndex>
 #include "datapoint.h"
+#include "calculator.h"
 #include <QVector>
 
 class DataPointModel : public QAbstractListModel
@@ -14,7 +15,18 @@ public:
         SpacingRole = Qt::UserRole + 1,
         ResistanceRole,
         CurrentRole,
-        EnabledRole
+        EnabledRole,
+        StructureRole,
+        SourceRole,
+        OriginRole,
+        HandleRole,
+        LeverageRole,
+        ResidualRole,
+        StudentizedResidualRole,
+        CooksDistanceRole,
+        LooSheetResistanceRole,
+        LooContactResistanceRole,
+        InfluentialRole
     };
 
     explicit DataPointModel(QObject *parent = nullptr);
@@ -25,7 +37,16 @@ public:
     [[nodiscard]] QHash<int, QByteArray> roleNames() const override;
 
     // Helpers to manage underlying data
-    void setDataPoints(const QVector<DataPoint> &points);
+    void setDataPoints(const QVector<DataPoint> &points,
+                       const QVector<Calculator::InfluenceDiagnostics> &diagnostics = {});
+    // Replace the influence diagnostics without resetting the model
+    void setDiagnostics(const QVector<Calculator::InfluenceDiagnostics> &diagnostics);
+    // Replace the diagnostics of the rows starting at first, e.g. one structure
+    void setDiagnostics(int first, const QVector<Calculator::InfluenceDiagnostics> &diagnostics);
+    // Single-row edits; an inserted row has neutral diagnostics until they are set
+    void setPoint(int row, const DataPoint &point);
+    void insertPoint(int row, const DataPoint &point);
+    void removePoint(int row);
     [[nodiscard]] const QVector<DataPoint>& dataPoints() const { return m_points; }
 
     // QML-friendly accessors
@@ -34,6 +55,7 @@ public:
 
 private:
     QVector<DataPoint> m_points;
+    QVector<Calculator::InfluenceDiagnostics> m_diagnostics; ///< Parallel to m_points (may be empty)
 };
 
 #endif // TLMANALYZER_DATAPOINTMODEL_H
@@ -0,0 +1,97 @@
+#ifndef TLMANALYZER_FILEDISCOVERY_H
+#define TLMANALYZER_FILEDISCOVERY_H
+
+#include <QAtomicInt>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+#include "appconfig.h"
+
+/**
+ * @brief Settings controlling which files are discovered under a root folder
+ */
+struct DiscoveryOptions {
+    bool recursive = false;                              ///< Descend into sub-folders
+    QStringList includePatterns {QStringLiteral("*.csv")}; ///< Wildcards a file name must match
+    QStringList excludePatterns;                         ///< Wildcards excluding files or whole folders
+    bool groupByFolder = false;                          ///< Tag files with their folder as structure
+
+    /**
+     * @brief Build options from the persisted application configuration
+     * @param config Application configuration
+     * @return Discovery options
+     */
+    static DiscoveryOptions fromConfig(const AppConfig &config);
+};
+
+/**
+ * @brief A file found during discovery
+ */
+struct DiscoveredFile {
+    QString path;      ///< Absolute path of the file
+    QString fileName;  ///< File name without directory
+    QString group;     ///< Folder relative to the root ("" for the root or when not grouping)
+    double spacing = -1; ///< Spacing already known from a FilenameIndex (-1: read it from the name)
+};
+
+/**
+ * @brief Streaming directory walker for large lot/wafer/die trees
+ *
+ * Walks the tree depth-first, one directory listing at a time, and hands
+ * every matching file to a visitor as soon as it is listed. Nothing is
+ * collected up front, so the first file reaches the parsers after a single
+ * directory read regardless of how large the tree is.
+ *
+ * Include patterns are matched against the file name. Exclude patterns are
+ * matched against both the name and the path relative to the root; a
+ * matching folder is pruned without being listed.
+ */
+class FileDiscovery {
+public:
+    /**
+     * @brief Visitor invoked for every discovered file
+     * @return False to stop the walk
+     */
+    using Visitor = std::function<bool(DiscoveredFile &&file)>;
+
+    /**
+     * @brief Constructor
+     * @param options Discovery options; patterns are compiled once here
+     */
+    explicit FileDiscovery(const DiscoveryOptions &options = DiscoveryOptions());
+
+    /**
+     * @brief Walk a root folder and report matching files
+     * @param rootPath Folder to walk
+     * @param visitor Called for every matching file, in walk order
+     * @param cancelFlag Optional flag; the walk stops when it becomes non-zero
+     * @return Number of files passed to the visitor
+     */
+    qsizetype discover(const QString &rootPath, const Visitor &visitor,
+                       const QAtomicInt *cancelFlag = nullptr) const;
+
+    /**
+     * @brief Check a file against the include and exclude patterns
+     * @param fileName File name without directory
+     * @param relativePath Path relative to the walked root
+     * @return True if the file should be processed
+     */
+    [[nodiscard]] bool acceptsFile(const QString &fileName, const QString &relativePath) const;
+
+    /**
+     * @brief Check whether a folder should be descended into
+     * @param dirName Folder name without parent
+     * @param relativePath Path relative to the walked root
+     * @return True unless the folder matches an exclude pattern
+     */
+    [[nodiscard]] bool acceptsDirectory(const QString &dirName, const QString &relativePath) const;
+
+private:
+    DiscoveryOptions m_options;
+    QVector<QRegularExpression> m_include;
+    QVector<QRegularExpression> m_exclude;
+};
+
+#endif // TLMANALYZER_FILEDISCOVERY_H
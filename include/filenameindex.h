@@ -0,0 +1,301 @@
+#ifndef TLMANALYZER_FILENAMEINDEX_H
+#define TLMANALYZER_FILENAMEINDEX_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "filediscovery.h"
+
+/**
+ * @brief Compiled filename templates that extract named fields
+ *
+ * A template is the file's base name (without the last extension) with
+ * `{field}` placeholders, e.g. `{lot}_W{wafer}_X{die_x}Y{die_y}_{structure}_{spacing}um`.
+ * `{field:regex}` gives a placeholder its own pattern and `*` matches any
+ * text. `{spacing}` matches a decimal number; other placeholders match as
+ * little text as the rest of the template allows. Matching is
+ * case-insensitive and templates are tried in order; the first match wins.
+ * Every template is compiled once, in the constructor.
+ */
+class FilenameTemplates {
+public:
+    /**
+     * @brief Constructor
+     * @param templates Templates in priority order; invalid ones are skipped (see errors())
+     */
+    explicit FilenameTemplates(const QStringList &templates = QStringList());
+
+    /**
+     * @brief True if no valid template was given
+     */
+    [[nodiscard]] bool isEmpty() const { return m_templates.isEmpty(); }
+
+    /**
+     * @brief Descriptions of the templates that could not be compiled
+     */
+    [[nodiscard]] const QStringList &errors() const { return m_errors; }
+
+    /**
+     * @brief Field names of all templates, in first-seen order
+     */
+    [[nodiscard]] QStringList fieldNames() const;
+
+    /**
+     * @brief Match a file name
+     * @param fileName File name without directory
+     * @param names Receives the field names of the matching template
+     * @param values Receives the field values, parallel to names
+     * @return Index of the matching template, or -1
+     */
+    int match(const QString &fileName, QStringList &names, QStringList &values) const;
+
+    /**
+     * @brief Pad spacing encoded in a file name
+     * @param fileName File name without directory
+     * @return The `spacing` field of the first matching template, else
+     *         CSVProcessor::extractSpacingFromFilename(); -1 if there is none
+     */
+    [[nodiscard]] double spacing(const QString &fileName) const;
+
+    /**
+     * @brief Translate a template into a regular expression
+     * @param text Template
+     * @param fields Receives the placeholder names in order
+     * @param error Receives a description of the problem, if any
+     * @return Anchored pattern with one capture group per placeholder, in field order; empty on error
+     */
+    static QString toPattern(const QString &text, QStringList &fields, QString *error = nullptr);
+
+private:
+    struct Compiled {
+        QRegularExpression regex;
+        QStringList fields;
+        int spacingField = -1;   ///< Position of "spacing" in fields, or -1
+    };
+
+    QVector<Compiled> m_templates;
+    QStringList m_errors;
+};
+
+/**
+ * @brief In-memory index of discovered files by filename field
+ *
+ * Every file gets a dense id in the order it is added. Each field keeps a
+ * dictionary of its distinct values and, per value, a bitmap of the files
+ * carrying it. Bitmaps store only the words between the first and the last
+ * set bit, so values whose files are contiguous in walk order (a lot, a
+ * wafer, a die folder) cost a few words however many files the index holds.
+ *
+ * Besides the template fields, every file is indexed under `spacing`
+ * (falling back to the first number in the name when no template matches)
+ * and, when discovery groups by folder, `group`.
+ *
+ * A query is a list of conditions `field op value` joined by whitespace,
+ * commas or `and`, with op one of `=`, `!=`, `<`, `<=`, `>`, `>=`; `=` also
+ * accepts alternatives separated by `|`. Values that parse as numbers are
+ * compared numerically ("7" equals "07"). Each condition scans only the
+ * field's dictionary and ORs the postings of the matching values; the
+ * conditions are then ANDed, so a query costs O(distinct values + words)
+ * and never touches the files themselves.
+ *
+ * Example: `spacing=20 and die_y=7`
+ */
+class FilenameIndex {
+public:
+    using FileId = quint32;
+
+    /**
+     * @brief Set of file ids stored as a trimmed run of 64-bit words
+     */
+    class Bitmap {
+    public:
+        /**
+         * @brief Add an id; cheapest when ids arrive in ascending order
+         */
+        void set(FileId id);
+
+        /**
+         * @brief Check whether an id is in the set
+         */
+        [[nodiscard]] bool contains(FileId id) const;
+
+        /**
+         * @brief Number of ids in the set
+         */
+        [[nodiscard]] qsizetype count() const;
+
+        /**
+         * @brief True if the set is empty
+         */
+        [[nodiscard]] bool isEmpty() const { return m_words.isEmpty(); }
+
+        /**
+         * @brief Ids in ascending order
+         */
+        [[nodiscard]] QVector<FileId> ids() const;
+
+        /**
+         * @brief Intersection
+         */
+        [[nodiscard]] Bitmap operator&(const Bitmap &other) const;
+
+        /**
+         * @brief Union, in place
+         */
+        Bitmap &operator|=(const Bitmap &other);
+
+        /**
+         * @brief Set of the ids 0 to count - 1
+         */
+        static Bitmap range(qsizetype count);
+
+    private:
+        void trim();
+
+        qsizetype m_firstWord = 0;   ///< Index of the first stored word
+        QVector<quint64> m_words;    ///< Words from m_firstWord on; first and last are non-zero
+    };
+
+    /**
+     * @brief Comparison of a query condition
+     */
+    enum class Op {
+        Equal,
+        NotEqual,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual
+    };
+
+    /**
+     * @brief One condition of a query
+     */
+    struct Condition {
+        QString field;
+        Op op = Op::Equal;
+        QStringList values;   ///< Alternatives; more than one only for Equal
+    };
+
+    /**
+     * @brief Constructor
+     * @param templates Filename templates (see FilenameTemplates)
+     */
+    explicit FilenameIndex(const QStringList &templates = QStringList());
+
+    /**
+     * @brief Walk folders and index every discovered file
+     * @param folderPaths Folders to walk
+     * @param options Discovery options (recursion, patterns, grouping)
+     * @param cancelFlag Optional flag; the walk stops when it becomes non-zero
+     * @return Number of files added
+     */
+    qsizetype addFolders(const QStringList &folderPaths, const DiscoveryOptions &options,
+                         const QAtomicInt *cancelFlag = nullptr);
+
+    /**
+     * @brief Index one file
+     * @param root Folder the file was found in
+     * @param file The file
+     * @return Id of the file
+     */
+    FileId add(const QString &root, const DiscoveredFile &file);
+
+    /**
+     * @brief Remove all files; the templates are kept
+     */
+    void clear();
+
+    /**
+     * @brief Number of files in the index
+     */
+    [[nodiscard]] qsizetype size() const { return m_paths.size(); }
+
+    /**
+     * @brief Indexed field names: template fields, then `spacing` and `group`
+     */
+    [[nodiscard]] QStringList fields() const;
+
+    /**
+     * @brief Distinct values of a field, in first-seen order
+     */
+    [[nodiscard]] QStringList values(const QString &field) const;
+
+    /**
+     * @brief Templates that could not be compiled
+     */
+    [[nodiscard]] const QStringList &templateErrors() const { return m_templates.errors(); }
+
+    /**
+     * @brief Parse a query
+     * @param text Query text; empty selects every file
+     * @param conditions Receives the conditions
+     * @param error Receives a description of the problem, if any
+     * @return False if the text is not a valid query
+     */
+    static bool parseQuery(const QString &text, QVector<Condition> &conditions, QString *error = nullptr);
+
+    /**
+     * @brief Files satisfying every condition
+     * @param conditions Conditions to AND
+     * @param error Receives a description of the problem, if any (e.g. an unknown field)
+     * @return Matching file ids
+     */
+    [[nodiscard]] Bitmap select(const QVector<Condition> &conditions, QString *error = nullptr) const;
+
+    /**
+     * @brief Parse and run a query
+     * @param text Query text
+     * @param error Receives a description of the problem, if any
+     * @return Matching file ids; empty on error
+     */
+    [[nodiscard]] Bitmap query(const QString &text, QString *error = nullptr) const;
+
+    /**
+     * @brief Path of a file
+     */
+    [[nodiscard]] QString path(FileId id) const { return m_paths.at(id); }
+
+    /**
+     * @brief Spacing of a file (μm), or -1
+     */
+    [[nodiscard]] double spacing(FileId id) const { return m_spacings.at(id); }
+
+    /**
+     * @brief Folders the indexed files were found in, in the order first seen
+     */
+    [[nodiscard]] const QStringList &roots() const { return m_roots; }
+
+    /**
+     * @brief Selected files grouped by folder, ready for IngestPipeline::runFiles()
+     * @param selection File ids
+     * @return One list per entry of roots(), in id order; spacing is filled in
+     */
+    [[nodiscard]] QVector<QVector<DiscoveredFile>> files(const Bitmap &selection) const;
+
+private:
+    struct Field {
+        QString name;
+        QHash<QString, quint32> ids;   ///< Value to dictionary id
+        QStringList values;            ///< Dictionary id to value
+        QVector<double> numbers;       ///< Numeric value per dictionary id, NaN if not a number
+        QVector<Bitmap> postings;      ///< Files per dictionary id
+    };
+
+    int fieldIndex(const QString &name);
+    void post(int field, const QString &value, FileId id);
+
+    FilenameTemplates m_templates;
+    QVector<Field> m_fields;
+    QHash<QString, int> m_fieldIndex;   ///< Lower-case field name to position in m_fields
+    QStringList m_paths;                ///< Path per file id
+    QVector<double> m_spacings;         ///< Spacing per file id
+    QStringList m_groups;               ///< Discovery group per file id
+    QVector<quint32> m_rootIds;         ///< Root per file id
+    QStringList m_roots;                ///< Distinct roots
+};
+
+#endif // TLMANALYZER_FILENAMEINDEX_H
@@ -0,0 +1,200 @@
+#ifndef TLMANALYZER_FITMODELS_H
+#define TLMANALYZER_FITMODELS_H
+
+#include <QVector>
+#include <cmath>
+#include "calculator.h"
+#include "datapoint.h"
+
+/**
+ * @brief Structure-model policies for the TLM fitting engine
+ *
+ * Each policy maps a measured point onto the straight line its structure
+ * obeys (x, y), maps a value on that line back to a resistance (resistance)
+ * and turns the fitted slope and intercept into physical parameters
+ * (extract). FitEngine is instantiated once per policy, so the
+ * transforms are inlined into the fitting loops and no model switch is
+ * evaluated per point. Geometry is in μm, resistances in Ω.
+ */
+namespace FitModels {
+
+/**
+ * @brief Linear (rectangular) TLM: R = (Rsh/W)·d + 2Rc
+ */
+struct LinearTLM {
+    static constexpr Calculator::FitModel id = Calculator::FitModel::LinearTLM;
+
+    static inline double x(const DataPoint &point, const Calculator::FitGeometry &) { return point.spacing; }
+    static inline double y(const DataPoint &point, const Calculator::FitGeometry &) { return point.resistance; }
+    static inline double resistance(double y, double, const Calculator::FitGeometry &) { return y; }
+
+    static inline void extract(double slope, double intercept, const Calculator::FitGeometry &geometry,
+                               Calculator::TLMResult &result)
+    {
+        result.sheetResistance = slope * geometry.channelWidth;  // Convert to Ω/sq
+        result.contactResistance = intercept;                    // Contact resistance in Ω
+        // Specific contact resistivity (legacy formula used by the app).
+        // Keep same units as before but guard against division by zero.
+        if (std::abs(result.sheetResistance) < 1e-15) {
+            result.specificContactResistivity = 0.0;
+        } else {
+            result.specificContactResistivity = (intercept * intercept / result.sheetResistance) * 1e-2; // ρc in Ω·cm²
+        }
+        result.transferLength = std::abs(slope) < 1e-15 ? 0.0 : intercept / (2.0 * slope);
+    }
+};
+
+/**
+ * @brief Circular TLM with inner contact radius r0 and gap d
+ *
+ * R = Rsh/(2π·r0)·(d + 2LT)·c(d) with the curvature correction
+ * c(d) = (r0/d)·ln(1 + d/r0). Dividing R by c(d) linearises the relation.
+ */
+struct CircularTLM {
+    static constexpr Calculator::FitModel id = Calculator::FitModel::CircularTLM;
+    static constexpr double pi = 3.14159265358979323846;
+
+    static inline double correction(double gap, double innerRadius)
+    {
+        const double ratio = gap / innerRadius;
+        return ratio > 0.0 ? std::log1p(ratio) / ratio : 1.0;
+    }
+
+    static inline double x(const DataPoint &point, const Calculator::FitGeometry &) { return point.spacing; }
+    static inline double y(const DataPoint &point, const Calculator::FitGeometry &geometry)
+    {
+        return point.resistance / correction(point.spacing, geometry.ctlmInnerRadius);
+    }
+    static inline double resistance(double y, double spacing, const Calculator::FitGeometry &geometry)
+    {
+        return y * correction(spacing, geometry.ctlmInnerRadius);
+    }
+
+    static inline void extract(double slope, double intercept, const Calculator::FitGeometry &geometry,
+                               Calculator::TLMResult &result)
+    {
+        result.sheetResistance = slope * 2.0 * pi * geometry.ctlmInnerRadius;
+        result.contactResistance = intercept;
+        result.transferLength = std::abs(slope) < 1e-15 ? 0.0 : intercept / (2.0 * slope);
+        // ρc = Rsh·LT², Ω·μm² to Ω·cm²
+        result.specificContactResistivity = result.sheetResistance * result.transferLength * result.transferLength * 1e-8;
+    }
+};
+
+/**
+ * @brief Linear TLM with finite contact length L (end-resistance model)
+ *
+ * The intercept is still 2Rc, but Rc = (Rsh·LT/W)·coth(L/LT), so LT is found
+ * by Newton iteration instead of read off the intercept. The end resistance
+ * Re = Rsh·LT/(W·sinh(L/LT)) follows from LT.
+ */
+struct EndResistanceTLM {
+    static constexpr Calculator::FitModel id = Calculator::FitModel::EndResistance;
+
+    static inline double x(const DataPoint &point, const Calculator::FitGeometry &) { return point.spacing; }
+    static inline double y(const DataPoint &point, const Calculator::FitGeometry &) { return point.resistance; }
+    static inline double resistance(double y, double, const Calculator::FitGeometry &) { return y; }
+
+    /**
+     * @brief Solve LT·coth(L/LT) = k for LT
+     * @param k Rc·W/Rsh in μm
+     * @param contactLength Contact length L in μm
+     * @return Transfer length in μm, or 0 if k or L is not positive
+     */
+    static inline double solveTransferLength(double k, double contactLength)
+    {
+        if (!(k > 0.0) || !(contactLength > 0.0)) {
+            return 0.0;
+        }
+        // Start from the long-contact limit coth → 1
+        double lt = k;
+        for (int i = 0; i < 100; ++i) {
+            const double u = contactLength / lt;
+            const double sinhU = std::sinh(u);
+            const double cothU = 1.0 / std::tanh(u);
+            const double g = lt * cothU - k;
+            const double dg = cothU + (std::isfinite(sinhU) ? u / (sinhU * sinhU) : 0.0);
+            double next = lt - g / dg;
+            if (next <= 0.0) {
+                next = lt / 2.0;
+            }
+            if (std::abs(next - lt) <= 1e-12 * lt) {
+                return next;
+            }
+            lt = next;
+        }
+        return lt;
+    }
+
+    static inline void extract(double slope, double intercept, const Calculator::FitGeometry &geometry,
+                               Calculator::TLMResult &result)
+    {
+        result.sheetResistance = slope * geometry.channelWidth;
+        result.contactResistance = intercept;
+        const double rc = intercept / 2.0;
+        const double k = std::abs(result.sheetResistance) < 1e-15 ? 0.0 : rc * geometry.channelWidth / result.sheetResistance;
+        result.transferLength = solveTransferLength(k, geometry.contactLength);
+        result.specificContactResistivity = result.sheetResistance * result.transferLength * result.transferLength * 1e-8;
+        result.endResistance = result.transferLength > 0.0
+            ? result.sheetResistance * result.transferLength
+                / (geometry.channelWidth * std::sinh(geometry.contactLength / result.transferLength))
+            : 0.0;
+    }
+};
+
+/**
+ * @brief Least-squares fitting engine specialised for one structure model
+ */
+template <typename Model>
+struct FitEngine {
+    /**
+     * @brief Fit the enabled points of one structure
+     * @param dataPoints Points to fit; disabled points are skipped
+     * @param geometry Structure geometry
+     * @param result Receives the fit and the extracted parameters
+     * @return True if at least two enabled points with distinct x were fitted
+     */
+    static bool fit(const QVector<DataPoint> &dataPoints, const Calculator::FitGeometry &geometry,
+                    Calculator::TLMResult &result)
+    {
+        if (dataPoints.size() < 2) {
+            return false;
+        }
+
+        // Select first, then transform in a loop without data-dependent branches
+        QVector<const DataPoint *> enabled;
+        enabled.reserve(dataPoints.size());
+        for (const DataPoint &point : dataPoints) {
+            if (point.enabled) {
+                enabled.append(&point);
+            }
+        }
+        if (enabled.size() < 2) {
+            return false;
+        }
+
+        QVector<double> x(enabled.size()), y(enabled.size());
+        for (qsizetype i = 0; i < enabled.size(); ++i) {
+            x[i] = Model::x(*enabled[i], geometry);
+            y[i] = Model::y(*enabled[i], geometry);
+        }
+
+        double slope, intercept;
+        if (!Calculator::linearRegression(x, y, slope, intercept)) {
+            return false;
+        }
+
+        result.slope = slope;
+        result.intercept = intercept;
+        result.channelWidth = geometry.channelWidth;
+        result.transferLength = 0.0;
+        result.endResistance = 0.0;
+        Model::extract(slope, intercept, geometry, result);
+        result.rSquared = Calculator::calculateRSquared(x, y, slope, intercept);
+        return true;
+    }
+};
+
+} // namespace FitModels
+
+#endif // TLMANALYZER_FITMODELS_H
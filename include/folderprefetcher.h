@@ -0,0 +1,194 @@
+#ifndef TLMANALYZER_FOLDERPREFETCHER_H
+#define TLMANALYZER_FOLDERPREFETCHER_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+#include <memory>
+#include "appconfig.h"
+#include "datapoint.h"
+#include "workerpools.h"
+
+/**
+ * @brief Parses the folders a user is likely to load next, ahead of time
+ *
+ * Engineers step through the dies of a wafer one folder at a time. After a
+ * folder is loaded, prefetchAfter() predicts the next few sibling folders,
+ * in natural name order or in a supplied wafer-map order, and parses them
+ * one folder at a time. Each parse is an ingest run driven from a single
+ * low-priority thread, with one worker per stage (enumerate, read, parse,
+ * validate) at the same priority, taken from the shared stage pool if one
+ * is set. Finished point sets are kept in a small LRU cache, and take()
+ * hands them out, or the parse still in progress for the requested folder,
+ * instead of loading from scratch.
+ *
+ * A request for any other folder cancels the speculative work at once
+ * (retarget()), so prefetching never competes with what the user asked
+ * for. Cached sets are only used while the ingest settings and the files
+ * (their paths, sizes and modification times) are the same as when they
+ * were parsed.
+ *
+ * Used from the GUI thread only.
+ */
+class FolderPrefetcher : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor; prefetching is off until configure() sets a depth
+     * @param parent The parent QObject
+     */
+    explicit FolderPrefetcher(QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor; cancels the running parse and waits for it
+     */
+    ~FolderPrefetcher() override;
+
+    /**
+     * @brief Apply prefetch_folders, prefetch_cache, prefetch_order, prefetch_priority and worker_cpus
+     *
+     * A depth of 0 turns prefetching off and drops the cache.
+     */
+    void configure(const AppConfig &config);
+
+    /**
+     * @brief Run the stage workers of prefetch parses on a shared pool
+     * @param pool Stage pool; nullptr for a pool private to each parse
+     */
+    void setStagePool(WorkerPool *pool);
+
+    /**
+     * @brief Replace the wafer-map order used to predict the next folders
+     * @param order Folder names or paths in stepping order; empty for natural name order
+     */
+    void setOrder(const QStringList &order);
+
+    /**
+     * @brief Number of folders parsed ahead; 0 if prefetching is off
+     */
+    [[nodiscard]] int depth() const { return m_depth; }
+
+    /**
+     * @brief Points of a folder parsed ahead
+     * @param folder Folder the user loads
+     * @param config Configuration of the load
+     * @param pool Pool that checks a cached set
+     * @param load Normal load of the folder, run on `pool` if the cached set is stale
+     * @return Future of a cached set or its replacement, the running parse
+     *         of the folder, or an invalid future if the folder must be loaded
+     *
+     * A cached set is checked against a fresh folderStamp() on `pool`, so
+     * the calling thread never lists the folder.
+     */
+    QFuture<QVector<DataPoint>> take(const QString &folder, const AppConfig &config, WorkerPool *pool,
+                                     const std::function<QVector<DataPoint>()> &load);
+
+    /**
+     * @brief Cancel speculative work that does not serve a request
+     * @param folders Folders the user requested
+     *
+     * Drops the queue and cancels the running parse unless it is for one of
+     * the requested folders.
+     */
+    void retarget(const QStringList &folders);
+
+    /**
+     * @brief Cancel all work, including a parse handed out by take()
+     */
+    void cancel();
+
+    /**
+     * @brief Start parsing the folders predicted to follow one
+     * @param folder Folder that was just loaded
+     * @param config Configuration of that load
+     */
+    void prefetchAfter(const QString &folder, const AppConfig &config);
+
+    /**
+     * @brief True if a ready point set of a folder is cached
+     */
+    [[nodiscard]] bool isCached(const QString &folder) const;
+
+    /**
+     * @brief Folders that follow one
+     * @param folder Current folder
+     * @param order Folder names or paths in stepping order; empty for natural name order
+     * @param count Maximum number of folders returned
+     * @return Existing sibling folders, as absolute paths, in stepping order
+     *
+     * Natural order compares runs of digits by value, so die2 comes before
+     * die10. A folder missing from a supplied order falls back to name order.
+     */
+    static QStringList siblingsAfter(const QString &folder, const QStringList &order, int count);
+
+    /**
+     * @brief Settings that change what a folder parses to
+     */
+    static QString ingestKey(const AppConfig &config);
+
+    /**
+     * @brief Fingerprint of the files a load of a folder would read
+     * @param folder Folder to list
+     * @param config Configuration selecting the files
+     * @return Hash over the paths, sizes and modification times of the files
+     */
+    static QByteArray folderStamp(const QString &folder, const AppConfig &config);
+
+signals:
+    /**
+     * @brief Emitted when a folder has been parsed ahead and cached
+     */
+    void prefetched(const QString &folder, int points);
+
+private:
+    /**
+     * @brief A ready point set
+     */
+    struct Entry {
+        QString folder;            ///< Absolute path
+        QString key;               ///< ingestKey() of the parse
+        QByteArray stamp;          ///< folderStamp() taken before the parse started
+        QVector<DataPoint> points;
+        std::shared_ptr<QAtomicInt> stale;  ///< Set by take()'s check when the files changed
+    };
+
+    /**
+     * @brief True if a take() found the files of an entry changed
+     */
+    static bool isStale(const Entry &entry);
+
+    /**
+     * @brief Drop entries found stale
+     */
+    void dropStale();
+
+    void startNext();
+    void finishRunning();
+
+    WorkerPool m_pool;                                  ///< Single low-priority thread driving one ingest run at a time
+    WorkerPool *m_stagePool = nullptr;                  ///< Shared pool of the stage workers; nullptr for a private one
+    QFutureWatcher<QVector<DataPoint>> *m_watcher = nullptr;
+
+    QStringList m_queue;                                ///< Folders still to parse, next first
+    AppConfig m_queueConfig;                            ///< Configuration for the queued folders
+
+    Entry m_running;                                    ///< Folder being parsed; points unused
+    std::shared_ptr<QAtomicInt> m_runningCancel;        ///< Cancel flag of the running parse
+    std::shared_ptr<QByteArray> m_runningStamp;         ///< Set by the running parse before it reads
+    bool m_runningAdopted = false;                      ///< The running parse was handed out by take()
+
+    QList<Entry> m_cache;                               ///< Most recently used first
+    int m_depth = 0;
+    int m_capacity = 4;
+    QStringList m_order;
+};
+
+#endif // TLMANALYZER_FOLDERPREFETCHER_H
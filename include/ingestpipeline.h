@@ -0,0 +1,194 @@
+#ifndef TLMANALYZER_INGESTPIPELINE_H
+#define TLMANALYZER_INGESTPIPELINE_H
+
+#include <QAtomicInt>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+#include <functional>
+#include "datapoint.h"
+#include "appconfig.h"
+#include "filenameindex.h"
+
+class QThreadPool;
+class WorkerPool;
+
+/**
+ * @brief Concurrency and buffering settings for the ingest pipeline
+ *
+ * Each stage runs its own set of workers. The enumerate stage walks the
+ * directory sequentially and the reduce stage runs on the calling thread,
+ * so only the read, parse and validate stages are configurable. The stage
+ * workers run on a shared stage pool, which may grant fewer workers than
+ * asked for, or else on a pool private to the run, at the given priority
+ * and on the given CPUs.
+ */
+struct IngestOptions {
+    int readThreads;      ///< Concurrent file readers (I/O bound)
+    int parseThreads;     ///< Concurrent CSV parsers (CPU bound)
+    int validateThreads;  ///< Concurrent validators
+    int queueCapacity;    ///< Capacity of each inter-stage queue
+    int readBatchSize;    ///< Files submitted per BatchFileReader call
+    QThread::Priority threadPriority;  ///< Priority of the stage workers
+    QVector<int> cpus;                 ///< CPUs the stage workers may run on; empty for all
+    QThreadPool *archivePool;          ///< Pool inflating zip members; nullptr for the global pool
+    WorkerPool *stagePool;             ///< Shared pool of at least four threads for the stage workers; nullptr for a private one
+
+    /**
+     * @brief Default constructor
+     * Sizes the parse stage to the machine and keeps a few readers in flight
+     */
+    IngestOptions();
+
+    /**
+     * @brief Build options from the persisted application configuration
+     * @param config Application configuration
+     * @return Options with non-positive config values replaced by defaults
+     *
+     * Readers default to io_threads and parsers to compute_threads when
+     * those are set; the workers take io_priority (low by default) and
+     * worker_cpus.
+     */
+    static IngestOptions fromConfig(const AppConfig &config);
+};
+
+/**
+ * @brief Staged, bounded loader for folders of CSV measurement files
+ *
+ * Splits folder loading into five stages connected by bounded lock-free
+ * queues:
+ *
+ *   enumerate -> read -> parse -> validate -> reduce
+ *
+ * Directory listing, file I/O and parsing overlap, so a slow network share
+ * no longer idles the CPU (and vice versa). Because every queue is bounded,
+ * at most a fixed number of file buffers is in flight regardless of how
+ * many files the folder contains. Cancellation is observed by every stage.
+ */
+class IngestPipeline {
+public:
+    /**
+     * @brief Progress callback
+     * @param processed Number of files that have left the pipeline
+     * @param discovered Number of files found so far
+     * @param discoveryDone True once enumeration has finished
+     *
+     * Always invoked on the thread that called run().
+     */
+    using ProgressCallback = std::function<void(qsizetype processed, qsizetype discovered, bool discoveryDone)>;
+
+    /**
+     * @brief Per-folder progress callback for runMany()
+     * @param rootIndex Index of the folder in the list passed to runMany()
+     * @param processed Number of files of that folder that have left the pipeline
+     * @param discovered Number of files found in that folder so far
+     * @param discoveryDone True once that folder has been fully enumerated
+     *
+     * Always invoked on the thread that called runMany().
+     */
+    using FolderProgressCallback = std::function<void(int rootIndex, qsizetype processed,
+                                                      qsizetype discovered, bool discoveryDone)>;
+
+    /**
+     * @brief Receives the accepted points of one file
+     * @param rootIndex Index of the file's folder in the list passed to streamMany()
+     * @param path Path of the file (or archive member)
+     * @param points Accepted points of the file; may be moved from
+     *
+     * Always invoked on the thread that called streamMany(), in the order
+     * files leave the pipeline.
+     */
+    using FileSink = std::function<void(int rootIndex, const QString &path, QVector<DataPoint> &&points)>;
+
+    /**
+     * @brief Constructor
+     * @param config Application configuration used by the parser
+     * @param options Stage concurrency and queue sizes
+     */
+    explicit IngestPipeline(const AppConfig &config, const IngestOptions &options = IngestOptions());
+
+    /**
+     * @brief Load all CSV files of a folder (and its sub-folders if configured)
+     * @param folderPath Path to the folder containing CSV files
+     * @param cancelFlag Optional flag; all stages stop when it becomes non-zero
+     * @param progress Optional progress callback
+     * @return Valid data points sorted by structure and spacing (partial if cancelled)
+     *
+     * Files are discovered with FileDiscovery using the configured recursion,
+     * include/exclude patterns and folder grouping. Archives found on the way
+     * are expanded in memory by the read stage. Blocks until every stage has finished.
+     */
+    QVector<DataPoint> run(const QString &folderPath, const QAtomicInt *cancelFlag = nullptr,
+                           const ProgressCallback &progress = ProgressCallback());
+
+    /**
+     * @brief Load several folders through one shared set of stage workers
+     * @param folderPaths Folders to load
+     * @param cancelFlag Optional flag; all stages stop when it becomes non-zero
+     * @param progress Optional per-folder progress callback
+     * @return Valid data points of all folders sorted by structure and spacing,
+     *         each tagged with its folder in DataPoint::origin
+     *
+     * Folders are enumerated concurrently (up to one enumerator per reader),
+     * and their files share the read, parse and validate workers, so a batch
+     * of small folders keeps every stage busy.
+     */
+    QVector<DataPoint> runMany(const QStringList &folderPaths, const QAtomicInt *cancelFlag = nullptr,
+                               const FolderProgressCallback &progress = FolderProgressCallback());
+
+    /**
+     * @brief Load several folders and hand each file's points to a sink
+     * @param folderPaths Folders to load
+     * @param sink Receives the accepted points of every file
+     * @param cancelFlag Optional flag; all stages stop when it becomes non-zero
+     * @param progress Optional per-folder progress callback
+     *
+     * Nothing is collected, so memory use is bounded by the queues no matter
+     * how many files the folders hold. Points are tagged as by runMany() but
+     * arrive unsorted.
+     */
+    void streamMany(const QStringList &folderPaths, const FileSink &sink, const QAtomicInt *cancelFlag = nullptr,
+                    const FolderProgressCallback &progress = FolderProgressCallback());
+
+    /**
+     * @brief Load an explicit selection of files, e.g. the result of a FilenameIndex query
+     * @param roots Folders the files belong to; points are tagged with them
+     * @param files Files per entry of roots
+     * @param cancelFlag Optional flag; all stages stop when it becomes non-zero
+     * @param progress Optional per-folder progress callback
+     * @return Valid data points sorted by structure and spacing
+     *
+     * Skips directory enumeration entirely; otherwise identical to runMany().
+     */
+    QVector<DataPoint> runFiles(const QStringList &roots, const QVector<QVector<DiscoveredFile>> &files,
+                                const QAtomicInt *cancelFlag = nullptr,
+                                const FolderProgressCallback &progress = FolderProgressCallback());
+
+    /**
+     * @brief Load an explicit selection of files and hand each file's points to a sink
+     * @param roots Folders the files belong to
+     * @param files Files per entry of roots
+     * @param sink Receives the accepted points of every file
+     * @param cancelFlag Optional flag; all stages stop when it becomes non-zero
+     * @param progress Optional per-folder progress callback
+     */
+    void streamFiles(const QStringList &roots, const QVector<QVector<DiscoveredFile>> &files, const FileSink &sink,
+                     const QAtomicInt *cancelFlag = nullptr,
+                     const FolderProgressCallback &progress = FolderProgressCallback());
+
+private:
+    /**
+     * @brief Lists the files of one root, passing each to the visitor until it returns false
+     */
+    using Enumerator = std::function<void(int rootIndex, const FileDiscovery::Visitor &visitor)>;
+
+    void stream(const QStringList &origins, const Enumerator &enumerate, const FileSink &sink,
+                const QAtomicInt *cancelFlag, const FolderProgressCallback &progress);
+
+    AppConfig m_config;
+    IngestOptions m_options;
+    FilenameTemplates m_templates;   ///< Compiled filename_templates
+};
+
+#endif // TLMANALYZER_INGESTPIPELINE_H
@@ -0,0 +1,144 @@
+#ifndef TLMANALYZER_NUMERICS_H
+#define TLMANALYZER_NUMERICS_H
+
+#include <QThreadPool>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include "workerpools.h"
+
+/**
+ * @brief Reproducible compensated summation
+ *
+ * Sums are formed in fixed blocks of BlockSize terms. Each block runs Lanes
+ * independent Neumaier accumulators (which the compiler can keep in vector
+ * registers), and the block results are combined in a fixed pairwise tree.
+ * The order of every floating-point operation depends only on the number of
+ * terms, so a sum has the same bits whether its blocks are computed on one
+ * thread or on many. Large sums run their blocks on the pool set with
+ * setThreadPool(), the application's compute pool.
+ */
+class Numerics {
+public:
+    static constexpr qsizetype BlockSize = 256;              ///< Terms per block
+    static constexpr int Lanes = 4;                          ///< Independent accumulators per block
+    static constexpr qsizetype ParallelThreshold = 1 << 16;  ///< Terms above which blocks run on the thread pool
+
+    /**
+     * @brief Running sum with its Neumaier compensation term
+     */
+    struct Partial {
+        double sum = 0.0;           ///< Leading part of the sum
+        double compensation = 0.0;  ///< Accumulated rounding error
+
+        /**
+         * @brief Add a value with Neumaier compensation
+         */
+        inline void add(double value)
+        {
+            const double t = sum + value;
+            compensation += std::abs(sum) >= std::abs(value) ? (sum - t) + value : (value - t) + sum;
+            sum = t;
+        }
+
+        /**
+         * @brief Merge another partial sum into this one
+         */
+        inline void merge(const Partial &other)
+        {
+            add(other.sum);
+            compensation += other.compensation;
+        }
+
+        /**
+         * @brief Compensated value of the sum
+         */
+        [[nodiscard]] inline double value() const { return sum + compensation; }
+    };
+
+    /**
+     * @brief Pool running the blocks of large sums
+     * @param pool Pool to use; nullptr for the global pool
+     */
+    static void setThreadPool(QThreadPool *pool);
+
+    /**
+     * @brief Pool running the blocks of large sums; nullptr for the global pool
+     */
+    static QThreadPool *threadPool();
+
+    /**
+     * @brief Reproducible sum of term(0) + ... + term(n - 1)
+     * @param n Number of terms
+     * @param term Callable returning term i; called concurrently for large n
+     * @return Compensated sum, bit-identical for any thread count
+     */
+    template <typename Term>
+    static double sumOf(qsizetype n, const Term &term)
+    {
+        if (n <= BlockSize) {
+            return blockSum(0, n, term).value();
+        }
+
+        const qsizetype blocks = (n + BlockSize - 1) / BlockSize;
+        QVector<Partial> parts(blocks);
+        Partial *first = parts.data();
+        auto computeBlocks = [first, n, &term](qsizetype begin, qsizetype end) {
+            for (qsizetype block = begin; block < end; ++block) {
+                const qsizetype start = block * BlockSize;
+                first[block] = blockSum(start, std::min(start + BlockSize, n), term);
+            }
+        };
+        if (n >= ParallelThreshold) {
+            WorkerPool::parallelFor(threadPool(), blocks, computeBlocks);
+        } else {
+            computeBlocks(0, blocks);
+        }
+        return reduce(parts.constData(), blocks).value();
+    }
+
+    /**
+     * @brief Reproducible sum of a vector
+     */
+    static double sum(const QVector<double> &values);
+
+    /**
+     * @brief Reproducible mean of a vector
+     * @return Mean, or 0 for an empty vector
+     */
+    static double mean(const QVector<double> &values);
+
+private:
+    /**
+     * @brief Private constructor to prevent instantiation
+     * This is a static utility class that should not be instantiated
+     */
+    Numerics() = default;
+
+    template <typename Term>
+    static Partial blockSum(qsizetype begin, qsizetype end, const Term &term)
+    {
+        Partial lanes[Lanes];
+        qsizetype i = begin;
+        for (; i + Lanes <= end; i += Lanes) {
+            for (int lane = 0; lane < Lanes; ++lane) {
+                lanes[lane].add(term(i + lane));
+            }
+        }
+        Partial total = lanes[0];
+        for (int lane = 1; lane < Lanes; ++lane) {
+            total.merge(lanes[lane]);
+        }
+        for (; i < end; ++i) {
+            total.add(term(i));
+        }
+        return total;
+    }
+
+    /**
+     * @brief Combine block results in a fixed pairwise tree
+     */
+    static Partial reduce(const Partial *parts, qsizetype count);
+};
+
+#endif // TLMANALYZER_NUMERICS_H
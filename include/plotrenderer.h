@@ -0,0 +1,150 @@
+#ifndef TLMANALYZER_PLOTRENDERER_H
+#define TLMANALYZER_PLOTRENDERER_H
+
+#include <QAtomicInt>
+#include <QColor>
+#include <QImage>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include "calculator.h"
+#include "datapoint.h"
+
+class QThreadPool;
+
+/**
+ * @brief Headless renderer for resistance-vs-spacing plots
+ *
+ * Draws the same scatter, influential-point rings, fit line, grid and axis
+ * labels as the interactive plotCanvas in MainUI.qml, without a window or a
+ * QML engine. The fit and the influence diagnostics use the structure model
+ * the results were computed with, so a circular TLM plot shows its curved
+ * fit rather than a straight line through the raw resistances. PNG output is painted with QPainter into a QImage, which is
+ * safe on worker threads; SVG output is written directly as text. Many
+ * structures are rendered in parallel on a caller-supplied thread pool.
+ */
+class PlotRenderer {
+public:
+    /**
+     * @brief Output format
+     */
+    enum class Format {
+        Png,  ///< Raster image
+        Svg   ///< Scalable vector graphics
+    };
+
+    /**
+     * @brief Appearance of a plot; defaults match plotCanvas
+     */
+    struct Style {
+        int width = 800;                          ///< Image width in pixels
+        int height = 600;                         ///< Image height in pixels
+        int padding = 50;                         ///< Margin around the plot area
+        bool showLinearFit = true;                ///< Draw the fit line
+        QString xAxisLabel = QStringLiteral("Spacing (μm)");
+        QString yAxisLabel = QStringLiteral("Resistance (Ω)");
+        QColor dataPointColor = QColor(0x19, 0x76, 0xD2);
+        QColor fitLineColor = QColor(0xD3, 0x2F, 0x2F);
+        QColor influentialColor = QColor(0xF5, 0x7C, 0x00);
+        QColor gridColor = QColor(0xe0, 0xe0, 0xe0);
+        QColor textColor = QColor(Qt::black);
+    };
+
+    /**
+     * @brief Geometry of one plot in data coordinates
+     */
+    struct ChartData {
+        struct Point {
+            double x = 0.0;
+            double y = 0.0;
+            bool influential = false;
+        };
+        QVector<Point> scatter;       ///< Enabled points
+        bool hasFit = false;          ///< True if a fit line is available
+        QVector<Point> fitLine;       ///< Fit line as a polyline in data coordinates
+        double xMin = 0.0, xMax = 1.0; ///< X axis range
+        double yMin = 0.0, yMax = 1.0; ///< Y axis range
+        QString title;                ///< Optional title drawn above the plot
+    };
+
+    /**
+     * @brief Progress callback for renderStructures()
+     * @param rendered Plots finished so far
+     * @param total Plots to render
+     */
+    using ProgressCallback = std::function<void(int rendered, int total)>;
+
+    /**
+     * @brief Build plot geometry from the points of one structure
+     * @param points Points of one structure; disabled points are not drawn
+     * @param model Structure model of the fit and the diagnostics
+     * @param geometry Structure geometry
+     * @param title Title drawn above the plot (may be empty)
+     * @return Scatter, fit line and axis ranges with 10% padding, as in calculateChartData()
+     */
+    static ChartData chartData(const QVector<DataPoint> &points, Calculator::FitModel model,
+                               const Calculator::FitGeometry &geometry, const QString &title = QString());
+
+    /**
+     * @brief Paint a plot into an image
+     */
+    static QImage renderImage(const ChartData &data, const Style &style = Style());
+
+    /**
+     * @brief Write a plot as an SVG document
+     */
+    static QByteArray renderSvg(const ChartData &data, const Style &style = Style());
+
+    /**
+     * @brief Render a plot to a file
+     * @param data Plot geometry
+     * @param path Output file
+     * @param format Output format
+     * @param style Appearance
+     * @param error Receives a description of the failure, if any
+     * @return True if the file was written
+     */
+    static bool renderToFile(const ChartData &data, const QString &path, Format format,
+                             const Style &style = Style(), QString *error = nullptr);
+
+    /**
+     * @brief Render one plot per structure in parallel
+     * @param points Points sorted by structure
+     * @param model Structure model of the fits
+     * @param geometry Structure geometry
+     * @param directory Output directory, created if needed
+     * @param prefix File name prefix; each file is "<prefix><structure>.<ext>"
+     * @param format Output format
+     * @param style Appearance
+     * @param cancelFlag Optional flag; remaining plots are skipped when it becomes non-zero
+     * @param progress Optional progress callback, invoked from worker threads
+     * @param pool Pool rendering the plots; nullptr for the global pool
+     * @return Number of plots written
+     */
+    static int renderStructures(const QVector<DataPoint> &points, Calculator::FitModel model,
+                                const Calculator::FitGeometry &geometry, const QString &directory, const QString &prefix,
+                                Format format, const Style &style = Style(), const QAtomicInt *cancelFlag = nullptr,
+                                const ProgressCallback &progress = ProgressCallback(), QThreadPool *pool = nullptr);
+
+    /**
+     * @brief File extension of a format, including the dot
+     */
+    static QString suffix(Format format);
+
+    /**
+     * @brief Parse a format name ("png" or "svg")
+     * @param name Format name, case-insensitive
+     * @param format Receives the format
+     * @return False if the name is unknown
+     */
+    static bool formatFromName(const QString &name, Format &format);
+
+private:
+    /**
+     * @brief Private constructor to prevent instantiation
+     * This is a static utility class that should not be instantiated
+     */
+    PlotRenderer() = default;
+};
+
+#endif // TLMANALYZER_PLOTRENDERER_H
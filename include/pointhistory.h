@@ -0,0 +1,259 @@
+#ifndef TLMANALYZER_POINTHISTORY_H
+#define TLMANALYZER_POINTHISTORY_H
+
+#include <QMap>
+#include <QString>
+#include <QVector>
+#include <algorithm>
+#include <memory>
+#include "calculator.h"
+#include "datapoint.h"
+
+/**
+ * @brief A change of one position in a sequence of points
+ *
+ * Edits are applied in order, each to the sequence left by the previous one.
+ */
+struct PointEdit {
+    enum Kind { Changed, Inserted, Removed };
+    Kind kind = Changed;
+    qsizetype row = -1;  ///< Row at the time of the edit
+    DataPoint point;     ///< The point after the edit; the removed point for Removed
+};
+
+/**
+ * @brief Immutable sequence of data points with structural sharing
+ *
+ * A treap ordered by position: every node holds one point, the size of its
+ * subtree and a pseudo-random priority that keeps the tree balanced in
+ * expectation. Nodes are never modified after construction, so set(),
+ * insert() and remove() copy only the O(log n) nodes on the path to the
+ * edited position and share every other node with the original. Keeping
+ * many versions therefore costs one copy of the points plus O(log n) per
+ * edited point, not one full copy per version.
+ *
+ * Versions may be read from any thread; nodes are released when the last
+ * version referring to them is destroyed.
+ */
+class PersistentPoints {
+public:
+    /**
+     * @brief Empty sequence
+     */
+    PersistentPoints() = default;
+
+    /**
+     * @brief Build a sequence from a vector in O(n)
+     */
+    static PersistentPoints fromVector(const QVector<DataPoint> &points);
+
+    /**
+     * @brief Number of points
+     */
+    [[nodiscard]] qsizetype size() const;
+
+    /**
+     * @brief True if there are no points
+     */
+    [[nodiscard]] bool isEmpty() const { return !m_root; }
+
+    /**
+     * @brief Point at a position, O(log n)
+     */
+    [[nodiscard]] const DataPoint &at(qsizetype index) const;
+
+    /**
+     * @brief Copy with the point at a position replaced
+     */
+    [[nodiscard]] PersistentPoints set(qsizetype index, const DataPoint &point) const;
+
+    /**
+     * @brief Copy with a point inserted before a position (size() appends)
+     */
+    [[nodiscard]] PersistentPoints insert(qsizetype index, const DataPoint &point) const;
+
+    /**
+     * @brief Copy without the point at a position
+     */
+    [[nodiscard]] PersistentPoints remove(qsizetype index) const;
+
+    /**
+     * @brief All points in order, O(n)
+     */
+    [[nodiscard]] QVector<DataPoint> toVector() const;
+
+    /**
+     * @brief Copy that equals a vector, sharing every unchanged point
+     * @param points Target contents
+     * @param maxEdits Give up and rebuild with fromVector() after this many edits; -1 for no limit
+     * @param edits Receives the edits applied, in order; empty if the contents already match or were rebuilt
+     *
+     * Points are matched by DataPoint::handle in a single merge-like pass,
+     * so toggling, removing or inserting k points costs O(n) time and
+     * O(k log n) new nodes. Points without a handle or moved by a re-sort
+     * are simply removed and inserted again; the result always equals
+     * `points`. The result shares its root with this version if nothing
+     * changed.
+     */
+    [[nodiscard]] PersistentPoints updated(const QVector<DataPoint> &points, qsizetype maxEdits = -1,
+                                           QVector<PointEdit> *edits = nullptr) const;
+
+    /**
+     * @brief Copy with a list of edits applied, O(k log n)
+     * @param edits Edits in order; every row must be valid when its edit is reached
+     * @param inverse Receives the edits that turn the result back into this version, in order
+     *
+     * A Changed edit that leaves its point as it was is skipped.
+     */
+    [[nodiscard]] PersistentPoints applied(const QVector<PointEdit> &edits,
+                                           QVector<PointEdit> *inverse = nullptr) const;
+
+    /**
+     * @brief True if two versions share their root, i.e. are the same version
+     */
+    [[nodiscard]] bool sharesRootWith(const PersistentPoints &other) const { return m_root == other.m_root; }
+
+    /**
+     * @brief Field-wise equality of two points, including the handle
+     */
+    static bool samePoint(const DataPoint &a, const DataPoint &b);
+
+private:
+    struct Node;
+    struct Ops;   ///< Tree algorithms, defined with Node in the source file
+    using NodePtr = std::shared_ptr<const Node>;
+
+    explicit PersistentPoints(NodePtr root) : m_root(std::move(root)) {}
+
+    NodePtr m_root;
+};
+
+/**
+ * @brief Bounded undo/redo history of the point collection
+ *
+ * Each entry is a PersistentPoints version, so consecutive entries share
+ * all points that did not change between them, and keeps the edits that
+ * led to it, so stepping between entries reports the rows that change
+ * without comparing whole versions. An entry can also carry the fit that
+ * was computed for it, which is restored together with the points instead
+ * of being recomputed.
+ */
+class PointHistory {
+public:
+    /**
+     * @brief Fit computed for one history entry
+     */
+    struct Fit {
+        Calculator::FitModel model = Calculator::FitModel::LinearTLM;  ///< Model of the fit
+        Calculator::FitGeometry geometry;                              ///< Geometry of the fit
+        Calculator::TLMResult result;                                  ///< Fit over all points
+        QMap<QString, Calculator::TLMResult> structureResults;         ///< Fits per structure
+        QString message;                                               ///< Formatted result message
+    };
+
+    /**
+     * @brief Constructor
+     * @param limit Number of undo steps kept; 0 disables the history
+     */
+    explicit PointHistory(int limit = 200);
+
+    /**
+     * @brief Change the number of undo steps kept; the oldest are dropped
+     */
+    void setLimit(int limit);
+
+    /**
+     * @brief Number of undo steps kept
+     */
+    [[nodiscard]] int limit() const { return m_limit; }
+
+    /**
+     * @brief Record the current collection as a new entry
+     * @param points Current collection
+     * @param edits Edits that turned the current entry into `points`, if known
+     * @return Version of the current entry; 0 if the history is disabled
+     *
+     * Known edits are applied as they are instead of matching `points`
+     * against the whole current entry. Nothing is recorded if the collection
+     * equals the current entry. Redo entries are dropped.
+     */
+    quint64 record(const QVector<DataPoint> &points, const QVector<PointEdit> &edits = {});
+
+    /**
+     * @brief Drop every entry
+     */
+    void clear();
+
+    /**
+     * @brief True if there is an entry before the current one
+     */
+    [[nodiscard]] bool canUndo() const { return m_current > 0; }
+
+    /**
+     * @brief True if there is an entry after the current one
+     */
+    [[nodiscard]] bool canRedo() const { return m_current >= 0 && m_current + 1 < m_entries.size(); }
+
+    /**
+     * @brief Step back one entry
+     * @param edits Receives the edits from the entry that was current to the new one; empty if unknown
+     * @return False if there is no earlier entry
+     */
+    bool undo(QVector<PointEdit> *edits = nullptr);
+
+    /**
+     * @brief Step forward one entry
+     * @param edits Receives the edits from the entry that was current to the new one; empty if unknown
+     * @return False if there is no later entry
+     */
+    bool redo(QVector<PointEdit> *edits = nullptr);
+
+    /**
+     * @brief Points of the current entry
+     */
+    [[nodiscard]] PersistentPoints currentPoints() const;
+
+    /**
+     * @brief Version of the current entry; 0 if there is none
+     */
+    [[nodiscard]] quint64 currentVersion() const;
+
+    /**
+     * @brief Number of entries before the current one
+     */
+    [[nodiscard]] int undoCount() const { return static_cast<int>(std::max<qsizetype>(0, m_current)); }
+
+    /**
+     * @brief Number of entries after the current one
+     */
+    [[nodiscard]] int redoCount() const { return m_current < 0 ? 0 : static_cast<int>(m_entries.size() - m_current - 1); }
+
+    /**
+     * @brief Attach a fit to an entry
+     * @param version Version the fit was computed from; ignored if it is no longer in the history
+     * @param fit The fit
+     */
+    void cacheFit(quint64 version, const Fit &fit);
+
+    /**
+     * @brief Fit attached to the current entry, or nullptr
+     */
+    [[nodiscard]] const Fit *currentFit() const;
+
+private:
+    struct Entry {
+        quint64 version = 0;
+        PersistentPoints points;
+        QVector<PointEdit> edits;   ///< Edits from the previous entry; empty if this one was rebuilt
+        std::shared_ptr<const Fit> fit;
+    };
+
+    void trim();
+
+    QVector<Entry> m_entries;
+    qsizetype m_current = -1;     ///< Position of the current entry, -1 when empty
+    int m_limit;
+    quint64 m_nextVersion = 1;
+};
+
+#endif // TLMANALYZER_POINTHISTORY_H
@@ -0,0 +1,39 @@
+#ifndef TLMANALYZER_QMLTYPES_H
+#define TLMANALYZER_QMLTYPES_H
+
+#include <QJSEngine>
+#include <QQmlEngine>
+#include <QtQml/qqmlregistration.h>
+#include "datamanager.h"
+
+/**
+ * @brief Declares DataManager as a singleton of the TLMAnalyzer QML module
+ *
+ * The declaration is seen by the QML type compiler at build time, so the
+ * type of every DataManager property and method is known when MainUI.qml
+ * is compiled and bindings using them are compiled to C++ instead of being
+ * interpreted at startup. main() sets the instance before loading the UI.
+ */
+struct DataManagerForeign {
+    Q_GADGET
+    QML_FOREIGN(DataManager)
+    QML_NAMED_ELEMENT(DataManager)
+    QML_SINGLETON
+
+public:
+    inline static DataManager *s_instance = nullptr; ///< Instance handed to QML
+
+    /**
+     * @brief Singleton factory called by the QML engine
+     * @return The instance set by main(), owned by C++
+     */
+    static DataManager *create(QQmlEngine *, QJSEngine *engine)
+    {
+        Q_ASSERT(s_instance);
+        Q_ASSERT(engine->thread() == s_instance->thread());
+        QJSEngine::setObjectOwnership(s_instance, QJSEngine::CppOwnership);
+        return s_instance;
+    }
+};
+
+#endif // TLMANALYZER_QMLTYPES_H
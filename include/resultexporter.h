@@ -0,0 +1,114 @@
+#ifndef TLMANALYZER_RESULTEXPORTER_H
+#define TLMANALYZER_RESULTEXPORTER_H
+
+#include <QAtomicInt>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include "calculator.h"
+#include "datapoint.h"
+
+/**
+ * @brief Streams per-point data and per-structure results to disk
+ *
+ * Rows are formatted in chunks on the calling thread (numbers with
+ * std::to_chars, no locale or QString round trip) and handed through a
+ * bounded queue to a dedicated writer thread, so formatting and disk I/O
+ * overlap and memory use stays at a few chunks however many rows are
+ * exported. Call it from a worker thread to keep the UI responsive.
+ *
+ * Two formats are written:
+ * - CSV: `<base>_points.csv` and `<base>_results.csv` with a header row
+ * - Columnar: `<base>_points.tlmc` and `<base>_results.tlmc`, little-endian:
+ *   magic "TLMCOL1\0", uint32 column count, uint64 row count, then for each
+ *   column a uint16 name length, the UTF-8 name, a uint8 type (0 = float64,
+ *   1 = uint8, 2 = string) and all of its values; strings are a uint32
+ *   byte length followed by UTF-8 bytes
+ */
+class ResultExporter {
+public:
+    /**
+     * @brief Output format
+     */
+    enum class Format {
+        Csv,      ///< Comma-separated text with a header row
+        Columnar  ///< Column-major binary (.tlmc)
+    };
+
+    /**
+     * @brief One fitted structure
+     */
+    struct ResultRow {
+        QString structure;              ///< Structure name ("" for a single structure)
+        QString model;                  ///< Fit model name
+        Calculator::TLMResult result;   ///< Fit and extracted parameters
+    };
+
+    /**
+     * @brief Export settings
+     */
+    struct Options {
+        Format format = Format::Csv;   ///< Output format
+        qsizetype chunkRows = 16384;   ///< Rows formatted per chunk
+        int queueCapacity = 8;         ///< Chunks buffered between formatter and writer
+    };
+
+    /**
+     * @brief Progress callback
+     * @param rowsWritten Rows formatted and queued so far
+     * @param totalRows Rows to export in total
+     */
+    using ProgressCallback = std::function<void(qsizetype rowsWritten, qsizetype totalRows)>;
+
+    /**
+     * @brief Export points and results next to each other
+     * @param points Points to export, in collection order
+     * @param results Fitted structures
+     * @param basePath Output path without suffix; "_points"/"_results" and the extension are appended
+     * @param options Export settings
+     * @param error Receives a description of the failure, if any
+     * @param cancelFlag Optional flag; the export stops when it becomes non-zero
+     * @param progress Optional progress callback, invoked on the calling thread
+     * @return True if both files were written completely
+     */
+    static bool exportAll(const QVector<DataPoint> &points, const QVector<ResultRow> &results,
+                          const QString &basePath, const Options &options, QString *error = nullptr,
+                          const QAtomicInt *cancelFlag = nullptr, const ProgressCallback &progress = ProgressCallback());
+
+    /**
+     * @brief Export points to one file
+     * @return True if the file was written completely
+     */
+    static bool writePoints(const QVector<DataPoint> &points, const QString &path, const Options &options,
+                            QString *error = nullptr, const QAtomicInt *cancelFlag = nullptr,
+                            const ProgressCallback &progress = ProgressCallback());
+
+    /**
+     * @brief Export fitted structures to one file
+     * @return True if the file was written completely
+     */
+    static bool writeResults(const QVector<ResultRow> &results, const QString &path, const Options &options,
+                             QString *error = nullptr, const QAtomicInt *cancelFlag = nullptr);
+
+    /**
+     * @brief File extension of a format, including the dot
+     */
+    static QString suffix(Format format);
+
+    /**
+     * @brief Parse a format name ("csv" or "columnar")
+     * @param name Format name, case-insensitive
+     * @param format Receives the format
+     * @return False if the name is unknown
+     */
+    static bool formatFromName(const QString &name, Format &format);
+
+private:
+    /**
+     * @brief Private constructor to prevent instantiation
+     * This is a static utility class that should not be instantiated
+     */
+    ResultExporter() = default;
+};
+
+#endif // TLMANALYZER_RESULTEXPORTER_H
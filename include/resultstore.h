@@ -0,0 +1,168 @@
+#ifndef TLMANALYZER_RESULTSTORE_H
+#define TLMANALYZER_RESULTSTORE_H
+
+#include <QDateTime>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+#include "appconfig.h"
+#include "calculator.h"
+#include "datapoint.h"
+
+/**
+ * @brief Embedded SQLite database of per-structure analysis results
+ *
+ * Every fitted structure becomes one row carrying its TLMResult and its
+ * provenance: lot, wafer and die, the folder and structure it came from,
+ * the fit model, the number of points and the time it was recorded. A
+ * structure keeps one row per model: analysing it again replaces the row. The
+ * table is indexed by (lot, wafer, die, recorded_at), by recorded_at and
+ * by structure, so history and trend queries over tens of thousands of
+ * structures are answered from the indexes without reading any CSV file.
+ *
+ * Queries use the FilenameIndex syntax, e.g. `lot=L42|L43 and rsh>150`.
+ * Available fields are lot, wafer, die, structure, model, folder, points,
+ * date (yyyy-MM-dd, local time) and the result columns rsh, rc, rho_c, lt,
+ * re, r2, slope, intercept and width.
+ *
+ * Each instance owns its own database connection, which Qt binds to the
+ * creating thread; use an instance from that thread only.
+ */
+class ResultStore {
+public:
+    /**
+     * @brief One stored structure
+     */
+    struct Record {
+        qint64 id = 0;                  ///< Row id, assigned by insert()
+        QDateTime recordedAt;           ///< When the analysis ran
+        QString lot;                    ///< Lot, from the structure's path
+        QString wafer;                  ///< Wafer, from the structure's path
+        QString die;                    ///< Die, from the structure's path
+        QString structure;              ///< Structure name ("" for a single structure)
+        QString folder;                 ///< Folder the points were loaded from
+        QString model;                  ///< Fit model name
+        int points = 0;                 ///< Enabled points in the fit
+        double resVoltage = 0.0;        ///< Voltage at which resistances were read (V)
+        Calculator::TLMResult result;   ///< Fit and extracted parameters
+    };
+
+    /**
+     * @brief Aggregate of one group of a trend query
+     */
+    struct TrendRow {
+        QString key;           ///< Value of the grouping field
+        qint64 count = 0;      ///< Structures in the group
+        double mean = 0.0;     ///< Mean of the quantity
+        double minimum = 0.0;  ///< Smallest value of the quantity
+        double maximum = 0.0;  ///< Largest value of the quantity
+    };
+
+    /**
+     * @brief Constructor; nothing is opened yet
+     * @param path Database file; created on open() if it does not exist
+     */
+    explicit ResultStore(const QString &path);
+
+    /**
+     * @brief Destructor; closes the connection
+     */
+    ~ResultStore();
+
+    ResultStore(const ResultStore &) = delete;
+    ResultStore &operator=(const ResultStore &) = delete;
+
+    /**
+     * @brief Open the database and create the schema if needed
+     * @param error Receives a description of the problem, if any
+     * @return False if the file cannot be opened or is not a results store
+     */
+    bool open(QString *error = nullptr);
+
+    /**
+     * @brief Whether open() succeeded
+     */
+    [[nodiscard]] bool isOpen() const { return m_open; }
+
+    /**
+     * @brief Database file
+     */
+    [[nodiscard]] const QString &path() const { return m_path; }
+
+    /**
+     * @brief Store records in one transaction, replacing older results of the same structures
+     * @param records Records to store; their ids are filled in
+     * @param error Receives a description of the problem, if any
+     * @return False if nothing was stored
+     */
+    bool insert(QVector<Record> &records, QString *error = nullptr);
+
+    /**
+     * @brief Records matching a query, newest first
+     * @param query Conditions; empty selects every record
+     * @param limit Maximum number of records, 0 for no limit
+     * @param error Receives a description of the problem, if any
+     */
+    QVector<Record> query(const QString &query, int limit = 0, QString *error = nullptr) const;
+
+    /**
+     * @brief Per-group statistics of one quantity
+     * @param query Conditions selecting the records
+     * @param groupBy lot, wafer, die, structure, model, folder, day or month
+     * @param quantity Result column, e.g. rsh
+     * @param error Receives a description of the problem, if any
+     * @return One row per group in ascending key order
+     */
+    QVector<TrendRow> trend(const QString &query, const QString &groupBy, const QString &quantity,
+                            QString *error = nullptr) const;
+
+    /**
+     * @brief Number of stored records
+     */
+    [[nodiscard]] qint64 count() const;
+
+    /**
+     * @brief Database file configured for an application configuration
+     * @return results_db, resolved against the folder of the configuration file
+     */
+    static QString pathFor(const AppConfig &config);
+
+    /**
+     * @brief Records for the structures of a fitted point set
+     * @param points Points sorted by structure
+     * @param results Fit per structure
+     * @param model Fit model name
+     * @param resVoltage Voltage at which resistances were read (V)
+     * @param pathLevels Names of the innermost folders of a structure path (see provenance())
+     * @param recordedAt Time stamp of every record
+     */
+    static QVector<Record> recordsFor(const QVector<DataPoint> &points,
+                                      const QMap<QString, Calculator::TLMResult> &results,
+                                      const QString &model, double resVoltage, const QStringList &pathLevels,
+                                      const QDateTime &recordedAt);
+
+    /**
+     * @brief Fill lot, wafer and die from the path of a structure
+     * @param record Record whose folder and structure are set
+     * @param source Instrument source of the structure's points; a trailing
+     *        source component added for multi-buffer files is ignored
+     * @param pathLevels Names for the innermost folders, outermost first,
+     *        e.g. {"lot", "wafer", "die"} for `.../L42/W03/D07`; names other
+     *        than lot, wafer and die skip their level
+     */
+    static void provenance(Record &record, const QString &source, const QStringList &pathLevels);
+
+private:
+    /**
+     * @brief Translate a query into a WHERE clause with positional parameters
+     */
+    static bool whereClause(const QString &query, QString &clause, QVariantList &values, QString *error);
+
+    QString m_path;
+    QString m_connection;   ///< Name of this instance's QSqlDatabase connection
+    bool m_open = false;
+};
+
+#endif // TLMANALYZER_RESULTSTORE_H
@@ -0,0 +1,124 @@
+#ifndef TLMANALYZER_SPACINGINDEX_H
+#define TLMANALYZER_SPACINGINDEX_H
+
+#include <QString>
+#include <QVector>
+#include <map>
+#include "datapoint.h"
+
+/**
+ * @brief Ordered index of data points grouped by structure and spacing
+ *
+ * TLM structures are usually measured with several devices (replicates) per
+ * pad spacing. SpacingIndex keeps one group per (structure, spacing) key in
+ * an ordered map and maintains each group's aggregates incrementally:
+ * point count, enabled count, and mean and variance of the enabled
+ * resistances (Welford's online update, reversed on removal). Insert,
+ * remove and enable/disable are O(log g) for g groups, so aggregates never
+ * require a re-scan of the collection.
+ *
+ * The index only stores aggregates; the points themselves stay in the
+ * DataManager collection, which is kept in the same (structure, spacing)
+ * order.
+ */
+class SpacingIndex {
+public:
+    /**
+     * @brief Group key: structure first, then spacing
+     */
+    struct Key {
+        QString structure;
+        double spacing = 0.0;
+
+        bool operator<(const Key &other) const
+        {
+            if (structure != other.structure) {
+                return structure < other.structure;
+            }
+            return spacing < other.spacing;
+        }
+    };
+
+    /**
+     * @brief Aggregates of the points measured at one spacing
+     */
+    struct Group {
+        int count = 0;          ///< Points in the group
+        int enabledCount = 0;   ///< Enabled points in the group
+        double mean = 0.0;      ///< Mean resistance of the enabled points (Ω)
+        double m2 = 0.0;        ///< Sum of squared deviations of the enabled resistances
+
+        /**
+         * @brief Sample variance of the enabled resistances (Ω²), 0 below two points
+         */
+        [[nodiscard]] double variance() const { return enabledCount > 1 ? m2 / (enabledCount - 1) : 0.0; }
+    };
+
+    using GroupMap = std::map<Key, Group>;
+
+    /**
+     * @brief Order of points in the collection: structure, then spacing
+     */
+    static bool lessThan(const DataPoint &a, const DataPoint &b);
+
+    /**
+     * @brief Remove all groups
+     */
+    void clear();
+
+    /**
+     * @brief Rebuild all groups from a collection
+     * @param points Points to index
+     */
+    void rebuild(const QVector<DataPoint> &points);
+
+    /**
+     * @brief Add a point to its group
+     */
+    void insert(const DataPoint &point);
+
+    /**
+     * @brief Remove a point from its group; empty groups are dropped
+     */
+    void remove(const DataPoint &point);
+
+    /**
+     * @brief Update the aggregates for a point whose enabled state changes
+     * @param point The point with its old state
+     * @param enabled The new enabled state
+     */
+    void setEnabled(const DataPoint &point, bool enabled);
+
+    /**
+     * @brief Look up the group of a structure and spacing
+     * @return The group, or nullptr if no point has that key
+     */
+    [[nodiscard]] const Group *group(const QString &structure, double spacing) const;
+
+    /**
+     * @brief All groups in key order
+     */
+    [[nodiscard]] const GroupMap &groups() const { return m_groups; }
+
+    /**
+     * @brief One point per group holding the mean enabled resistance
+     * @return Points in key order; groups without enabled points are disabled
+     *
+     * Suitable for fitting group means instead of individual devices.
+     */
+    [[nodiscard]] QVector<DataPoint> groupMeanPoints() const;
+
+    /**
+     * @brief Hand out a new stable point handle
+     */
+    quint64 nextHandle() { return ++m_lastHandle; }
+
+private:
+    static void addValue(Group &group, double value);
+    static void removeValue(Group &group, double value);
+
+    GroupMap m_groups;
+    quint64 m_lastHandle = 0;
+};
+
+#endif // TLMANALYZER_SPACINGINDEX_H
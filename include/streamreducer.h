@@ -0,0 +1,206 @@
+#ifndef TLMANALYZER_STREAMREDUCER_H
+#define TLMANALYZER_STREAMREDUCER_H
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <map>
+#include "calculator.h"
+#include "datapoint.h"
+
+/**
+ * @brief Bounded-memory summary of an arbitrarily large stream of points
+ *
+ * Every point is folded into the sufficient statistics of its structure and
+ * then forgotten: per fit model the count, means, and centred second
+ * moments of the model's (x, y) coordinates (Welford's update), per spacing
+ * the replicate count, mean, spread and range, and a log-binned resistance
+ * histogram. Memory is O(structures × spacings), independent of how many
+ * files were read, and the per-structure fits equal the fits of the full
+ * point set up to rounding.
+ *
+ * The circular model's coordinates depend on the inner contact radius, so
+ * the geometry is fixed when the reducer is created. Not thread-safe; give
+ * each worker its own reducer and merge() them.
+ */
+class StreamReducer {
+public:
+    /**
+     * @brief Running regression statistics of (x, y) pairs
+     */
+    struct Moments {
+        qint64 count = 0;   ///< Pairs added
+        double meanX = 0.0; ///< Mean of x
+        double meanY = 0.0; ///< Mean of y
+        double m2X = 0.0;   ///< Σ(x - x̄)²
+        double m2Y = 0.0;   ///< Σ(y - ȳ)²
+        double cXY = 0.0;   ///< Σ(x - x̄)(y - ȳ)
+
+        /**
+         * @brief Add one pair
+         */
+        void add(double x, double y);
+
+        /**
+         * @brief Combine with the statistics of a disjoint set of pairs
+         */
+        void merge(const Moments &other);
+
+        /**
+         * @brief Least-squares line through the pairs
+         * @return False below two pairs or when all x are equal
+         */
+        bool line(double &slope, double &intercept, double &rSquared) const;
+    };
+
+    /**
+     * @brief Replicate statistics of one spacing
+     */
+    struct SpacingStats {
+        qint64 count = 0;       ///< Points measured at this spacing
+        double mean = 0.0;      ///< Mean resistance (Ω)
+        double m2 = 0.0;        ///< Sum of squared deviations of the resistances
+        double minimum = 0.0;   ///< Smallest resistance (Ω)
+        double maximum = 0.0;   ///< Largest resistance (Ω)
+
+        /**
+         * @brief Sample variance of the resistances (Ω²), 0 below two points
+         */
+        [[nodiscard]] double variance() const { return count > 1 ? m2 / static_cast<double>(count - 1) : 0.0; }
+    };
+
+    /**
+     * @brief Resistance histogram with logarithmic bins
+     *
+     * BinsPerDecade bins per decade from 10^MinExponent to 10^MaxExponent Ω,
+     * plus an underflow and an overflow count.
+     */
+    struct Histogram {
+        static constexpr int BinsPerDecade = 10;
+        static constexpr int MinExponent = -3;
+        static constexpr int MaxExponent = 9;
+        static constexpr int BinCount = (MaxExponent - MinExponent) * BinsPerDecade;
+
+        QVector<qint64> bins = QVector<qint64>(BinCount, 0); ///< Counts per bin, ascending
+        qint64 underflow = 0;   ///< Values below the first bin
+        qint64 overflow = 0;    ///< Values at or above the end of the last bin
+
+        /**
+         * @brief Count one value
+         */
+        void add(double value);
+
+        /**
+         * @brief Add the counts of another histogram
+         */
+        void merge(const Histogram &other);
+
+        /**
+         * @brief Lower edge of a bin (Ω)
+         */
+        static double lowerEdge(int bin);
+
+        /**
+         * @brief Approximate quantile, interpolated geometrically within its bin
+         * @param q Quantile in [0, 1]
+         * @return Resistance (Ω), or 0 for an empty histogram
+         */
+        [[nodiscard]] double quantile(double q) const;
+
+        /**
+         * @brief Values counted, including under- and overflow
+         */
+        [[nodiscard]] qint64 total() const;
+    };
+
+    /**
+     * @brief Everything kept about one structure
+     */
+    struct StructureStats {
+        qint64 points = 0;                      ///< Points folded in
+        Moments spacingResistance;              ///< (d, R): linear and end-resistance models
+        Moments spacingCorrected;               ///< (d, R/c(d)): circular model
+        std::map<double, SpacingStats> spacings; ///< Replicates per spacing, ascending
+        Histogram resistance;                   ///< Distribution of R over all spacings
+    };
+
+    /**
+     * @brief Constructor
+     * @param geometry Structure geometry; the circular model uses its inner radius
+     */
+    explicit StreamReducer(const Calculator::FitGeometry &geometry = Calculator::FitGeometry());
+
+    /**
+     * @brief Fold one point into its structure; disabled points are ignored
+     */
+    void add(const DataPoint &point);
+
+    /**
+     * @brief Fold a batch of points, e.g. all points of one file
+     */
+    void add(const QVector<DataPoint> &points);
+
+    /**
+     * @brief Combine with a reducer that saw a disjoint set of points
+     * @param other Reducer with the same geometry
+     */
+    void merge(const StreamReducer &other);
+
+    /**
+     * @brief Forget everything
+     */
+    void clear();
+
+    /**
+     * @brief Fit one structure
+     * @param structure Structure name
+     * @param model Structure model
+     * @param result Receives the fit and the extracted parameters
+     * @return False if the structure is unknown or cannot be fitted
+     */
+    bool fit(const QString &structure, Calculator::FitModel model, Calculator::TLMResult &result) const;
+
+    /**
+     * @brief Fit every structure
+     * @param model Structure model
+     * @param results Map receiving one result per structure that could be fitted
+     * @return True if at least one structure could be fitted
+     */
+    bool fitAll(Calculator::FitModel model, QMap<QString, Calculator::TLMResult> &results) const;
+
+    /**
+     * @brief One point per (structure, spacing) carrying the mean resistance
+     * @return Points sorted by structure and spacing; `current` holds the replicate count
+     *
+     * Small enough to plot or hand to code that expects points.
+     */
+    [[nodiscard]] QVector<DataPoint> spacingMeans() const;
+
+    /**
+     * @brief Statistics of one structure, or nullptr if it was never seen
+     */
+    [[nodiscard]] const StructureStats *structure(const QString &name) const;
+
+    /**
+     * @brief Names of all structures seen, sorted
+     */
+    [[nodiscard]] QStringList structures() const;
+
+    /**
+     * @brief Points folded in over all structures
+     */
+    [[nodiscard]] qint64 pointCount() const { return m_pointCount; }
+
+    /**
+     * @brief Geometry the reducer was created with
+     */
+    [[nodiscard]] const Calculator::FitGeometry &geometry() const { return m_geometry; }
+
+private:
+    Calculator::FitGeometry m_geometry;
+    std::map<QString, StructureStats> m_structures;
+    qint64 m_pointCount = 0;
+};
+
+#endif // TLMANALYZER_STREAMREDUCER_H
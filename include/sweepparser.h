@@ -0,0 +1,103 @@
+#ifndef TLMANALYZER_SWEEPPARSER_H
+#define TLMANALYZER_SWEEPPARSER_H
+
+#include <QByteArrayView>
+#include <QString>
+#include <QVector>
+#include "datapoint.h"
+
+/**
+ * @brief Line-by-line parser for Keithley sweep exports
+ *
+ * The `[ DATA ]` section of a Keithley export holds one column group per
+ * instrument buffer (e.g. `Bias_SMU` and `Sweep_SMU`), each with timestamp,
+ * source value and reading columns. Step/sweep configurations repeat the
+ * table once per step, either under a new `Name,...` header or by
+ * restarting the row index.
+ *
+ * SweepParser tracks every buffer of every step block at once and emits one
+ * DataPoint per block and buffer as soon as both the reading at the
+ * resistance voltage and the reading at zero volts have been seen. Each
+ * point's `source` names the buffer and, from the second block on, the step
+ * (e.g. "Sweep_SMU step 3").
+ *
+ * Files without a `[ DATA ]` section are handled as before: voltage in
+ * column 6, current in column 7, one point reported by finish().
+ */
+class SweepParser {
+public:
+    /**
+     * @brief Constructor
+     * @param resistanceVoltage Voltage at which the resistance is evaluated (V)
+     */
+    explicit SweepParser(double resistanceVoltage);
+
+    /**
+     * @brief Feed one line of the file
+     * @param line Line contents without the line terminator ('\r' is tolerated)
+     */
+    void feedLine(QByteArrayView line);
+
+    /**
+     * @brief Take the points completed since the last call
+     * @return Points in completion order
+     */
+    QVector<DataPoint> takePoints();
+
+    /**
+     * @brief Signal end of input
+     * @return Remaining points, including the legacy column 6/7 point for
+     *         files without a `[ DATA ]` section
+     */
+    QVector<DataPoint> finish();
+
+    /**
+     * @brief True once a `[ DATA ]` section has been entered
+     */
+    [[nodiscard]] bool hasDataSection() const { return m_inData || m_seenData; }
+
+    /**
+     * @brief Number of points emitted so far
+     */
+    [[nodiscard]] int emittedCount() const { return m_emittedCount; }
+
+    /**
+     * @brief Number of buffers in the current step block
+     */
+    [[nodiscard]] int bufferCount() const { return static_cast<int>(m_buffers.size()); }
+
+    /**
+     * @brief Index of the current step block (0 for the first)
+     */
+    [[nodiscard]] int block() const { return m_block; }
+
+private:
+    struct Buffer {
+        QString name;             ///< Instrument buffer name from the `Name` row
+        int firstColumn = 0;      ///< First column of the buffer's column group
+        int sourceColumn = -1;    ///< Column holding the source value (V)
+        int readingColumn = -1;   ///< Column holding the reading (A)
+        bool foundVoltage = false;
+        bool foundZero = false;
+        bool done = false;
+        double currentAtVoltage = 0.0;
+        double currentAtZero = 0.0;
+    };
+
+    void startBlock();
+    void update(Buffer &buffer, double voltage, double current, bool emitWhenComplete);
+    void complete(Buffer &buffer);
+
+    double m_resistanceVoltage;
+    bool m_inData = false;
+    bool m_seenData = false;
+    int m_block = 0;
+    int m_rowsInBlock = 0;
+    int m_lastIndex = -1;
+    QVector<Buffer> m_buffers;
+    Buffer m_legacy;              ///< Column 6/7 tracker for files without `[ DATA ]`
+    QVector<DataPoint> m_points;
+    int m_emittedCount = 0;
+};
+
+#endif // TLMANALYZER_SWEEPPARSER_H
@@ -0,0 +1,106 @@
+#ifndef TLMANALYZER_TAILPARSER_H
+#define TLMANALYZER_TAILPARSER_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "appconfig.h"
+#include "datapoint.h"
+#include "filenameindex.h"
+#include "sweepparser.h"
+
+/**
+ * @brief Resumable parser for sweep files that are still being written
+ *
+ * Keeps, per file, the offset just past the last complete line and the
+ * SweepParser state reached there. Each poll() reads only the bytes
+ * appended since, feeds the complete lines and returns the points whose
+ * bias and zero-volt readings have both arrived, so following an active
+ * measurement costs only the new bytes. A trailing partial line is left
+ * on disk and read again once its newline has been written.
+ *
+ * Points get their spacing from the file name (through the configured
+ * filename templates) and their structure from the group and source, as in
+ * CSVProcessor::processFolder(), so every buffer and step block is its own
+ * structure from its first point on. Files without a `[ DATA ]` section
+ * only report their point from finish(), because their layout has no
+ * marker for a complete sweep.
+ *
+ * Not thread-safe; use one instance from one thread at a time.
+ */
+class TailParser {
+public:
+    /**
+     * @brief Constructor
+     * @param config Application configuration (resistance voltage, filename templates)
+     */
+    explicit TailParser(const AppConfig &config);
+
+    /**
+     * @brief Consume whatever has been appended to a file since the last poll
+     * @param filePath Path of the file
+     * @param group Structure group of the file ("" for none)
+     * @param restarted Set to true if the file had shrunk and was parsed again from the start;
+     *                  points returned by earlier polls of it are then stale
+     * @return Points completed by the new bytes
+     */
+    QVector<DataPoint> poll(const QString &filePath, const QString &group = QString(), bool *restarted = nullptr);
+
+    /**
+     * @brief Signal that a file is complete and stop following it
+     * @param filePath Path of the file
+     * @return Remaining points, including the point of a file without a `[ DATA ]` section
+     */
+    QVector<DataPoint> finish(const QString &filePath);
+
+    /**
+     * @brief Finish every followed file
+     * @return Remaining points of all files
+     */
+    QVector<DataPoint> finishAll();
+
+    /**
+     * @brief Stop following a file without reporting anything
+     */
+    void forget(const QString &filePath);
+
+    /**
+     * @brief Stop following all files
+     */
+    void clear();
+
+    /**
+     * @brief Bytes of a file consumed so far (0 for a file not followed)
+     */
+    [[nodiscard]] qint64 offset(const QString &filePath) const;
+
+    /**
+     * @brief Files being followed
+     */
+    [[nodiscard]] QStringList files() const;
+
+private:
+    /**
+     * @brief Parse state of one followed file
+     */
+    struct FileState {
+        explicit FileState(double resistanceVoltage = 1.0) : parser(resistanceVoltage) {}
+
+        SweepParser parser;  ///< State reached at offset
+        qint64 offset = 0;   ///< Bytes consumed, always just past a newline
+        QString group;       ///< Structure group of the file
+        double spacing = 0;  ///< Spacing from the file name
+    };
+
+    /**
+     * @brief Give completed points their spacing and structure, dropping invalid ones
+     */
+    static QVector<DataPoint> label(const FileState &state, QVector<DataPoint> points);
+
+    double m_resistanceVoltage;          ///< Voltage at which resistances are evaluated
+    FilenameTemplates m_templates;       ///< Compiled filename_templates, for the spacing
+    QHash<QString, FileState> m_files;   ///< Followed files by path
+};
+
+#endif // TLMANALYZER_TAILPARSER_H
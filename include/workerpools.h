@@ -0,0 +1,208 @@
+#ifndef TLMANALYZER_WORKERPOOLS_H
+#define TLMANALYZER_WORKERPOOLS_H
+
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+#include <QtConcurrent/QtConcurrentRun>
+#include <functional>
+#include <utility>
+#include "appconfig.h"
+
+/**
+ * @brief Thread pool whose threads run at a set priority and on a set of CPUs
+ *
+ * Qt applies a pool's thread priority only to threads it starts afterwards
+ * and has no notion of affinity, so every task started through run() or
+ * parallelFor() first calls prepareThread(), which brings the executing
+ * thread in line with the current configuration. The check is a single
+ * atomic load once a thread is up to date, so reconfiguring a pool takes
+ * effect with the next task of each thread.
+ */
+class WorkerPool : public QThreadPool {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor
+     * @param parent The parent QObject
+     */
+    explicit WorkerPool(QObject *parent = nullptr);
+
+    /**
+     * @brief Apply a size, priority and CPU set
+     * @param threads Maximum number of threads (at least 1)
+     * @param priority Priority of the pool's threads
+     * @param cpus CPUs the threads may run on; empty for all
+     */
+    void configure(int threads, QThread::Priority priority, const QVector<int> &cpus);
+
+    /**
+     * @brief Run a function on the pool
+     * @return Future of the function's result
+     */
+    template <typename Function>
+    auto run(Function function)
+    {
+        QThreadPool *pool = this;   // Selects the pool overload of QtConcurrent::run()
+        return QtConcurrent::run(pool, [this, function = std::move(function)]() mutable {
+            prepareThread();
+            return function();
+        });
+    }
+
+    /**
+     * @brief Give the calling pool thread the configured priority and CPU set
+     */
+    void prepareThread();
+
+    /**
+     * @brief Priority of the pool's threads
+     */
+    [[nodiscard]] QThread::Priority priority() const;
+
+    /**
+     * @brief Reserve threads for workers that must all run at the same time
+     * @param wanted Workers the caller would like to start
+     * @param minimum Workers the caller cannot do without
+     * @return Workers granted, between minimum and wanted; return them with releaseWorkers()
+     *
+     * Blocks while other reservations leave fewer than minimum threads free.
+     * Every granted worker gets a thread at once, so workers that wait on
+     * each other (the stages of an ingest run) cannot deadlock on a shared
+     * pool.
+     */
+    int claimWorkers(int wanted, int minimum);
+
+    /**
+     * @brief Return threads reserved with claimWorkers()
+     */
+    void releaseWorkers(int count);
+
+    /**
+     * @brief Process the indices 0 to count - 1 on a pool and the calling thread
+     * @param pool Pool supplying the helper threads; nullptr for the global pool
+     * @param count Number of indices
+     * @param body Called with half-open index ranges [begin, end), possibly concurrently
+     * @param grain Indices per range; 0 picks a value that gives each worker several ranges
+     *
+     * The indices are split into one contiguous range per worker. A worker
+     * takes grains from the front of its own range and, once that is empty,
+     * steals the back half of the fullest remaining range, so uneven items
+     * (a structure with many more points than the rest) never leave the
+     * other workers idle. Helpers are only started on idle pool threads and
+     * the caller always takes part, so calling this from a task of the same
+     * pool cannot deadlock. Returns when every index has been processed.
+     */
+    static void parallelFor(QThreadPool *pool, qsizetype count,
+                            const std::function<void(qsizetype begin, qsizetype end)> &body, qsizetype grain = 0);
+
+    /**
+     * @brief Parse a priority name
+     * @param name idle, lowest, low, normal, high or highest (case-insensitive)
+     * @param fallback Returned for an empty or unknown name
+     */
+    static QThread::Priority priorityFromName(const QString &name, QThread::Priority fallback);
+
+    /**
+     * @brief Parse a CPU list such as "0-3,6"
+     * @param text Comma-separated CPU numbers and inclusive ranges
+     * @param error Receives a description of the problem, if any
+     * @return Sorted, distinct CPU numbers; empty for empty or invalid text
+     */
+    static QVector<int> parseCpuList(const QString &text, QString *error = nullptr);
+
+    /**
+     * @brief Restrict the calling thread to a set of CPUs
+     * @param cpus CPU numbers; empty allows every CPU again
+     * @return False if the platform does not support affinity or refused the set
+     */
+    static bool pinCurrentThread(const QVector<int> &cpus);
+
+private:
+    mutable QMutex m_mutex;                ///< Guards m_priority and m_cpus
+    QThread::Priority m_priority = QThread::InheritPriority;
+    QVector<int> m_cpus;
+    QAtomicInteger<quint64> m_generation;  ///< Changes with every configure()
+
+    QMutex m_claimMutex;                   ///< Guards m_claimed
+    QWaitCondition m_claimReleased;
+    int m_claimed = 0;                     ///< Threads reserved by claimWorkers()
+};
+
+/**
+ * @brief The I/O, ingest and compute pools of the application
+ *
+ * Loading, reduction, indexing, following and exporting are dominated by
+ * file system access and run on the I/O pool, by default a few threads at
+ * low priority. Fits, plot rendering, archive inflation and parallel sums
+ * are CPU bound and run on the compute pool, by default one thread per core
+ * minus one so the GUI and render threads always have a core. The stage
+ * workers of every ingest run, the prefetcher's included, share the ingest
+ * pool and reserve their threads with WorkerPool::claimWorkers(), so
+ * concurrent loads divide its threads instead of adding their own. No pool
+ * shares threads with QThreadPool::globalInstance(), which Qt Quick uses
+ * internally.
+ *
+ * Tasks of the I/O pool start ingest runs and use the compute pool, and
+ * ingest runs use the compute pool as well, so the pools are declared in
+ * the opposite order: the I/O pool is destroyed, and its tasks finished,
+ * first and the compute pool last.
+ */
+class WorkerPools {
+public:
+    /**
+     * @brief Constructor; applies the defaults of AppConfig
+     */
+    WorkerPools();
+
+    WorkerPools(const WorkerPools &) = delete;
+    WorkerPools &operator=(const WorkerPools &) = delete;
+
+    /**
+     * @brief Apply io_threads, io_priority, compute_threads, compute_priority and worker_cpus
+     */
+    void configure(const AppConfig &config);
+
+    /**
+     * @brief Pool for file system bound work
+     */
+    WorkerPool *io() { return &m_io; }
+
+    /**
+     * @brief Pool for CPU bound work
+     */
+    WorkerPool *compute() { return &m_compute; }
+
+    /**
+     * @brief Pool shared by the stage workers of ingest runs
+     */
+    WorkerPool *ingest() { return &m_ingest; }
+
+    /**
+     * @brief Size of the I/O pool for a configuration
+     */
+    static int ioThreads(const AppConfig &config);
+
+    /**
+     * @brief Size of the compute pool for a configuration
+     */
+    static int computeThreads(const AppConfig &config);
+
+    /**
+     * @brief Size of the ingest pool for a configuration
+     */
+    static int ingestThreads(const AppConfig &config);
+
+private:
+    // Destroyed in reverse order: each pool's tasks may use the pools above it
+    WorkerPool m_compute;
+    WorkerPool m_ingest;
+    WorkerPool m_io;
+};
+
+#endif // TLMANALYZER_WORKERPOOLS_H
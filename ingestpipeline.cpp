@@ -0,0 +1,519 @@
+#include "include/ingestpipeline.h"
+#include "include/archivereader.h"
+#include "include/batchfilereader.h"
+#include "include/boundedqueue.h"
+#include "include/csvprocessor.h"
+#include "include/filediscovery.h"
+#include "include/workerpools.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <cmath>
+
+namespace {
+
+// Work items passed between stages
+struct FileTask {
+    int root = 0;                ///< Index of the folder the file was found in
+    QString path;
+    QString fileName;
+    QString group;
+    double spacing = -1;
+    bool isArchive = false;
+};
+
+struct FileBuffer {
+    FileTask task;
+    QByteArray content;
+    bool readOk = false;
+};
+
+struct ParsedFile {
+    FileTask task;
+    QVector<DataPoint> points;   ///< One per instrument buffer and step
+};
+
+struct ValidatedFile {
+    int root = 0;
+    QString path;
+    QVector<DataPoint> points;   ///< Accepted points only
+};
+
+struct AcceptedPoint {
+    QString path;
+    int order = 0;               ///< Position of the point within its file
+    DataPoint point;
+};
+
+/**
+ * @brief Sort collected points by structure and spacing
+ *
+ * Ties are broken by file path and position in the file so the result does
+ * not depend on which worker finished first.
+ */
+QVector<DataPoint> sortAccepted(QVector<AcceptedPoint> &accepted)
+{
+    std::sort(accepted.begin(), accepted.end(), [](const AcceptedPoint &a, const AcceptedPoint &b) {
+        if (a.point.structure != b.point.structure) {
+            return a.point.structure < b.point.structure;
+        }
+        if (a.point.spacing != b.point.spacing) {
+            return a.point.spacing < b.point.spacing;
+        }
+        if (a.path != b.path) {
+            return a.path < b.path;
+        }
+        return a.order < b.order;
+    });
+
+    QVector<DataPoint> points;
+    points.reserve(accepted.size());
+    for (const AcceptedPoint &entry : accepted) {
+        points.append(entry.point);
+    }
+    return points;
+}
+
+/**
+ * @brief Sink appending every point to a collection for sortAccepted()
+ */
+IngestPipeline::FileSink collectInto(QVector<AcceptedPoint> &accepted)
+{
+    return [&accepted](int, const QString &path, QVector<DataPoint> &&points) {
+        for (int i = 0; i < points.size(); ++i) {
+            accepted.append(AcceptedPoint {path, i, std::move(points[i])});
+        }
+    };
+}
+
+/**
+ * @brief Runs `count` copies of a stage body and closes the output queue
+ * after the last copy returns
+ *
+ * Each copy runs at `priority` unless that is InheritPriority, and releases
+ * `finished` once it no longer touches the run's state.
+ */
+template <typename Output, typename Body>
+void startStage(WorkerPool &pool, int count, QThread::Priority priority, BoundedQueue<Output> &output,
+                QAtomicInt &remaining, QSemaphore &finished, Body body)
+{
+    remaining.storeRelaxed(count);
+    for (int i = 0; i < count; ++i) {
+        pool.start([&pool, priority, &output, &remaining, &finished, body]() {
+            pool.prepareThread();
+            // A run on a shared pool may ask for another priority than the pool's
+            QThread *thread = QThread::currentThread();
+            const QThread::Priority own = thread->priority();
+            const bool adjust = priority != QThread::InheritPriority && priority != own;
+            if (adjust) {
+                thread->setPriority(priority);
+            }
+            body();
+            if (remaining.fetchAndSubOrdered(1) == 1) {
+                output.close();
+            }
+            if (adjust) {
+                thread->setPriority(own == QThread::InheritPriority ? QThread::NormalPriority : own);
+            }
+            finished.release();
+        });
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Default constructor
+ *
+ * Parsing is CPU bound and gets one worker per core; reading is I/O bound
+ * and gets a few workers so that several requests are outstanding on slow
+ * storage.
+ */
+IngestOptions::IngestOptions()
+    : readThreads(4),
+      parseThreads(std::max(1, QThread::idealThreadCount())),
+      validateThreads(1),
+      queueCapacity(64),
+      readBatchSize(64),
+      threadPriority(QThread::InheritPriority),
+      archivePool(nullptr),
+      stagePool(nullptr)
+{
+}
+
+/**
+ * @brief Build options from the persisted application configuration
+ * @param config Application configuration
+ * @return Options with non-positive config values replaced by defaults
+ *
+ * Readers default to io_threads and parsers to compute_threads when those
+ * are set; the workers take io_priority and worker_cpus. A load is bulk
+ * work, so by default (io_priority "low", as for the I/O pool) it yields to
+ * analysis and to the GUI thread.
+ */
+IngestOptions IngestOptions::fromConfig(const AppConfig &config)
+{
+    IngestOptions options;
+    if (config.io_threads > 0) options.readThreads = config.io_threads;
+    if (config.compute_threads > 0) options.parseThreads = config.compute_threads;
+    if (config.ingest_read_threads > 0) options.readThreads = config.ingest_read_threads;
+    if (config.ingest_parse_threads > 0) options.parseThreads = config.ingest_parse_threads;
+    if (config.ingest_validate_threads > 0) options.validateThreads = config.ingest_validate_threads;
+    if (config.ingest_queue_capacity > 0) options.queueCapacity = config.ingest_queue_capacity;
+    if (config.ingest_read_batch > 0) options.readBatchSize = config.ingest_read_batch;
+    options.threadPriority = WorkerPool::priorityFromName(config.io_priority, QThread::LowPriority);
+    options.cpus = WorkerPool::parseCpuList(config.worker_cpus);
+    return options;
+}
+
+/**
+ * @brief Constructor
+ * @param config Application configuration used by the parser
+ * @param options Stage concurrency and queue sizes
+ */
+IngestPipeline::IngestPipeline(const AppConfig &config, const IngestOptions &options)
+    : m_config(config), m_options(options), m_templates(config.filename_templates)
+{
+}
+
+/**
+ * @brief Load all CSV files of a folder (and its sub-folders if configured)
+ * @param folderPath Path to the folder containing CSV files
+ * @param cancelFlag Optional flag; all stages stop when it becomes non-zero
+ * @param progress Optional progress callback
+ * @return Valid data points sorted by structure and spacing (partial if cancelled)
+ *
+ * Convenience wrapper around runMany() for a single folder.
+ */
+QVector<DataPoint> IngestPipeline::run(const QString &folderPath, const QAtomicInt *cancelFlag,
+                                       const ProgressCallback &progress)
+{
+    FolderProgressCallback folderProgress;
+    if (progress) {
+        folderProgress = [&progress](int, qsizetype processed, qsizetype discovered, bool discoveryDone) {
+            progress(processed, discovered, discoveryDone);
+        };
+    }
+    return runMany(QStringList {folderPath}, cancelFlag, folderProgress);
+}
+
+/**
+ * @brief Load several folders through one shared set of stage workers
+ * @param folderPaths Folders to load
+ * @param cancelFlag Optional flag; all stages stop when it becomes non-zero
+ * @param progress Optional per-folder progress callback
+ * @return Valid data points of all folders sorted by structure and spacing
+ *
+ * Collects what streamMany() hands over and sorts it.
+ */
+QVector<DataPoint> IngestPipeline::runMany(const QStringList &folderPaths, const QAtomicInt *cancelFlag,
+                                           const FolderProgressCallback &progress)
+{
+    QVector<AcceptedPoint> accepted;
+    streamMany(folderPaths, collectInto(accepted), cancelFlag, progress);
+    return sortAccepted(accepted);
+}
+
+/**
+ * @brief Load several folders and hand each file's points to a sink
+ * @param folderPaths Folders to load
+ * @param sink Receives the accepted points of every file
+ * @param cancelFlag Optional flag; all stages stop when it becomes non-zero
+ * @param progress Optional per-folder progress callback
+ *
+ * Each folder is walked with FileDiscovery by the enumerate stage.
+ */
+void IngestPipeline::streamMany(const QStringList &folderPaths, const FileSink &sink, const QAtomicInt *cancelFlag,
+                                const FolderProgressCallback &progress)
+{
+    QStringList origins;
+    origins.reserve(folderPaths.size());
+    for (const QString &folderPath : folderPaths) {
+        origins.append(QDir(folderPath).absolutePath());
+    }
+    const DiscoveryOptions discoveryOptions = DiscoveryOptions::fromConfig(m_config);
+    stream(origins, [&origins, &discoveryOptions, cancelFlag](int root, const FileDiscovery::Visitor &visitor) {
+        FileDiscovery(discoveryOptions).discover(origins.at(root), visitor, cancelFlag);
+    }, sink, cancelFlag, progress);
+}
+
+/**
+ * @brief Load an explicit selection of files, e.g. the result of a FilenameIndex query
+ * @param roots Folders the files belong to; points are tagged with them
+ * @param files Files per entry of roots
+ * @param cancelFlag Optional flag; all stages stop when it becomes non-zero
+ * @param progress Optional per-folder progress callback
+ * @return Valid data points sorted by structure and spacing
+ */
+QVector<DataPoint> IngestPipeline::runFiles(const QStringList &roots, const QVector<QVector<DiscoveredFile>> &files,
+                                            const QAtomicInt *cancelFlag, const FolderProgressCallback &progress)
+{
+    QVector<AcceptedPoint> accepted;
+    streamFiles(roots, files, collectInto(accepted), cancelFlag, progress);
+    return sortAccepted(accepted);
+}
+
+/**
+ * @brief Load an explicit selection of files and hand each file's points to a sink
+ * @param roots Folders the files belong to
+ * @param files Files per entry of roots
+ * @param sink Receives the accepted points of every file
+ * @param cancelFlag Optional flag; all stages stop when it becomes non-zero
+ * @param progress Optional per-folder progress callback
+ *
+ * The enumerate stage replays the given lists instead of walking folders.
+ */
+void IngestPipeline::streamFiles(const QStringList &roots, const QVector<QVector<DiscoveredFile>> &files,
+                                 const FileSink &sink, const QAtomicInt *cancelFlag,
+                                 const FolderProgressCallback &progress)
+{
+    stream(roots, [&files](int root, const FileDiscovery::Visitor &visitor) {
+        if (root >= files.size()) {
+            return;
+        }
+        for (const DiscoveredFile &file : files.at(root)) {
+            DiscoveredFile copy = file;
+            if (!visitor(std::move(copy))) {
+                return;
+            }
+        }
+    }, sink, cancelFlag, progress);
+}
+
+/**
+ * @brief Run the five stages over the files an enumerator lists
+ * @param origins Root folders; points are tagged with them
+ * @param enumerate Lists the files of one root
+ * @param sink Receives the accepted points of every file
+ * @param cancelFlag Optional cancellation flag
+ * @param progress Optional per-folder progress callback
+ *
+ * The enumerate, read, parse and validate stages block on each other, so
+ * every stage worker must be live at the same time: on the shared stage
+ * pool the run reserves a thread per worker, shrinking the largest stages
+ * to what the pool grants, and otherwise it sizes a private pool to fit.
+ * The run returns only after its last worker has finished. The
+ * reduce stage runs on the calling thread and is the only place where
+ * results are handed over. Enumerators claim roots from a shared counter;
+ * every file task carries the index of its root so the reduce stage can
+ * keep per-folder counts.
+ */
+void IngestPipeline::stream(const QStringList &origins, const Enumerator &enumerate, const FileSink &sink,
+                            const QAtomicInt *cancelFlag, const FolderProgressCallback &progress)
+{
+    const int rootCount = static_cast<int>(origins.size());
+    if (rootCount == 0) {
+        return;
+    }
+
+    QAtomicInt neverCancelled {0};
+    const QAtomicInt *cancel = cancelFlag ? cancelFlag : &neverCancelled;
+
+    const int capacity = std::max(2, m_options.queueCapacity);
+    int readers = std::max(1, m_options.readThreads);
+    int parsers = std::max(1, m_options.parseThreads);
+    int validators = std::max(1, m_options.validateThreads);
+    int enumerators = std::min(rootCount, readers);
+    const int readBatch = std::max(1, m_options.readBatchSize);
+
+    WorkerPool privatePool;
+    WorkerPool *pool = m_options.stagePool;
+    int claimed = 0;
+    if (pool) {
+        // Reserve a thread per stage worker; shrink the largest stages to the grant
+        claimed = pool->claimWorkers(enumerators + readers + parsers + validators, 4);
+        int *stages[] = {&readers, &parsers, &enumerators, &validators};
+        while (enumerators + readers + parsers + validators > claimed) {
+            int *largest = *std::max_element(std::begin(stages), std::end(stages),
+                                             [](const int *a, const int *b) { return *a < *b; });
+            if (*largest <= 1) {
+                break;
+            }
+            --*largest;
+        }
+    } else {
+        pool = &privatePool;
+        pool->configure(enumerators + readers + parsers + validators, m_options.threadPriority, m_options.cpus);
+    }
+    const QThread::Priority priority = pool == &privatePool ? QThread::InheritPriority : m_options.threadPriority;
+    QSemaphore finished;
+
+    // The task queue holds only paths; size it so every reader can fill a batch
+    BoundedQueue<FileTask> taskQueue(std::max(capacity, readBatch * readers));
+    BoundedQueue<FileBuffer> bufferQueue(capacity);
+    BoundedQueue<ParsedFile> parsedQueue(capacity);
+    BoundedQueue<ValidatedFile> validatedQueue(capacity);
+
+    QAtomicInt enumerateRemaining, readRemaining, parseRemaining, validateRemaining;
+    std::unique_ptr<std::atomic<qsizetype>[]> discovered(new std::atomic<qsizetype>[rootCount]);
+    std::unique_ptr<std::atomic<bool>[]> discoveryDone(new std::atomic<bool>[rootCount]);
+    for (int root = 0; root < rootCount; ++root) {
+        discovered[root].store(0, std::memory_order_relaxed);
+        discoveryDone[root].store(false, std::memory_order_relaxed);
+    }
+    std::atomic<int> nextRoot {0};
+
+    // Stage 1: enumerate. Files are handed on as soon as they are listed;
+    // each enumerator claims folders until none are left.
+    startStage(*pool, enumerators, priority, taskQueue, enumerateRemaining, finished, [&]() {
+        for (int root = nextRoot.fetch_add(1); root < rootCount && cancel->loadAcquire() == 0;
+             root = nextRoot.fetch_add(1)) {
+            enumerate(root, [&](DiscoveredFile &&file) {
+                FileTask task;
+                task.root = root;
+                if (ArchiveReader::isArchive(file.fileName)) {
+                    // Members are counted and checked for spacing when the archive is read
+                    task.isArchive = true;
+                    task.path = std::move(file.path);
+                    task.fileName = std::move(file.fileName);
+                    task.group = std::move(file.group);
+                    return taskQueue.push(std::move(task), cancel);
+                }
+                task.spacing = file.spacing > 0 ? file.spacing : m_templates.spacing(file.fileName);
+                if (task.spacing <= 0) {
+                    qDebug() << "Filename does not contain valid spacing, skipping:" << file.fileName;
+                    return true;
+                }
+                task.path = std::move(file.path);
+                task.fileName = std::move(file.fileName);
+                task.group = std::move(file.group);
+                discovered[root].fetch_add(1, std::memory_order_relaxed);
+                return taskQueue.push(std::move(task), cancel);
+            });
+            discoveryDone[root].store(true, std::memory_order_release);
+        }
+    });
+
+    // Stage 2: read. Pure I/O (and decompression), no parsing. Each reader
+    // drains up to a batch of queued tasks and reads them with a single
+    // BatchFileReader call; archives are streamed member by member.
+    const QStringList memberPatterns = m_config.include_patterns.isEmpty()
+        ? DiscoveryOptions().includePatterns : m_config.include_patterns;
+    startStage(*pool, readers, priority, bufferQueue, readRemaining, finished, [&]() {
+        BatchFileReader reader(readBatch);
+        QVector<FileTask> batch;
+        QStringList paths;
+        FileTask task;
+
+        auto expandArchive = [&](const FileTask &archive) {
+            const QString archiveName = ArchiveReader::archiveBaseName(archive.fileName);
+            bool pushed = true;
+            ArchiveReader::readMembers(archive.path, memberPatterns,
+                [&](const QString &memberName, QByteArray &&content) {
+                    FileBuffer buffer;
+                    buffer.task.root = archive.root;
+                    buffer.task.fileName = memberName.section(QLatin1Char('/'), -1);
+                    buffer.task.spacing = m_templates.spacing(buffer.task.fileName);
+                    if (buffer.task.spacing <= 0) {
+                        qDebug() << "Filename does not contain valid spacing, skipping:" << memberName;
+                        return true;
+                    }
+                    buffer.task.path = archive.path + QLatin1Char('/') + memberName;
+                    if (m_config.group_by_folder) {
+                        // Each bundle is a separate structure
+                        buffer.task.group = archive.group.isEmpty()
+                            ? archiveName : archive.group + QLatin1Char('/') + archiveName;
+                    }
+                    buffer.content = std::move(content);
+                    buffer.readOk = true;
+                    discovered[archive.root].fetch_add(1, std::memory_order_relaxed);
+                    pushed = bufferQueue.push(std::move(buffer), cancel);
+                    return pushed;
+                }, cancel, m_options.archivePool, ArchiveReader::memberLimit(m_config.archive_member_limit_mb));
+            return pushed;
+        };
+
+        while (taskQueue.pop(task, cancel)) {
+            batch.clear();
+            paths.clear();
+            do {
+                if (task.isArchive) {
+                    if (!expandArchive(task)) {
+                        return;
+                    }
+                    continue;
+                }
+                paths.append(task.path);
+                batch.append(std::move(task));
+            } while (batch.size() < readBatch && taskQueue.tryPop(task));
+
+            QVector<BatchFileReader::Result> results = reader.readFiles(paths);
+            for (qsizetype i = 0; i < batch.size(); ++i) {
+                FileBuffer buffer;
+                buffer.task = std::move(batch[i]);
+                buffer.content = std::move(results[i].content);
+                buffer.readOk = results[i].ok;
+                if (!bufferQueue.push(std::move(buffer), cancel)) {
+                    return;
+                }
+            }
+        }
+    });
+
+    // Stage 3: parse. Pure CPU, no I/O.
+    startStage(*pool, parsers, priority, parsedQueue, parseRemaining, finished, [&]() {
+        FileBuffer buffer;
+        while (bufferQueue.pop(buffer, cancel)) {
+            ParsedFile parsed;
+            if (buffer.readOk) {
+                parsed.points = CSVProcessor::parseContentAll(buffer.content, m_config, buffer.task.path);
+            }
+            parsed.task = std::move(buffer.task);
+            buffer.content = QByteArray(); // Release the file buffer before blocking on the next push
+            if (!parsedQueue.push(std::move(parsed), cancel)) {
+                break;
+            }
+        }
+    });
+
+    // Stage 4: validate. Attach the spacing and reject unusable points.
+    startStage(*pool, validators, priority, validatedQueue, validateRemaining, finished, [&]() {
+        ParsedFile parsed;
+        while (parsedQueue.pop(parsed, cancel)) {
+            ValidatedFile validated;
+            validated.root = parsed.task.root;
+            validated.path = parsed.task.path;
+            for (DataPoint &point : parsed.points) {
+                if (point.resistance > 0 && std::isfinite(point.resistance)) {
+                    point.spacing = parsed.task.spacing;
+                    point.origin = origins.at(parsed.task.root);
+                    // Every buffer and step is its own structure, however many a file holds
+                    point.structure = CSVProcessor::structureForSource(parsed.task.group, point.source);
+                    validated.points.append(std::move(point));
+                } else {
+                    qDebug() << "Skipping point due to invalid resistance:" << parsed.task.fileName << point.source << point.resistance;
+                }
+            }
+            if (parsed.points.isEmpty()) {
+                qDebug() << "Skipping file without a complete measurement:" << parsed.task.fileName;
+            }
+            if (!validatedQueue.push(std::move(validated), cancel)) {
+                break;
+            }
+        }
+    });
+
+    // Stage 5: reduce, on the calling thread
+    QVector<qsizetype> processed(rootCount, 0);
+    ValidatedFile validated;
+    while (validatedQueue.pop(validated, cancel)) {
+        const int root = validated.root;
+        ++processed[root];
+        sink(root, validated.path, std::move(validated.points));
+        if (progress) {
+            progress(root, processed.at(root), discovered[root].load(std::memory_order_relaxed),
+                     discoveryDone[root].load(std::memory_order_acquire));
+        }
+    }
+
+    finished.acquire(enumerators + readers + parsers + validators);
+    if (claimed > 0) {
+        pool->releaseWorkers(claimed);
+    }
+}
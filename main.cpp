@@ -2,11 +2,21 @@
 #include <QQmlApplicationEngine>
 #include <QQuickStyle>
 #include <QIcon>
-#include <QQmlContext>
+#include <QtQml/qqmlextensionplugin.h>
 #include "include/datamanager.h"
+#include "include/qmltypes.h"
+#include "include/cli.h"
+
+// The TLMAnalyzer QML module is linked statically
+Q_IMPORT_QML_PLUGIN(TLMAnalyzerPlugin)
 
 int main(int argc, char *argv[])
 {
+    // Headless batch runs never create the GUI
+    if (Cli::wantsCli(argc, argv)) {
+        return Cli::run(argc, argv);
+    }
+
     QGuiApplication app(argc, argv);
 
     // Set the application icon
@@ -15,15 +25,13 @@ int main(int argc, char *argv[])
     QQuickStyle::setStyle("Material");
 
     qRegisterMetaType<DataPoint>("DataPoint");
-    int dataPointResult = qmlRegisterUncreatableType<DataPoint>("TLMAnalyzer", 1, 0, "DataPoint",
-                                         QStringLiteral("DataPoint should not be created in QML"));
-    Q_ASSERT(dataPointResult >= 0);
 
     QQmlApplicationEngine engine;
 
-    // Create and expose a single DataManager instance to QML
-    auto dm = new DataManager(&engine);
-    engine.rootContext()->setContextProperty(QStringLiteral("DataManager"), dm);
+    // Create the single DataManager instance; QML reaches it as the
+    // TLMAnalyzer.DataManager singleton. Its configuration loads in the
+    // background while the UI is created.
+    DataManagerForeign::s_instance = new DataManager(&engine);
 
     QObject::connect(&engine, &QQmlApplicationEngine::objectCreationFailed,
         &app, [](const QUrl &url) {
@@ -31,9 +39,7 @@ int main(int argc, char *argv[])
         },
         Qt::QueuedConnection);
 
-    const QUrl urlMain(QStringLiteral("qrc:/qml/MainUI.qml"));
-
-    engine.load(urlMain);
+    engine.loadFromModule("TLMAnalyzer", "MainUI");
 
     if (engine.rootObjects().isEmpty()) {
         return -1;
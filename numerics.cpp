@@ -0,0 +1,69 @@
+#include "include/numerics.h"
+#include <atomic>
+
+namespace {
+
+std::atomic<QThreadPool *> sumPool {nullptr};
+
+} // namespace
+
+/**
+ * @brief Pool running the blocks of large sums
+ * @param pool Pool to use; nullptr for the global pool
+ *
+ * Sums are started from compute pool tasks as well; parallelFor() lets the
+ * calling thread take part, so that cannot deadlock.
+ */
+void Numerics::setThreadPool(QThreadPool *pool)
+{
+    sumPool.store(pool, std::memory_order_release);
+}
+
+/**
+ * @brief Pool running the blocks of large sums; nullptr for the global pool
+ */
+QThreadPool *Numerics::threadPool()
+{
+    return sumPool.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Reproducible sum of a vector
+ * @param values Values to add
+ * @return Compensated sum
+ */
+double Numerics::sum(const QVector<double> &values)
+{
+    const double *data = values.constData();
+    return sumOf(values.size(), [data](qsizetype i) { return data[i]; });
+}
+
+/**
+ * @brief Reproducible mean of a vector
+ * @param values Values to average
+ * @return Mean, or 0 for an empty vector
+ */
+double Numerics::mean(const QVector<double> &values)
+{
+    return values.isEmpty() ? 0.0 : sum(values) / static_cast<double>(values.size());
+}
+
+/**
+ * @brief Combine block results in a fixed pairwise tree
+ * @param parts Block results in block order
+ * @param count Number of blocks, at least one
+ * @return Combined partial sum
+ *
+ * The split point depends only on count, so the combination order is the
+ * same however the blocks were computed.
+ */
+Numerics::Partial Numerics::reduce(const Partial *parts, qsizetype count)
+{
+    if (count == 1) {
+        return parts[0];
+    }
+    const qsizetype half = count / 2;
+    Partial left = reduce(parts, half);
+    left.merge(reduce(parts + half, count - half));
+    return left;
+}
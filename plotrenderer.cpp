@@ -0,0 +1,415 @@
+#include "include/plotrenderer.h"
+#include <QDir>
+#include <QFile>
+#include <QPainter>
+#include <QPolygonF>
+#include <QRegularExpression>
+#include <algorithm>
+#include "include/calculator.h"
+#include "include/fitmodels.h"
+#include "include/workerpools.h"
+
+namespace {
+
+/**
+ * @brief Maps data coordinates to pixel coordinates of the plot area
+ */
+struct Frame {
+    double padding;
+    double width;
+    double height;
+    double plotWidth;
+    double plotHeight;
+    const PlotRenderer::ChartData &data;
+
+    Frame(const PlotRenderer::ChartData &chart, const PlotRenderer::Style &style)
+        : padding(style.padding), width(style.width), height(style.height),
+          plotWidth(style.width - style.padding * 2.0), plotHeight(style.height - style.padding * 2.0), data(chart)
+    {
+    }
+
+    double toX(double x) const { return padding + (x - data.xMin) / (data.xMax - data.xMin) * plotWidth; }
+    double toY(double y) const { return padding + plotHeight - (y - data.yMin) / (data.yMax - data.yMin) * plotHeight; }
+};
+
+QString svgColor(const QColor &color)
+{
+    return color.name(QColor::HexRgb);
+}
+
+QString svgEscape(const QString &text)
+{
+    return text.toHtmlEscaped();
+}
+
+/**
+ * @brief Resistance the fitted line of a model predicts at a spacing
+ */
+double fittedResistance(Calculator::FitModel model, const Calculator::TLMResult &fit, double spacing,
+                        const Calculator::FitGeometry &geometry)
+{
+    const double y = fit.slope * spacing + fit.intercept;
+    switch (model) {
+    case Calculator::FitModel::CircularTLM:
+        return FitModels::CircularTLM::resistance(y, spacing, geometry);
+    case Calculator::FitModel::EndResistance:
+        return FitModels::EndResistanceTLM::resistance(y, spacing, geometry);
+    case Calculator::FitModel::LinearTLM:
+        break;
+    }
+    return FitModels::LinearTLM::resistance(y, spacing, geometry);
+}
+
+QString fileNameFor(const QString &structure)
+{
+    static const QRegularExpression unsafe(QStringLiteral("[^A-Za-z0-9._-]"));
+    QString name = structure;
+    name.replace(unsafe, QStringLiteral("_"));
+    return name.isEmpty() ? QStringLiteral("plot") : name;
+}
+
+} // namespace
+
+/**
+ * @brief Build plot geometry from the points of one structure
+ * @param points Points of one structure; disabled points are not drawn
+ * @param model Structure model of the fit and the diagnostics
+ * @param geometry Structure geometry
+ * @param title Title drawn above the plot (may be empty)
+ * @return Plot geometry
+ *
+ * Axis ranges follow calculateChartData() in Implementation.qml: 10% padding
+ * on both axes (1 if the range is empty) and a y axis that starts at zero or
+ * above. Influential points are flagged by Cook's distance of the model's
+ * fit. The fit is drawn as the resistance the model predicts, which is a
+ * straight line except for circular TLM, where it is sampled as a polyline.
+ */
+PlotRenderer::ChartData PlotRenderer::chartData(const QVector<DataPoint> &points, Calculator::FitModel model,
+                                                const Calculator::FitGeometry &geometry, const QString &title)
+{
+    ChartData data;
+    data.title = title;
+
+    const QVector<Calculator::InfluenceDiagnostics> diagnostics = Calculator::influenceDiagnostics(model, points, geometry);
+    QVector<double> xs, ys;
+    for (qsizetype i = 0; i < points.size(); ++i) {
+        const DataPoint &point = points.at(i);
+        if (!point.enabled) {
+            continue;
+        }
+        data.scatter.append({point.spacing, point.resistance, diagnostics.at(i).influential});
+        xs.append(point.spacing);
+        ys.append(point.resistance);
+    }
+    if (xs.isEmpty()) {
+        return data;
+    }
+
+    const auto [minX, maxX] = std::minmax_element(xs.cbegin(), xs.cend());
+    const auto [minY, maxY] = std::minmax_element(ys.cbegin(), ys.cend());
+    double xPadding = (*maxX - *minX) * 0.1;
+    double yPadding = (*maxY - *minY) * 0.1;
+    if (xPadding == 0) xPadding = 1;
+    if (yPadding == 0) yPadding = 1;
+    data.xMin = *minX - xPadding;
+    data.xMax = *maxX + xPadding;
+    data.yMin = std::max(0.0, *minY - yPadding);
+    data.yMax = *maxY + yPadding;
+
+    Calculator::TLMResult fit;
+    if (xs.size() > 1 && Calculator::fit(model, points, geometry, fit)) {
+        data.hasFit = true;
+        const int samples = model == Calculator::FitModel::CircularTLM ? 64 : 2;
+        for (int i = 0; i < samples; ++i) {
+            const double x = data.xMin + (data.xMax - data.xMin) * i / (samples - 1);
+            data.fitLine.append({x, fittedResistance(model, fit, x, geometry), false});
+        }
+    }
+    return data;
+}
+
+/**
+ * @brief Paint a plot into an image
+ * @param data Plot geometry
+ * @param style Appearance
+ * @return White ARGB image of style.width × style.height pixels
+ */
+QImage PlotRenderer::renderImage(const ChartData &data, const Style &style)
+{
+    QImage image(style.width, style.height, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    QFont font = painter.font();
+    font.setPixelSize(12);
+    painter.setFont(font);
+
+    const Frame frame(data, style);
+    if (data.scatter.isEmpty()) {
+        font.setPixelSize(16);
+        painter.setFont(font);
+        painter.setPen(style.textColor);
+        painter.drawText(QRectF(0, 0, frame.width, frame.height), Qt::AlignCenter, QStringLiteral("No data to display"));
+        return image;
+    }
+
+    // Grid
+    painter.setPen(QPen(style.gridColor, 1));
+    for (int i = 0; i <= 5; ++i) {
+        const double x = frame.padding + frame.plotWidth / 5 * i;
+        const double y = frame.padding + frame.plotHeight / 5 * i;
+        painter.drawLine(QPointF(x, frame.padding), QPointF(x, frame.height - frame.padding));
+        painter.drawLine(QPointF(frame.padding, y), QPointF(frame.width - frame.padding, y));
+    }
+
+    // Axes
+    painter.setPen(QPen(style.textColor, 1));
+    painter.drawLine(QPointF(frame.padding, frame.padding), QPointF(frame.padding, frame.height - frame.padding));
+    painter.drawLine(QPointF(frame.padding, frame.height - frame.padding),
+                     QPointF(frame.width - frame.padding, frame.height - frame.padding));
+
+    // Labels, title and tick values
+    const auto drawCentered = [&painter](double x, double y, const QString &text) {
+        painter.drawText(QRectF(x - 200, y - 12, 400, 16), Qt::AlignHCenter | Qt::AlignBottom, text);
+    };
+    drawCentered(frame.width / 2, frame.height - 10, style.xAxisLabel);
+    if (!data.title.isEmpty()) {
+        drawCentered(frame.width / 2, frame.padding - 15, data.title);
+    }
+    painter.save();
+    painter.translate(15, frame.height / 2);
+    painter.rotate(-90);
+    drawCentered(0, 0, style.yAxisLabel);
+    painter.restore();
+    for (int i = 0; i <= 5; ++i) {
+        const double yValue = data.yMin + (data.yMax - data.yMin) * (1 - i / 5.0);
+        const double y = frame.padding + frame.plotHeight / 5 * i + 4;
+        painter.drawText(QRectF(0, y - 12, frame.padding - 5, 16), Qt::AlignRight | Qt::AlignBottom,
+                         QString::number(yValue, 'f', 2));
+        const double xValue = data.xMin + (data.xMax - data.xMin) * (i / 5.0);
+        drawCentered(frame.padding + frame.plotWidth / 5 * i, frame.height - frame.padding + 15,
+                     QString::number(xValue, 'f', 2));
+    }
+
+    // Scatter points; influential points get a ring
+    for (const ChartData::Point &point : data.scatter) {
+        const QPointF center(frame.toX(point.x), frame.toY(point.y));
+        const QColor color = point.influential ? style.influentialColor : style.dataPointColor;
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(color);
+        painter.drawEllipse(center, 4, 4);
+        if (point.influential) {
+            painter.setBrush(Qt::NoBrush);
+            painter.setPen(QPen(color, 1.5));
+            painter.drawEllipse(center, 8, 8);
+        }
+    }
+
+    // Fit line
+    if (style.showLinearFit && data.hasFit) {
+        painter.setPen(QPen(style.fitLineColor, 2));
+        QPolygonF polyline;
+        for (const ChartData::Point &point : data.fitLine) {
+            polyline.append(QPointF(frame.toX(point.x), frame.toY(point.y)));
+        }
+        painter.drawPolyline(polyline);
+    }
+
+    return image;
+}
+
+/**
+ * @brief Write a plot as an SVG document
+ * @param data Plot geometry
+ * @param style Appearance
+ * @return UTF-8 SVG document
+ */
+QByteArray PlotRenderer::renderSvg(const ChartData &data, const Style &style)
+{
+    const Frame frame(data, style);
+    QString svg;
+    svg.reserve(4096 + data.scatter.size() * 96);
+    svg += QStringLiteral("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                          "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%1\" height=\"%2\" viewBox=\"0 0 %1 %2\" "
+                          "font-family=\"sans-serif\" font-size=\"12\">\n"
+                          "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n")
+               .arg(style.width).arg(style.height);
+
+    const auto line = [&svg](double x1, double y1, double x2, double y2, const QColor &color, double width) {
+        svg += QStringLiteral("<line x1=\"%1\" y1=\"%2\" x2=\"%3\" y2=\"%4\" stroke=\"%5\" stroke-width=\"%6\"/>\n")
+                   .arg(x1).arg(y1).arg(x2).arg(y2).arg(svgColor(color)).arg(width);
+    };
+    const auto text = [&svg, &style](double x, double y, const QString &anchor, const QString &content,
+                                     const QString &extra = QString()) {
+        svg += QStringLiteral("<text x=\"%1\" y=\"%2\" text-anchor=\"%3\" fill=\"%4\"%5>%6</text>\n")
+                   .arg(x).arg(y).arg(anchor, svgColor(style.textColor), extra, svgEscape(content));
+    };
+
+    if (data.scatter.isEmpty()) {
+        svg += QStringLiteral("<text x=\"%1\" y=\"%2\" text-anchor=\"middle\" font-size=\"16\">No data to display</text>\n")
+                   .arg(frame.width / 2).arg(frame.height / 2);
+        svg += QStringLiteral("</svg>\n");
+        return svg.toUtf8();
+    }
+
+    for (int i = 0; i <= 5; ++i) {
+        const double x = frame.padding + frame.plotWidth / 5 * i;
+        const double y = frame.padding + frame.plotHeight / 5 * i;
+        line(x, frame.padding, x, frame.height - frame.padding, style.gridColor, 1);
+        line(frame.padding, y, frame.width - frame.padding, y, style.gridColor, 1);
+    }
+    line(frame.padding, frame.padding, frame.padding, frame.height - frame.padding, style.textColor, 1);
+    line(frame.padding, frame.height - frame.padding, frame.width - frame.padding, frame.height - frame.padding,
+         style.textColor, 1);
+
+    text(frame.width / 2, frame.height - 10, QStringLiteral("middle"), style.xAxisLabel);
+    if (!data.title.isEmpty()) {
+        text(frame.width / 2, frame.padding - 15, QStringLiteral("middle"), data.title);
+    }
+    text(0, 0, QStringLiteral("middle"), style.yAxisLabel,
+         QStringLiteral(" transform=\"translate(15 %1) rotate(-90)\"").arg(frame.height / 2));
+    for (int i = 0; i <= 5; ++i) {
+        const double yValue = data.yMin + (data.yMax - data.yMin) * (1 - i / 5.0);
+        text(frame.padding - 5, frame.padding + frame.plotHeight / 5 * i + 4, QStringLiteral("end"),
+             QString::number(yValue, 'f', 2));
+        const double xValue = data.xMin + (data.xMax - data.xMin) * (i / 5.0);
+        text(frame.padding + frame.plotWidth / 5 * i, frame.height - frame.padding + 15, QStringLiteral("middle"),
+             QString::number(xValue, 'f', 2));
+    }
+
+    for (const ChartData::Point &point : data.scatter) {
+        const QString color = svgColor(point.influential ? style.influentialColor : style.dataPointColor);
+        const double cx = frame.toX(point.x);
+        const double cy = frame.toY(point.y);
+        svg += QStringLiteral("<circle cx=\"%1\" cy=\"%2\" r=\"4\" fill=\"%3\"/>\n").arg(cx).arg(cy).arg(color);
+        if (point.influential) {
+            svg += QStringLiteral("<circle cx=\"%1\" cy=\"%2\" r=\"8\" fill=\"none\" stroke=\"%3\" stroke-width=\"1.5\"/>\n")
+                       .arg(cx).arg(cy).arg(color);
+        }
+    }
+
+    if (style.showLinearFit && data.hasFit) {
+        for (qsizetype i = 1; i < data.fitLine.size(); ++i) {
+            const ChartData::Point &from = data.fitLine.at(i - 1);
+            const ChartData::Point &to = data.fitLine.at(i);
+            line(frame.toX(from.x), frame.toY(from.y), frame.toX(to.x), frame.toY(to.y), style.fitLineColor, 2);
+        }
+    }
+
+    svg += QStringLiteral("</svg>\n");
+    return svg.toUtf8();
+}
+
+/**
+ * @brief Render a plot to a file
+ * @param data Plot geometry
+ * @param path Output file
+ * @param format Output format
+ * @param style Appearance
+ * @param error Receives a description of the failure, if any
+ * @return True if the file was written
+ */
+bool PlotRenderer::renderToFile(const ChartData &data, const QString &path, Format format,
+                                const Style &style, QString *error)
+{
+    if (format == Format::Png) {
+        // Light compression: plots are mostly flat colour and encode quickly
+        if (!renderImage(data, style).save(path, "PNG", 90)) {
+            if (error) *error = QStringLiteral("Could not write %1").arg(path);
+            return false;
+        }
+        return true;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) *error = QStringLiteral("Could not open %1 for writing: %2").arg(path, file.errorString());
+        return false;
+    }
+    const QByteArray svg = renderSvg(data, style);
+    if (file.write(svg) != svg.size()) {
+        if (error) *error = QStringLiteral("Could not write %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Render one plot per structure in parallel
+ * @param points Points sorted by structure
+ * @param model Structure model of the fits
+ * @param geometry Structure geometry
+ * @param directory Output directory, created if needed
+ * @param prefix File name prefix
+ * @param format Output format
+ * @param style Appearance
+ * @param cancelFlag Optional flag; remaining plots are skipped when it becomes non-zero
+ * @param progress Optional progress callback, invoked from worker threads
+ * @param pool Pool rendering the plots; nullptr for the global pool
+ * @return Number of plots written
+ */
+int PlotRenderer::renderStructures(const QVector<DataPoint> &points, Calculator::FitModel model,
+                                   const Calculator::FitGeometry &geometry, const QString &directory,
+                                   const QString &prefix, Format format, const Style &style, const QAtomicInt *cancelFlag,
+                                   const ProgressCallback &progress, QThreadPool *pool)
+{
+    if (!QDir().mkpath(directory)) {
+        return 0;
+    }
+
+    // Each structure is a contiguous run of the sorted points
+    struct Run {
+        qsizetype begin;
+        qsizetype end;
+    };
+    QVector<Run> runs;
+    for (qsizetype begin = 0; begin < points.size();) {
+        qsizetype end = begin + 1;
+        while (end < points.size() && points.at(end).structure == points.at(begin).structure) {
+            ++end;
+        }
+        runs.append({begin, end});
+        begin = end;
+    }
+
+    const QDir dir(directory);
+    const QString extension = suffix(format);
+    const int total = static_cast<int>(runs.size());
+    QAtomicInt rendered {0};
+    QAtomicInt written {0};
+    WorkerPool::parallelFor(pool, runs.size(), [&](qsizetype first, qsizetype last) {
+        for (qsizetype i = first; i < last; ++i) {
+            if (cancelFlag && cancelFlag->loadAcquire() != 0) {
+                return;
+            }
+            const Run &run = runs.at(i);
+            const QString structure = points.at(run.begin).structure;
+            const ChartData data = chartData(points.mid(run.begin, run.end - run.begin), model, geometry, structure);
+            if (renderToFile(data, dir.filePath(prefix + fileNameFor(structure) + extension), format, style)) {
+                written.fetchAndAddRelaxed(1);
+            }
+            const int done = rendered.fetchAndAddRelaxed(1) + 1;
+            if (progress) progress(done, total);
+        }
+    }, 1);
+    return written.loadAcquire();
+}
+
+QString PlotRenderer::suffix(Format format)
+{
+    return format == Format::Svg ? QStringLiteral(".svg") : QStringLiteral(".png");
+}
+
+bool PlotRenderer::formatFromName(const QString &name, Format &format)
+{
+    if (name.compare(QStringLiteral("png"), Qt::CaseInsensitive) == 0) {
+        format = Format::Png;
+        return true;
+    }
+    if (name.compare(QStringLiteral("svg"), Qt::CaseInsensitive) == 0) {
+        format = Format::Svg;
+        return true;
+    }
+    return false;
+}
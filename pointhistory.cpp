@@ -0,0 +1,543 @@
+#include "include/pointhistory.h"
+#include <QSet>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Pseudo-random treap priority (splitmix64 over a shared counter)
+ */
+quint64 nextPriority()
+{
+    static std::atomic<quint64> state {0};
+    quint64 z = state.fetch_add(0x9E3779B97F4A7C15ULL, std::memory_order_relaxed) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Equality that treats two NaNs as equal, so unreadable values do not count as edits
+ */
+bool sameValue(double a, double b)
+{
+    return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+/**
+ * @brief True if edits can be applied in order to `from` points and leave `to` points
+ */
+bool editsReach(qsizetype from, const QVector<PointEdit> &edits, qsizetype to)
+{
+    if (edits.isEmpty()) {
+        return false;
+    }
+    qsizetype size = from;
+    for (const PointEdit &edit : edits) {
+        const qsizetype limit = edit.kind == PointEdit::Inserted ? size + 1 : size;
+        if (edit.row < 0 || edit.row >= limit) {
+            return false;
+        }
+        if (edit.kind == PointEdit::Inserted) ++size;
+        if (edit.kind == PointEdit::Removed) --size;
+    }
+    return size == to;
+}
+
+} // namespace
+
+/**
+ * @brief Treap node; immutable once shared
+ */
+struct PersistentPoints::Node {
+    DataPoint point;
+    NodePtr left;
+    NodePtr right;
+    qsizetype size = 1;      ///< Points in this subtree
+    quint64 priority = 0;    ///< Heap key; a parent's is never smaller than its children's
+};
+
+/**
+ * @brief Path-copying treap algorithms
+ *
+ * Every function returns a new root and leaves its arguments untouched;
+ * unchanged subtrees are shared, not copied.
+ */
+struct PersistentPoints::Ops {
+    static qsizetype sizeOf(const NodePtr &node)
+    {
+        return node ? node->size : 0;
+    }
+
+    static const DataPoint &at(const Node *node, qsizetype index)
+    {
+        for (;;) {
+            const qsizetype leftSize = sizeOf(node->left);
+            if (index < leftSize) {
+                node = node->left.get();
+            } else if (index > leftSize) {
+                index -= leftSize + 1;
+                node = node->right.get();
+            } else {
+                return node->point;
+            }
+        }
+    }
+
+    static NodePtr make(const DataPoint &point, NodePtr left, NodePtr right, quint64 priority)
+    {
+        auto node = std::make_shared<Node>();
+        node->point = point;
+        node->size = sizeOf(left) + sizeOf(right) + 1;
+        node->left = std::move(left);
+        node->right = std::move(right);
+        node->priority = priority;
+        return node;
+    }
+
+    /**
+     * @brief Split into the first `count` points and the rest
+     */
+    static void split(const NodePtr &node, qsizetype count, NodePtr &first, NodePtr &rest)
+    {
+        if (!node) {
+            first.reset();
+            rest.reset();
+            return;
+        }
+        const qsizetype leftSize = sizeOf(node->left);
+        if (count <= leftSize) {
+            NodePtr leftRest;
+            split(node->left, count, first, leftRest);
+            rest = make(node->point, leftRest, node->right, node->priority);
+        } else {
+            NodePtr rightFirst;
+            split(node->right, count - leftSize - 1, rightFirst, rest);
+            first = make(node->point, node->left, rightFirst, node->priority);
+        }
+    }
+
+    /**
+     * @brief Concatenate two trees
+     */
+    static NodePtr merge(const NodePtr &a, const NodePtr &b)
+    {
+        if (!a) return b;
+        if (!b) return a;
+        if (a->priority >= b->priority) {
+            return make(a->point, a->left, merge(a->right, b), a->priority);
+        }
+        return make(b->point, merge(a, b->left), b->right, b->priority);
+    }
+
+    static NodePtr set(const NodePtr &node, qsizetype index, const DataPoint &point)
+    {
+        const qsizetype leftSize = sizeOf(node->left);
+        if (index < leftSize) {
+            return make(node->point, set(node->left, index, point), node->right, node->priority);
+        }
+        if (index > leftSize) {
+            return make(node->point, node->left, set(node->right, index - leftSize - 1, point), node->priority);
+        }
+        return make(point, node->left, node->right, node->priority);
+    }
+
+    /**
+     * @brief Insert by descending to where the new priority belongs, splitting only there
+     */
+    static NodePtr insert(const NodePtr &node, qsizetype index, const DataPoint &point, quint64 priority)
+    {
+        if (!node || priority > node->priority) {
+            NodePtr first, rest;
+            split(node, index, first, rest);
+            return make(point, first, rest, priority);
+        }
+        const qsizetype leftSize = sizeOf(node->left);
+        if (index <= leftSize) {
+            return make(node->point, insert(node->left, index, point, priority), node->right, node->priority);
+        }
+        return make(node->point, node->left, insert(node->right, index - leftSize - 1, point, priority),
+                    node->priority);
+    }
+
+    static NodePtr remove(const NodePtr &node, qsizetype index)
+    {
+        const qsizetype leftSize = sizeOf(node->left);
+        if (index < leftSize) {
+            return make(node->point, remove(node->left, index), node->right, node->priority);
+        }
+        if (index > leftSize) {
+            return make(node->point, node->left, remove(node->right, index - leftSize - 1), node->priority);
+        }
+        return merge(node->left, node->right);
+    }
+
+    /**
+     * @brief Build the subtree rooted at one index of a Cartesian-tree layout
+     */
+    static NodePtr build(const QVector<DataPoint> &points, const std::vector<quint64> &priorities,
+                         const std::vector<qsizetype> &left, const std::vector<qsizetype> &right, qsizetype index)
+    {
+        if (index < 0) {
+            return NodePtr();
+        }
+        return make(points.at(index), build(points, priorities, left, right, left[index]),
+                    build(points, priorities, left, right, right[index]), priorities[index]);
+    }
+};
+
+/**
+ * @brief Build a sequence from a vector in O(n)
+ *
+ * Draws a priority per point and lays out the treap with the usual stack
+ * construction of a Cartesian tree, then creates the nodes bottom-up.
+ */
+PersistentPoints PersistentPoints::fromVector(const QVector<DataPoint> &points)
+{
+    const qsizetype count = points.size();
+    std::vector<quint64> priorities(count);
+    std::vector<qsizetype> left(count, -1);
+    std::vector<qsizetype> right(count, -1);
+    std::vector<qsizetype> stack;
+    for (qsizetype i = 0; i < count; ++i) {
+        priorities[i] = nextPriority();
+        qsizetype last = -1;
+        while (!stack.empty() && priorities[stack.back()] < priorities[i]) {
+            last = stack.back();
+            stack.pop_back();
+        }
+        left[i] = last;
+        if (!stack.empty()) {
+            right[stack.back()] = i;
+        }
+        stack.push_back(i);
+    }
+    return PersistentPoints(stack.empty() ? NodePtr()
+                                          : Ops::build(points, priorities, left, right, stack.front()));
+}
+
+qsizetype PersistentPoints::size() const
+{
+    return Ops::sizeOf(m_root);
+}
+
+const DataPoint &PersistentPoints::at(qsizetype index) const
+{
+    return Ops::at(m_root.get(), index);
+}
+
+PersistentPoints PersistentPoints::set(qsizetype index, const DataPoint &point) const
+{
+    return PersistentPoints(Ops::set(m_root, index, point));
+}
+
+PersistentPoints PersistentPoints::insert(qsizetype index, const DataPoint &point) const
+{
+    return PersistentPoints(Ops::insert(m_root, index, point, nextPriority()));
+}
+
+PersistentPoints PersistentPoints::remove(qsizetype index) const
+{
+    return PersistentPoints(Ops::remove(m_root, index));
+}
+
+QVector<DataPoint> PersistentPoints::toVector() const
+{
+    QVector<DataPoint> points;
+    points.reserve(size());
+    std::vector<const Node *> stack;
+    const Node *node = m_root.get();
+    while (node || !stack.empty()) {
+        while (node) {
+            stack.push_back(node);
+            node = node->left.get();
+        }
+        node = stack.back();
+        stack.pop_back();
+        points.append(node->point);
+        node = node->right.get();
+    }
+    return points;
+}
+
+/**
+ * @brief Copy that equals a vector, sharing every unchanged point
+ * @param points Target contents
+ * @param maxEdits Give up and rebuild with fromVector() after this many edits; -1 for no limit
+ * @param edits Receives the edits applied, in order; empty if the contents already match or were rebuilt
+ *
+ * Walks this version and `points` side by side while editing a copy, so
+ * that at every step the copy holds `points[0, j)` followed by the not yet
+ * visited rest of this version. A point whose handle matches is replaced if
+ * it changed; an old point that is not wanted any more (or was already
+ * placed) is removed; anything else is inserted. The handle sets are only
+ * built once the handles first disagree, so toggling points costs a single
+ * comparison pass.
+ */
+PersistentPoints PersistentPoints::updated(const QVector<DataPoint> &points, qsizetype maxEdits,
+                                           QVector<PointEdit> *edits) const
+{
+    if (edits) edits->clear();
+    NodePtr result = m_root;
+    qsizetype editCount = 0;
+    QSet<quint64> wanted;
+    QSet<quint64> placed;
+    bool haveSets = false;
+    auto ensureSets = [&](qsizetype from) {
+        if (haveSets) return;
+        haveSets = true;
+        for (qsizetype k = 0; k < points.size(); ++k) {
+            if (points.at(k).handle != 0) {
+                wanted.insert(points.at(k).handle);
+                // Points before `from` were matched in order
+                if (k < from) placed.insert(points.at(k).handle);
+            }
+        }
+    };
+
+    std::vector<const Node *> stack;
+    const Node *next = m_root.get();
+    auto advance = [&]() -> const Node * {
+        while (next) {
+            stack.push_back(next);
+            next = next->left.get();
+        }
+        if (stack.empty()) {
+            return nullptr;
+        }
+        const Node *current = stack.back();
+        stack.pop_back();
+        next = current->right.get();
+        return current;
+    };
+
+    const Node *old = advance();
+    qsizetype j = 0;
+    while (old || j < points.size()) {
+        if (maxEdits >= 0 && editCount > maxEdits) {
+            if (edits) edits->clear();
+            return fromVector(points);
+        }
+        if (old && j < points.size() && old->point.handle != 0 && old->point.handle == points.at(j).handle) {
+            if (!samePoint(old->point, points.at(j))) {
+                result = Ops::set(result, j, points.at(j));
+                if (edits) edits->append(PointEdit {PointEdit::Changed, j, points.at(j)});
+                ++editCount;
+            }
+            if (haveSets) placed.insert(points.at(j).handle);
+            old = advance();
+            ++j;
+            continue;
+        }
+        ensureSets(j);
+        if (old && (j >= points.size() || old->point.handle == 0 || !wanted.contains(old->point.handle)
+                    || placed.contains(old->point.handle))) {
+            result = Ops::remove(result, j);
+            if (edits) edits->append(PointEdit {PointEdit::Removed, j, old->point});
+            ++editCount;
+            old = advance();
+            continue;
+        }
+        result = Ops::insert(result, j, points.at(j), nextPriority());
+        if (edits) edits->append(PointEdit {PointEdit::Inserted, j, points.at(j)});
+        placed.insert(points.at(j).handle);
+        ++editCount;
+        ++j;
+    }
+    return PersistentPoints(result);
+}
+
+/**
+ * @brief Copy with a list of edits applied, O(k log n)
+ * @param edits Edits in order; every row must be valid when its edit is reached
+ * @param inverse Receives the edits that turn the result back into this version, in order
+ *
+ * Each edit is inverted while it is applied, since only then is the point
+ * it replaces or removes at hand; the inverses are undone last to first.
+ */
+PersistentPoints PersistentPoints::applied(const QVector<PointEdit> &edits, QVector<PointEdit> *inverse) const
+{
+    if (inverse) {
+        inverse->clear();
+        inverse->reserve(edits.size());
+    }
+    NodePtr result = m_root;
+    for (const PointEdit &edit : edits) {
+        switch (edit.kind) {
+            case PointEdit::Changed: {
+                const DataPoint &previous = Ops::at(result.get(), edit.row);
+                if (samePoint(previous, edit.point)) {
+                    break;
+                }
+                if (inverse) inverse->append(PointEdit {PointEdit::Changed, edit.row, previous});
+                result = Ops::set(result, edit.row, edit.point);
+                break;
+            }
+            case PointEdit::Inserted:
+                if (inverse) inverse->append(PointEdit {PointEdit::Removed, edit.row, edit.point});
+                result = Ops::insert(result, edit.row, edit.point, nextPriority());
+                break;
+            case PointEdit::Removed:
+                if (inverse) inverse->append(PointEdit {PointEdit::Inserted, edit.row, Ops::at(result.get(), edit.row)});
+                result = Ops::remove(result, edit.row);
+                break;
+        }
+    }
+    if (inverse) {
+        std::reverse(inverse->begin(), inverse->end());
+    }
+    return PersistentPoints(result);
+}
+
+bool PersistentPoints::samePoint(const DataPoint &a, const DataPoint &b)
+{
+    return a.handle == b.handle && a.enabled == b.enabled && sameValue(a.spacing, b.spacing)
+        && sameValue(a.resistance, b.resistance) && sameValue(a.current, b.current)
+        && a.structure == b.structure && a.source == b.source && a.origin == b.origin;
+}
+
+/**
+ * @brief Constructor
+ * @param limit Number of undo steps kept; 0 disables the history
+ */
+PointHistory::PointHistory(int limit)
+    : m_limit(std::max(0, limit))
+{
+}
+
+void PointHistory::setLimit(int limit)
+{
+    m_limit = std::max(0, limit);
+    if (m_limit == 0) {
+        clear();
+    } else {
+        trim();
+    }
+}
+
+/**
+ * @brief Record the current collection as a new entry
+ * @param points Current collection
+ * @param edits Edits that turned the current entry into `points`, if known
+ * @return Version of the current entry; 0 if the history is disabled
+ *
+ * Edits are only trusted if every row is in range and they end at the
+ * size of `points`; otherwise the collection is matched against the
+ * current entry by handle. Past a quarter of the points changed, sharing
+ * saves little and the new entry is built from scratch instead.
+ */
+quint64 PointHistory::record(const QVector<DataPoint> &points, const QVector<PointEdit> &edits)
+{
+    if (m_limit <= 0) {
+        return 0;
+    }
+
+    Entry entry;
+    if (m_current >= 0) {
+        const Entry &current = m_entries.at(m_current);
+        if (editsReach(current.points.size(), edits, points.size())) {
+            entry.points = current.points.applied(edits);
+            entry.edits = edits;
+        } else {
+            entry.points = current.points.updated(points, std::max<qsizetype>(64, points.size() / 4), &entry.edits);
+        }
+        if (entry.points.sharesRootWith(current.points)) {
+            return current.version;
+        }
+        m_entries.resize(m_current + 1);
+    } else {
+        entry.points = PersistentPoints::fromVector(points);
+    }
+    entry.version = m_nextVersion++;
+    m_entries.append(std::move(entry));
+    m_current = m_entries.size() - 1;
+    trim();
+    return m_entries.at(m_current).version;
+}
+
+void PointHistory::clear()
+{
+    m_entries.clear();
+    m_current = -1;
+}
+
+/**
+ * @brief Step back one entry
+ * @param edits Receives the edits from the entry that was current to the new one; empty if unknown
+ * @return False if there is no earlier entry
+ *
+ * The entry being left holds the edits that led to it; they are inverted
+ * against the earlier entry, O(k log n) for k edits.
+ */
+bool PointHistory::undo(QVector<PointEdit> *edits)
+{
+    if (!canUndo()) {
+        return false;
+    }
+    if (edits) {
+        edits->clear();
+        const QVector<PointEdit> &forward = m_entries.at(m_current).edits;
+        if (!forward.isEmpty()) {
+            (void)m_entries.at(m_current - 1).points.applied(forward, edits);
+        }
+    }
+    --m_current;
+    return true;
+}
+
+bool PointHistory::redo(QVector<PointEdit> *edits)
+{
+    if (!canRedo()) {
+        return false;
+    }
+    ++m_current;
+    if (edits) {
+        *edits = m_entries.at(m_current).edits;
+    }
+    return true;
+}
+
+PersistentPoints PointHistory::currentPoints() const
+{
+    return m_current >= 0 ? m_entries.at(m_current).points : PersistentPoints();
+}
+
+quint64 PointHistory::currentVersion() const
+{
+    return m_current >= 0 ? m_entries.at(m_current).version : 0;
+}
+
+/**
+ * @brief Attach a fit to an entry
+ * @param version Version the fit was computed from; ignored if it is no longer in the history
+ * @param fit The fit
+ */
+void PointHistory::cacheFit(quint64 version, const Fit &fit)
+{
+    for (Entry &entry : m_entries) {
+        if (entry.version == version) {
+            entry.fit = std::make_shared<const Fit>(fit);
+            return;
+        }
+    }
+}
+
+const PointHistory::Fit *PointHistory::currentFit() const
+{
+    return m_current >= 0 ? m_entries.at(m_current).fit.get() : nullptr;
+}
+
+/**
+ * @brief Drop the oldest entries beyond the limit
+ */
+void PointHistory::trim()
+{
+    const qsizetype excess = m_entries.size() - (static_cast<qsizetype>(m_limit) + 1);
+    if (excess > 0) {
+        m_entries.remove(0, excess);
+        m_current = std::max<qsizetype>(0, m_current - excess);
+    }
+}
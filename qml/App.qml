@@ -1,4 +0,0 @@
-import QtQuick
-
-import implementation 1.0
-import MainUI 1.0
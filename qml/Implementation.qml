@@ -1,4 +1,5 @@
 import QtQuick
+import TLMAnalyzer
 
 QtObject {
     id: implementation
@@ -31,17 +32,52 @@ QtObject {
     // Minimal wrappers used by MainUI.qml
     function c_loadDataFromFolder() {
         if (typeof DataManager !== 'undefined')
-            DataManager.c_loadDataFromFolder(qml_currentFolder);
+            DataManager.c_loadDataFromFolder(qml_currentFolder, qml_resistanceVoltage);
     }
     function c_performAnalysis() {
         if (typeof DataManager !== 'undefined')
             DataManager.c_performAnalysis(qml_channelWidth);
     }
+    function c_setResistanceVoltage(voltage) {
+        if (typeof DataManager !== 'undefined')
+            DataManager.resistanceVoltage = voltage;
+    }
+    function c_setChannelWidth(width) {
+        if (typeof DataManager !== 'undefined')
+            DataManager.channelWidth = width;
+    }
     function c_setDataPointEnabled(index, enabled) {
         if (typeof DataManager !== 'undefined')
             DataManager.c_setDataPointEnabled(index, enabled);
     }
 
+    // Bulk edits publish a single model and chart update
+    function c_setDataPointsEnabled(indices, enabled) {
+        if (typeof DataManager !== 'undefined')
+            return DataManager.c_setDataPointsEnabled(indices, enabled);
+        return 0;
+    }
+    function c_removeDataPoints(indices) {
+        if (typeof DataManager !== 'undefined')
+            return DataManager.c_removeDataPoints(indices);
+        return 0;
+    }
+    function c_setEnabledWhere(field, op, value, enabled) {
+        if (typeof DataManager !== 'undefined')
+            return DataManager.c_setEnabledWhere(field, op, value, enabled);
+        return 0;
+    }
+    function c_batchUpdate(edits) {
+        if (typeof DataManager === 'undefined')
+            return;
+        DataManager.c_beginUpdate();
+        try {
+            edits();
+        } finally {
+            DataManager.c_commitUpdate();
+        }
+    }
+
     // Chart logic moved from ChartData.qml
     function calculateChartData(points, showLinearFit) {
         var scatterPoints = [];
@@ -63,7 +99,8 @@ QtObject {
                 continue;
             scatterPoints.push({
                 x: p.spacing,
-                y: p.resistance
+                y: p.resistance,
+                influential: p.influential === true
             });
             xs.push(p.spacing);
             ys.push(p.resistance);
@@ -88,20 +125,11 @@ QtObject {
             axisYRange.max = maxY + yPadding;
 
             if (showLinearFit && points.length > 1) {
-                var sx = 0, sy = 0, sxy = 0, sxx = 0, n = 0;
-                for (var j = 0; j < points.length; ++j) {
-                    if (!points[j].enabled)
-                        continue;
-                    var xx = points[j].spacing, yy = points[j].resistance;
-                    sx += xx;
-                    sy += yy;
-                    sxy += xx * yy;
-                    sxx += xx * xx;
-                    n++;
-                }
-                if (n > 1) {
-                    var slope = (n * sxy - sx * sy) / (n * sxx - sx * sx);
-                    var intercept = (sy - slope * sx) / n;
+                // Same compensated regression as the analysis
+                var line = DataManager.c_linearFit();
+                if (line.ok) {
+                    var slope = line.slope;
+                    var intercept = line.intercept;
                     var x1 = axisXRange.min;
                     var x2 = axisXRange.max;
                     var y1 = slope * x1 + intercept;
@@ -139,7 +167,8 @@ QtObject {
                 spacing: item.spacing,
                 resistance: item.resistance,
                 current: item.current,
-                enabled: item.enabled
+                enabled: item.enabled,
+                influential: item.influential
             });
         }
         return arr;
@@ -152,18 +181,22 @@ QtObject {
         }
     }
 
-    // Listen to global DataManager context property (set in main.cpp)
-    Connections {
+    // Listen to the DataManager singleton (a QtObject has no default property)
+    property Connections dataManagerConnections: Connections {
         target: DataManager
 
-        onAnalysisComplete: function (resultMessage) {
+        function onAnalysisComplete(resultMessage) {
             implementation.qml_onAnalysisComplete(resultMessage);
         }
-        onDataChanged: function () {
+        function onDataChanged() {
             implementation.qml_onDataChanged();
         }
-        onProgressUpdated: function (progress) {
+        function onProgressUpdated(progress) {
             implementation.qml_onProgressUpdated(progress);
         }
+        function onConfigLoaded() {
+            implementation.qml_resistanceVoltage = DataManager.getResistanceVoltage();
+            implementation.qml_channelWidth = DataManager.getChannelWidth();
+        }
     }
 }
\ No newline at end of file
@@ -2,7 +2,7 @@ import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
 import QtQuick.Dialogs
-import "./Implementation.qml" as Impl
+import TLMAnalyzer
 
 ApplicationWindow {
     id: mainWindow
@@ -16,6 +16,10 @@ ApplicationWindow {
     property double qml_resistanceVoltage: 1.0
     property double qml_channelWidth: 100.0  // Default channel width in μm
 
+    // Wrappers around DataManager and the chart logic
+    Implementation {
+        id: implementation
+    }
     
     // Animations
     SequentialAnimation {
@@ -42,24 +46,24 @@ ApplicationWindow {
         }
     }
 
-    // Connections from the loaded Implementation object to the UI
+    // Connections from the Implementation object to the UI
     Connections {
-        target: implLoader.item
-        onQml_onAnalysisComplete: function(resultMessage) {
+        target: implementation
+        function onQml_onAnalysisComplete(resultMessage) {
             resultText.text = resultMessage
             completionAnimation.start()
         }
-        onQml_onDataChanged: function() {
+        function onQml_onDataChanged() {
             console.log("Data changed, updating UI")
             updateUIWithData()
         }
-        onQml_onProgressUpdated: function(progress) {
+        function onQml_onProgressUpdated(progress) {
             progressBar.value = progress
             progressBar.visible = (progress > 0 && progress < 100)
             cancelLoadButton.enabled = (progress > 0 && progress < 100)
             if (progress === 100) {
                 console.log("Loading complete — running analysis")
-                if (implLoader.item) implLoader.item.c_performAnalysis()
+                implementation.c_performAnalysis()
             }
         }
     }
@@ -137,7 +141,7 @@ ApplicationWindow {
                 }
 
                 onClicked: {
-                    implLoader.item.c_loadDataFromFolder()
+                    implementation.c_loadDataFromFolder()
                 }
             }
 
@@ -167,8 +171,28 @@ ApplicationWindow {
                 }
                 
                 onClicked: {
-                    // TODO: Implement export plot functionality
-                    console.log("Export button clicked - functionality needs to be implemented")
+                    exportPlotDialog.open()
+                }
+            }
+
+            Button {
+                id: exportResultsButton
+                text: qsTr("Export Results")
+                onClicked: {
+                    exportResultsDialog.open()
+                }
+            }
+
+            // Adds points while the SMU is still writing the folder's files
+            Button {
+                id: followButton
+                text: DataManager.following ? qsTr("Stop Following") : qsTr("Follow Folder")
+                enabled: DataManager.following || qml_currentFolder !== ""
+                onClicked: {
+                    if (DataManager.following)
+                        DataManager.c_stopFollowing()
+                    else
+                        DataManager.c_followFolder(qml_currentFolder)
                 }
             }
             
@@ -214,7 +238,7 @@ ApplicationWindow {
                     delegate: Rectangle {
                         width: dataPointList.width
                         height: 40
-                        color: enabled ? (dataPointList.currentIndex === index ? "#cce5ff" : "transparent") : "#f0f0f0"
+                        color: enabled ? (dataPointList.currentIndex === index ? "#cce5ff" : (influential ? "#fff3cd" : "transparent")) : "#f0f0f0"
 
                         Text {
                             anchors.left: parent.left
@@ -228,8 +252,8 @@ ApplicationWindow {
                             anchors.right: parent.right
                             anchors.rightMargin: 10
                             anchors.verticalCenter: parent.verticalCenter
-                            text: enabled ? "" : qsTr("(Removed)")
-                            color: "red"
+                            text: enabled ? (influential ? qsTr("Influential (D=%1, without: Rsh=%2 Ω/sq)").arg(cooksDistance.toFixed(2)).arg(looSheetResistance.toFixed(2)) : "") : qsTr("(Removed)")
+                            color: enabled ? "#b26a00" : "red"
                         }
 
                         MouseArea {
@@ -259,7 +283,7 @@ ApplicationWindow {
                         enabled: dataPointList.currentIndex >= 0
                         onClicked: {
                             if (dataPointList.currentIndex >= 0) {
-                                implLoader.item.c_setDataPointEnabled(dataPointList.currentIndex, false)
+                                implementation.c_setDataPointEnabled(dataPointList.currentIndex, false)
                                 dataPointList.currentIndex = -1
                                 console.log("Point removed, updating UI")
                                 updateUIWithData()
@@ -272,10 +296,32 @@ ApplicationWindow {
                         text: qsTr("Clear Removed Points")
                         onClicked: {
                             console.log("Clearing disabled points")
-                            implLoader.item.c_clearDisabledDataPoints()
+                            implementation.c_clearDisabledDataPoints()
                             updateUIWithData()
                         }
                     }
+
+                    RowLayout {
+                        Button {
+                            id: undoButton
+                            text: qsTr("Undo")
+                            enabled: DataManager.canUndo
+                            onClicked: {
+                                DataManager.c_undo()
+                                updateUIWithData()
+                            }
+                        }
+
+                        Button {
+                            id: redoButton
+                            text: qsTr("Redo")
+                            enabled: DataManager.canRedo
+                            onClicked: {
+                                DataManager.c_redo()
+                                updateUIWithData()
+                            }
+                        }
+                    }
                     
                     Item {
                         Layout.fillHeight: true
@@ -301,6 +347,7 @@ ApplicationWindow {
                 property string yAxisLabel: "Resistance (Ω)"
                 property color dataPointColor: "#1976D2"
                 property color fitLineColor: "#D32F2F"
+                property color influentialColor: "#F57C00"
                 property color gridColor: "#e0e0e0"
                 property color textColor: "black"
                 property int padding: 50
@@ -402,14 +449,21 @@ ApplicationWindow {
                         ctx.fillText(val.toFixed(2), padding + (plotWidth / 5) * i, height - padding + 15);
                     }
 
-                    // Draw scatter points
-                    ctx.fillStyle = dataPointColor;
+                    // Draw scatter points; influential points get a ring
                     for (i = 0; i < chartData.scatter.length; i++) {
                         var sx = toCanvasX(chartData.scatter[i].x);
                         var sy = toCanvasY(chartData.scatter[i].y);
+                        ctx.fillStyle = chartData.scatter[i].influential ? influentialColor : dataPointColor;
                         ctx.beginPath();
                         ctx.arc(sx, sy, 4 * pointAnimationProgress, 0, 2 * Math.PI);
                         ctx.fill();
+                        if (chartData.scatter[i].influential) {
+                            ctx.beginPath();
+                            ctx.strokeStyle = influentialColor;
+                            ctx.lineWidth = 1.5;
+                            ctx.arc(sx, sy, 8 * pointAnimationProgress, 0, 2 * Math.PI);
+                            ctx.stroke();
+                        }
                     }
 
                     // Draw fit line
@@ -457,8 +511,8 @@ ApplicationWindow {
         plotCanvas.pointAnimationProgress = 0
         plotCanvas.lineAnimationProgress = 0
 
-        var points = implLoader.item.modelToArray()
-        plotCanvas.chartData = implLoader.item.calculateChartData(points, plotCanvas.showLinearFit)
+        var points = implementation.modelToArray()
+        plotCanvas.chartData = implementation.calculateChartData(points, plotCanvas.showLinearFit)
 
         plotAnimation.start()
     }
@@ -470,11 +524,57 @@ ApplicationWindow {
         
         onAccepted: {
             qml_currentFolder = selectedFolder.toString().replace("file:///", "")
-            implLoader.item.qml_currentFolder = qml_currentFolder
+            implementation.qml_currentFolder = qml_currentFolder
             folderPathField.text = qml_currentFolder
         }
     }
     
+    FileDialog {
+        id: exportPlotDialog
+        title: qsTr("Export Plot")
+        fileMode: FileDialog.SaveFile
+        nameFilters: [qsTr("PNG image (*.png)"), qsTr("SVG image (*.svg)")]
+        defaultSuffix: "png"
+
+        onAccepted: {
+            DataManager.c_exportPlot(selectedFile.toString())
+        }
+    }
+
+    FileDialog {
+        id: exportResultsDialog
+        title: qsTr("Export Points and Results")
+        fileMode: FileDialog.SaveFile
+        nameFilters: [qsTr("CSV files (*.csv)"), qsTr("Columnar binary (*.tlmc)")]
+
+        onAccepted: {
+            var format = selectedNameFilter.index === 1 ? "columnar" : "csv"
+            exportResultsButton.enabled = false
+            DataManager.c_exportResults(selectedFile.toString(), format)
+        }
+    }
+
+    Connections {
+        target: DataManager
+        function onExportProgressUpdated(progress) {
+            progressBar.value = progress
+            progressBar.visible = (progress > 0 && progress < 100)
+        }
+        function onExportFinished(ok, message) {
+            exportResultsButton.enabled = true
+            progressBar.visible = false
+            resultText.text = message
+        }
+        function onFollowUpdated(newPoints) {
+            implementation.c_performAnalysis()
+        }
+        // The saved settings arrive shortly after startup
+        function onConfigLoaded() {
+            qml_resistanceVoltage = DataManager.resistanceVoltage
+            qml_channelWidth = DataManager.channelWidth
+        }
+    }
+
     Dialog {
         id: addPointDialog
         title: qsTr("Add Data Point")
@@ -520,7 +620,7 @@ ApplicationWindow {
             if (!isNaN(spacing) && !isNaN(current)) {
                 // Add the data point through implementation
                 // Use the voltage from settings
-                implLoader.item.c_addManualDataPoint(spacing, current, implLoader.item.qml_resistanceVoltage)
+                implementation.c_addManualDataPoint(spacing, current, implementation.qml_resistanceVoltage)
             }
             
             // Clear the fields
@@ -564,7 +664,7 @@ ApplicationWindow {
         standardButtons: Dialog.Ok | Dialog.Cancel
         modal: true
         width: 400
-        height: 300
+        height: 340
         
         onAccepted: {
             // Save the settings
@@ -573,21 +673,24 @@ ApplicationWindow {
             
             if (!isNaN(resistanceVoltage)) {
                 qml_resistanceVoltage = resistanceVoltage
-                implLoader.item.qml_resistanceVoltage = resistanceVoltage
-                implLoader.item.c_setResistanceVoltage(resistanceVoltage)
+                implementation.qml_resistanceVoltage = resistanceVoltage
+                implementation.c_setResistanceVoltage(resistanceVoltage)
             }
             
             if (!isNaN(channelWidth) && channelWidth > 0) {
                 qml_channelWidth = channelWidth
-                implLoader.item.qml_channelWidth = channelWidth
-                implLoader.item.c_setChannelWidth(channelWidth)
+                implementation.qml_channelWidth = channelWidth
+                implementation.c_setChannelWidth(channelWidth)
             }
+
+            DataManager.fitModel = fitModelCombo.currentText
         }
         
         onOpened: {
             // Load current values when dialog opens
             resistanceVoltageField.text = qml_resistanceVoltage.toString()
             channelWidthField.text = qml_channelWidth.toString()
+            fitModelCombo.currentIndex = fitModelCombo.find(DataManager.fitModel)
         }
         
         ColumnLayout {
@@ -628,6 +731,16 @@ ApplicationWindow {
                             top: 1000000.0
                         }
                     }
+
+                    Label {
+                        text: qsTr("Fit Model:")
+                    }
+
+                    ComboBox {
+                        id: fitModelCombo
+                        Layout.fillWidth: true
+                        model: DataManager.c_fitModels()
+                    }
                 }
             }
             
@@ -0,0 +1,362 @@
+#include "include/resultexporter.h"
+#include <QFile>
+#include <QThread>
+#include <QtEndian>
+#include <algorithm>
+#include <charconv>
+#include <memory>
+#include "include/boundedqueue.h"
+
+namespace {
+
+/**
+ * @brief Storage type of a column in the columnar format
+ */
+enum ColumnType : quint8 {
+    Float64 = 0,
+    UInt8 = 1,
+    String = 2
+};
+
+/**
+ * @brief One exported column: a name, a type and an accessor
+ */
+template <typename Row>
+struct Column {
+    const char *name;
+    ColumnType type;
+    double (*number)(const Row &);         ///< Accessor for Float64 and UInt8 columns
+    const QString &(*text)(const Row &);   ///< Accessor for String columns
+};
+
+template <typename Row>
+Column<Row> numberColumn(const char *name, double (*number)(const Row &))
+{
+    return {name, Float64, number, nullptr};
+}
+
+template <typename Row>
+Column<Row> flagColumn(const char *name, double (*number)(const Row &))
+{
+    return {name, UInt8, number, nullptr};
+}
+
+template <typename Row>
+Column<Row> textColumn(const char *name, const QString &(*text)(const Row &))
+{
+    return {name, String, nullptr, text};
+}
+
+/**
+ * @brief UTF-8 bytes of the last string seen in a column
+ *
+ * Structure, source and origin repeat over long runs of points, so most
+ * cells reuse the previous encoding instead of converting again.
+ */
+struct TextCache {
+    QString last;
+    QByteArray utf8;
+    QByteArray csv;
+
+    void update(const QString &text)
+    {
+        if (!utf8.isNull() && text == last) {
+            return;
+        }
+        last = text;
+        utf8 = text.toUtf8();
+        if (utf8.contains(',') || utf8.contains('"') || utf8.contains('\n') || utf8.contains('\r')) {
+            csv = '"' + QByteArray(utf8).replace("\"", "\"\"") + '"';
+        } else {
+            csv = utf8;
+        }
+    }
+};
+
+void appendNumber(QByteArray &out, double value)
+{
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr - buffer);
+}
+
+template <typename T>
+void appendLittleEndian(QByteArray &out, T value)
+{
+    char buffer[sizeof(T)];
+    qToLittleEndian(value, buffer);
+    out.append(buffer, sizeof(T));
+}
+
+/**
+ * @brief Writes chunks to a file on a dedicated thread
+ */
+class ChunkWriter {
+public:
+    ChunkWriter(const QString &path, int capacity, const QAtomicInt *cancelFlag)
+        : m_file(path), m_queue(capacity), m_cancelFlag(cancelFlag)
+    {
+    }
+
+    ~ChunkWriter()
+    {
+        if (m_thread) {
+            m_stop.storeRelease(1);
+            m_thread->wait();
+        }
+    }
+
+    bool open(QString *error)
+    {
+        if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            if (error) *error = QStringLiteral("Could not open %1 for writing: %2").arg(m_file.fileName(), m_file.errorString());
+            return false;
+        }
+        m_thread.reset(QThread::create([this]() {
+            QByteArray chunk;
+            while (m_queue.pop(chunk, &m_stop)) {
+                if (m_file.write(chunk) != chunk.size()) {
+                    m_failed.storeRelease(1);
+                    m_stop.storeRelease(1);
+                }
+            }
+        }));
+        m_thread->start();
+        return true;
+    }
+
+    /**
+     * @brief Queue a chunk, waiting while the queue is full
+     * @return False if the export was cancelled or the writer failed
+     */
+    bool push(QByteArray &&chunk)
+    {
+        if (m_cancelFlag && m_cancelFlag->loadAcquire() != 0) {
+            m_stop.storeRelease(1);
+        }
+        return m_stop.loadAcquire() == 0 && m_queue.push(std::move(chunk), &m_stop);
+    }
+
+    /**
+     * @brief Drain the queue, stop the writer and close the file
+     * @return True if every chunk was written
+     */
+    bool finish(QString *error)
+    {
+        m_queue.close();
+        m_thread->wait();
+        m_thread.reset();
+        const bool flushed = m_file.flush();
+        m_file.close();
+        if (m_failed.loadAcquire() != 0 || !flushed) {
+            if (error) *error = QStringLiteral("Could not write %1: %2").arg(m_file.fileName(), m_file.errorString());
+            return false;
+        }
+        if (m_stop.loadAcquire() != 0) {
+            if (error) *error = QStringLiteral("Export cancelled");
+            return false;
+        }
+        return true;
+    }
+
+private:
+    QFile m_file;
+    BoundedQueue<QByteArray> m_queue;
+    const QAtomicInt *m_cancelFlag;
+    QAtomicInt m_stop {0};
+    QAtomicInt m_failed {0};
+    std::unique_ptr<QThread> m_thread;
+};
+
+/**
+ * @brief Stream a table to one file in the requested format
+ * @param reportRows Progress callback taking the number of rows completed
+ */
+template <typename Row>
+bool writeTable(const QVector<Row> &rows, const QVector<Column<Row>> &columns, const QString &path,
+                const ResultExporter::Options &options, QString *error, const QAtomicInt *cancelFlag,
+                const std::function<void(qsizetype)> &reportRows)
+{
+    ChunkWriter writer(path, options.queueCapacity, cancelFlag);
+    if (!writer.open(error)) {
+        return false;
+    }
+
+    const qsizetype chunkRows = std::max<qsizetype>(1, options.chunkRows);
+    QVector<TextCache> caches(columns.size());
+    bool ok = true;
+
+    if (options.format == ResultExporter::Format::Csv) {
+        QByteArray header;
+        for (qsizetype c = 0; c < columns.size(); ++c) {
+            header += (c ? "," : "") + QByteArray(columns[c].name);
+        }
+        header += '\n';
+        ok = writer.push(std::move(header));
+
+        for (qsizetype begin = 0; ok && begin < rows.size(); begin += chunkRows) {
+            const qsizetype end = std::min(begin + chunkRows, rows.size());
+            QByteArray chunk;
+            chunk.reserve((end - begin) * 16 * columns.size());
+            for (qsizetype r = begin; r < end; ++r) {
+                for (qsizetype c = 0; c < columns.size(); ++c) {
+                    if (c) chunk += ',';
+                    const Column<Row> &column = columns[c];
+                    if (column.type == String) {
+                        caches[c].update(column.text(rows[r]));
+                        chunk += caches[c].csv;
+                    } else {
+                        appendNumber(chunk, column.number(rows[r]));
+                    }
+                }
+                chunk += '\n';
+            }
+            ok = writer.push(std::move(chunk));
+            if (reportRows) reportRows(end);
+        }
+    } else {
+        QByteArray header("TLMCOL1", 8);
+        appendLittleEndian<quint32>(header, static_cast<quint32>(columns.size()));
+        appendLittleEndian<quint64>(header, static_cast<quint64>(rows.size()));
+        ok = writer.push(std::move(header));
+
+        for (qsizetype c = 0; ok && c < columns.size(); ++c) {
+            const Column<Row> &column = columns[c];
+            QByteArray chunk(column.name);
+            chunk.prepend(QByteArray(2, '\0'));
+            qToLittleEndian<quint16>(static_cast<quint16>(chunk.size() - 2), chunk.data());
+            chunk += static_cast<char>(column.type);
+
+            for (qsizetype begin = 0; ok && begin < rows.size(); begin += chunkRows) {
+                const qsizetype end = std::min(begin + chunkRows, rows.size());
+                chunk.reserve(chunk.size() + (end - begin) * 8);
+                for (qsizetype r = begin; r < end; ++r) {
+                    if (column.type == Float64) {
+                        appendLittleEndian<double>(chunk, column.number(rows[r]));
+                    } else if (column.type == UInt8) {
+                        chunk += static_cast<char>(column.number(rows[r]) != 0.0);
+                    } else {
+                        caches[c].update(column.text(rows[r]));
+                        appendLittleEndian<quint32>(chunk, static_cast<quint32>(caches[c].utf8.size()));
+                        chunk += caches[c].utf8;
+                    }
+                }
+                ok = writer.push(std::move(chunk));
+                chunk = QByteArray();
+                if (reportRows) reportRows((c * rows.size() + end) / columns.size());
+            }
+            if (ok && !chunk.isEmpty()) {
+                ok = writer.push(std::move(chunk));
+            }
+        }
+    }
+
+    // finish() reports the reason when a push was refused
+    return writer.finish(error) && ok;
+}
+
+QVector<Column<DataPoint>> pointColumns()
+{
+    return {
+        textColumn<DataPoint>("structure", [](const DataPoint &p) -> const QString & { return p.structure; }),
+        textColumn<DataPoint>("source", [](const DataPoint &p) -> const QString & { return p.source; }),
+        textColumn<DataPoint>("origin", [](const DataPoint &p) -> const QString & { return p.origin; }),
+        numberColumn<DataPoint>("spacing_um", [](const DataPoint &p) { return p.spacing; }),
+        numberColumn<DataPoint>("resistance_ohm", [](const DataPoint &p) { return p.resistance; }),
+        numberColumn<DataPoint>("current_a", [](const DataPoint &p) { return p.current; }),
+        flagColumn<DataPoint>("enabled", [](const DataPoint &p) { return p.enabled ? 1.0 : 0.0; }),
+    };
+}
+
+QVector<Column<ResultExporter::ResultRow>> resultColumns()
+{
+    using Row = ResultExporter::ResultRow;
+    return {
+        textColumn<Row>("structure", [](const Row &r) -> const QString & { return r.structure; }),
+        textColumn<Row>("model", [](const Row &r) -> const QString & { return r.model; }),
+        numberColumn<Row>("slope_ohm_per_um", [](const Row &r) { return r.result.slope; }),
+        numberColumn<Row>("intercept_ohm", [](const Row &r) { return r.result.intercept; }),
+        numberColumn<Row>("r_squared", [](const Row &r) { return r.result.rSquared; }),
+        numberColumn<Row>("sheet_resistance_ohm_sq", [](const Row &r) { return r.result.sheetResistance; }),
+        numberColumn<Row>("contact_resistance_ohm", [](const Row &r) { return r.result.contactResistance; }),
+        numberColumn<Row>("specific_contact_resistivity_ohm_cm2", [](const Row &r) { return r.result.specificContactResistivity; }),
+        numberColumn<Row>("transfer_length_um", [](const Row &r) { return r.result.transferLength; }),
+        numberColumn<Row>("end_resistance_ohm", [](const Row &r) { return r.result.endResistance; }),
+        numberColumn<Row>("channel_width_um", [](const Row &r) { return r.result.channelWidth; }),
+    };
+}
+
+} // namespace
+
+/**
+ * @brief Export points and results next to each other
+ * @param points Points to export, in collection order
+ * @param results Fitted structures
+ * @param basePath Output path without suffix
+ * @param options Export settings
+ * @param error Receives a description of the failure, if any
+ * @param cancelFlag Optional flag; the export stops when it becomes non-zero
+ * @param progress Optional progress callback
+ * @return True if both files were written completely
+ */
+bool ResultExporter::exportAll(const QVector<DataPoint> &points, const QVector<ResultRow> &results,
+                               const QString &basePath, const Options &options, QString *error,
+                               const QAtomicInt *cancelFlag, const ProgressCallback &progress)
+{
+    const QString extension = suffix(options.format);
+    return writeResults(results, basePath + QStringLiteral("_results") + extension, options, error, cancelFlag)
+        && writePoints(points, basePath + QStringLiteral("_points") + extension, options, error, cancelFlag, progress);
+}
+
+/**
+ * @brief Export points to one file
+ * @param points Points to export
+ * @param path Output file
+ * @param options Export settings
+ * @param error Receives a description of the failure, if any
+ * @param cancelFlag Optional flag; the export stops when it becomes non-zero
+ * @param progress Optional progress callback
+ * @return True if the file was written completely
+ */
+bool ResultExporter::writePoints(const QVector<DataPoint> &points, const QString &path, const Options &options,
+                                 QString *error, const QAtomicInt *cancelFlag, const ProgressCallback &progress)
+{
+    const qsizetype total = points.size();
+    return writeTable(points, pointColumns(), path, options, error, cancelFlag, [&](qsizetype rows) {
+        if (progress) progress(rows, total);
+    });
+}
+
+/**
+ * @brief Export fitted structures to one file
+ * @param results Fitted structures
+ * @param path Output file
+ * @param options Export settings
+ * @param error Receives a description of the failure, if any
+ * @param cancelFlag Optional flag; the export stops when it becomes non-zero
+ * @return True if the file was written completely
+ */
+bool ResultExporter::writeResults(const QVector<ResultRow> &results, const QString &path, const Options &options,
+                                  QString *error, const QAtomicInt *cancelFlag)
+{
+    return writeTable(results, resultColumns(), path, options, error, cancelFlag, {});
+}
+
+QString ResultExporter::suffix(Format format)
+{
+    return format == Format::Columnar ? QStringLiteral(".tlmc") : QStringLiteral(".csv");
+}
+
+bool ResultExporter::formatFromName(const QString &name, Format &format)
+{
+    if (name.compare(QStringLiteral("csv"), Qt::CaseInsensitive) == 0) {
+        format = Format::Csv;
+        return true;
+    }
+    if (name.compare(QStringLiteral("columnar"), Qt::CaseInsensitive) == 0
+        || name.compare(QStringLiteral("tlmc"), Qt::CaseInsensitive) == 0) {
+        format = Format::Columnar;
+        return true;
+    }
+    return false;
+}
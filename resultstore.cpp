@@ -0,0 +1,572 @@
+#include "include/resultstore.h"
+#include "include/filenameindex.h"
+#include <QAtomicInt>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QDebug>
+
+namespace {
+
+constexpr int SchemaVersion = 1;
+
+// Columns read back into a Record, in the order of recordFromQuery()
+const char *const SelectColumns =
+    "id, recorded_at, lot, wafer, die, structure, folder, model, points, res_voltage, channel_width, "
+    "slope, intercept, r_squared, sheet_resistance, contact_resistance, specific_contact_resistivity, "
+    "transfer_length, end_resistance";
+
+/**
+ * @brief A queryable field and the column behind it
+ */
+struct Column {
+    const char *name;
+    bool numeric;
+};
+
+const QHash<QString, Column> &queryFields()
+{
+    static const QHash<QString, Column> fields {
+        {QStringLiteral("lot"), {"lot", false}},
+        {QStringLiteral("wafer"), {"wafer", false}},
+        {QStringLiteral("die"), {"die", false}},
+        {QStringLiteral("structure"), {"structure", false}},
+        {QStringLiteral("folder"), {"folder", false}},
+        {QStringLiteral("model"), {"model", false}},
+        {QStringLiteral("points"), {"points", true}},
+        {QStringLiteral("width"), {"channel_width", true}},
+        {QStringLiteral("slope"), {"slope", true}},
+        {QStringLiteral("intercept"), {"intercept", true}},
+        {QStringLiteral("r2"), {"r_squared", true}},
+        {QStringLiteral("rsh"), {"sheet_resistance", true}},
+        {QStringLiteral("rc"), {"contact_resistance", true}},
+        {QStringLiteral("rho_c"), {"specific_contact_resistivity", true}},
+        {QStringLiteral("lt"), {"transfer_length", true}},
+        {QStringLiteral("re"), {"end_resistance", true}}
+    };
+    return fields;
+}
+
+const char *sqlOperator(FilenameIndex::Op op)
+{
+    switch (op) {
+    case FilenameIndex::Op::Equal:        return "=";
+    case FilenameIndex::Op::NotEqual:     return "<>";
+    case FilenameIndex::Op::Less:         return "<";
+    case FilenameIndex::Op::LessEqual:    return "<=";
+    case FilenameIndex::Op::Greater:      return ">";
+    case FilenameIndex::Op::GreaterEqual: return ">=";
+    }
+    return "=";
+}
+
+/**
+ * @brief Start of a local calendar day in ms since the epoch
+ */
+qint64 dayStart(const QDate &date)
+{
+    return QDateTime(date, QTime(0, 0)).toMSecsSinceEpoch();
+}
+
+ResultStore::Record recordFromQuery(const QSqlQuery &query)
+{
+    ResultStore::Record record;
+    record.id = query.value(0).toLongLong();
+    record.recordedAt = QDateTime::fromMSecsSinceEpoch(query.value(1).toLongLong());
+    record.lot = query.value(2).toString();
+    record.wafer = query.value(3).toString();
+    record.die = query.value(4).toString();
+    record.structure = query.value(5).toString();
+    record.folder = query.value(6).toString();
+    record.model = query.value(7).toString();
+    record.points = query.value(8).toInt();
+    record.resVoltage = query.value(9).toDouble();
+    record.result.channelWidth = query.value(10).toDouble();
+    record.result.slope = query.value(11).toDouble();
+    record.result.intercept = query.value(12).toDouble();
+    record.result.rSquared = query.value(13).toDouble();
+    record.result.sheetResistance = query.value(14).toDouble();
+    record.result.contactResistance = query.value(15).toDouble();
+    record.result.specificContactResistivity = query.value(16).toDouble();
+    record.result.transferLength = query.value(17).toDouble();
+    record.result.endResistance = query.value(18).toDouble();
+    return record;
+}
+
+bool fail(QString *error, const QString &message)
+{
+    if (error) {
+        *error = message;
+    }
+    qDebug() << "Result store:" << message;
+    return false;
+}
+
+} // namespace
+
+/**
+ * @brief Constructor; nothing is opened yet
+ * @param path Database file
+ */
+ResultStore::ResultStore(const QString &path)
+    : m_path(path)
+{
+    static QAtomicInt instances {0};
+    m_connection = QStringLiteral("tlm_results_%1").arg(instances.fetchAndAddRelaxed(1));
+}
+
+/**
+ * @brief Destructor; closes the connection
+ *
+ * The QSqlDatabase handle must be gone before the connection is removed.
+ */
+ResultStore::~ResultStore()
+{
+    if (!m_open) {
+        return;
+    }
+    {
+        QSqlDatabase db = QSqlDatabase::database(m_connection, false);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(m_connection);
+}
+
+/**
+ * @brief Open the database and create the schema if needed
+ * @param error Receives a description of the problem, if any
+ * @return False if the file cannot be opened or is not a results store
+ *
+ * The database runs in WAL mode, so the application and a CLI run can read
+ * while the other one appends.
+ */
+bool ResultStore::open(QString *error)
+{
+    if (m_open) {
+        return true;
+    }
+    if (!QSqlDatabase::isDriverAvailable(QStringLiteral("QSQLITE"))) {
+        return fail(error, QStringLiteral("The Qt SQLite driver is not available"));
+    }
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), m_connection);
+        db.setDatabaseName(m_path);
+        if (!db.open()) {
+            const QString message = db.lastError().text();
+            db = QSqlDatabase();
+            QSqlDatabase::removeDatabase(m_connection);
+            return fail(error, QStringLiteral("Cannot open %1: %2").arg(m_path, message));
+        }
+
+        QSqlQuery query(db);
+        query.exec(QStringLiteral("PRAGMA journal_mode=WAL"));
+        query.exec(QStringLiteral("PRAGMA synchronous=NORMAL"));
+        const int version = query.exec(QStringLiteral("PRAGMA user_version")) && query.next() ? query.value(0).toInt() : -1;
+        if (version > SchemaVersion) {
+            fail(error, QStringLiteral("%1 was written by a newer version (schema %2)").arg(m_path).arg(version));
+        } else if (version < 0) {
+            fail(error, QStringLiteral("%1 is not a database: %2").arg(m_path, query.lastError().text()));
+        } else {
+            // Text columns compare case-insensitively, as filename queries do
+            static const char *const schema[] = {
+                "CREATE TABLE IF NOT EXISTS results ("
+                "id INTEGER PRIMARY KEY, recorded_at INTEGER NOT NULL, "
+                "lot TEXT COLLATE NOCASE, wafer TEXT COLLATE NOCASE, die TEXT COLLATE NOCASE, "
+                "structure TEXT COLLATE NOCASE, folder TEXT, model TEXT COLLATE NOCASE, "
+                "points INTEGER, res_voltage REAL, channel_width REAL, slope REAL, intercept REAL, r_squared REAL, "
+                "sheet_resistance REAL, contact_resistance REAL, specific_contact_resistivity REAL, "
+                "transfer_length REAL, end_resistance REAL)",
+                "CREATE INDEX IF NOT EXISTS results_by_die ON results (lot, wafer, die, recorded_at)",
+                "CREATE INDEX IF NOT EXISTS results_by_time ON results (recorded_at)",
+                "CREATE INDEX IF NOT EXISTS results_by_structure ON results (structure)",
+                "CREATE UNIQUE INDEX IF NOT EXISTS results_by_key ON results (folder, structure, model)"
+            };
+            ok = true;
+            for (const char *statement : schema) {
+                if (!query.exec(QString::fromLatin1(statement))) {
+                    ok = fail(error, QStringLiteral("Cannot create the schema: %1").arg(query.lastError().text()));
+                    break;
+                }
+            }
+            if (ok && version < SchemaVersion) {
+                query.exec(QStringLiteral("PRAGMA user_version=%1").arg(SchemaVersion));
+            }
+        }
+        if (!ok) {
+            db.close();
+        }
+    }
+    if (!ok) {
+        QSqlDatabase::removeDatabase(m_connection);
+        return false;
+    }
+    m_open = true;
+    return true;
+}
+
+/**
+ * @brief Store records in one transaction, replacing older results of the same structures
+ * @param records Records to store; their ids are filled in
+ * @param error Receives a description of the problem, if any
+ * @return False if nothing was stored
+ *
+ * One prepared statement is bound per record; a single commit keeps the
+ * cost to one fsync however many structures were fitted. A record replaces
+ * the stored row with the same folder, structure and model, so analysing
+ * a die again does not give it more weight in counts and trends. Empty
+ * keys are stored as '' rather than NULL, which the unique index would
+ * treat as always distinct.
+ */
+bool ResultStore::insert(QVector<Record> &records, QString *error)
+{
+    if (!m_open) {
+        return fail(error, QStringLiteral("The result store is not open"));
+    }
+    if (records.isEmpty()) {
+        return true;
+    }
+
+    QSqlDatabase db = QSqlDatabase::database(m_connection, false);
+    if (!db.transaction()) {
+        return fail(error, db.lastError().text());
+    }
+    QSqlQuery query(db);
+    query.prepare(QStringLiteral(
+        "INSERT OR REPLACE INTO results (recorded_at, lot, wafer, die, structure, folder, model, points, res_voltage, "
+        "channel_width, slope, intercept, r_squared, sheet_resistance, contact_resistance, "
+        "specific_contact_resistivity, transfer_length, end_resistance) "
+        "VALUES (?, ?, ?, ?, COALESCE(?, ''), COALESCE(?, ''), COALESCE(?, ''), ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
+    for (Record &record : records) {
+        const Calculator::TLMResult &r = record.result;
+        query.addBindValue(record.recordedAt.toMSecsSinceEpoch());
+        query.addBindValue(record.lot);
+        query.addBindValue(record.wafer);
+        query.addBindValue(record.die);
+        query.addBindValue(record.structure);
+        query.addBindValue(record.folder);
+        query.addBindValue(record.model);
+        query.addBindValue(record.points);
+        query.addBindValue(record.resVoltage);
+        query.addBindValue(r.channelWidth);
+        query.addBindValue(r.slope);
+        query.addBindValue(r.intercept);
+        query.addBindValue(r.rSquared);
+        query.addBindValue(r.sheetResistance);
+        query.addBindValue(r.contactResistance);
+        query.addBindValue(r.specificContactResistivity);
+        query.addBindValue(r.transferLength);
+        query.addBindValue(r.endResistance);
+        if (!query.exec()) {
+            const QString message = query.lastError().text();
+            db.rollback();
+            return fail(error, QStringLiteral("Cannot store results: %1").arg(message));
+        }
+        record.id = query.lastInsertId().toLongLong();
+    }
+    if (!db.commit()) {
+        const QString message = db.lastError().text();
+        db.rollback();
+        return fail(error, QStringLiteral("Cannot store results: %1").arg(message));
+    }
+    return true;
+}
+
+/**
+ * @brief Translate a query into a WHERE clause with positional parameters
+ * @param query Conditions in FilenameIndex syntax
+ * @param clause Receives " WHERE ..." or an empty string
+ * @param values Receives the values to bind, in order
+ * @param error Receives a description of the problem, if any
+ *
+ * Values are always bound, never spliced into the SQL. Dates become
+ * ranges of recorded_at, so the time index stays usable.
+ */
+bool ResultStore::whereClause(const QString &query, QString &clause, QVariantList &values, QString *error)
+{
+    QVector<FilenameIndex::Condition> conditions;
+    if (!FilenameIndex::parseQuery(query, conditions, error)) {
+        return false;
+    }
+
+    QStringList terms;
+    for (const FilenameIndex::Condition &condition : conditions) {
+        if (condition.field == QLatin1String("date")) {
+            QVector<QDate> dates;
+            for (const QString &value : condition.values) {
+                const QDate date = QDate::fromString(value, Qt::ISODate);
+                if (!date.isValid()) {
+                    return fail(error, QStringLiteral("Invalid date \"%1\"; use yyyy-MM-dd").arg(value));
+                }
+                dates.append(date);
+            }
+            const QDate date = dates.constFirst();
+            switch (condition.op) {
+            case FilenameIndex::Op::Equal: {
+                QStringList ranges;
+                for (const QDate &day : dates) {
+                    ranges.append(QStringLiteral("(recorded_at >= ? AND recorded_at < ?)"));
+                    values << dayStart(day) << dayStart(day.addDays(1));
+                }
+                terms.append(QLatin1Char('(') + ranges.join(QStringLiteral(" OR ")) + QLatin1Char(')'));
+                break;
+            }
+            case FilenameIndex::Op::NotEqual:
+                terms.append(QStringLiteral("(recorded_at < ? OR recorded_at >= ?)"));
+                values << dayStart(date) << dayStart(date.addDays(1));
+                break;
+            case FilenameIndex::Op::Less:
+                terms.append(QStringLiteral("recorded_at < ?"));
+                values << dayStart(date);
+                break;
+            case FilenameIndex::Op::LessEqual:
+                terms.append(QStringLiteral("recorded_at < ?"));
+                values << dayStart(date.addDays(1));
+                break;
+            case FilenameIndex::Op::Greater:
+                terms.append(QStringLiteral("recorded_at >= ?"));
+                values << dayStart(date.addDays(1));
+                break;
+            case FilenameIndex::Op::GreaterEqual:
+                terms.append(QStringLiteral("recorded_at >= ?"));
+                values << dayStart(date);
+                break;
+            }
+            continue;
+        }
+
+        const auto it = queryFields().constFind(condition.field);
+        if (it == queryFields().constEnd()) {
+            QStringList names = queryFields().keys();
+            names.append(QStringLiteral("date"));
+            names.sort();
+            return fail(error, QStringLiteral("Unknown field \"%1\"; available: %2")
+                                   .arg(condition.field, names.join(QStringLiteral(", "))));
+        }
+        const QString column = QString::fromLatin1(it->name);
+        QVariantList bound;
+        for (const QString &value : condition.values) {
+            if (it->numeric) {
+                bool ok = false;
+                const double number = value.toDouble(&ok);
+                if (!ok) {
+                    return fail(error, QStringLiteral("\"%1\" needs a number, not \"%2\"").arg(condition.field, value));
+                }
+                bound.append(number);
+            } else {
+                bound.append(value);
+            }
+        }
+        if (condition.op == FilenameIndex::Op::Equal && bound.size() > 1) {
+            QStringList placeholders;
+            for (qsizetype i = 0; i < bound.size(); ++i) {
+                placeholders.append(QStringLiteral("?"));
+            }
+            terms.append(column + QStringLiteral(" IN (") + placeholders.join(QStringLiteral(", ")) + QLatin1Char(')'));
+        } else {
+            terms.append(column + QLatin1Char(' ') + QLatin1String(sqlOperator(condition.op)) + QStringLiteral(" ?"));
+        }
+        values += bound;
+    }
+
+    clause = terms.isEmpty() ? QString() : QStringLiteral(" WHERE ") + terms.join(QStringLiteral(" AND "));
+    return true;
+}
+
+/**
+ * @brief Records matching a query, newest first
+ */
+QVector<ResultStore::Record> ResultStore::query(const QString &query, int limit, QString *error) const
+{
+    QVector<Record> records;
+    if (!m_open) {
+        fail(error, QStringLiteral("The result store is not open"));
+        return records;
+    }
+    QString clause;
+    QVariantList values;
+    if (!whereClause(query, clause, values, error)) {
+        return records;
+    }
+
+    QSqlQuery sql(QSqlDatabase::database(m_connection, false));
+    sql.setForwardOnly(true);
+    QString text = QStringLiteral("SELECT %1 FROM results%2 ORDER BY recorded_at DESC, id DESC")
+                       .arg(QLatin1String(SelectColumns), clause);
+    if (limit > 0) {
+        text += QStringLiteral(" LIMIT %1").arg(limit);
+    }
+    sql.prepare(text);
+    for (const QVariant &value : std::as_const(values)) {
+        sql.addBindValue(value);
+    }
+    if (!sql.exec()) {
+        fail(error, sql.lastError().text());
+        return records;
+    }
+    while (sql.next()) {
+        records.append(recordFromQuery(sql));
+    }
+    return records;
+}
+
+/**
+ * @brief Per-group statistics of one quantity
+ *
+ * Aggregated by SQLite, so only one row per group leaves the database.
+ */
+QVector<ResultStore::TrendRow> ResultStore::trend(const QString &query, const QString &groupBy,
+                                                  const QString &quantity, QString *error) const
+{
+    QVector<TrendRow> rows;
+    if (!m_open) {
+        fail(error, QStringLiteral("The result store is not open"));
+        return rows;
+    }
+
+    const QString group = groupBy.toLower();
+    QString key;
+    if (group == QLatin1String("day")) {
+        key = QStringLiteral("date(recorded_at / 1000, 'unixepoch', 'localtime')");
+    } else if (group == QLatin1String("month")) {
+        key = QStringLiteral("strftime('%Y-%m', recorded_at / 1000, 'unixepoch', 'localtime')");
+    } else if (queryFields().contains(group) && !queryFields().value(group).numeric) {
+        key = QString::fromLatin1(queryFields().value(group).name);
+    } else {
+        fail(error, QStringLiteral("Cannot group by \"%1\"; use lot, wafer, die, structure, model, folder, day or month")
+                        .arg(groupBy));
+        return rows;
+    }
+    const auto column = queryFields().constFind(quantity.toLower());
+    if (column == queryFields().constEnd() || !column->numeric) {
+        fail(error, QStringLiteral("\"%1\" is not a numeric result column").arg(quantity));
+        return rows;
+    }
+    const QString value = QString::fromLatin1(column->name);
+
+    QString clause;
+    QVariantList values;
+    if (!whereClause(query, clause, values, error)) {
+        return rows;
+    }
+
+    QSqlQuery sql(QSqlDatabase::database(m_connection, false));
+    sql.setForwardOnly(true);
+    sql.prepare(QStringLiteral("SELECT %1 AS k, COUNT(*), AVG(%2), MIN(%2), MAX(%2) FROM results%3 GROUP BY k ORDER BY k")
+                    .arg(key, value, clause));
+    for (const QVariant &bound : std::as_const(values)) {
+        sql.addBindValue(bound);
+    }
+    if (!sql.exec()) {
+        fail(error, sql.lastError().text());
+        return rows;
+    }
+    while (sql.next()) {
+        TrendRow row;
+        row.key = sql.value(0).toString();
+        row.count = sql.value(1).toLongLong();
+        row.mean = sql.value(2).toDouble();
+        row.minimum = sql.value(3).toDouble();
+        row.maximum = sql.value(4).toDouble();
+        rows.append(row);
+    }
+    return rows;
+}
+
+qint64 ResultStore::count() const
+{
+    if (!m_open) {
+        return 0;
+    }
+    QSqlQuery sql(QSqlDatabase::database(m_connection, false));
+    return sql.exec(QStringLiteral("SELECT COUNT(*) FROM results")) && sql.next() ? sql.value(0).toLongLong() : 0;
+}
+
+/**
+ * @brief Database file configured for an application configuration
+ */
+QString ResultStore::pathFor(const AppConfig &config)
+{
+    if (config.results_db.isEmpty() || QDir::isAbsolutePath(config.results_db)) {
+        return config.results_db;
+    }
+    return QFileInfo(config.getConfigFile()).absoluteDir().filePath(config.results_db);
+}
+
+/**
+ * @brief Records for the structures of a fitted point set
+ *
+ * Folder and source of a structure are taken from its first point.
+ */
+QVector<ResultStore::Record> ResultStore::recordsFor(const QVector<DataPoint> &points,
+                                                     const QMap<QString, Calculator::TLMResult> &results,
+                                                     const QString &model, double resVoltage,
+                                                     const QStringList &pathLevels, const QDateTime &recordedAt)
+{
+    struct Seen {
+        int enabled = 0;
+        QString origin;
+        QString source;
+    };
+    QHash<QString, Seen> structures;
+    for (const DataPoint &point : points) {
+        auto it = structures.find(point.structure);
+        if (it == structures.end()) {
+            it = structures.insert(point.structure, Seen {0, point.origin, point.source});
+        }
+        if (point.enabled) {
+            ++it->enabled;
+        }
+    }
+
+    QVector<Record> records;
+    records.reserve(results.size());
+    for (auto it = results.cbegin(); it != results.cend(); ++it) {
+        const Seen seen = structures.value(it.key());
+        Record record;
+        record.recordedAt = recordedAt;
+        record.structure = it.key();
+        record.folder = seen.origin;
+        record.model = model;
+        record.points = seen.enabled;
+        record.resVoltage = resVoltage;
+        record.result = it.value();
+        provenance(record, seen.source, pathLevels);
+        records.append(record);
+    }
+    return records;
+}
+
+/**
+ * @brief Fill lot, wafer and die from the path of a structure
+ *
+ * The path is the folder followed by the structure's folder components.
+ * A structure already prefixed with the folder's name (several folders
+ * loaded at once) is not counted twice.
+ */
+void ResultStore::provenance(Record &record, const QString &source, const QStringList &pathLevels)
+{
+    QStringList components = QDir::fromNativeSeparators(record.folder).split(QLatin1Char('/'), Qt::SkipEmptyParts);
+    QStringList structure = record.structure.split(QLatin1Char('/'), Qt::SkipEmptyParts);
+    if (!source.isEmpty() && !structure.isEmpty() && structure.constLast() == source) {
+        structure.removeLast();
+    }
+    if (!components.isEmpty() && !structure.isEmpty() && structure.constFirst() == components.constLast()) {
+        structure.removeFirst();
+    }
+    components += structure;
+
+    const qsizetype first = components.size() - pathLevels.size();
+    for (qsizetype i = 0; i < pathLevels.size(); ++i) {
+        const QString value = first + i >= 0 ? components.at(first + i) : QString();
+        const QString level = pathLevels.at(i).toLower();
+        if (level == QLatin1String("lot")) record.lot = value;
+        else if (level == QLatin1String("wafer")) record.wafer = value;
+        else if (level == QLatin1String("die")) record.die = value;
+    }
+}
@@ -0,0 +1,147 @@
+#include "include/spacingindex.h"
+
+/**
+ * @brief Order of points in the collection: structure, then spacing
+ * @param a First point
+ * @param b Second point
+ * @return True if a sorts before b
+ */
+bool SpacingIndex::lessThan(const DataPoint &a, const DataPoint &b)
+{
+    if (a.structure != b.structure) {
+        return a.structure < b.structure;
+    }
+    return a.spacing < b.spacing;
+}
+
+/**
+ * @brief Remove all groups
+ */
+void SpacingIndex::clear()
+{
+    m_groups.clear();
+}
+
+/**
+ * @brief Rebuild all groups from a collection
+ * @param points Points to index
+ */
+void SpacingIndex::rebuild(const QVector<DataPoint> &points)
+{
+    m_groups.clear();
+    for (const DataPoint &point : points) {
+        insert(point);
+    }
+}
+
+/**
+ * @brief Add a point to its group
+ * @param point Point to add
+ */
+void SpacingIndex::insert(const DataPoint &point)
+{
+    Group &group = m_groups[Key {point.structure, point.spacing}];
+    ++group.count;
+    if (point.enabled) {
+        addValue(group, point.resistance);
+    }
+}
+
+/**
+ * @brief Remove a point from its group
+ * @param point Point to remove, with the state it was indexed with
+ */
+void SpacingIndex::remove(const DataPoint &point)
+{
+    auto it = m_groups.find(Key {point.structure, point.spacing});
+    if (it == m_groups.end()) {
+        return;
+    }
+    Group &group = it->second;
+    if (point.enabled) {
+        removeValue(group, point.resistance);
+    }
+    if (--group.count <= 0) {
+        m_groups.erase(it);
+    }
+}
+
+/**
+ * @brief Update the aggregates for a point whose enabled state changes
+ * @param point The point with its old state
+ * @param enabled The new enabled state
+ */
+void SpacingIndex::setEnabled(const DataPoint &point, bool enabled)
+{
+    if (point.enabled == enabled) {
+        return;
+    }
+    auto it = m_groups.find(Key {point.structure, point.spacing});
+    if (it == m_groups.end()) {
+        return;
+    }
+    if (enabled) {
+        addValue(it->second, point.resistance);
+    } else {
+        removeValue(it->second, point.resistance);
+    }
+}
+
+/**
+ * @brief Look up the group of a structure and spacing
+ * @param structure Structure name
+ * @param spacing Pad spacing (μm)
+ * @return The group, or nullptr if no point has that key
+ */
+const SpacingIndex::Group *SpacingIndex::group(const QString &structure, double spacing) const
+{
+    auto it = m_groups.find(Key {structure, spacing});
+    return it == m_groups.end() ? nullptr : &it->second;
+}
+
+/**
+ * @brief One point per group holding the mean enabled resistance
+ * @return Points in key order
+ */
+QVector<DataPoint> SpacingIndex::groupMeanPoints() const
+{
+    QVector<DataPoint> points;
+    points.reserve(static_cast<qsizetype>(m_groups.size()));
+    for (const auto &[key, group] : m_groups) {
+        DataPoint point(key.spacing, group.mean, 0.0, group.enabledCount > 0);
+        point.structure = key.structure;
+        points.append(point);
+    }
+    return points;
+}
+
+/**
+ * @brief Welford update for one added value
+ */
+void SpacingIndex::addValue(Group &group, double value)
+{
+    ++group.enabledCount;
+    const double delta = value - group.mean;
+    group.mean += delta / group.enabledCount;
+    group.m2 += delta * (value - group.mean);
+}
+
+/**
+ * @brief Reverse Welford update for one removed value
+ */
+void SpacingIndex::removeValue(Group &group, double value)
+{
+    if (group.enabledCount <= 1) {
+        group.enabledCount = 0;
+        group.mean = 0.0;
+        group.m2 = 0.0;
+        return;
+    }
+    const double oldMean = group.mean;
+    --group.enabledCount;
+    group.mean = (oldMean * (group.enabledCount + 1) - value) / group.enabledCount;
+    group.m2 -= (value - oldMean) * (value - group.mean);
+    if (group.m2 < 0.0) {
+        group.m2 = 0.0; // Rounding noise
+    }
+}
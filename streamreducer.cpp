@@ -0,0 +1,290 @@
+#include "include/streamreducer.h"
+#include "include/fitmodels.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Add one pair
+ *
+ * Welford's update extended to the co-moment, so no large sums are formed
+ * and subtracted.
+ */
+void StreamReducer::Moments::add(double x, double y)
+{
+    ++count;
+    const double dx = x - meanX;
+    const double dy = y - meanY;
+    meanX += dx / static_cast<double>(count);
+    meanY += dy / static_cast<double>(count);
+    m2X += dx * (x - meanX);
+    m2Y += dy * (y - meanY);
+    cXY += dx * (y - meanY);
+}
+
+/**
+ * @brief Combine with the statistics of a disjoint set of pairs
+ *
+ * Chan's pairwise formula; the result equals adding the other pairs one by one.
+ */
+void StreamReducer::Moments::merge(const Moments &other)
+{
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    const double n = static_cast<double>(count + other.count);
+    const double weight = static_cast<double>(count) * static_cast<double>(other.count) / n;
+    const double dx = other.meanX - meanX;
+    const double dy = other.meanY - meanY;
+    meanX += dx * static_cast<double>(other.count) / n;
+    meanY += dy * static_cast<double>(other.count) / n;
+    m2X += other.m2X + dx * dx * weight;
+    m2Y += other.m2Y + dy * dy * weight;
+    cXY += other.cXY + dx * dy * weight;
+    count += other.count;
+}
+
+/**
+ * @brief Least-squares line through the pairs
+ * @return False below two pairs or when all x are equal
+ *
+ * Same guards and R² clamping as Calculator::linearRegression() and
+ * Calculator::calculateRSquared().
+ */
+bool StreamReducer::Moments::line(double &slope, double &intercept, double &rSquared) const
+{
+    if (count < 2 || std::abs(m2X) < 1e-15) {
+        return false;
+    }
+    slope = cXY / m2X;
+    intercept = meanY - slope * meanX;
+    if (std::abs(m2Y) < 1e-15) {
+        rSquared = 1.0;
+    } else {
+        const double residual = std::max(0.0, m2Y - slope * cXY);
+        rSquared = std::clamp(1.0 - residual / m2Y, 0.0, 1.0);
+    }
+    return true;
+}
+
+void StreamReducer::Histogram::add(double value)
+{
+    const double position = (std::log10(value) - MinExponent) * BinsPerDecade;
+    if (!(position >= 0.0)) {
+        ++underflow;   // Also non-positive and NaN values
+    } else if (position >= BinCount) {
+        ++overflow;
+    } else {
+        ++bins[static_cast<int>(position)];
+    }
+}
+
+void StreamReducer::Histogram::merge(const Histogram &other)
+{
+    for (int bin = 0; bin < BinCount; ++bin) {
+        bins[bin] += other.bins.at(bin);
+    }
+    underflow += other.underflow;
+    overflow += other.overflow;
+}
+
+double StreamReducer::Histogram::lowerEdge(int bin)
+{
+    return std::pow(10.0, MinExponent + static_cast<double>(bin) / BinsPerDecade);
+}
+
+qint64 StreamReducer::Histogram::total() const
+{
+    qint64 sum = underflow + overflow;
+    for (qint64 count : bins) {
+        sum += count;
+    }
+    return sum;
+}
+
+/**
+ * @brief Approximate quantile, interpolated geometrically within its bin
+ *
+ * The error is at most one bin width, about 26% for ten bins per decade.
+ */
+double StreamReducer::Histogram::quantile(double q) const
+{
+    const qint64 n = total();
+    if (n == 0) {
+        return 0.0;
+    }
+    const double rank = std::clamp(q, 0.0, 1.0) * static_cast<double>(n);
+    double below = static_cast<double>(underflow);
+    if (rank <= below && underflow > 0) {
+        return lowerEdge(0);
+    }
+    for (int bin = 0; bin < BinCount; ++bin) {
+        const double count = static_cast<double>(bins.at(bin));
+        if (count > 0 && rank <= below + count) {
+            const double fraction = (rank - below) / count;
+            return lowerEdge(bin) * std::pow(10.0, fraction / BinsPerDecade);
+        }
+        below += count;
+    }
+    return lowerEdge(BinCount);
+}
+
+/**
+ * @brief Constructor
+ * @param geometry Structure geometry; the circular model uses its inner radius
+ */
+StreamReducer::StreamReducer(const Calculator::FitGeometry &geometry)
+    : m_geometry(geometry)
+{
+}
+
+/**
+ * @brief Fold one point into its structure; disabled points are ignored
+ */
+void StreamReducer::add(const DataPoint &point)
+{
+    if (!point.enabled) {
+        return;
+    }
+    StructureStats &stats = m_structures[point.structure];
+    ++stats.points;
+    ++m_pointCount;
+
+    stats.spacingResistance.add(FitModels::LinearTLM::x(point, m_geometry), FitModels::LinearTLM::y(point, m_geometry));
+    stats.spacingCorrected.add(FitModels::CircularTLM::x(point, m_geometry), FitModels::CircularTLM::y(point, m_geometry));
+
+    SpacingStats &spacing = stats.spacings[point.spacing];
+    ++spacing.count;
+    const double delta = point.resistance - spacing.mean;
+    spacing.mean += delta / static_cast<double>(spacing.count);
+    spacing.m2 += delta * (point.resistance - spacing.mean);
+    if (spacing.count == 1) {
+        spacing.minimum = spacing.maximum = point.resistance;
+    } else {
+        spacing.minimum = std::min(spacing.minimum, point.resistance);
+        spacing.maximum = std::max(spacing.maximum, point.resistance);
+    }
+
+    stats.resistance.add(point.resistance);
+}
+
+/**
+ * @brief Fold a batch of points, e.g. all points of one file
+ */
+void StreamReducer::add(const QVector<DataPoint> &points)
+{
+    for (const DataPoint &point : points) {
+        add(point);
+    }
+}
+
+/**
+ * @brief Combine with a reducer that saw a disjoint set of points
+ * @param other Reducer with the same geometry
+ */
+void StreamReducer::merge(const StreamReducer &other)
+{
+    for (const auto &[name, theirs] : other.m_structures) {
+        StructureStats &stats = m_structures[name];
+        stats.points += theirs.points;
+        stats.spacingResistance.merge(theirs.spacingResistance);
+        stats.spacingCorrected.merge(theirs.spacingCorrected);
+        stats.resistance.merge(theirs.resistance);
+        for (const auto &[spacing, group] : theirs.spacings) {
+            SpacingStats &mine = stats.spacings[spacing];
+            if (mine.count == 0) {
+                mine = group;
+                continue;
+            }
+            const double n = static_cast<double>(mine.count + group.count);
+            const double delta = group.mean - mine.mean;
+            mine.m2 += group.m2 + delta * delta * static_cast<double>(mine.count) * static_cast<double>(group.count) / n;
+            mine.mean += delta * static_cast<double>(group.count) / n;
+            mine.count += group.count;
+            mine.minimum = std::min(mine.minimum, group.minimum);
+            mine.maximum = std::max(mine.maximum, group.maximum);
+        }
+    }
+    m_pointCount += other.m_pointCount;
+}
+
+void StreamReducer::clear()
+{
+    m_structures.clear();
+    m_pointCount = 0;
+}
+
+/**
+ * @brief Fit one structure
+ * @param structure Structure name
+ * @param model Structure model
+ * @param result Receives the fit and the extracted parameters
+ * @return False if the structure is unknown or cannot be fitted
+ */
+bool StreamReducer::fit(const QString &structure, Calculator::FitModel model, Calculator::TLMResult &result) const
+{
+    const auto it = m_structures.find(structure);
+    if (it == m_structures.end()) {
+        return false;
+    }
+    const Moments &moments = model == Calculator::FitModel::CircularTLM
+        ? it->second.spacingCorrected : it->second.spacingResistance;
+    double slope, intercept, rSquared;
+    if (!moments.line(slope, intercept, rSquared)) {
+        return false;
+    }
+    Calculator::fromLine(model, slope, intercept, rSquared, m_geometry, result);
+    return true;
+}
+
+/**
+ * @brief Fit every structure
+ * @param model Structure model
+ * @param results Map receiving one result per structure that could be fitted
+ * @return True if at least one structure could be fitted
+ */
+bool StreamReducer::fitAll(Calculator::FitModel model, QMap<QString, Calculator::TLMResult> &results) const
+{
+    for (const auto &entry : m_structures) {
+        Calculator::TLMResult result;
+        if (fit(entry.first, model, result)) {
+            results.insert(entry.first, result);
+        }
+    }
+    return !results.isEmpty();
+}
+
+/**
+ * @brief One point per (structure, spacing) carrying the mean resistance
+ */
+QVector<DataPoint> StreamReducer::spacingMeans() const
+{
+    QVector<DataPoint> points;
+    for (const auto &[name, stats] : m_structures) {
+        for (const auto &[spacing, group] : stats.spacings) {
+            DataPoint point(spacing, group.mean, static_cast<double>(group.count));
+            point.structure = name;
+            points.append(point);
+        }
+    }
+    return points;
+}
+
+const StreamReducer::StructureStats *StreamReducer::structure(const QString &name) const
+{
+    const auto it = m_structures.find(name);
+    return it == m_structures.end() ? nullptr : &it->second;
+}
+
+QStringList StreamReducer::structures() const
+{
+    QStringList names;
+    names.reserve(static_cast<qsizetype>(m_structures.size()));
+    for (const auto &entry : m_structures) {
+        names.append(entry.first);
+    }
+    return names;
+}
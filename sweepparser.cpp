@@ -0,0 +1,214 @@
+#include "include/sweepparser.h"
+#include <QDebug>
+#include <QVarLengthArray>
+#include <cmath>
+
+namespace {
+
+using Fields = QVarLengthArray<QByteArrayView, 16>;
+
+void splitFields(QByteArrayView line, Fields &fields)
+{
+    fields.clear();
+    qsizetype start = 0;
+    for (;;) {
+        const qsizetype comma = line.indexOf(',', start);
+        if (comma < 0) {
+            fields.append(line.sliced(start).trimmed());
+            return;
+        }
+        fields.append(line.sliced(start, comma - start).trimmed());
+        start = comma + 1;
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Constructor
+ * @param resistanceVoltage Voltage at which the resistance is evaluated (V)
+ */
+SweepParser::SweepParser(double resistanceVoltage)
+    : m_resistanceVoltage(resistanceVoltage)
+{
+    m_legacy.sourceColumn = 5;   // Column 6 voltage
+    m_legacy.readingColumn = 6;  // Column 7 current
+}
+
+/**
+ * @brief Feed one line of the file
+ * @param line Line contents without the line terminator
+ */
+void SweepParser::feedLine(QByteArrayView line)
+{
+    if (line.endsWith('\r')) {
+        line.chop(1);
+    }
+
+    // Section markers
+    const QByteArrayView trimmed = line.trimmed();
+    if (trimmed.startsWith('[')) {
+        m_inData = trimmed.contains(QByteArrayView("DATA"));
+        if (m_inData) {
+            m_seenData = true;
+        }
+        return;
+    }
+
+    Fields fields;
+    splitFields(line, fields);
+
+    if (!m_inData) {
+        // Before (or without) a data section only the legacy columns are tracked
+        if (!m_seenData && fields.size() >= 7) {
+            bool ok1, ok2;
+            const double v = fields[m_legacy.sourceColumn].toDouble(&ok1);
+            const double i = fields[m_legacy.readingColumn].toDouble(&ok2);
+            if (ok1 && ok2) {
+                update(m_legacy, v, i, false);
+            }
+        }
+        return;
+    }
+
+    // Buffer names: a new header starts a new step block
+    if (fields.first().compare("Name") == 0) {
+        if (m_rowsInBlock > 0) {
+            ++m_block;
+        }
+        m_buffers.clear();
+        for (qsizetype c = 1; c < fields.size(); ++c) {
+            if (!fields[c].isEmpty()) {
+                Buffer buffer;
+                buffer.name = QString::fromUtf8(fields[c]);
+                buffer.firstColumn = static_cast<int>(c);
+                buffer.sourceColumn = static_cast<int>(c) + 1;   // Timestamp, Source Value, Reading
+                buffer.readingColumn = static_cast<int>(c) + 2;
+                m_buffers.append(buffer);
+            }
+        }
+        m_rowsInBlock = 0;
+        m_lastIndex = -1;
+        return;
+    }
+
+    // Column titles refine where each buffer's source value and reading are
+    if (fields.first().isEmpty()) {
+        for (qsizetype b = 0; b < m_buffers.size(); ++b) {
+            Buffer &buffer = m_buffers[b];
+            const qsizetype end = (b + 1 < m_buffers.size()) ? m_buffers[b + 1].firstColumn : fields.size();
+            for (qsizetype c = buffer.firstColumn; c < end && c < fields.size(); ++c) {
+                if (fields[c].compare("Source Value") == 0) buffer.sourceColumn = static_cast<int>(c);
+                if (fields[c].compare("Reading") == 0) buffer.readingColumn = static_cast<int>(c);
+            }
+        }
+        return;
+    }
+
+    // Data rows start with the reading index
+    bool indexOk = false;
+    const int index = fields.first().toInt(&indexOk);
+    if (!indexOk) {
+        return; // Metadata rows such as Buffer, NumReadings, BaseTimestamp
+    }
+
+    if (m_buffers.isEmpty()) {
+        // Data section without a Name row: fall back to the legacy columns
+        Buffer buffer;
+        buffer.sourceColumn = m_legacy.sourceColumn;
+        buffer.readingColumn = m_legacy.readingColumn;
+        m_buffers.append(buffer);
+    }
+
+    // The index restarting means the next step of a step/sweep run
+    if (m_rowsInBlock > 0 && index <= m_lastIndex) {
+        startBlock();
+    }
+    m_lastIndex = index;
+    ++m_rowsInBlock;
+
+    for (Buffer &buffer : m_buffers) {
+        if (buffer.done || buffer.sourceColumn >= fields.size() || buffer.readingColumn >= fields.size()) {
+            continue;
+        }
+        bool ok1, ok2;
+        const double v = fields[buffer.sourceColumn].toDouble(&ok1);
+        const double i = fields[buffer.readingColumn].toDouble(&ok2);
+        if (ok1 && ok2) {
+            update(buffer, v, i, true);
+        }
+    }
+}
+
+/**
+ * @brief Take the points completed since the last call
+ */
+QVector<DataPoint> SweepParser::takePoints()
+{
+    QVector<DataPoint> points;
+    points.swap(m_points);
+    return points;
+}
+
+/**
+ * @brief Signal end of input
+ */
+QVector<DataPoint> SweepParser::finish()
+{
+    if (!m_seenData && m_legacy.foundVoltage && m_legacy.foundZero && !m_legacy.done) {
+        complete(m_legacy);
+    }
+    return takePoints();
+}
+
+/**
+ * @brief Begin a new step block with the same buffer layout
+ */
+void SweepParser::startBlock()
+{
+    ++m_block;
+    m_rowsInBlock = 0;
+    for (Buffer &buffer : m_buffers) {
+        buffer.foundVoltage = false;
+        buffer.foundZero = false;
+        buffer.done = false;
+    }
+}
+
+/**
+ * @brief Record a (voltage, current) reading for a buffer
+ */
+void SweepParser::update(Buffer &buffer, double voltage, double current, bool emitWhenComplete)
+{
+    if (std::abs(voltage - m_resistanceVoltage) < 1e-3 && !buffer.foundVoltage) {
+        buffer.currentAtVoltage = current;
+        buffer.foundVoltage = true;
+    }
+    if (std::abs(voltage) < 1e-3 && !buffer.foundZero) {
+        buffer.currentAtZero = current;
+        buffer.foundZero = true;
+    }
+    if (emitWhenComplete && buffer.foundVoltage && buffer.foundZero) {
+        complete(buffer);
+    }
+}
+
+/**
+ * @brief Turn a buffer with both readings into a DataPoint
+ */
+void SweepParser::complete(Buffer &buffer)
+{
+    buffer.done = true;
+    const double deltaI = buffer.currentAtVoltage - buffer.currentAtZero;
+    if (std::abs(deltaI) < 1e-15 || !std::isfinite(deltaI)) {
+        qDebug() << "Invalid current difference (zero or non-finite) in buffer" << buffer.name << "deltaI=" << deltaI;
+        return;
+    }
+
+    DataPoint point;
+    point.resistance = m_resistanceVoltage / deltaI;
+    point.current = deltaI;
+    point.source = (m_block > 0) ? QString("%1 step %2").arg(buffer.name).arg(m_block + 1) : buffer.name;
+    m_points.append(point);
+    ++m_emittedCount;
+}
@@ -0,0 +1,156 @@
+#include "include/tailparser.h"
+#include <cmath>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include "include/csvprocessor.h"
+
+/**
+ * @brief Constructor
+ * @param config Application configuration (resistance voltage)
+ */
+TailParser::TailParser(const AppConfig &config)
+    : m_resistanceVoltage(config.res_voltage), m_templates(config.filename_templates)
+{
+}
+
+/**
+ * @brief Consume whatever has been appended to a file since the last poll
+ * @param filePath Path of the file
+ * @param group Structure group of the file
+ * @param restarted Set to true if the file was parsed again from the start
+ * @return Points completed by the new bytes
+ *
+ * Only complete lines are consumed. A file that is now shorter than the
+ * consumed offset has been truncated or replaced and is parsed again from
+ * the start.
+ */
+QVector<DataPoint> TailParser::poll(const QString &filePath, const QString &group, bool *restarted)
+{
+    if (restarted) {
+        *restarted = false;
+    }
+
+    const double spacing = m_templates.spacing(QFileInfo(filePath).fileName());
+    if (!(spacing > 0)) {
+        return {};
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Cannot open file:" << filePath;
+        return {};
+    }
+
+    auto it = m_files.find(filePath);
+    if (it == m_files.end()) {
+        it = m_files.insert(filePath, FileState(m_resistanceVoltage));
+    }
+    FileState &state = it.value();
+    state.group = group;
+    state.spacing = spacing;
+
+    const qint64 size = file.size();
+    if (size < state.offset) {
+        qDebug() << "File shrank, parsing again from the start:" << filePath;
+        state = FileState(m_resistanceVoltage);
+        state.group = group;
+        state.spacing = spacing;
+        if (restarted) {
+            *restarted = true;
+        }
+    }
+    if (size == state.offset || !file.seek(state.offset)) {
+        return {};
+    }
+
+    const QByteArray appended = file.read(size - state.offset);
+    const qsizetype lastNewline = appended.lastIndexOf('\n');
+    if (lastNewline < 0) {
+        return {}; // The first new line is not finished yet
+    }
+
+    const QByteArrayView data(appended.constData(), lastNewline + 1);
+    qsizetype lineStart = 0;
+    while (lineStart < data.size()) {
+        const qsizetype lineEnd = data.indexOf('\n', lineStart);
+        state.parser.feedLine(data.sliced(lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
+    }
+    state.offset += lastNewline + 1;
+
+    return label(state, state.parser.takePoints());
+}
+
+/**
+ * @brief Signal that a file is complete and stop following it
+ * @param filePath Path of the file
+ * @return Remaining points
+ */
+QVector<DataPoint> TailParser::finish(const QString &filePath)
+{
+    auto it = m_files.find(filePath);
+    if (it == m_files.end()) {
+        return {};
+    }
+    const QVector<DataPoint> points = label(it.value(), it.value().parser.finish());
+    m_files.erase(it);
+    return points;
+}
+
+/**
+ * @brief Finish every followed file
+ * @return Remaining points of all files
+ */
+QVector<DataPoint> TailParser::finishAll()
+{
+    QVector<DataPoint> points;
+    for (auto it = m_files.begin(); it != m_files.end(); ++it) {
+        points += label(it.value(), it.value().parser.finish());
+    }
+    m_files.clear();
+    return points;
+}
+
+void TailParser::forget(const QString &filePath)
+{
+    m_files.remove(filePath);
+}
+
+void TailParser::clear()
+{
+    m_files.clear();
+}
+
+qint64 TailParser::offset(const QString &filePath) const
+{
+    const auto it = m_files.constFind(filePath);
+    return it == m_files.cend() ? 0 : it.value().offset;
+}
+
+QStringList TailParser::files() const
+{
+    return m_files.keys();
+}
+
+/**
+ * @brief Give completed points their spacing and structure, dropping invalid ones
+ *
+ * The structure depends on the point's source only, so the first point of
+ * a step sweep lands in the same structure the batch loader gives it.
+ */
+QVector<DataPoint> TailParser::label(const FileState &state, QVector<DataPoint> points)
+{
+    QVector<DataPoint> labelled;
+    labelled.reserve(points.size());
+    for (DataPoint &point : points) {
+        if (!(point.resistance > 0) || !std::isfinite(point.resistance)) {
+            qDebug() << "Skipping point with invalid resistance:" << point.source << point.resistance;
+            continue;
+        }
+        point.spacing = state.spacing;
+        point.structure = CSVProcessor::structureForSource(state.group, point.source);
+        labelled.append(point);
+    }
+    return labelled;
+}
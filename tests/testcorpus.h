@@ -0,0 +1,114 @@
+#ifndef TLMANALYZER_TESTCORPUS_H
+#define TLMANALYZER_TESTCORPUS_H
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QString>
+
+/**
+ * @brief Deterministic synthetic sweep files shared by the test programs
+ *
+ * The files use the Keithley export layout of test_data/, with a device
+ * whose resistance is known exactly, so golden values do not depend on a
+ * particular instrument.
+ */
+namespace TestCorpus {
+
+/**
+ * @brief Contents of a linear sweep file
+ * @param resistance Device resistance in Ω
+ * @return CSV text; the current at 0 V is offset by 60 μA as on a real SMU
+ */
+inline QByteArray sweepCsv(double resistance)
+{
+    QByteArray csv;
+    csv += "[ DATA ]\n";
+    csv += "Name,Bias_SMU,,,Sweep_SMU,,\n";
+    csv += ",Timestamp,Source Value,Reading,Timestamp,Source Value,Reading\n";
+    csv += ",(seconds),(Volts),(Amps),(seconds),(Volts),(Amps)\n";
+    for (int step = 0; step <= 20; ++step) {
+        const double volts = -1.0 + 0.1 * step;
+        const double amps = volts / resistance + 6.0e-5;
+        csv += QByteArray::number(step + 1) + ",,,," + QByteArray::number(0.01 * step) + ","
+             + QByteArray::number(volts, 'f', 1) + "," + QByteArray::number(amps, 'g', 10) + "\n";
+    }
+    return csv;
+}
+
+/**
+ * @brief Resistance of a generated device
+ * @param die Die index; each die has its own sheet and contact resistance
+ * @param spacing Pad spacing in μm
+ * @param replicate Replicate index (0 or 1); replicates differ by ±0.1 %
+ */
+inline double resistance(int die, double spacing, int replicate)
+{
+    const double intercept = 10.0 + 2.0 * die;
+    const double slope = 0.5 + 0.1 * die;
+    return (intercept + slope * spacing) * (1.0 + 0.001 * (2 * replicate - 1));
+}
+
+/**
+ * @brief Spacings of every generated structure, in μm
+ */
+inline const double *spacings(int *count)
+{
+    static const double values[] = {2, 4, 8, 14, 22, 32, 44};
+    *count = 7;
+    return values;
+}
+
+/**
+ * @brief Write a wafer: one sub-folder per die, two replicates per spacing
+ * @param root Folder to write into
+ * @param dies Number of die folders ("die0", "die1", ...)
+ * @return False if a file could not be written
+ */
+inline bool writeWafer(const QString &root, int dies)
+{
+    int spacingCount = 0;
+    const double *values = spacings(&spacingCount);
+    for (int die = 0; die < dies; ++die) {
+        QDir dir(root);
+        const QString dieName = QStringLiteral("die%1").arg(die);
+        if (!dir.mkpath(dieName)) {
+            return false;
+        }
+        for (int s = 0; s < spacingCount; ++s) {
+            for (int replicate = 0; replicate < 2; ++replicate) {
+                QFile file(dir.filePath(QStringLiteral("%1/%2_%3.csv").arg(dieName).arg(values[s]).arg(replicate)));
+                if (!file.open(QIODevice::WriteOnly)) {
+                    return false;
+                }
+                file.write(sweepCsv(resistance(die, values[s], replicate)));
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Write a flat folder of many files for throughput cases
+ * @param root Folder to write into
+ * @param fileCount Number of files
+ * @return False if a file could not be written
+ */
+inline bool writeFlat(const QString &root, int fileCount)
+{
+    int spacingCount = 0;
+    const double *values = spacings(&spacingCount);
+    for (int i = 0; i < fileCount; ++i) {
+        const double spacing = values[i % spacingCount];
+        QFile file(QDir(root).filePath(QStringLiteral("%1_%2.csv").arg(spacing).arg(i)));
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        file.write(sweepCsv(resistance(0, spacing, i % 2)));
+    }
+    return true;
+}
+
+} // namespace TestCorpus
+
+#endif // TLMANALYZER_TESTCORPUS_H
@@ -0,0 +1,136 @@
+#include <QtTest>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include "appconfig.h"
+#include "datamanager.h"
+#include "testcorpus.h"
+
+/**
+ * @brief Behaviour of DataManager that spans its background work
+ *
+ * Runs against the test-mode configuration directory, so the user's
+ * config.json is never read or written.
+ */
+class DataManagerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void undoDropsPendingAnalysis();
+    void redoRepublishesCachedFit();
+    void earlyEditKeepsOtherSettings();
+    void sameNamedFoldersStaySeparate();
+
+private:
+    static void addPoints(DataManager &manager);
+};
+
+void DataManagerTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void DataManagerTest::addPoints(DataManager &manager)
+{
+    manager.c_beginUpdate();
+    for (int i = 1; i <= 5; ++i) {
+        // R = 10 + 2 * spacing at 1 V
+        manager.c_addManualDataPoint(5.0 * i, 1.0 / (10.0 + 10.0 * i), 1.0);
+    }
+    manager.c_commitUpdate();
+}
+
+void DataManagerTest::undoDropsPendingAnalysis()
+{
+    DataManager manager;
+    QSignalSpy completed(&manager, &DataManager::analysisComplete);
+    addPoints(manager);
+    QCOMPARE(manager.getDataPoints().size(), 5);
+
+    // The outcome is only delivered through the event loop, so it is still pending at the undo
+    QFuture<DataManager::AnalysisOutcome> pending = manager.performAnalysisAsync(100.0);
+    QVERIFY(manager.c_undo());
+    QVERIFY(manager.getDataPoints().isEmpty());
+    pending.waitForFinished();
+    QTest::qWait(100);
+    QCOMPARE(completed.count(), 0);
+
+    // Nothing was cached for the state that was left, so redo has no fit to publish
+    QVERIFY(manager.c_redo());
+    QCOMPARE(manager.getDataPoints().size(), 5);
+    QTest::qWait(100);
+    QCOMPARE(completed.count(), 0);
+}
+
+void DataManagerTest::redoRepublishesCachedFit()
+{
+    DataManager manager;
+    QSignalSpy completed(&manager, &DataManager::analysisComplete);
+    addPoints(manager);
+
+    manager.performAnalysisAsync(100.0);
+    QTRY_COMPARE(completed.count(), 1);
+    const QString message = completed.last().constFirst().toString();
+
+    QVERIFY(manager.c_undo());
+    QCOMPARE(completed.count(), 1);
+    QVERIFY(manager.c_redo());
+    QCOMPARE(completed.count(), 2);
+    QCOMPARE(completed.last().constFirst().toString(), message);
+}
+
+/**
+ * @brief A setting changed before the configuration loads is saved without resetting the others
+ */
+void DataManagerTest::earlyEditKeepsOtherSettings()
+{
+    AppConfig saved(QStringLiteral("config.json"));
+    saved.channel_length = 250.0;
+    saved.fit_model = QStringLiteral("circular");
+    QVERIFY(saved.saveConfig());
+
+    {
+        DataManager manager;
+        // The configuration is applied from the event loop, so this edit comes first
+        manager.setResistanceVoltage(2.0);
+        QTRY_VERIFY(manager.isConfigLoaded());
+        QCOMPARE(manager.getResistanceVoltage(), 2.0);
+        QCOMPARE(manager.getChannelWidth(), 250.0);
+        QCOMPARE(manager.getFitModel(), QStringLiteral("circular"));
+    }
+
+    const AppConfig reloaded(QStringLiteral("config.json"));
+    QCOMPARE(reloaded.res_voltage, 2.0);
+    QCOMPARE(reloaded.channel_length, 250.0);
+    QCOMPARE(reloaded.fit_model, QStringLiteral("circular"));
+    QVERIFY(QFile::remove(reloaded.getConfigFile()));
+}
+
+/**
+ * @brief Die folders of the same name from different wafers are labelled by the path that tells them apart
+ */
+void DataManagerTest::sameNamedFoldersStaySeparate()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+    const QDir lots(root.path());
+    QVERIFY(TestCorpus::writeWafer(lots.filePath(QStringLiteral("lotA/w1")), 1));
+    QVERIFY(TestCorpus::writeWafer(lots.filePath(QStringLiteral("lotB/w1")), 1));
+
+    DataManager manager;
+    manager.c_loadDataFromFolders({lots.filePath(QStringLiteral("lotA/w1/die0")),
+                                   lots.filePath(QStringLiteral("lotB/w1/die0"))}, false);
+    QTRY_COMPARE_WITH_TIMEOUT(manager.getDataPoints().size(), 28, 30000);
+
+    QSet<QString> structures;
+    for (const DataPoint &point : manager.getDataPoints()) {
+        structures.insert(point.structure);
+    }
+    QCOMPARE(structures, (QSet<QString> {QStringLiteral("lotA/w1/die0/Sweep_SMU"),
+                                         QStringLiteral("lotB/w1/die0/Sweep_SMU")}));
+}
+
+QTEST_GUILESS_MAIN(DataManagerTest)
+#include "tst_datamanager.moc"
@@ -0,0 +1,178 @@
+#include <QtTest>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include "calculator.h"
+#include "fitmodels.h"
+
+/**
+ * @brief Leave-one-out influence diagnostics against explicit refits
+ *
+ * Calculator::influenceDiagnostics derives every leave-one-out fit from the
+ * full fit; here each one is compared with a Calculator::fit of the
+ * structure with that point disabled, for every model.
+ */
+class DiagnosticsTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void matchesRefits_data();
+    void matchesRefits();
+
+private:
+    static QVector<DataPoint> makePoints();
+    static double modelY(Calculator::FitModel model, const DataPoint &point, const Calculator::FitGeometry &geometry);
+    static bool close(double actual, double expected);
+};
+
+/**
+ * @brief One structure with scatter, a far spacing and a disabled outlier
+ */
+QVector<DataPoint> DiagnosticsTest::makePoints()
+{
+    const QVector<double> spacings {5.0, 10.0, 15.0, 20.0, 30.0, 40.0, 60.0, 120.0};
+    const QVector<double> scatter {0.8, -1.1, 0.4, 1.6, -0.7, -1.9, 0.9, 2.4};
+    QVector<DataPoint> points;
+    for (qsizetype i = 0; i < spacings.size(); ++i) {
+        const double resistance = 12.0 + 0.45 * spacings.at(i) + scatter.at(i);
+        points.append(DataPoint(spacings.at(i), resistance, 1.0 / resistance));
+    }
+    points[3].resistance += 15.0;
+    points[3].enabled = false;
+    return points;
+}
+
+/**
+ * @brief y of a point in the coordinates the model fits in
+ */
+double DiagnosticsTest::modelY(Calculator::FitModel model, const DataPoint &point,
+                               const Calculator::FitGeometry &geometry)
+{
+    switch (model) {
+    case Calculator::FitModel::CircularTLM:
+        return FitModels::CircularTLM::y(point, geometry);
+    case Calculator::FitModel::EndResistance:
+        return FitModels::EndResistanceTLM::y(point, geometry);
+    case Calculator::FitModel::LinearTLM:
+        break;
+    }
+    return FitModels::LinearTLM::y(point, geometry);
+}
+
+/**
+ * @brief Equal to a relative 1e-9, or 1e-9 absolute near zero
+ */
+bool DiagnosticsTest::close(double actual, double expected)
+{
+    return std::abs(actual - expected) <= 1e-9 * std::max({1.0, std::abs(actual), std::abs(expected)});
+}
+
+void DiagnosticsTest::matchesRefits_data()
+{
+    QTest::addColumn<QString>("model");
+
+    for (const QString &model : Calculator::fitModelNames()) {
+        QTest::newRow(qPrintable(model)) << model;
+    }
+}
+
+/**
+ * @brief Leave-one-out line, Cook's distance and studentized residual of each point match n refits
+ *
+ * Cook's distance is the summed squared shift of the fitted values when the
+ * point is left out, over 2·s². The studentized residual is the point's
+ * distance from the line fitted without it, over the standard error of
+ * predicting it from that line. A disabled point is already out of the fit,
+ * so its leave-one-out line is the full fit and both measures are zero.
+ */
+void DiagnosticsTest::matchesRefits()
+{
+    QFETCH(QString, model);
+
+    Calculator::FitModel fitModel;
+    QVERIFY(Calculator::fitModelFromName(model, fitModel));
+    Calculator::FitGeometry geometry;
+    geometry.ctlmInnerRadius = 50.0;
+    geometry.contactLength = 20.0;
+
+    const QVector<DataPoint> points = makePoints();
+    const QVector<Calculator::InfluenceDiagnostics> diagnostics =
+        Calculator::influenceDiagnostics(fitModel, points, geometry);
+    QCOMPARE(diagnostics.size(), points.size());
+
+    Calculator::TLMResult full;
+    QVERIFY(Calculator::fit(fitModel, points, geometry, full));
+    const qsizetype n = std::count_if(points.cbegin(), points.cend(), [](const DataPoint &point) {
+        return point.enabled;
+    });
+    double sse = 0.0;
+    for (const DataPoint &point : points) {
+        const double e = modelY(fitModel, point, geometry) - (full.slope * point.spacing + full.intercept);
+        sse += point.enabled ? e * e : 0.0;
+    }
+    const double s2 = sse / static_cast<double>(n - 2);
+
+    for (qsizetype i = 0; i < points.size(); ++i) {
+        const Calculator::InfluenceDiagnostics &d = diagnostics.at(i);
+        QVERIFY(d.valid);
+
+        if (!points.at(i).enabled) {
+            QVERIFY(close(d.looSlope, full.slope));
+            QVERIFY(close(d.looIntercept, full.intercept));
+            QCOMPARE(d.cooksDistance, 0.0);
+            QCOMPARE(d.studentizedResidual, 0.0);
+            continue;
+        }
+
+        QVector<DataPoint> without = points;
+        without[i].enabled = false;
+        Calculator::TLMResult loo;
+        QVERIFY(Calculator::fit(fitModel, without, geometry, loo));
+        QVERIFY2(close(d.looSlope, loo.slope),
+                 qPrintable(QStringLiteral("point %1: slope %2, refit %3").arg(i).arg(d.looSlope, 0, 'g', 17)
+                            .arg(loo.slope, 0, 'g', 17)));
+        QVERIFY2(close(d.looIntercept, loo.intercept),
+                 qPrintable(QStringLiteral("point %1: intercept %2, refit %3").arg(i).arg(d.looIntercept, 0, 'g', 17)
+                            .arg(loo.intercept, 0, 'g', 17)));
+
+        // Shift of the fitted values, and the spread of the others about their own line
+        double shift = 0.0, looSse = 0.0, looMeanX = 0.0;
+        for (qsizetype j = 0; j < points.size(); ++j) {
+            if (!points.at(j).enabled) {
+                continue;
+            }
+            const double x = points.at(j).spacing;
+            const double delta = (full.slope - loo.slope) * x + (full.intercept - loo.intercept);
+            shift += delta * delta;
+            if (j != i) {
+                const double e = modelY(fitModel, points.at(j), geometry) - (loo.slope * x + loo.intercept);
+                looSse += e * e;
+                looMeanX += x;
+            }
+        }
+        const double m = static_cast<double>(n - 1);
+        looMeanX /= m;
+        double looSxx = 0.0;
+        for (qsizetype j = 0; j < points.size(); ++j) {
+            if (points.at(j).enabled && j != i) {
+                looSxx += (points.at(j).spacing - looMeanX) * (points.at(j).spacing - looMeanX);
+            }
+        }
+        const double x = points.at(i).spacing;
+        const double predictionError = modelY(fitModel, points.at(i), geometry) - (loo.slope * x + loo.intercept);
+        const double predictionVariance = looSse / (m - 2.0) * (1.0 + 1.0 / m + (x - looMeanX) * (x - looMeanX) / looSxx);
+
+        const double cooks = shift / (2.0 * s2);
+        const double studentized = predictionError / std::sqrt(predictionVariance);
+        QVERIFY2(close(d.cooksDistance, cooks),
+                 qPrintable(QStringLiteral("point %1: Cook's distance %2, refit %3").arg(i)
+                            .arg(d.cooksDistance, 0, 'g', 17).arg(cooks, 0, 'g', 17)));
+        QVERIFY2(close(d.studentizedResidual, studentized),
+                 qPrintable(QStringLiteral("point %1: studentized residual %2, refit %3").arg(i)
+                            .arg(d.studentizedResidual, 0, 'g', 17).arg(studentized, 0, 'g', 17)));
+    }
+}
+
+QTEST_GUILESS_MAIN(DiagnosticsTest)
+#include "tst_diagnostics.moc"
@@ -0,0 +1,440 @@
+#include <QtTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cmath>
+#include "appconfig.h"
+#include "calculator.h"
+#include "csvprocessor.h"
+#include "datamanager.h"
+#include "filenameindex.h"
+#include "ingestpipeline.h"
+#include "streamreducer.h"
+#include "testcorpus.h"
+#include "workerpools.h"
+
+/**
+ * @brief Golden-result regression tests
+ *
+ * Loads test_data/ and a generated wafer, and compares the extracted points
+ * and the fit of every model against the values stored in tests/golden/.
+ * Run with TLM_UPDATE_GOLDEN=1 to rewrite the golden files from the current
+ * build after an intended change of results.
+ */
+class GoldenTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void points_data();
+    void points();
+    void results_data();
+    void results();
+    void streamedResults_data();
+    void streamedResults();
+    void queriedPoints();
+    void pooledResults();
+
+private:
+    /**
+     * @brief A data set: where it is loaded from and its golden file
+     */
+    struct Corpus {
+        QString folder;
+        QString goldenPath;
+        bool groupByFolder = false;
+        QJsonObject golden;
+        bool changed = false;
+    };
+
+    AppConfig configFor(const Corpus &corpus) const;
+    static Calculator::FitGeometry geometryOf(const QJsonObject &golden);
+    static QJsonArray pointsToJson(const QVector<DataPoint> &points);
+    static QJsonObject resultToJson(const Calculator::TLMResult &result);
+    static void sortPoints(QVector<DataPoint> &points);
+    static bool matches(double actual, double expected);
+    static void comparePoints(const QVector<DataPoint> &points, const QJsonArray &golden);
+    static void compareResult(const Calculator::TLMResult &result, const QJsonObject &golden);
+
+    QTemporaryDir m_wafer;
+    QMap<QString, Corpus> m_corpora;
+    bool m_update = false;
+};
+
+void GoldenTest::initTestCase()
+{
+    m_update = qEnvironmentVariableIntValue("TLM_UPDATE_GOLDEN") != 0;
+
+    QVERIFY(m_wafer.isValid());
+    QVERIFY(TestCorpus::writeWafer(m_wafer.path(), 4));
+
+    const QString goldenDir = QStringLiteral(TLM_SOURCE_DIR "/tests/golden/");
+    m_corpora.insert(QStringLiteral("test_data"),
+                     {QStringLiteral(TLM_SOURCE_DIR "/test_data"), goldenDir + "test_data.json", false, {}, false});
+    m_corpora.insert(QStringLiteral("generated"),
+                     {m_wafer.path(), goldenDir + "generated.json", true, {}, false});
+
+    for (Corpus &corpus : m_corpora) {
+        QFile file(corpus.goldenPath);
+        QVERIFY2(file.open(QIODevice::ReadOnly), qPrintable("Cannot open " + corpus.goldenPath));
+        QJsonParseError error;
+        corpus.golden = QJsonDocument::fromJson(file.readAll(), &error).object();
+        QVERIFY2(error.error == QJsonParseError::NoError, qPrintable(error.errorString()));
+    }
+}
+
+void GoldenTest::cleanupTestCase()
+{
+    if (!m_update) {
+        return;
+    }
+    for (const Corpus &corpus : std::as_const(m_corpora)) {
+        if (!corpus.changed) {
+            continue;
+        }
+        QFile file(corpus.goldenPath);
+        QVERIFY2(file.open(QIODevice::WriteOnly | QIODevice::Truncate), qPrintable("Cannot write " + corpus.goldenPath));
+        file.write(QJsonDocument(corpus.golden).toJson(QJsonDocument::Indented));
+        qDebug() << "Updated" << corpus.goldenPath;
+    }
+}
+
+/**
+ * @brief Skip the comparisons that do not write golden files while updating them
+ */
+void GoldenTest::init()
+{
+    const QByteArray name = QTest::currentTestFunction();
+    if (m_update && name != "points" && name != "results") {
+        QSKIP("Golden files are written from the point-based loads and fits");
+    }
+}
+
+/**
+ * @brief Configuration for a corpus without touching config.json
+ */
+AppConfig GoldenTest::configFor(const Corpus &corpus) const
+{
+    AppConfig config(QStringLiteral("config.json"), AppConfig::Loading::Deferred);
+    config.res_voltage = corpus.golden.value(QStringLiteral("resVoltage")).toDouble(1.0);
+    config.scan_recursive = corpus.groupByFolder;
+    config.group_by_folder = corpus.groupByFolder;
+    config.include_patterns = QStringList {QStringLiteral("*.csv")};
+    return config;
+}
+
+Calculator::FitGeometry GoldenTest::geometryOf(const QJsonObject &golden)
+{
+    const QJsonObject geometry = golden.value(QStringLiteral("geometry")).toObject();
+    Calculator::FitGeometry result;
+    result.channelWidth = geometry.value(QStringLiteral("channelWidth")).toDouble(result.channelWidth);
+    result.ctlmInnerRadius = geometry.value(QStringLiteral("ctlmInnerRadius")).toDouble(result.ctlmInnerRadius);
+    result.contactLength = geometry.value(QStringLiteral("contactLength")).toDouble(result.contactLength);
+    return result;
+}
+
+QJsonArray GoldenTest::pointsToJson(const QVector<DataPoint> &points)
+{
+    QJsonArray array;
+    for (const DataPoint &point : points) {
+        array.append(QJsonObject {
+            {QStringLiteral("structure"), point.structure},
+            {QStringLiteral("spacing"), point.spacing},
+            {QStringLiteral("resistance"), point.resistance},
+            {QStringLiteral("current"), point.current}
+        });
+    }
+    return array;
+}
+
+QJsonObject GoldenTest::resultToJson(const Calculator::TLMResult &result)
+{
+    return QJsonObject {
+        {QStringLiteral("slope"), result.slope},
+        {QStringLiteral("intercept"), result.intercept},
+        {QStringLiteral("rSquared"), result.rSquared},
+        {QStringLiteral("sheetResistance"), result.sheetResistance},
+        {QStringLiteral("contactResistance"), result.contactResistance},
+        {QStringLiteral("specificContactResistivity"), result.specificContactResistivity},
+        {QStringLiteral("channelWidth"), result.channelWidth},
+        {QStringLiteral("transferLength"), result.transferLength},
+        {QStringLiteral("endResistance"), result.endResistance}
+    };
+}
+
+/**
+ * @brief Order points independently of discovery and thread scheduling
+ *
+ * Replicates share a spacing, so the loaders' own (structure, spacing)
+ * order leaves them in file-system order.
+ */
+void GoldenTest::sortPoints(QVector<DataPoint> &points)
+{
+    std::sort(points.begin(), points.end(), [](const DataPoint &a, const DataPoint &b) {
+        if (a.structure != b.structure) {
+            return a.structure < b.structure;
+        }
+        if (a.spacing != b.spacing) {
+            return a.spacing < b.spacing;
+        }
+        return a.resistance < b.resistance;
+    });
+}
+
+/**
+ * @brief Compare with a relative tolerance of 1e-9
+ *
+ * Loose enough for a different compiler or summation order, tight enough
+ * that any change to parsing or fitting shows up.
+ */
+bool GoldenTest::matches(double actual, double expected)
+{
+    return std::abs(actual - expected) <= 1e-12 + 1e-9 * std::abs(expected);
+}
+
+void GoldenTest::comparePoints(const QVector<DataPoint> &points, const QJsonArray &golden)
+{
+    QCOMPARE(points.size(), golden.size());
+    for (qsizetype i = 0; i < points.size(); ++i) {
+        const DataPoint &point = points.at(i);
+        const QJsonObject expected = golden.at(i).toObject();
+        const QString where = QStringLiteral("point %1 (%2, %3 μm)").arg(i).arg(point.structure).arg(point.spacing);
+        QCOMPARE(point.structure, expected.value(QStringLiteral("structure")).toString());
+        QVERIFY2(matches(point.spacing, expected.value(QStringLiteral("spacing")).toDouble()), qPrintable(where));
+        QVERIFY2(matches(point.resistance, expected.value(QStringLiteral("resistance")).toDouble()),
+                 qPrintable(where + QStringLiteral(": resistance %1, expected %2")
+                            .arg(point.resistance, 0, 'g', 17)
+                            .arg(expected.value(QStringLiteral("resistance")).toDouble(), 0, 'g', 17)));
+        QVERIFY2(matches(point.current, expected.value(QStringLiteral("current")).toDouble()),
+                 qPrintable(where + QStringLiteral(": current %1, expected %2")
+                            .arg(point.current, 0, 'g', 17)
+                            .arg(expected.value(QStringLiteral("current")).toDouble(), 0, 'g', 17)));
+    }
+}
+
+void GoldenTest::compareResult(const Calculator::TLMResult &result, const QJsonObject &golden)
+{
+    const QJsonObject actual = resultToJson(result);
+    for (auto it = actual.constBegin(); it != actual.constEnd(); ++it) {
+        const double expected = golden.value(it.key()).toDouble();
+        QVERIFY2(matches(it.value().toDouble(), expected),
+                 qPrintable(QStringLiteral("%1 is %2, expected %3").arg(it.key())
+                            .arg(it.value().toDouble(), 0, 'g', 17).arg(expected, 0, 'g', 17)));
+    }
+}
+
+void GoldenTest::points_data()
+{
+    QTest::addColumn<QString>("corpus");
+    QTest::addColumn<bool>("pipeline");
+
+    for (const QString &corpus : m_corpora.keys()) {
+        QTest::newRow(qPrintable(corpus + "/processFolder")) << corpus << false;
+        QTest::newRow(qPrintable(corpus + "/IngestPipeline")) << corpus << true;
+    }
+}
+
+/**
+ * @brief Both loaders extract the golden points
+ */
+void GoldenTest::points()
+{
+    QFETCH(QString, corpus);
+    QFETCH(bool, pipeline);
+
+    Corpus &data = m_corpora[corpus];
+    const AppConfig config = configFor(data);
+    QVector<DataPoint> points = pipeline
+        ? IngestPipeline(config, IngestOptions::fromConfig(config)).run(data.folder)
+        : CSVProcessor::processFolder(data.folder, config);
+    sortPoints(points);
+
+    if (m_update) {
+        data.golden.insert(QStringLiteral("points"), pointsToJson(points));
+        data.changed = true;
+        return;
+    }
+    comparePoints(points, data.golden.value(QStringLiteral("points")).toArray());
+}
+
+void GoldenTest::results_data()
+{
+    QTest::addColumn<QString>("corpus");
+    QTest::addColumn<QString>("model");
+
+    for (const QString &corpus : m_corpora.keys()) {
+        for (const QString &model : Calculator::fitModelNames()) {
+            QTest::newRow(qPrintable(corpus + "/" + model)) << corpus << model;
+        }
+    }
+}
+
+/**
+ * @brief Every model reproduces the golden fit of every structure
+ *
+ * A corpus with one structure is fitted as a whole, as the application
+ * does; a grouped corpus is fitted per structure.
+ */
+void GoldenTest::results()
+{
+    QFETCH(QString, corpus);
+    QFETCH(QString, model);
+
+    Corpus &data = m_corpora[corpus];
+    Calculator::FitModel fitModel;
+    QVERIFY(Calculator::fitModelFromName(model, fitModel));
+    const Calculator::FitGeometry geometry = geometryOf(data.golden);
+
+    QVector<DataPoint> points = CSVProcessor::processFolder(data.folder, configFor(data));
+    sortPoints(points);
+
+    QJsonObject results = data.golden.value(QStringLiteral("results")).toObject();
+    if (!data.groupByFolder) {
+        Calculator::TLMResult result;
+        QVERIFY(Calculator::fit(fitModel, points, geometry, result));
+        if (m_update) {
+            results.insert(model, resultToJson(result));
+            data.golden.insert(QStringLiteral("results"), results);
+            data.changed = true;
+            return;
+        }
+        compareResult(result, results.value(model).toObject());
+        return;
+    }
+
+    QMap<QString, Calculator::TLMResult> structures;
+    QVERIFY(DataManager::calculateStructureResults(points, structures, fitModel, geometry));
+    if (m_update) {
+        QJsonObject byStructure;
+        for (auto it = structures.cbegin(); it != structures.cend(); ++it) {
+            byStructure.insert(it.key(), resultToJson(it.value()));
+        }
+        results.insert(model, byStructure);
+        data.golden.insert(QStringLiteral("results"), results);
+        data.changed = true;
+        return;
+    }
+
+    const QJsonObject expected = results.value(model).toObject();
+    QCOMPARE(structures.size(), expected.size());
+    for (auto it = structures.cbegin(); it != structures.cend(); ++it) {
+        QVERIFY2(expected.contains(it.key()), qPrintable("Unexpected structure " + it.key()));
+        compareResult(it.value(), expected.value(it.key()).toObject());
+    }
+}
+
+void GoldenTest::streamedResults_data()
+{
+    QTest::addColumn<QString>("model");
+
+    for (const QString &model : Calculator::fitModelNames()) {
+        QTest::newRow(qPrintable(model)) << model;
+    }
+}
+
+/**
+ * @brief Fits from streamed sufficient statistics match the golden fits
+ *
+ * The generated wafer is folded file by file into a StreamReducer, as
+ * `--stream` does, without collecting its points.
+ */
+void GoldenTest::streamedResults()
+{
+    QFETCH(QString, model);
+
+    const Corpus &data = m_corpora[QStringLiteral("generated")];
+    Calculator::FitModel fitModel;
+    QVERIFY(Calculator::fitModelFromName(model, fitModel));
+
+    const AppConfig config = configFor(data);
+    StreamReducer reducer(geometryOf(data.golden));
+    IngestPipeline(config, IngestOptions::fromConfig(config)).streamMany(QStringList {data.folder},
+        [&reducer](int, const QString &, QVector<DataPoint> &&points) {
+            reducer.add(points);
+        });
+    QCOMPARE(reducer.pointCount(), data.golden.value(QStringLiteral("points")).toArray().size());
+
+    QMap<QString, Calculator::TLMResult> structures;
+    QVERIFY(reducer.fitAll(fitModel, structures));
+    const QJsonObject expected = data.golden.value(QStringLiteral("results")).toObject().value(model).toObject();
+    QCOMPARE(structures.size(), expected.size());
+    for (auto it = structures.cbegin(); it != structures.cend(); ++it) {
+        QVERIFY2(expected.contains(it.key()), qPrintable("Unexpected structure " + it.key()));
+        compareResult(it.value(), expected.value(it.key()).toObject());
+    }
+}
+
+/**
+ * @brief A filename query selects exactly the matching files
+ *
+ * The generated wafer's names are indexed with a template, and only the
+ * selected files are loaded; their points must equal the golden points of
+ * the same structures and spacings.
+ */
+void GoldenTest::queriedPoints()
+{
+    const Corpus &data = m_corpora[QStringLiteral("generated")];
+    AppConfig config = configFor(data);
+    config.filename_templates = QStringList {QStringLiteral("{spacing}_{rep}")};
+
+    FilenameIndex index(config.filename_templates);
+    QVERIFY(index.templateErrors().isEmpty());
+    QCOMPARE(index.addFolders(QStringList {data.folder}, DiscoveryOptions::fromConfig(config)), 4 * 7 * 2);
+    QCOMPARE(index.fields(), (QStringList {QStringLiteral("spacing"), QStringLiteral("rep"), QStringLiteral("group")}));
+    QCOMPARE(index.values(QStringLiteral("rep")).size(), 2);
+
+    QString error;
+    QCOMPARE(index.query(QStringLiteral("spacing=22 and rep=1"), &error).count(), 4);
+    QCOMPARE(index.query(QStringLiteral("spacing=022.0, group!=die0"), &error).count(), 6);
+    QVERIFY(error.isEmpty());
+    QVERIFY(index.query(QStringLiteral("wafer=3"), &error).isEmpty());
+    QVERIFY(!error.isEmpty());
+
+    const FilenameIndex::Bitmap selection = index.query(QStringLiteral("spacing>=32 and group=die1|die2"), &error);
+    QVERIFY(error.isEmpty());
+    QCOMPARE(selection.count(), 2 * 2 * 2);
+    QVector<DataPoint> points = IngestPipeline(config, IngestOptions::fromConfig(config))
+                                    .runFiles(index.roots(), index.files(selection));
+    sortPoints(points);
+
+    QJsonArray expected;
+    for (const QJsonValue &value : data.golden.value(QStringLiteral("points")).toArray()) {
+        const QJsonObject point = value.toObject();
+        const QString structure = point.value(QStringLiteral("structure")).toString();
+        if ((structure == QLatin1String("die1/Sweep_SMU") || structure == QLatin1String("die2/Sweep_SMU"))
+            && point.value(QStringLiteral("spacing")).toDouble() >= 32) {
+            expected.append(point);
+        }
+    }
+    comparePoints(points, expected);
+}
+
+/**
+ * @brief Fits spread over a work-stealing pool match the golden fits
+ */
+void GoldenTest::pooledResults()
+{
+    WorkerPool pool;
+    pool.configure(3, QThread::LowPriority, QVector<int>());
+
+    const Corpus &data = m_corpora[QStringLiteral("generated")];
+    const QVector<DataPoint> points = CSVProcessor::processFolder(data.folder, configFor(data));
+    QMap<QString, Calculator::TLMResult> structures;
+    QVERIFY(DataManager::calculateStructureResults(points, structures, Calculator::FitModel::LinearTLM,
+                                                   geometryOf(data.golden), &pool));
+    const QJsonObject expected = data.golden.value(QStringLiteral("results")).toObject()
+                                     .value(Calculator::fitModelName(Calculator::FitModel::LinearTLM)).toObject();
+    QCOMPARE(structures.size(), expected.size());
+    for (auto it = structures.cbegin(); it != structures.cend(); ++it) {
+        QVERIFY2(expected.contains(it.key()), qPrintable("Unexpected structure " + it.key()));
+        compareResult(it.value(), expected.value(it.key()).toObject());
+    }
+}
+
+QTEST_GUILESS_MAIN(GoldenTest)
+#include "tst_golden.moc"
@@ -0,0 +1,210 @@
+#include <QtTest>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <cmath>
+#include "appconfig.h"
+#include "calculator.h"
+#include "csvprocessor.h"
+#include "ingestpipeline.h"
+#include "numerics.h"
+#include "resultexporter.h"
+#include "testcorpus.h"
+
+/**
+ * @brief Throughput regression tests
+ *
+ * Each case in tests/budgets.json is timed (best of three runs) and fails
+ * when it takes longer than its budget plus the margin. The margin in the
+ * file can be overridden with the TLM_BUDGET_MARGIN environment variable,
+ * e.g. 1.0 to allow twice the budget on a slow or shared machine.
+ */
+class PerformanceTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void throughput_data();
+    void throughput();
+
+private:
+    /**
+     * @brief Run one case
+     * @param name Case name from budgets.json
+     * @param size Files or points the case works on
+     * @return False if the case is unknown or its work failed
+     */
+    bool runCase(const QString &name, int size);
+
+    /**
+     * @brief Synthetic points of one structure
+     */
+    static QVector<DataPoint> makePoints(int count);
+
+    /**
+     * @brief Write (once) and return a flat folder of generated files
+     */
+    QString corpus(int fileCount);
+
+    AppConfig configFor() const;
+
+    QTemporaryDir m_scratch;
+    QJsonArray m_cases;
+    double m_margin = 0.25;
+    QMap<int, QString> m_corpora;
+};
+
+void PerformanceTest::initTestCase()
+{
+    QVERIFY(m_scratch.isValid());
+
+    QFile file(QStringLiteral(TLM_SOURCE_DIR "/tests/budgets.json"));
+    QVERIFY2(file.open(QIODevice::ReadOnly), "Cannot open tests/budgets.json");
+    const QJsonObject budgets = QJsonDocument::fromJson(file.readAll()).object();
+    m_cases = budgets.value(QStringLiteral("cases")).toArray();
+    QVERIFY(!m_cases.isEmpty());
+    m_margin = budgets.value(QStringLiteral("margin")).toDouble(m_margin);
+
+    bool ok = false;
+    const double margin = qEnvironmentVariable("TLM_BUDGET_MARGIN").toDouble(&ok);
+    if (ok && margin >= 0.0) {
+        m_margin = margin;
+    }
+    qDebug() << "Budget margin:" << m_margin;
+}
+
+AppConfig PerformanceTest::configFor() const
+{
+    AppConfig config(QStringLiteral("config.json"), AppConfig::Loading::Deferred);
+    config.res_voltage = 1.0;
+    config.include_patterns = QStringList {QStringLiteral("*.csv")};
+    return config;
+}
+
+QString PerformanceTest::corpus(int fileCount)
+{
+    if (!m_corpora.contains(fileCount)) {
+        const QString folder = m_scratch.filePath(QStringLiteral("corpus_%1").arg(fileCount));
+        if (!QDir().mkpath(folder) || !TestCorpus::writeFlat(folder, fileCount)) {
+            return QString();
+        }
+        m_corpora.insert(fileCount, folder);
+    }
+    return m_corpora.value(fileCount);
+}
+
+QVector<DataPoint> PerformanceTest::makePoints(int count)
+{
+    int spacingCount = 0;
+    const double *spacings = TestCorpus::spacings(&spacingCount);
+    QVector<DataPoint> points;
+    points.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const double spacing = spacings[i % spacingCount];
+        DataPoint point(spacing, TestCorpus::resistance(0, spacing, i % 2), 1.0e-3);
+        point.source = QStringLiteral("Sweep_SMU");
+        points.append(point);
+    }
+    return points;
+}
+
+bool PerformanceTest::runCase(const QString &name, int size)
+{
+    const AppConfig config = configFor();
+
+    if (name == QLatin1String("processFile") || name == QLatin1String("ingestPipeline")) {
+        const QString folder = corpus(size);
+        if (folder.isEmpty()) {
+            return false;
+        }
+        if (name == QLatin1String("ingestPipeline")) {
+            return IngestPipeline(config, IngestOptions::fromConfig(config)).run(folder).size() == size;
+        }
+        int valid = 0;
+        QDirIterator it(folder, {QStringLiteral("*.csv")}, QDir::Files);
+        while (it.hasNext()) {
+            valid += CSVProcessor::processFile(it.next(), config).resistance > 0 ? 1 : 0;
+        }
+        return valid == size;
+    }
+
+    if (name == QLatin1String("fit")) {
+        const QVector<DataPoint> points = makePoints(size);
+        for (Calculator::FitModel model : {Calculator::FitModel::LinearTLM, Calculator::FitModel::CircularTLM,
+                                           Calculator::FitModel::EndResistance}) {
+            Calculator::TLMResult result;
+            if (!Calculator::fit(model, points, Calculator::FitGeometry(), result)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if (name == QLatin1String("exportCsv")) {
+        return ResultExporter::writePoints(makePoints(size), m_scratch.filePath(QStringLiteral("points.csv")),
+                                           ResultExporter::Options());
+    }
+
+    if (name == QLatin1String("numericsSum")) {
+        QVector<double> values(size);
+        for (int i = 0; i < size; ++i) {
+            values[i] = 1.0 / (1.0 + i);
+        }
+        return std::isfinite(Numerics::sum(values));
+    }
+
+    return false;
+}
+
+void PerformanceTest::throughput_data()
+{
+    QTest::addColumn<QString>("name");
+    QTest::addColumn<int>("size");
+    QTest::addColumn<double>("budgetMs");
+
+    for (const QJsonValue &value : std::as_const(m_cases)) {
+        const QJsonObject entry = value.toObject();
+        const QString name = entry.value(QStringLiteral("name")).toString();
+        const int size = entry.contains(QStringLiteral("files"))
+            ? entry.value(QStringLiteral("files")).toInt() : entry.value(QStringLiteral("points")).toInt();
+        QTest::newRow(qPrintable(name)) << name << size << entry.value(QStringLiteral("budgetMs")).toDouble();
+    }
+}
+
+/**
+ * @brief A case finishes within its budget plus the margin
+ *
+ * The first run also warms up the corpus and the thread pools; the best of
+ * three is compared, so one noisy run does not fail the gate.
+ */
+void PerformanceTest::throughput()
+{
+    QFETCH(QString, name);
+    QFETCH(int, size);
+    QFETCH(double, budgetMs);
+
+    double best = -1.0;
+    for (int run = 0; run < 3; ++run) {
+        QElapsedTimer timer;
+        timer.start();
+        QVERIFY2(runCase(name, size), qPrintable("Case failed or is unknown: " + name));
+        const double elapsed = timer.nsecsElapsed() / 1.0e6;
+        if (best < 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    const double limit = budgetMs * (1.0 + m_margin);
+    qDebug().noquote() << QStringLiteral("%1: %2 ms (budget %3 ms, limit %4 ms)")
+                              .arg(name).arg(best, 0, 'f', 1).arg(budgetMs, 0, 'f', 0).arg(limit, 0, 'f', 0);
+    QVERIFY2(best <= limit, qPrintable(QStringLiteral("%1 took %2 ms, over the %3 ms budget + %4%")
+                                           .arg(name).arg(best, 0, 'f', 1).arg(budgetMs, 0, 'f', 0)
+                                           .arg(m_margin * 100.0, 0, 'f', 0)));
+}
+
+QTEST_GUILESS_MAIN(PerformanceTest)
+#include "tst_performance.moc"
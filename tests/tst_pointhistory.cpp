@@ -0,0 +1,146 @@
+#include <QtTest>
+#include <QVector>
+#include <algorithm>
+#include "pointhistory.h"
+
+/**
+ * @brief Undo and redo through PointHistory
+ */
+class PointHistoryTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrip();
+    void stepEditsReplay();
+
+private:
+    static QVector<DataPoint> makePoints(int structures, int spacings);
+    static bool equal(const PersistentPoints &actual, const QVector<DataPoint> &expected);
+    static void replay(QVector<DataPoint> &points, const QVector<PointEdit> &edits);
+};
+
+/**
+ * @brief Points of several structures, sorted and with handles as DataManager assigns them
+ */
+QVector<DataPoint> PointHistoryTest::makePoints(int structures, int spacings)
+{
+    QVector<DataPoint> points;
+    for (int structure = 0; structure < structures; ++structure) {
+        for (int i = 0; i < spacings; ++i) {
+            DataPoint point(2.0 * (i + 1), 10.0 + structure + 0.5 * (i + 1), 1.0e-3);
+            point.structure = QStringLiteral("die%1").arg(structure);
+            point.handle = static_cast<quint64>(points.size() + 1);
+            points.append(point);
+        }
+    }
+    return points;
+}
+
+bool PointHistoryTest::equal(const PersistentPoints &actual, const QVector<DataPoint> &expected)
+{
+    const QVector<DataPoint> points = actual.toVector();
+    return points.size() == expected.size()
+        && std::equal(points.cbegin(), points.cend(), expected.cbegin(), &PersistentPoints::samePoint);
+}
+
+/**
+ * @brief Apply edits to a vector the way DataManager applies them to its collection
+ */
+void PointHistoryTest::replay(QVector<DataPoint> &points, const QVector<PointEdit> &edits)
+{
+    for (const PointEdit &edit : edits) {
+        switch (edit.kind) {
+            case PointEdit::Changed: points[edit.row] = edit.point; break;
+            case PointEdit::Inserted: points.insert(edit.row, edit.point); break;
+            case PointEdit::Removed: points.remove(edit.row); break;
+        }
+    }
+}
+
+/**
+ * @brief Toggles, removes and adds points in three recorded steps, then walks back and forward again
+ */
+void PointHistoryTest::roundTrip()
+{
+    const QVector<DataPoint> loaded = makePoints(4, 14);
+
+    PointHistory history(10);
+    history.record(loaded);
+
+    QVector<DataPoint> toggled = loaded;
+    for (qsizetype i = 0; i < toggled.size(); i += 5) {
+        toggled[i].enabled = false;
+    }
+    history.record(toggled);
+    QVERIFY(equal(history.currentPoints(), toggled));
+
+    QVector<DataPoint> edited = toggled;
+    edited.removeIf([](const DataPoint &point) { return !point.enabled; });
+    DataPoint added = edited.at(2);
+    added.resistance *= 2.0;
+    added.handle = static_cast<quint64>(loaded.size() + 1);
+    edited.insert(3, added);
+    history.record(edited);
+    QVERIFY(equal(history.currentPoints(), edited));
+    QCOMPARE(history.undoCount(), 2);
+
+    // Recording an unchanged collection adds no step
+    const quint64 version = history.currentVersion();
+    QCOMPARE(history.record(edited), version);
+
+    QVERIFY(history.undo());
+    QVERIFY(equal(history.currentPoints(), toggled));
+    QVERIFY(history.undo());
+    QVERIFY(!history.undo());
+    QVERIFY(equal(history.currentPoints(), loaded));
+
+    QVERIFY(history.redo());
+    QVERIFY(history.redo());
+    QVERIFY(!history.redo());
+    QVERIFY(equal(history.currentPoints(), edited));
+}
+
+/**
+ * @brief Edits reported by undo and redo turn one state into the other, whether recorded with edits or matched
+ */
+void PointHistoryTest::stepEditsReplay()
+{
+    const QVector<DataPoint> loaded = makePoints(4, 14);
+    PointHistory history(10);
+    history.record(loaded);
+
+    // A toggle recorded with its edit
+    QVector<DataPoint> toggled = loaded;
+    toggled[7].enabled = false;
+    history.record(toggled, {PointEdit {PointEdit::Changed, 7, toggled.at(7)}});
+    QVERIFY(equal(history.currentPoints(), toggled));
+
+    // A removal and an insertion recorded without edits
+    QVector<DataPoint> edited = toggled;
+    edited.remove(20);
+    DataPoint added = edited.at(3);
+    added.handle = static_cast<quint64>(loaded.size() + 1);
+    edited.insert(4, added);
+    history.record(edited);
+
+    QVector<DataPoint> shown = edited;
+    QVector<PointEdit> edits;
+    QVERIFY(history.undo(&edits));
+    QVERIFY(!edits.isEmpty());
+    replay(shown, edits);
+    QVERIFY(equal(PersistentPoints::fromVector(shown), toggled));
+    QVERIFY(history.undo(&edits));
+    QCOMPARE(edits.size(), 1);
+    replay(shown, edits);
+    QVERIFY(equal(PersistentPoints::fromVector(shown), loaded));
+
+    QVERIFY(history.redo(&edits));
+    replay(shown, edits);
+    QVERIFY(history.redo(&edits));
+    replay(shown, edits);
+    QVERIFY(equal(PersistentPoints::fromVector(shown), edited));
+}
+
+QTEST_GUILESS_MAIN(PointHistoryTest)
+#include "tst_pointhistory.moc"
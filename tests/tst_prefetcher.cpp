@@ -0,0 +1,151 @@
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include "appconfig.h"
+#include "folderprefetcher.h"
+#include "ingestpipeline.h"
+#include "testcorpus.h"
+
+/**
+ * @brief Sibling prediction, caching and staleness of FolderPrefetcher
+ */
+class PrefetcherTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void siblingOrder();
+    void prefetchedDieMatchesLoad();
+    void changedSettingsAreNotReused();
+    void editedFileIsNotReused();
+
+private:
+    QString die(int index) const;
+    static AppConfig prefetchConfig();
+    static QVector<DataPoint> load(const QString &folder, const AppConfig &config);
+
+    QTemporaryDir m_wafer;
+    WorkerPool m_io;    ///< Pool that checks cached sets, as DataManager's I/O pool does
+};
+
+void PrefetcherTest::initTestCase()
+{
+    QVERIFY(m_wafer.isValid());
+    QVERIFY(TestCorpus::writeWafer(m_wafer.path(), 4));
+    m_io.configure(2, QThread::NormalPriority, QVector<int>());
+}
+
+QString PrefetcherTest::die(int index) const
+{
+    return QDir(m_wafer.path()).absoluteFilePath(QStringLiteral("die%1").arg(index));
+}
+
+/**
+ * @brief Configuration of a die load without touching config.json
+ */
+AppConfig PrefetcherTest::prefetchConfig()
+{
+    AppConfig config(QStringLiteral("config.json"), AppConfig::Loading::Deferred);
+    config.include_patterns = QStringList {QStringLiteral("*.csv")};
+    config.prefetch_folders = 2;
+    return config;
+}
+
+/**
+ * @brief Normal load of a folder, which take() falls back to for a stale set
+ */
+QVector<DataPoint> PrefetcherTest::load(const QString &folder, const AppConfig &config)
+{
+    return IngestPipeline(config, IngestOptions::fromConfig(config)).runMany(QStringList {folder});
+}
+
+/**
+ * @brief Natural order puts die2 after die1; a wafer map overrides it and skips missing folders
+ */
+void PrefetcherTest::siblingOrder()
+{
+    QCOMPARE(FolderPrefetcher::siblingsAfter(die(0), QStringList(), 2), QStringList({die(1), die(2)}));
+    QCOMPARE(FolderPrefetcher::siblingsAfter(die(0), {QStringLiteral("die3"), QStringLiteral("die0"),
+                                                      QStringLiteral("missing"), QStringLiteral("die2")}, 5),
+             QStringList({die(2)}));
+    QVERIFY(FolderPrefetcher::siblingsAfter(die(3), QStringList(), 2).isEmpty());
+}
+
+void PrefetcherTest::prefetchedDieMatchesLoad()
+{
+    const AppConfig config = prefetchConfig();
+    FolderPrefetcher prefetcher;
+    prefetcher.configure(config);
+    prefetcher.prefetchAfter(die(0), config);
+    QTRY_VERIFY_WITH_TIMEOUT(prefetcher.isCached(die(2)), 30000);
+    QVERIFY(prefetcher.isCached(die(1)));
+
+    bool loaded = false;
+    QFuture<QVector<DataPoint>> future = prefetcher.take(die(1), config, &m_io, [&loaded]() {
+        loaded = true;
+        return QVector<DataPoint>();
+    });
+    QVERIFY(future.isValid());
+    const QVector<DataPoint> prefetched = future.result();
+    QVERIFY(!loaded);
+    const QVector<DataPoint> direct = load(die(1), config);
+    QCOMPARE(prefetched.size(), direct.size());
+    for (qsizetype i = 0; i < direct.size(); ++i) {
+        QCOMPARE(prefetched.at(i).resistance, direct.at(i).resistance);
+        QCOMPARE(prefetched.at(i).origin, direct.at(i).origin);
+    }
+
+    // A set that was handed out stays cached for stepping back
+    QVERIFY(prefetcher.isCached(die(1)));
+}
+
+void PrefetcherTest::changedSettingsAreNotReused()
+{
+    AppConfig config = prefetchConfig();
+    FolderPrefetcher prefetcher;
+    prefetcher.configure(config);
+    prefetcher.prefetchAfter(die(0), config);
+    QTRY_VERIFY_WITH_TIMEOUT(prefetcher.isCached(die(2)), 30000);
+
+    config.res_voltage *= 2.0;
+    QVERIFY(!prefetcher.take(die(2), config, &m_io, []() { return QVector<DataPoint>(); }).isValid());
+}
+
+/**
+ * @brief Editing a file in place leaves the folder's own modification time alone, but not the stamp
+ *
+ * The stale set is replaced by the normal load, run by the future take() returns.
+ */
+void PrefetcherTest::editedFileIsNotReused()
+{
+    QTemporaryDir wafer;
+    QVERIFY(wafer.isValid());
+    QVERIFY(TestCorpus::writeWafer(wafer.path(), 2));
+    const QDir root(wafer.path());
+    const QString edited = root.absoluteFilePath(QStringLiteral("die1"));
+
+    const AppConfig config = prefetchConfig();
+    FolderPrefetcher prefetcher;
+    prefetcher.configure(config);
+    prefetcher.prefetchAfter(root.absoluteFilePath(QStringLiteral("die0")), config);
+    QTRY_VERIFY_WITH_TIMEOUT(prefetcher.isCached(edited), 30000);
+
+    const QStringList files = QDir(edited).entryList(QDir::Files);
+    QVERIFY(!files.isEmpty());
+    QFile file(QDir(edited).absoluteFilePath(files.constFirst()));
+    QVERIFY(file.open(QIODevice::Append));
+    file.write("\n");
+    file.close();
+
+    QFuture<QVector<DataPoint>> future = prefetcher.take(edited, config, &m_io, [edited, config]() {
+        return load(edited, config);
+    });
+    QVERIFY(future.isValid());
+    QCOMPARE(future.result().size(), load(edited, config).size());
+    QVERIFY(!prefetcher.isCached(edited));
+}
+
+QTEST_GUILESS_MAIN(PrefetcherTest)
+#include "tst_prefetcher.moc"
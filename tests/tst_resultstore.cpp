@@ -0,0 +1,105 @@
+#include <QtTest>
+#include <QDir>
+#include <QTemporaryDir>
+#include "appconfig.h"
+#include "calculator.h"
+#include "csvprocessor.h"
+#include "datamanager.h"
+#include "resultstore.h"
+#include "testcorpus.h"
+
+/**
+ * @brief Recording and querying fits in the ResultStore
+ *
+ * Fits a generated four-die wafer per structure, records the results with
+ * the die taken from the folder name and reads them back by die, date and
+ * as a trend.
+ */
+class ResultStoreTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void roundTrip();
+
+private:
+    static void compareResult(const Calculator::TLMResult &actual, const Calculator::TLMResult &expected);
+
+    QTemporaryDir m_wafer;
+};
+
+void ResultStoreTest::initTestCase()
+{
+    QVERIFY(m_wafer.isValid());
+    QVERIFY(TestCorpus::writeWafer(m_wafer.path(), 4));
+}
+
+void ResultStoreTest::compareResult(const Calculator::TLMResult &actual, const Calculator::TLMResult &expected)
+{
+    QCOMPARE(actual.slope, expected.slope);
+    QCOMPARE(actual.intercept, expected.intercept);
+    QCOMPARE(actual.rSquared, expected.rSquared);
+    QCOMPARE(actual.sheetResistance, expected.sheetResistance);
+    QCOMPARE(actual.contactResistance, expected.contactResistance);
+    QCOMPARE(actual.transferLength, expected.transferLength);
+}
+
+void ResultStoreTest::roundTrip()
+{
+    AppConfig config(QStringLiteral("config.json"), AppConfig::Loading::Deferred);
+    config.scan_recursive = true;
+    config.group_by_folder = true;
+    config.include_patterns = QStringList {QStringLiteral("*.csv")};
+    const QVector<DataPoint> points = CSVProcessor::processFolder(m_wafer.path(), config);
+    QVector<DataPoint> qualified = points;
+    for (DataPoint &point : qualified) {
+        point.origin = QDir(m_wafer.path()).absolutePath();
+    }
+
+    QMap<QString, Calculator::TLMResult> results;
+    QVERIFY(DataManager::calculateStructureResults(points, results, Calculator::FitModel::LinearTLM,
+                                                   Calculator::FitGeometry()));
+    const QDateTime now = QDateTime::currentDateTime();
+    QVector<ResultStore::Record> records = ResultStore::recordsFor(
+        qualified, results, QStringLiteral("linear"), 1.0, QStringList {QStringLiteral("die")}, now);
+    QCOMPARE(records.size(), 4);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ResultStore store(dir.filePath(QStringLiteral("results.sqlite")));
+    QString error;
+    QVERIFY2(store.open(&error), qPrintable(error));
+    QVERIFY2(store.insert(records, &error), qPrintable(error));
+    QCOMPARE(store.count(), 4);
+
+    // Analysing the same structures again replaces their rows
+    QVector<ResultStore::Record> again = records;
+    QVERIFY2(store.insert(again, &error), qPrintable(error));
+    QCOMPARE(store.count(), 4);
+
+    const QVector<ResultStore::Record> die2 = store.query(QStringLiteral("die=DIE2 and model=linear"), 0, &error);
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+    QCOMPARE(die2.size(), 1);
+    QCOMPARE(die2.first().structure, QStringLiteral("die2/Sweep_SMU"));
+    QCOMPARE(die2.first().points, 14);
+    compareResult(die2.first().result, results.value(QStringLiteral("die2/Sweep_SMU")));
+
+    const QString today = now.date().toString(Qt::ISODate);
+    QCOMPARE(store.query(QStringLiteral("date=") + today, 0, &error).size(), 4);
+    QCOMPARE(store.query(QStringLiteral("date<") + today, 0, &error).size(), 0);
+    QCOMPARE(store.query(QStringLiteral("rsh>0 and r2>=0.99"), 2, &error).size(), 2);
+    QVERIFY(store.query(QStringLiteral("rsh=high"), 0, &error).isEmpty());
+    QVERIFY(!error.isEmpty());
+
+    error.clear();
+    const QVector<ResultStore::TrendRow> trend = store.trend(QString(), QStringLiteral("die"), QStringLiteral("rsh"), &error);
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+    QCOMPARE(trend.size(), 4);
+    QCOMPARE(trend.first().key, QStringLiteral("die0"));
+    QCOMPARE(trend.first().count, 1);
+    QCOMPARE(trend.first().mean, results.value(QStringLiteral("die0/Sweep_SMU")).sheetResistance);
+}
+
+QTEST_GUILESS_MAIN(ResultStoreTest)
+#include "tst_resultstore.moc"
@@ -0,0 +1,187 @@
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include "appconfig.h"
+#include "csvprocessor.h"
+#include "tailparser.h"
+
+/**
+ * @brief Incremental parsing of sweep files that are still being written
+ *
+ * Each case writes a file in steps and polls a TailParser after each, as
+ * DataManager does while following a folder.
+ */
+class TailParserTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void partialLineWaitsForNewline();
+    void pointWaitsForZeroReading();
+    void truncatedFileRestarts();
+    void legacyFileReportsOnFinish();
+
+private:
+    static QByteArray header();
+    static QByteArray row(int index, double volts, double resistance);
+    static QByteArray rows(int first, int last, double resistance);
+    static bool write(const QString &path, const QByteArray &data, QIODevice::OpenMode mode);
+    static bool near(double actual, double expected);
+
+    QTemporaryDir m_dir;
+    AppConfig m_config {QStringLiteral("config.json"), AppConfig::Loading::Deferred};
+};
+
+void TailParserTest::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    m_config.res_voltage = 1.0;
+}
+
+/**
+ * @brief Start of a Keithley export with one Sweep_SMU buffer
+ */
+QByteArray TailParserTest::header()
+{
+    return "[ DATA ]\n"
+           "Name,Sweep_SMU,,\n"
+           ",Timestamp,Source Value,Reading\n"
+           ",(seconds),(Volts),(Amps)\n";
+}
+
+/**
+ * @brief Data row of a sweep from +1 V down to -1 V, so the 1 V reading comes before the 0 V one
+ * @param index Row index, 1-based
+ * @param volts Source value
+ * @param resistance Device resistance in Ω; the current has a 60 μA offset
+ */
+QByteArray TailParserTest::row(int index, double volts, double resistance)
+{
+    return QByteArray::number(index) + "," + QByteArray::number(0.01 * index) + ","
+         + QByteArray::number(volts, 'f', 1) + "," + QByteArray::number(volts / resistance + 6.0e-5, 'g', 10) + "\n";
+}
+
+/**
+ * @brief Rows first to last (1-based) of the 21-step sweep, at 1 V - 0.1 V·(index - 1)
+ */
+QByteArray TailParserTest::rows(int first, int last, double resistance)
+{
+    QByteArray data;
+    for (int index = first; index <= last; ++index) {
+        data += row(index, 1.0 - 0.1 * (index - 1), resistance);
+    }
+    return data;
+}
+
+bool TailParserTest::write(const QString &path, const QByteArray &data, QIODevice::OpenMode mode)
+{
+    QFile file(path);
+    return file.open(mode) && file.write(data) == data.size();
+}
+
+bool TailParserTest::near(double actual, double expected)
+{
+    return qAbs(actual - expected) <= 1e-6 * qAbs(expected);
+}
+
+/**
+ * @brief Half a line is left on disk until its newline arrives, then completes the point
+ */
+void TailParserTest::partialLineWaitsForNewline()
+{
+    const QString path = QDir(m_dir.path()).filePath(QStringLiteral("10_partial.csv"));
+    const QByteArray complete = header() + rows(1, 10, 50.0);
+    const QByteArray zeroRow = row(11, 0.0, 50.0);
+    QVERIFY(write(path, complete + zeroRow.left(5), QIODevice::WriteOnly));
+
+    TailParser parser(m_config);
+    QVERIFY(parser.poll(path).isEmpty());
+    QCOMPARE(parser.offset(path), qint64(complete.size()));
+
+    QVERIFY(write(path, zeroRow.mid(5), QIODevice::Append));
+    const QVector<DataPoint> points = parser.poll(path);
+    QCOMPARE(points.size(), 1);
+    QVERIFY(near(points.first().resistance, 50.0));
+    QCOMPARE(points.first().spacing, 10.0);
+    QCOMPARE(points.first().structure, CSVProcessor::structureForSource(QString(), QStringLiteral("Sweep_SMU")));
+    QCOMPARE(parser.offset(path), qint64(complete.size() + zeroRow.size()));
+}
+
+/**
+ * @brief A sweep that has reached its bias reports nothing until the 0 V reading, and the point only once
+ */
+void TailParserTest::pointWaitsForZeroReading()
+{
+    const QString path = QDir(m_dir.path()).filePath(QStringLiteral("20_sweep.csv"));
+    QVERIFY(write(path, header() + rows(1, 10, 80.0), QIODevice::WriteOnly));
+
+    TailParser parser(m_config);
+    QVERIFY(parser.poll(path).isEmpty());
+
+    QVERIFY(write(path, rows(11, 11, 80.0), QIODevice::Append));
+    const QVector<DataPoint> points = parser.poll(path);
+    QCOMPARE(points.size(), 1);
+    QVERIFY(near(points.first().resistance, 80.0));
+
+    QVERIFY(write(path, rows(12, 21, 80.0), QIODevice::Append));
+    QVERIFY(parser.poll(path).isEmpty());
+    QVERIFY(parser.finish(path).isEmpty());
+    QVERIFY(parser.files().isEmpty());
+}
+
+/**
+ * @brief A file rewritten shorter is parsed again from the start and reported as restarted
+ */
+void TailParserTest::truncatedFileRestarts()
+{
+    const QString path = QDir(m_dir.path()).filePath(QStringLiteral("30_rewritten.csv"));
+    QVERIFY(write(path, header() + rows(1, 21, 100.0), QIODevice::WriteOnly));
+
+    TailParser parser(m_config);
+    bool restarted = true;
+    QVector<DataPoint> points = parser.poll(path, QString(), &restarted);
+    QVERIFY(!restarted);
+    QCOMPARE(points.size(), 1);
+    QVERIFY(near(points.first().resistance, 100.0));
+
+    const QByteArray replaced = header() + rows(1, 11, 120.0);
+    QVERIFY(write(path, replaced, QIODevice::WriteOnly | QIODevice::Truncate));
+    points = parser.poll(path, QString(), &restarted);
+    QVERIFY(restarted);
+    QCOMPARE(points.size(), 1);
+    QVERIFY(near(points.first().resistance, 120.0));
+    QCOMPARE(parser.offset(path), qint64(replaced.size()));
+
+    QVERIFY(parser.poll(path, QString(), &restarted).isEmpty());
+    QVERIFY(!restarted);
+}
+
+/**
+ * @brief A file without a `[ DATA ]` section has no marker for a complete sweep, so only finish() reports it
+ */
+void TailParserTest::legacyFileReportsOnFinish()
+{
+    const QString path = QDir(m_dir.path()).filePath(QStringLiteral("40_legacy.csv"));
+    QByteArray data;
+    for (int step = 0; step <= 20; ++step) {
+        const double volts = -1.0 + 0.1 * step;
+        data += QByteArray::number(step + 1) + ",,,,," + QByteArray::number(volts, 'f', 1) + ","
+              + QByteArray::number(volts / 40.0 + 6.0e-5, 'g', 10) + "\n";
+    }
+    QVERIFY(write(path, data, QIODevice::WriteOnly));
+
+    TailParser parser(m_config);
+    QVERIFY(parser.poll(path).isEmpty());
+    QCOMPARE(parser.offset(path), qint64(data.size()));
+
+    const QVector<DataPoint> points = parser.finish(path);
+    QCOMPARE(points.size(), 1);
+    QVERIFY(near(points.first().resistance, 40.0));
+    QCOMPARE(points.first().spacing, 40.0);
+    QVERIFY(parser.files().isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TailParserTest)
+#include "tst_tailparser.moc"
@@ -0,0 +1,109 @@
+#include <QtTest>
+#include <QVector>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include "numerics.h"
+#include "workerpools.h"
+
+/**
+ * @brief Work stealing, thread reservations and pooled sums of WorkerPool
+ */
+class WorkerPoolsTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void stealingVisitsEveryIndexOnce();
+    void claimsStayWithinThePool();
+    void claimWaitsForRelease();
+    void pooledSumIsReproducible();
+};
+
+/**
+ * @brief A grain of one and uneven items force ranges to be stolen; every index is still visited once
+ */
+void WorkerPoolsTest::stealingVisitsEveryIndexOnce()
+{
+    WorkerPool pool;
+    pool.configure(3, QThread::LowPriority, QVector<int>());
+    QVector<int> visits(1000, 0);
+    int *visitOut = visits.data();
+    WorkerPool::parallelFor(&pool, visits.size(), [visitOut](qsizetype begin, qsizetype end) {
+        for (qsizetype i = begin; i < end; ++i) {
+            ++visitOut[i];
+            if (i % 97 == 0) QThread::usleep(200);   // Uneven items make the fast workers steal
+        }
+    }, 1);
+    QVERIFY(std::all_of(visits.cbegin(), visits.cend(), [](int count) { return count == 1; }));
+}
+
+void WorkerPoolsTest::claimsStayWithinThePool()
+{
+    WorkerPool pool;
+    pool.configure(4, QThread::NormalPriority, QVector<int>());
+
+    // A claim larger than the pool gets the whole pool
+    QCOMPARE(pool.claimWorkers(10, 4), 4);
+    pool.releaseWorkers(4);
+
+    // Later claims share what is left
+    QCOMPARE(pool.claimWorkers(3, 1), 3);
+    QCOMPARE(pool.claimWorkers(3, 1), 1);
+    pool.releaseWorkers(1);
+    pool.releaseWorkers(3);
+
+    // A minimum above the pool size is reduced to it
+    QCOMPARE(pool.claimWorkers(2, 8), 4);
+    pool.releaseWorkers(4);
+}
+
+void WorkerPoolsTest::claimWaitsForRelease()
+{
+    WorkerPool pool;
+    pool.configure(4, QThread::NormalPriority, QVector<int>());
+    QCOMPARE(pool.claimWorkers(3, 3), 3);
+
+    std::atomic<int> granted {0};
+    QThread *waiter = QThread::create([&pool, &granted]() {
+        granted.store(pool.claimWorkers(4, 2));
+    });
+    waiter->start();
+    QVERIFY(!waiter->wait(100));
+    QCOMPARE(granted.load(), 0);
+
+    pool.releaseWorkers(3);
+    QVERIFY(waiter->wait(5000));
+    QCOMPARE(granted.load(), 4);
+    pool.releaseWorkers(4);
+    delete waiter;
+}
+
+/**
+ * @brief A sum split over a pool has the bits of the single-pool sum
+ */
+void WorkerPoolsTest::pooledSumIsReproducible()
+{
+    QVector<double> values(Numerics::ParallelThreshold * 3 + 17);
+    for (qsizetype i = 0; i < values.size(); ++i) {
+        values[i] = std::sin(static_cast<double>(i)) * 1.0e6 + 1.0 / static_cast<double>(i + 1);
+    }
+
+    WorkerPool single;
+    single.configure(1, QThread::NormalPriority, QVector<int>());
+    Numerics::setThreadPool(&single);
+    const double reference = Numerics::sum(values);
+
+    WorkerPool pool;
+    pool.configure(4, QThread::NormalPriority, QVector<int>());
+    Numerics::setThreadPool(&pool);
+    const double pooled = Numerics::sum(values);
+    Numerics::setThreadPool(nullptr);
+
+    QCOMPARE(pooled, reference);
+    QVERIFY(std::memcmp(&pooled, &reference, sizeof(double)) == 0);
+}
+
+QTEST_GUILESS_MAIN(WorkerPoolsTest)
+#include "tst_workerpools.moc"
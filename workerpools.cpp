@@ -0,0 +1,424 @@
+#include "include/workerpools.h"
+#include "include/ingestpipeline.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QSemaphore>
+#include <QStringList>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#if defined(Q_OS_LINUX)
+#include <sched.h>
+#elif defined(Q_OS_WIN)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace {
+
+// Generations are unique across pools, so a thread can tell whether it is up to date
+std::atomic<quint64> lastGeneration {0};
+
+quint64 nextGeneration()
+{
+    return lastGeneration.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+// Default size of the I/O pool: enough to keep a load, a reduction and an export in flight
+constexpr int DefaultIoThreads = 4;
+
+// An ingest run has four stages of at least one worker each
+constexpr int MinimumIngestThreads = 4;
+
+// Largest CPU number accepted in worker_cpus
+constexpr int MaxCpu = 1023;
+
+/**
+ * @brief Indices a parallelFor() worker has not processed yet
+ *
+ * The owner takes grains from the front and thieves take the back half,
+ * both under the mutex; the bounds are atomic only so that thieves can
+ * look for the fullest range without locking every one of them.
+ */
+struct WorkRange {
+    QMutex mutex;
+    std::atomic<qsizetype> begin {0};
+    std::atomic<qsizetype> end {0};
+
+    qsizetype remaining() const
+    {
+        return end.load(std::memory_order_relaxed) - begin.load(std::memory_order_relaxed);
+    }
+};
+
+} // namespace
+
+/**
+ * @brief Constructor
+ * @param parent The parent QObject
+ */
+WorkerPool::WorkerPool(QObject *parent)
+    : QThreadPool(parent), m_generation(nextGeneration())
+{
+}
+
+/**
+ * @brief Apply a size, priority and CPU set
+ * @param threads Maximum number of threads (at least 1)
+ * @param priority Priority of the pool's threads
+ * @param cpus CPUs the threads may run on; empty for all
+ *
+ * Threads started from now on get the priority from Qt; threads that are
+ * already running pick up both settings in prepareThread().
+ */
+void WorkerPool::configure(int threads, QThread::Priority priority, const QVector<int> &cpus)
+{
+    setMaxThreadCount(std::max(1, threads));
+    setThreadPriority(priority);
+
+    QMutexLocker locker(&m_mutex);
+    if (m_priority == priority && m_cpus == cpus) {
+        return;
+    }
+    m_priority = priority;
+    m_cpus = cpus;
+    m_generation.storeRelease(nextGeneration());
+}
+
+/**
+ * @brief Give the calling pool thread the configured priority and CPU set
+ *
+ * Costs one atomic load when the thread already matches the configuration.
+ * A thread that was pinned by an earlier configuration is released again
+ * when the CPU set is cleared.
+ */
+void WorkerPool::prepareThread()
+{
+    static thread_local quint64 prepared = 0;
+    const quint64 generation = m_generation.loadAcquire();
+    if (prepared == generation) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_priority != QThread::InheritPriority) {
+        QThread::currentThread()->setPriority(m_priority);
+    }
+    if (!m_cpus.isEmpty() || prepared != 0) {
+        pinCurrentThread(m_cpus);
+    }
+    prepared = generation;
+}
+
+/**
+ * @brief Priority of the pool's threads
+ */
+QThread::Priority WorkerPool::priority() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_priority;
+}
+
+/**
+ * @brief Reserve threads for workers that must all run at the same time
+ * @param wanted Workers the caller would like to start
+ * @param minimum Workers the caller cannot do without
+ * @return Workers granted, between minimum and wanted; return them with releaseWorkers()
+ *
+ * A reservation never exceeds maxThreadCount() together with the others,
+ * so the pool starts every granted worker at once. A minimum larger than
+ * the pool is reduced to the pool size; the caller then has to make do with
+ * fewer workers per stage.
+ */
+int WorkerPool::claimWorkers(int wanted, int minimum)
+{
+    QMutexLocker locker(&m_claimMutex);
+    for (;;) {
+        const int capacity = std::max(1, maxThreadCount());
+        const int needed = std::clamp(minimum, 1, capacity);
+        if (capacity - m_claimed >= needed) {
+            const int granted = std::clamp(wanted, needed, capacity - m_claimed);
+            m_claimed += granted;
+            return granted;
+        }
+        m_claimReleased.wait(&m_claimMutex);
+    }
+}
+
+/**
+ * @brief Return threads reserved with claimWorkers()
+ */
+void WorkerPool::releaseWorkers(int count)
+{
+    QMutexLocker locker(&m_claimMutex);
+    m_claimed = std::max(0, m_claimed - count);
+    m_claimReleased.wakeAll();
+}
+
+/**
+ * @brief Process the indices 0 to count - 1 on a pool and the calling thread
+ * @param pool Pool supplying the helper threads; nullptr for the global pool
+ * @param count Number of indices
+ * @param body Called with half-open index ranges [begin, end), possibly concurrently
+ * @param grain Indices per range; 0 picks a value that gives each worker several ranges
+ *
+ * Every worker owns one contiguous range, so in the common case each works
+ * through its own part of the data front to back and only touches its own
+ * mutex. Stealing the back half of the fullest range keeps the split
+ * balanced without a central queue: a thief leaves the victim the part it
+ * is about to reach and takes enough that it will not have to steal again
+ * soon. Ranges of helpers that could not be started are simply stolen.
+ */
+void WorkerPool::parallelFor(QThreadPool *pool, qsizetype count,
+                             const std::function<void(qsizetype begin, qsizetype end)> &body, qsizetype grain)
+{
+    if (count <= 0) {
+        return;
+    }
+    if (!pool) {
+        pool = QThreadPool::globalInstance();
+    }
+
+    // The caller takes part, so up to one worker more than the pool has threads
+    int workers = std::max(1, pool->maxThreadCount()) + 1;
+    if (grain <= 0) {
+        grain = std::max<qsizetype>(1, count / (static_cast<qsizetype>(workers) * 8));
+    }
+    workers = static_cast<int>(std::min<qsizetype>(workers, (count + grain - 1) / grain));
+    if (workers <= 1) {
+        body(0, count);
+        return;
+    }
+
+    std::unique_ptr<WorkRange[]> ranges(new WorkRange[workers]);
+    for (int i = 0; i < workers; ++i) {
+        ranges[i].begin.store(count * i / workers, std::memory_order_relaxed);
+        ranges[i].end.store(count * (i + 1) / workers, std::memory_order_relaxed);
+    }
+
+    auto work = [&](int self) {
+        WorkRange &own = ranges[self];
+        for (;;) {
+            qsizetype begin = 0;
+            qsizetype end = 0;
+            {
+                QMutexLocker locker(&own.mutex);
+                begin = own.begin.load(std::memory_order_relaxed);
+                end = std::min(own.end.load(std::memory_order_relaxed), begin + grain);
+                own.begin.store(end, std::memory_order_relaxed);
+            }
+            if (begin < end) {
+                body(begin, end);
+                continue;
+            }
+
+            // Own range exhausted: steal from the fullest one
+            int victim = -1;
+            qsizetype largest = 0;
+            for (int i = 0; i < workers; ++i) {
+                const qsizetype remaining = ranges[i].remaining();
+                if (remaining > largest) {
+                    largest = remaining;
+                    victim = i;
+                }
+            }
+            if (victim < 0) {
+                return;
+            }
+            {
+                QMutexLocker locker(&ranges[victim].mutex);
+                begin = ranges[victim].begin.load(std::memory_order_relaxed);
+                end = ranges[victim].end.load(std::memory_order_relaxed);
+                if (begin >= end) {
+                    continue;   // Drained meanwhile; look again
+                }
+                begin += (end - begin) / 2;
+                ranges[victim].end.store(begin, std::memory_order_relaxed);
+            }
+            QMutexLocker locker(&own.mutex);
+            own.begin.store(begin, std::memory_order_relaxed);
+            own.end.store(end, std::memory_order_relaxed);
+        }
+    };
+
+    auto *workerPool = qobject_cast<WorkerPool *>(pool);
+    QSemaphore finished;
+    int started = 0;
+    for (int i = 1; i < workers; ++i) {
+        const bool ok = pool->tryStart([&work, &finished, workerPool, i]() {
+            if (workerPool) workerPool->prepareThread();
+            work(i);
+            finished.release();
+        });
+        if (!ok) {
+            break;
+        }
+        ++started;
+    }
+    work(0);
+    finished.acquire(started);
+}
+
+/**
+ * @brief Parse a priority name
+ * @param name idle, lowest, low, normal, high or highest (case-insensitive)
+ * @param fallback Returned for an empty or unknown name
+ */
+QThread::Priority WorkerPool::priorityFromName(const QString &name, QThread::Priority fallback)
+{
+    const QString key = name.trimmed().toLower();
+    if (key == QLatin1String("idle")) return QThread::IdlePriority;
+    if (key == QLatin1String("lowest")) return QThread::LowestPriority;
+    if (key == QLatin1String("low")) return QThread::LowPriority;
+    if (key == QLatin1String("normal")) return QThread::NormalPriority;
+    if (key == QLatin1String("high")) return QThread::HighPriority;
+    if (key == QLatin1String("highest")) return QThread::HighestPriority;
+    if (!key.isEmpty()) {
+        qDebug() << "Unknown thread priority:" << name;
+    }
+    return fallback;
+}
+
+/**
+ * @brief Parse a CPU list such as "0-3,6"
+ * @param text Comma-separated CPU numbers and inclusive ranges
+ * @param error Receives a description of the problem, if any
+ * @return Sorted, distinct CPU numbers; empty for empty or invalid text
+ */
+QVector<int> WorkerPool::parseCpuList(const QString &text, QString *error)
+{
+    QVector<int> cpus;
+    const QStringList items = text.split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString &item : items) {
+        const QStringList bounds = item.trimmed().split(QLatin1Char('-'));
+        bool firstOk = false;
+        bool lastOk = bounds.size() == 1;
+        const int first = bounds.first().trimmed().toInt(&firstOk);
+        const int last = bounds.size() == 2 ? bounds.last().trimmed().toInt(&lastOk) : first;
+        if (bounds.size() > 2 || !firstOk || !lastOk || first < 0 || last < first || last > MaxCpu) {
+            if (error) *error = QStringLiteral("Invalid CPU list entry: %1").arg(item.trimmed());
+            return QVector<int>();
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.append(cpu);
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+/**
+ * @brief Restrict the calling thread to a set of CPUs
+ * @param cpus CPU numbers; empty allows every CPU again
+ * @return False if the platform does not support affinity or refused the set
+ *
+ * Uses sched_setaffinity() on Linux and SetThreadAffinityMask() on Windows
+ * (first processor group only); elsewhere only an empty set succeeds.
+ */
+bool WorkerPool::pinCurrentThread(const QVector<int> &cpus)
+{
+#if defined(Q_OS_LINUX)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (cpus.isEmpty()) {
+        // The kernel intersects the mask with the CPUs the process may use
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            CPU_SET(cpu, &set);
+        }
+    } else {
+        for (int cpu : cpus) {
+            if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+        }
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        qDebug() << "Cannot set thread affinity to CPUs" << cpus;
+        return false;
+    }
+    return true;
+#elif defined(Q_OS_WIN)
+    DWORD_PTR mask = 0;
+    if (cpus.isEmpty()) {
+        DWORD_PTR systemMask = 0;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &mask, &systemMask)) {
+            return false;
+        }
+    } else {
+        for (int cpu : cpus) {
+            if (cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) mask |= DWORD_PTR(1) << cpu;
+        }
+    }
+    if (mask == 0 || SetThreadAffinityMask(GetCurrentThread(), mask) == 0) {
+        qDebug() << "Cannot set thread affinity to CPUs" << cpus;
+        return false;
+    }
+    return true;
+#else
+    return cpus.isEmpty();
+#endif
+}
+
+/**
+ * @brief Constructor; applies the defaults of AppConfig
+ */
+WorkerPools::WorkerPools()
+{
+    configure(AppConfig(QString(), AppConfig::Loading::Deferred));
+}
+
+/**
+ * @brief Apply io_threads, io_priority, compute_threads, compute_priority and worker_cpus
+ *
+ * All pools share the CPU set; an invalid set is reported and ignored. The
+ * ingest pool runs at io_priority; a run may lower the priority of its own
+ * stage workers (IngestOptions::threadPriority).
+ */
+void WorkerPools::configure(const AppConfig &config)
+{
+    QString error;
+    const QVector<int> cpus = WorkerPool::parseCpuList(config.worker_cpus, &error);
+    if (!error.isEmpty()) {
+        qDebug() << "Ignoring worker_cpus:" << error;
+    }
+    m_io.configure(ioThreads(config), WorkerPool::priorityFromName(config.io_priority, QThread::LowPriority), cpus);
+    m_compute.configure(computeThreads(config),
+                        WorkerPool::priorityFromName(config.compute_priority, QThread::NormalPriority), cpus);
+    m_ingest.configure(ingestThreads(config), WorkerPool::priorityFromName(config.io_priority, QThread::LowPriority),
+                       cpus);
+}
+
+/**
+ * @brief Size of the I/O pool for a configuration
+ */
+int WorkerPools::ioThreads(const AppConfig &config)
+{
+    return config.io_threads > 0 ? config.io_threads : DefaultIoThreads;
+}
+
+/**
+ * @brief Size of the compute pool for a configuration
+ *
+ * Defaults to one thread per core minus one, leaving a core to the GUI and
+ * render threads.
+ */
+int WorkerPools::computeThreads(const AppConfig &config)
+{
+    return config.compute_threads > 0 ? config.compute_threads : std::max(1, QThread::idealThreadCount() - 1);
+}
+
+/**
+ * @brief Size of the ingest pool for a configuration
+ *
+ * Room for the readers and parsers of one full-size run plus an enumerator
+ * and a validator; a second run waits until the first returns its threads
+ * or shares what is left.
+ */
+int WorkerPools::ingestThreads(const AppConfig &config)
+{
+    const IngestOptions options = IngestOptions::fromConfig(config);
+    return std::max(MinimumIngestThreads,
+                    options.readThreads + options.parseThreads + options.validateThreads + 1);
+}